@@ -0,0 +1,175 @@
+#include "bench.hpp"
+
+#include <vkh/rangeAllocator.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using vkh::RangeAllocator;
+
+namespace {
+
+constexpr uint64_t CAPACITY = 64ull * 1024 * 1024;
+/// Chunk meshes are packed quads, 8 bytes each, with up to a few thousand
+/// per chunk.
+constexpr uint32_t QUAD_SIZE = 8;
+constexpr uint32_t MAX_QUADS = 6000;
+
+auto randomSize(bench::Rng &rng) -> uint64_t {
+  return uint64_t{rng.below(MAX_QUADS) + 1} * QUAD_SIZE;
+}
+
+/// Checks live allocations are aligned, in bounds, do not overlap and add up
+/// to what the allocator reports as used.
+auto checkLive(const RangeAllocator &allocator,
+               std::vector<RangeAllocator::Allocation> live,
+               uint64_t alignment) -> bool {
+  std::ranges::sort(live, {}, &RangeAllocator::Allocation::offset);
+
+  uint64_t used = 0;
+  uint64_t end = 0;
+  for (const auto &allocation : live) {
+    if (allocation.offset % alignment != 0 || allocation.offset < end ||
+        allocation.offset + allocation.size > allocator.capacity()) {
+      return false;
+    }
+    end = allocation.offset + allocation.size;
+    used += allocation.size;
+  }
+
+  const auto stats = allocator.stats();
+  return stats.used == used && stats.allocations == live.size() &&
+         stats.free == stats.capacity - used && stats.largestFree <= stats.free;
+}
+
+/// Allocates and frees in random order, checking invariants along the way.
+/// Freeing everything has to coalesce back into a single range.
+auto checkChurn(uint64_t alignment) -> bool {
+  RangeAllocator allocator(CAPACITY);
+  bench::Rng rng(alignment);
+  std::vector<RangeAllocator::Allocation> live;
+
+  for (uint32_t step = 0; step < 20000; ++step) {
+    if (live.empty() || rng.below(100) < 55) {
+      if (auto allocation = allocator.allocate(randomSize(rng), alignment)) {
+        live.push_back(*allocation);
+      }
+    } else {
+      const auto index = rng.below(static_cast<uint32_t>(live.size()));
+      allocator.free(live[index]);
+      live[index] = live.back();
+      live.pop_back();
+    }
+
+    if (step % 500 == 0 && !checkLive(allocator, live, alignment)) {
+      return false;
+    }
+  }
+
+  if (!checkLive(allocator, live, alignment)) {
+    return false;
+  }
+
+  for (const auto &allocation : live) {
+    allocator.free(allocation);
+  }
+  const auto stats = allocator.stats();
+  return stats.used == 0 && stats.freeRanges == 1 &&
+         stats.largestFree == CAPACITY;
+}
+
+/// Exhausting the range has to fail cleanly, and the freed space has to be
+/// reusable at the exact same offsets.
+auto checkExhaustion() -> bool {
+  constexpr uint64_t BLOCK = 4096;
+  RangeAllocator allocator(BLOCK * 16);
+
+  std::vector<RangeAllocator::Allocation> blocks;
+  while (auto allocation = allocator.allocate(BLOCK)) {
+    blocks.push_back(*allocation);
+  }
+  if (blocks.size() != 16 || allocator.stats().free != 0 ||
+      allocator.allocate(1)) {
+    return false;
+  }
+
+  // Every other block free leaves half the space, none of it contiguous.
+  for (size_t i = 0; i < blocks.size(); i += 2) {
+    allocator.free(blocks[i]);
+  }
+  auto stats = allocator.stats();
+  if (stats.freeRanges != 8 || stats.largestFree != BLOCK ||
+      allocator.allocate(BLOCK * 2)) {
+    return false;
+  }
+
+  auto reused = allocator.allocate(BLOCK);
+  if (!reused || reused->offset % (BLOCK * 2) != 0) {
+    return false;
+  }
+  allocator.free(*reused);
+
+  for (size_t i = 1; i < blocks.size(); i += 2) {
+    allocator.free(blocks[i]);
+  }
+  stats = allocator.stats();
+  return stats.freeRanges == 1 && stats.largestFree == BLOCK * 16;
+}
+
+} // namespace
+
+auto main() -> int {
+  const bool churnOk = checkChurn(1) && checkChurn(16) && checkChurn(256);
+  const bool exhaustionOk = checkExhaustion();
+  std::printf("%-40s %s\n", "churn invariants", churnOk ? "ok" : "FAILED");
+  std::printf("%-40s %s\n", "exhaustion and coalescing",
+              exhaustionOk ? "ok" : "FAILED");
+  if (!churnOk || !exhaustionOk) {
+    return 1;
+  }
+
+  // Steady state streaming: keep roughly a thousand chunk meshes resident and
+  // replace one per operation.
+  constexpr uint32_t RESIDENT = 1000;
+  constexpr uint32_t REPLACEMENTS = 100000;
+
+  RangeAllocator allocator(CAPACITY);
+  bench::Rng rng;
+  std::vector<RangeAllocator::Allocation> live;
+  for (uint32_t i = 0; i < RESIDENT; ++i) {
+    if (auto allocation = allocator.allocate(randomSize(rng), 16)) {
+      live.push_back(*allocation);
+    }
+  }
+
+  uint32_t failed = 0;
+  auto result = bench::run([&]() -> uint64_t {
+    uint32_t i = 0;
+    // Failed allocations drop their entry, so `live` may run dry.
+    for (; i < REPLACEMENTS && !live.empty(); ++i) {
+      const auto index = rng.below(static_cast<uint32_t>(live.size()));
+      allocator.free(live[index]);
+      if (auto allocation = allocator.allocate(randomSize(rng), 16)) {
+        live[index] = *allocation;
+      } else {
+        ++failed;
+        live[index] = live.back();
+        live.pop_back();
+      }
+    }
+    return i;
+  });
+  bench::report("replace (free + allocate)", result);
+
+  const auto stats = allocator.stats();
+  std::printf("%-40s %.1f / %.1f MiB in %u allocations\n", "resident",
+              static_cast<double>(stats.used) / (1024.0 * 1024.0),
+              static_cast<double>(stats.capacity) / (1024.0 * 1024.0),
+              stats.allocations);
+  std::printf("%-40s %u ranges, largest %.1f MiB, %.1f%% fragmented\n",
+              "free space", stats.freeRanges,
+              static_cast<double>(stats.largestFree) / (1024.0 * 1024.0),
+              stats.fragmentation() * 100.0);
+  std::printf("%-40s %u\n", "failed allocations", failed);
+  return 0;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+namespace bench {
+
+/// Keeps the compiler from discarding a value computed only for timing.
+template <typename T> inline void doNotOptimize(const T &value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+/// Small deterministic generator so runs are comparable between builds.
+class Rng {
+public:
+  explicit Rng(uint64_t seed = 0x9E3779B97F4A7C15ull) noexcept : state(seed) {}
+
+  auto next() noexcept -> uint64_t {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+  }
+
+  auto below(uint32_t bound) noexcept -> uint32_t {
+    return static_cast<uint32_t>(next() % bound);
+  }
+
+private:
+  uint64_t state;
+};
+
+struct Result {
+  double totalNs;
+  uint64_t ops;
+
+  [[nodiscard]] auto nsPerOp() const noexcept -> double {
+    return totalNs / static_cast<double>(ops);
+  }
+
+  [[nodiscard]] auto opsPerSecond() const noexcept -> double {
+    return static_cast<double>(ops) * 1e9 / totalNs;
+  }
+};
+
+/// Runs `fn` `repeats` times after one warm up call. `fn` returns the number
+/// of operations it performed.
+template <typename Fn>
+auto run(Fn &&fn, uint32_t repeats = 5) noexcept -> Result {
+  (void)fn();
+
+  Result result{.totalNs = 0.0, .ops = 0};
+  for (uint32_t i = 0; i < repeats; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    result.ops += fn();
+    auto end = std::chrono::steady_clock::now();
+    result.totalNs +=
+        std::chrono::duration<double, std::nano>(end - start).count();
+  }
+  return result;
+}
+
+/// Nanoseconds since `start`.
+inline auto elapsedNs(std::chrono::steady_clock::time_point start) noexcept
+    -> double {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+inline void report(const char *name, const Result &result) noexcept {
+  std::printf("%-40s %12.2f ns/op %16.0f ops/s\n", name, result.nsPerOp(),
+              result.opsPerSecond());
+}
+
+/// Prints whether `name` held and clears `allOk` if it did not, so a bench
+/// can check everything before it fails.
+inline void check(const char *name, bool ok, bool &allOk) noexcept {
+  allOk = allOk && ok;
+  std::printf("%-40s %s\n", name, ok ? "ok" : "FAILED");
+}
+
+} // namespace bench
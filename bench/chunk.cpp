@@ -0,0 +1,144 @@
+#include "bench.hpp"
+
+#include <engine/voxel/chunk.hpp>
+
+#include <array>
+#include <memory>
+
+using engine::voxel::BlockId;
+using engine::voxel::Chunk;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::CHUNK_VOLUME;
+
+namespace {
+
+constexpr uint32_t RANDOM_OPS = 1 << 20;
+
+/// Builds a chunk resembling generated terrain: a few layers of solid blocks
+/// below a rolling surface with `blockTypes` distinct ids mixed in.
+auto terrainChunk(uint32_t blockTypes, bench::Rng &rng) -> Chunk {
+  Chunk chunk;
+  for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+    for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+      const uint32_t height = 12 + ((x * 7 + z * 3) % 9);
+      for (uint32_t y = 0; y < height; ++y) {
+        chunk.set(x, y, z, static_cast<BlockId>(1 + rng.below(blockTypes)));
+      }
+    }
+  }
+  return chunk;
+}
+
+void randomAccess(uint32_t blockTypes) {
+  bench::Rng rng;
+  auto chunk = terrainChunk(blockTypes, rng);
+
+  std::array<char, 64> name{};
+
+  std::snprintf(name.data(), name.size(), "get random (%u types, %u bits)",
+                blockTypes, chunk.bitsPerIndex());
+  bench::report(name.data(), bench::run([&]() -> uint64_t {
+                  uint32_t sum = 0;
+                  for (uint32_t i = 0; i < RANDOM_OPS; ++i) {
+                    sum += chunk.getIndex(rng.below(CHUNK_VOLUME));
+                  }
+                  bench::doNotOptimize(sum);
+                  return RANDOM_OPS;
+                }));
+
+  std::snprintf(name.data(), name.size(), "set random (%u types)", blockTypes);
+  bench::report(name.data(), bench::run([&]() -> uint64_t {
+                  for (uint32_t i = 0; i < RANDOM_OPS; ++i) {
+                    chunk.setIndex(rng.below(CHUNK_VOLUME),
+                                   static_cast<BlockId>(rng.below(blockTypes)));
+                  }
+                  bench::doNotOptimize(chunk);
+                  return RANDOM_OPS;
+                }));
+}
+
+void paletteResize() {
+  // Every call walks the palette through each width from 0 to 8 bits.
+  bench::report("palette growth 1 -> 256 entries", bench::run([]() -> uint64_t {
+                  Chunk chunk;
+                  for (uint32_t i = 0; i < 256; ++i) {
+                    chunk.setIndex(i * 127, static_cast<BlockId>(i + 1));
+                  }
+                  bench::doNotOptimize(chunk);
+                  return 256;
+                }));
+
+  bench::Rng rng;
+  auto source = terrainChunk(64, rng);
+  bench::report("compact after clearing half",
+                bench::run([&]() -> uint64_t {
+                  auto chunk = source;
+                  for (uint32_t i = 0; i < CHUNK_VOLUME / 2; ++i) {
+                    chunk.setIndex(i, engine::voxel::AIR);
+                  }
+                  chunk.compact();
+                  bench::doNotOptimize(chunk);
+                  return 1;
+                }));
+}
+
+void iteration(uint32_t blockTypes) {
+  bench::Rng rng;
+  auto chunk = terrainChunk(blockTypes, rng);
+  auto out = std::make_unique<std::array<BlockId, CHUNK_VOLUME>>();
+
+  std::array<char, 64> name{};
+  std::snprintf(name.data(), name.size(), "forEach (%u types) per voxel",
+                blockTypes);
+  bench::report(name.data(), bench::run([&]() -> uint64_t {
+                  uint32_t solid = 0;
+                  chunk.forEach([&solid](uint32_t, BlockId block) {
+                    solid += block != engine::voxel::AIR ? 1 : 0;
+                  });
+                  bench::doNotOptimize(solid);
+                  return CHUNK_VOLUME;
+                }));
+
+  std::snprintf(name.data(), name.size(), "unpack (%u types) per voxel",
+                blockTypes);
+  bench::report(name.data(), bench::run([&]() -> uint64_t {
+                  chunk.unpack(*out);
+                  bench::doNotOptimize(out);
+                  return CHUNK_VOLUME;
+                }));
+
+  std::snprintf(name.data(), name.size(), "pack (%u types) per voxel",
+                blockTypes);
+  bench::report(name.data(), bench::run([&]() -> uint64_t {
+                  chunk.pack(*out);
+                  bench::doNotOptimize(chunk);
+                  return CHUNK_VOLUME;
+                }));
+}
+
+void memory() {
+  std::printf("\n%-12s %8s %12s %12s\n", "types", "bits", "bytes", "vs u16");
+  for (uint32_t types : {1u, 2u, 4u, 16u, 200u, 1000u}) {
+    bench::Rng rng;
+    auto chunk = terrainChunk(types, rng);
+    const auto bytes = chunk.memoryUsage();
+    std::printf("%-12u %8u %12zu %11.1fx\n", types, chunk.bitsPerIndex(),
+                bytes,
+                static_cast<double>(CHUNK_VOLUME * sizeof(BlockId)) /
+                    static_cast<double>(bytes));
+  }
+}
+
+} // namespace
+
+auto main() -> int {
+  for (uint32_t types : {2u, 12u, 200u}) {
+    randomAccess(types);
+  }
+  paletteResize();
+  for (uint32_t types : {1u, 12u, 200u}) {
+    iteration(types);
+  }
+  memory();
+  return 0;
+}
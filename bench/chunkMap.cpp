@@ -0,0 +1,287 @@
+#include "bench.hpp"
+
+#include <engine/voxel/chunkMap.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using engine::voxel::BlockId;
+using engine::voxel::Chunk;
+using engine::voxel::ChunkHandle;
+using engine::voxel::ChunkMap;
+
+namespace {
+
+/// A loaded area around the player, 48 x 8 x 48 chunks.
+constexpr glm::ivec3 WORLD_MIN{-24, -4, -24};
+constexpr glm::ivec3 WORLD_MAX{23, 3, 23};
+
+/// Fills each chunk with a block derived from its position, so lookups can
+/// be checked against the chunk they return.
+auto blockFor(glm::ivec3 position) -> BlockId {
+  const auto hash = (static_cast<uint32_t>(position.x) * 73856093u) ^
+                    (static_cast<uint32_t>(position.y) * 19349663u) ^
+                    (static_cast<uint32_t>(position.z) * 83492791u);
+  return static_cast<BlockId>(1 + hash % 1000);
+}
+
+auto worldPositions() -> std::vector<glm::ivec3> {
+  std::vector<glm::ivec3> positions;
+  for (int z = WORLD_MIN.z; z <= WORLD_MAX.z; ++z) {
+    for (int y = WORLD_MIN.y; y <= WORLD_MAX.y; ++y) {
+      for (int x = WORLD_MIN.x; x <= WORLD_MAX.x; ++x) {
+        positions.emplace_back(x, y, z);
+      }
+    }
+  }
+  return positions;
+}
+
+auto randomPosition(bench::Rng &rng, int spread) -> glm::ivec3 {
+  auto axis = [&]() {
+    return static_cast<int>(rng.below(static_cast<uint32_t>(spread * 2))) -
+           spread;
+  };
+  return {axis(), axis(), axis()};
+}
+
+auto holds(const ChunkMap &map, ChunkHandle handle, glm::ivec3 position)
+    -> bool {
+  const auto *chunk = map.get(handle);
+  return chunk != nullptr && map.position(handle) == position &&
+         chunk->get(0, 0, 0) == blockFor(position);
+}
+
+/// Random inserts and erases mirrored in a `std::unordered_map`. Every
+/// handle has to keep resolving to its chunk while it lives and stop
+/// resolving once erased, and the neighbour links have to match lookups.
+auto checkChurn() -> bool {
+  ChunkMap map;
+  std::unordered_map<uint64_t, ChunkHandle> reference;
+  std::vector<ChunkHandle> erased;
+  bench::Rng rng(7);
+
+  for (uint32_t step = 0; step < 200000; ++step) {
+    const auto position = randomPosition(rng, 12);
+    const auto key = ChunkMap::pack(position);
+    if (rng.below(100) < 60) {
+      const auto handle = map.insert(position, Chunk(blockFor(position)));
+      const auto [it, inserted] = reference.try_emplace(key, handle);
+      if (!inserted && it->second != handle) {
+        return false;
+      }
+    } else {
+      const bool wasThere = map.erase(position);
+      const auto it = reference.find(key);
+      if (wasThere != (it != reference.end())) {
+        return false;
+      }
+      if (it != reference.end()) {
+        erased.push_back(it->second);
+        reference.erase(it);
+      }
+    }
+  }
+
+  if (map.size() != reference.size()) {
+    return false;
+  }
+  for (const auto &[key, handle] : reference) {
+    const auto position = ChunkMap::unpack(key);
+    if (map.find(position) != handle || !holds(map, handle, position)) {
+      return false;
+    }
+
+    const auto links = map.neighbours(handle);
+    for (int dz = -1; dz <= 1; ++dz) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          const auto found = map.find(position + glm::ivec3(dx, dy, dz));
+          if (links[ChunkMap::neighbourIndex(dx, dy, dz)] != found ||
+              map.neighbour(handle, dx, dy, dz) != found) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+
+  // Slots get reused, so only the generation tells these apart.
+  return std::ranges::none_of(erased, [&](const ChunkHandle &handle) {
+    return map.get(handle) != nullptr;
+  });
+}
+
+/// Radius iteration has to visit exactly the chunks a brute force distance
+/// test finds, whichever strategy it picks.
+auto checkRadius(ChunkMap &map) -> bool {
+  bench::Rng rng(11);
+  const auto size = static_cast<float>(engine::voxel::CHUNK_SIZE);
+
+  for (uint32_t i = 0; i < 200; ++i) {
+    const glm::vec3 center{static_cast<float>(rng.below(2000)) - 1000.0f,
+                           static_cast<float>(rng.below(400)) - 200.0f,
+                           static_cast<float>(rng.below(2000)) - 1000.0f};
+    const auto radius = static_cast<float>(rng.below(1200));
+
+    uint32_t expected = 0;
+    map.forEach([&](ChunkHandle, glm::ivec3 position, Chunk &) {
+      const auto lo = glm::vec3(position) * size;
+      const auto offset = glm::clamp(center, lo, lo + size) - center;
+      if (glm::dot(offset, offset) < radius * radius) {
+        ++expected;
+      }
+    });
+
+    uint32_t visited = 0;
+    bool correct = true;
+    map.forEachInRadius(center, radius,
+                        [&](ChunkHandle handle, glm::ivec3 position,
+                            Chunk &chunk) {
+                          ++visited;
+                          correct = correct &&
+                                    chunk.get(0, 0, 0) == blockFor(position) &&
+                                    map.position(handle) == position;
+                        });
+    if (!correct || visited != expected) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+auto main() -> int {
+  const auto positions = worldPositions();
+
+  ChunkMap map;
+  std::unordered_map<uint64_t, Chunk> stdMap;
+  std::vector<ChunkHandle> handles;
+  for (const auto &position : positions) {
+    handles.push_back(map.insert(position, Chunk(blockFor(position))));
+    stdMap.emplace(ChunkMap::pack(position), Chunk(blockFor(position)));
+  }
+
+  bool allOk = true;
+  bench::check("churn, handles and neighbour links", checkChurn(), allOk);
+  bench::check("radius iteration", checkRadius(map), allOk);
+  if (!allOk) {
+    return 1;
+  }
+  std::printf("%-40s %u chunks, %u bricks in %u buckets\n", "world",
+              map.size(), map.brickCount(), map.capacity());
+
+  // Lookups spread past the world edge so about a third of them miss.
+  constexpr uint32_t LOOKUPS = 1 << 20;
+  std::vector<glm::ivec3> lookups;
+  bench::Rng rng;
+  for (uint32_t i = 0; i < LOOKUPS; ++i) {
+    lookups.push_back(randomPosition(rng, 28));
+  }
+
+  const auto findMap = bench::run([&]() -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &position : lookups) {
+      if (const auto *chunk = map.get(map.find(position))) {
+        sum += chunk->getIndex(0);
+      }
+    }
+    bench::doNotOptimize(sum);
+    return LOOKUPS;
+  });
+  bench::report("find, ChunkMap", findMap);
+
+  const auto findStd = bench::run([&]() -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &position : lookups) {
+      if (auto it = stdMap.find(ChunkMap::pack(position)); it != stdMap.end()) {
+        sum += it->second.getIndex(0);
+      }
+    }
+    bench::doNotOptimize(sum);
+    return LOOKUPS;
+  });
+  bench::report("find, std::unordered_map", findStd);
+
+  // All 26 neighbours of every chunk, as meshing and lighting gather them.
+  auto sumLinked = [&]() -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &handle : handles) {
+      for (const auto &neighbour : map.neighbours(handle)) {
+        if (neighbour.valid()) {
+          sum += map.get(neighbour)->getIndex(0);
+        }
+      }
+    }
+    bench::doNotOptimize(sum);
+    return handles.size();
+  };
+  const auto linked = bench::run(sumLinked);
+  bench::report("26 neighbours, ChunkMap links", linked);
+
+  auto sumProbed = [&]() -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &position : positions) {
+      for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+          for (int dx = -1; dx <= 1; ++dx) {
+            const auto *chunk =
+                map.get(map.find(position + glm::ivec3(dx, dy, dz)));
+            if (chunk != nullptr) {
+              sum += chunk->getIndex(0);
+            }
+          }
+        }
+      }
+    }
+    bench::doNotOptimize(sum);
+    return positions.size();
+  };
+  bench::report("26 neighbours, ChunkMap probes", bench::run(sumProbed));
+
+  auto sumStd = [&]() -> uint64_t {
+    uint64_t sum = 0;
+    for (const auto &position : positions) {
+      for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+          for (int dx = -1; dx <= 1; ++dx) {
+            const auto it = stdMap.find(
+                ChunkMap::pack(position + glm::ivec3(dx, dy, dz)));
+            if (it != stdMap.end()) {
+              sum += it->second.getIndex(0);
+            }
+          }
+        }
+      }
+    }
+    bench::doNotOptimize(sum);
+    return positions.size();
+  };
+  const auto probedStd = bench::run(sumStd);
+  bench::report("26 neighbours, std::unordered_map", probedStd);
+
+  // A render distance of 8 chunks around the origin.
+  constexpr float RADIUS = 8.0f * engine::voxel::CHUNK_SIZE;
+  const auto result = bench::run([&]() -> uint64_t {
+    uint64_t visited = 0;
+    for (uint32_t i = 0; i < 64; ++i) {
+      map.forEachInRadius(glm::vec3(static_cast<float>(i)), RADIUS,
+                          [&](ChunkHandle, glm::ivec3, Chunk &) {
+                            ++visited;
+                          });
+    }
+    bench::doNotOptimize(visited);
+    return 64;
+  });
+  bench::report("radius 8 chunks, per query", result);
+
+  // What the map is for: lookups no slower than the container it replaces,
+  // and neighbours faster than looking them up in it.
+  bench::check("find as fast as std::unordered_map",
+               findMap.nsPerOp() <= findStd.nsPerOp(), allOk);
+  bench::check("links faster than std::unordered_map",
+               linked.nsPerOp() < probedStd.nsPerOp(), allOk);
+  return allOk ? 0 : 1;
+}
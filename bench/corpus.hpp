@@ -0,0 +1,108 @@
+#pragma once
+
+#include "bench.hpp"
+
+#include <engine/voxel/chunk.hpp>
+
+#include <array>
+#include <cmath>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace bench {
+
+struct CorpusChunk {
+  std::string_view name;
+  engine::voxel::Chunk chunk;
+};
+
+/// FNV-1a over every block of `chunks` in order, to compare chunks that went
+/// different ways to get here.
+inline auto hashChunks(std::span<const engine::voxel::Chunk> chunks) noexcept
+    -> uint64_t {
+  std::array<engine::voxel::BlockId, engine::voxel::CHUNK_VOLUME> blocks;
+  uint64_t hash = 0xCBF29CE484222325ull;
+  for (const auto &chunk : chunks) {
+    chunk.unpack(blocks);
+    for (auto block : blocks) {
+      hash = (hash ^ block) * 0x100000001B3ull;
+    }
+  }
+  return hash;
+}
+
+/// Deterministic set of chunks covering the cases meshing cares about: empty
+/// and full chunks, smooth terrain, noisy terrain and the checkerboard worst
+/// case where nothing can be merged.
+inline auto chunkCorpus() -> std::vector<CorpusChunk> {
+  using engine::voxel::BlockId;
+  using engine::voxel::Chunk;
+  using engine::voxel::CHUNK_SIZE;
+
+  constexpr BlockId STONE = 1;
+  constexpr BlockId DIRT = 2;
+  constexpr BlockId GRASS = 3;
+
+  std::vector<CorpusChunk> corpus;
+  corpus.push_back({.name = "empty", .chunk = Chunk()});
+  corpus.push_back({.name = "full", .chunk = Chunk(STONE)});
+
+  Chunk hills;
+  for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+    for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+      const auto height = static_cast<uint32_t>(
+          14.0 + 6.0 * std::sin(x * 0.2) * std::cos(z * 0.15));
+      for (uint32_t y = 0; y < height; ++y) {
+        BlockId block = y + 1 == height ? GRASS : y + 4 >= height ? DIRT : STONE;
+        hills.set(x, y, z, block);
+      }
+    }
+  }
+  corpus.push_back({.name = "hills", .chunk = hills});
+
+  Chunk sphere;
+  for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        const auto dx = static_cast<int>(x) - 16;
+        const auto dy = static_cast<int>(y) - 16;
+        const auto dz = static_cast<int>(z) - 16;
+        if (dx * dx + dy * dy + dz * dz < 14 * 14) {
+          sphere.set(x, y, z, STONE);
+        }
+      }
+    }
+  }
+  corpus.push_back({.name = "sphere", .chunk = sphere});
+
+  Rng rng(1234);
+  Chunk noisy;
+  for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        const auto roll = rng.below(8);
+        if (roll < 3) {
+          noisy.set(x, y, z, static_cast<BlockId>(1 + roll));
+        }
+      }
+    }
+  }
+  corpus.push_back({.name = "random", .chunk = noisy});
+
+  Chunk checker;
+  for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        if (((x + y + z) & 1) == 0) {
+          checker.set(x, y, z, STONE);
+        }
+      }
+    }
+  }
+  corpus.push_back({.name = "checkerboard", .chunk = checker});
+
+  return corpus;
+}
+
+} // namespace bench
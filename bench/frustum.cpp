@@ -0,0 +1,112 @@
+#include "bench.hpp"
+
+#include <engine/frustum.hpp>
+#include <engine/voxel/chunk.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <array>
+#include <vector>
+
+using engine::Frustum;
+
+namespace {
+
+constexpr float CHUNK = static_cast<float>(engine::voxel::CHUNK_SIZE);
+/// Chunks per axis around the camera, roughly a 32 chunk view distance.
+constexpr int RADIUS_XZ = 32;
+constexpr int RADIUS_Y = 8;
+
+struct Box {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+auto chunkBoxes() -> std::vector<Box> {
+  std::vector<Box> boxes;
+  for (int y = -RADIUS_Y; y < RADIUS_Y; ++y) {
+    for (int z = -RADIUS_XZ; z < RADIUS_XZ; ++z) {
+      for (int x = -RADIUS_XZ; x < RADIUS_XZ; ++x) {
+        const glm::vec3 min = glm::vec3(x, y, z) * CHUNK;
+        boxes.push_back(Box{.min = min, .max = min + CHUNK});
+      }
+    }
+  }
+  return boxes;
+}
+
+auto viewProjection(const glm::vec3 &forward) -> glm::mat4 {
+  const glm::vec3 eye(5.0f, 20.0f, -3.0f);
+  return glm::perspectiveRH_ZO(glm::radians(90.0f), 16.0f / 9.0f, 0.1f,
+                               CHUNK * RADIUS_XZ) *
+         glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+/// The test may keep boxes that are outside, but must never drop one with a
+/// point inside the clip volume. Samples a grid of points in each box.
+auto countFalseNegatives(const Frustum &frustum, const glm::mat4 &matrix,
+                         const std::vector<Box> &boxes) -> uint32_t {
+  constexpr int SAMPLES = 4;
+
+  uint32_t falseNegatives = 0;
+  for (const auto &box : boxes) {
+    if (frustum.intersects(box.min, box.max)) {
+      continue;
+    }
+
+    bool inside = false;
+    for (int i = 0; i <= SAMPLES && !inside; ++i) {
+      for (int j = 0; j <= SAMPLES && !inside; ++j) {
+        for (int k = 0; k <= SAMPLES && !inside; ++k) {
+          const auto t = glm::vec3(i, j, k) / static_cast<float>(SAMPLES);
+          const auto clip =
+              matrix * glm::vec4(box.min + (box.max - box.min) * t, 1.0f);
+          inside = clip.w > 0.0f && glm::abs(clip.x) < clip.w &&
+                   glm::abs(clip.y) < clip.w && clip.z > 0.0f &&
+                   clip.z < clip.w;
+        }
+      }
+    }
+    falseNegatives += inside ? 1 : 0;
+  }
+  return falseNegatives;
+}
+
+} // namespace
+
+auto main() -> int {
+  const auto boxes = chunkBoxes();
+  const std::array<glm::vec3, 3> directions = {
+      glm::vec3(0.0f, 0.0f, -1.0f),
+      glm::normalize(glm::vec3(1.0f, -0.5f, 0.3f)),
+      glm::normalize(glm::vec3(-0.2f, 0.9f, 0.1f))};
+
+  bool ok = true;
+  for (const auto &direction : directions) {
+    const auto matrix = viewProjection(direction);
+    const Frustum frustum(matrix);
+
+    const auto falseNegatives = countFalseNegatives(frustum, matrix, boxes);
+    ok = ok && falseNegatives == 0;
+
+    uint32_t visible = 0;
+    auto result = bench::run([&]() -> uint64_t {
+      visible = 0;
+      for (const auto &box : boxes) {
+        visible += frustum.intersects(box.min, box.max) ? 1 : 0;
+      }
+      bench::doNotOptimize(visible);
+      return boxes.size();
+    });
+
+    std::array<char, 64> name{};
+    std::snprintf(name.data(), name.size(), "cpu cull (%.1f, %.1f, %.1f)",
+                  direction.x, direction.y, direction.z);
+    bench::report(name.data(), result);
+    std::printf("%-40s %u of %zu chunks kept, %u wrongly culled\n", "",
+                visible, boxes.size(), falseNegatives);
+  }
+
+  std::printf("%-40s %s\n", "conservative", ok ? "ok" : "FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <engine/jobs.hpp>
+#include <engine/voxel/mesher.hpp>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+using engine::JobCounter;
+using engine::JobSystem;
+
+namespace {
+
+/// Runs three stages that each depend on the previous one and checks every
+/// stage saw the whole of the one before it.
+auto checkDependencies(JobSystem &jobs) -> bool {
+  constexpr uint32_t COUNT = 4096;
+  std::vector<uint32_t> first(COUNT, 0);
+  std::vector<uint32_t> second(COUNT, 0);
+  std::atomic<uint32_t> mismatches = 0;
+  std::atomic<uint64_t> total = 0;
+
+  JobCounter firstDone;
+  JobCounter secondDone;
+  JobCounter thirdDone;
+
+  jobs.parallelFor(
+      COUNT, 64,
+      [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+          first[i] = i + 1;
+        }
+      },
+      firstDone);
+
+  jobs.parallelFor(
+      COUNT, 64,
+      [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+          if (first[i] != i + 1) {
+            ++mismatches;
+          }
+          second[i] = first[i] * 2;
+        }
+      },
+      secondDone, &firstDone);
+
+  jobs.submit(
+      [&]() {
+        uint64_t sum = 0;
+        for (auto value : second) {
+          sum += value;
+        }
+        total = sum;
+      },
+      &thirdDone, &secondDone);
+
+  jobs.waitAndHelp(thirdDone);
+
+  const uint64_t expected = uint64_t{COUNT} * (COUNT + 1);
+  return mismatches == 0 && total == expected;
+}
+
+struct NestedResult {
+  bool ok;
+  /// Children that ran on another thread than the job that submitted them.
+  uint32_t stolen;
+};
+
+/// Stresses nested submission. Every round starts a tree of jobs that submit
+/// their children from whichever thread runs them, down to leaves that each
+/// add their own index. Half of the parents wait for their children with
+/// `waitAndHelp` before returning, so threads wait inside jobs while others
+/// steal from them. The rest only hold the round's counter open.
+auto checkNested(JobSystem &jobs) -> NestedResult {
+  constexpr uint32_t ROUNDS = 16;
+  constexpr uint32_t ROOTS = 64;
+  constexpr uint32_t FANOUT = 4;
+  constexpr uint32_t DEPTH = 4;
+  constexpr uint64_t LEAVES =
+      uint64_t{ROOTS} * FANOUT * FANOUT * FANOUT * FANOUT;
+  static_assert(DEPTH == 4, "LEAVES assumes four levels below the roots");
+
+  NestedResult result{.ok = true, .stolen = 0};
+  for (uint32_t round = 0; round < ROUNDS; ++round) {
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<uint64_t> leaves = 0;
+    std::atomic<uint32_t> stolen = 0;
+    JobCounter done;
+
+    std::function<void(uint32_t, uint64_t)> run;
+    run = [&](uint32_t depth, uint64_t id) {
+      if (depth == DEPTH) {
+        sum.fetch_add(id, std::memory_order_relaxed);
+        leaves.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      const bool waits = (id & 1) == 0;
+      JobCounter children;
+      const auto parent = std::this_thread::get_id();
+      for (uint32_t i = 0; i < FANOUT; ++i) {
+        jobs.submit(
+            [&, depth, parent, child = id * FANOUT + i]() {
+              if (std::this_thread::get_id() != parent) {
+                stolen.fetch_add(1, std::memory_order_relaxed);
+              }
+              run(depth + 1, child);
+            },
+            waits ? &children : &done);
+      }
+      if (waits) {
+        jobs.waitAndHelp(children);
+      }
+    };
+
+    for (uint32_t root = 0; root < ROOTS; ++root) {
+      jobs.submit([&, root]() { run(0, root); }, &done);
+    }
+    jobs.waitAndHelp(done);
+
+    result.ok = result.ok && leaves == LEAVES &&
+                sum == LEAVES * (LEAVES - 1) / 2;
+    result.stolen += stolen;
+  }
+  return result;
+}
+
+} // namespace
+
+auto main() -> int {
+  constexpr uint32_t CHUNKS_PER_RUN = 512;
+
+  auto corpus = bench::chunkCorpus();
+  std::vector<const engine::voxel::Chunk *> chunks;
+  for (const auto &entry : corpus) {
+    if (entry.name == "hills" || entry.name == "sphere") {
+      chunks.push_back(&entry.chunk);
+    }
+  }
+
+  const auto maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::vector<uint32_t> threadCounts;
+  for (uint32_t threads = 1; threads < maxThreads; threads *= 2) {
+    threadCounts.push_back(threads);
+  }
+  threadCounts.push_back(maxThreads);
+  std::vector<size_t> quadCounts(CHUNKS_PER_RUN, 0);
+
+  std::printf("%-8s %14s %12s %10s %8s %8s %8s\n", "threads", "chunks/s",
+              "us/chunk", "speedup", "deps", "nested", "stolen");
+  double baseline = 0.0;
+  for (auto threads : threadCounts) {
+    // The main thread helps, so it counts as one of the threads.
+    JobSystem jobs(threads - 1);
+    const bool depsOk = checkDependencies(jobs);
+    const auto nested = checkNested(jobs);
+
+    auto result = bench::run([&]() -> uint64_t {
+      JobCounter done;
+      jobs.parallelFor(
+          CHUNKS_PER_RUN, 4,
+          [&](uint32_t begin, uint32_t end) {
+            thread_local engine::voxel::Mesher mesher;
+            thread_local std::vector<engine::voxel::Quad> quads;
+            for (uint32_t i = begin; i < end; ++i) {
+              quads.clear();
+              mesher.mesh(*chunks[i % chunks.size()], {}, quads);
+              quadCounts[i] = quads.size();
+            }
+          },
+          done);
+      jobs.waitAndHelp(done);
+      return CHUNKS_PER_RUN;
+    });
+
+    if (threads == 1) {
+      baseline = result.opsPerSecond();
+    }
+    std::printf("%-8u %14.0f %12.2f %9.2fx %8s %8s %8u\n", threads,
+                result.opsPerSecond(), result.nsPerOp() / 1000.0,
+                result.opsPerSecond() / baseline, depsOk ? "ok" : "FAILED",
+                nested.ok ? "ok" : "FAILED", nested.stolen);
+    if (!depsOk || !nested.ok) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,271 @@
+#include "bench.hpp"
+#include "world.hpp"
+
+#include <engine/voxel/chunkMap.hpp>
+#include <engine/voxel/light.hpp>
+#include <engine/voxel/terrain.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+using engine::voxel::AIR;
+using engine::voxel::Chunk;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::CHUNK_VOLUME;
+using engine::voxel::ChunkMap;
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::ColumnLight;
+using engine::voxel::Lighting;
+using engine::voxel::STITCHES_PER_UPDATE;
+namespace blocks = engine::voxel::blocks;
+
+namespace {
+
+constexpr int32_t SEED = 1337;
+constexpr int32_t RADIUS = 2;
+/// Torches go on the surface of the columns this far from the middle one,
+/// so their light never reaches past the columns generated.
+constexpr int32_t TORCH_RADIUS = 1;
+constexpr uint32_t TORCHES = 512;
+/// Longest the main thread may spend relighting in one update, a quarter of
+/// a 60 Hz frame. It takes a single edit or the columns `World` stitches in.
+constexpr double LIGHT_BUDGET_US = 4000.0;
+/// Times the budget checks take each step, see `worstOfBest`.
+constexpr uint32_t TIMING_RUNS = 3;
+
+auto seconds(std::chrono::steady_clock::time_point start) -> double {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/// The columns generated, a disc rather than the whole square.
+auto columns(const ChunkMap &chunks) -> std::vector<glm::ivec2> {
+  std::vector<glm::ivec2> out;
+  for (int32_t z = -RADIUS; z <= RADIUS; ++z) {
+    for (int32_t x = -RADIUS; x <= RADIUS; ++x) {
+      if (chunks.find(glm::ivec3(x, 0, z)).valid()) {
+        out.emplace_back(x, z);
+      }
+    }
+  }
+  return out;
+}
+
+auto columnChunks(const ChunkMap &chunks, glm::ivec2 column)
+    -> std::array<Chunk, COLUMN_CHUNKS> {
+  std::array<Chunk, COLUMN_CHUNKS> out;
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    out[y] = *chunks.get(chunks.find(glm::ivec3(column.x, y, column.y)));
+  }
+  return out;
+}
+
+struct Relit {
+  Lighting lighting;
+  double lightSeconds = 0.0;
+  double insertSeconds = 0.0;
+  double worstInsertUs = 0.0;
+  /// Of each column, in the order `columns` returns them.
+  std::vector<double> insertUs;
+  uint64_t insertVisited = 0;
+};
+
+/// Lights every column from scratch, as loading them would.
+auto relight(const ChunkMap &chunks) -> Relit {
+  Relit relit;
+  std::vector<std::pair<glm::ivec2, ColumnLight>> lit;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto column : columns(chunks)) {
+    const auto own = columnChunks(chunks, column);
+    lit.emplace_back(column, Lighting::lightColumn(own));
+  }
+  relit.lightSeconds = seconds(start);
+
+  start = std::chrono::steady_clock::now();
+  for (auto &[column, light] : lit) {
+    const auto insertStart = std::chrono::steady_clock::now();
+    relit.lighting.insertColumn(chunks, column, std::move(light));
+    relit.insertUs.push_back(seconds(insertStart) * 1e6);
+    relit.worstInsertUs = std::max(relit.worstInsertUs, relit.insertUs.back());
+    relit.insertVisited += relit.lighting.visited();
+  }
+  relit.insertSeconds = seconds(start);
+  std::vector<glm::ivec3> changed;
+  relit.lighting.takeChanged(changed);
+  return relit;
+}
+
+auto sameLight(const ChunkMap &chunks, const Lighting &a, const Lighting &b)
+    -> bool {
+  for (const auto column : columns(chunks)) {
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      const glm::ivec3 chunk(column.x, y, column.y);
+      const auto *la = a.get(chunk);
+      const auto *lb = b.get(chunk);
+      if (la == nullptr || lb == nullptr) {
+        return false;
+      }
+      for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+        if (la->get(i) != lb->get(i)) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+struct Storm {
+  double seconds = 0.0;
+  double worstEditUs = 0.0;
+  /// Of each edit, in order.
+  std::vector<double> editUs;
+  uint64_t visited = 0;
+  uint64_t mostVisited = 0;
+  uint64_t changed = 0;
+};
+
+/// Sets each of `positions` to `block` in turn, relighting after each.
+auto storm(ChunkMap &chunks, Lighting &lighting,
+           const std::vector<glm::ivec3> &positions,
+           engine::voxel::BlockId block) -> Storm {
+  Storm result;
+  std::vector<glm::ivec3> changed;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto position : positions) {
+    const auto editStart = std::chrono::steady_clock::now();
+    chunks.setBlock(position, block);
+    lighting.blockChanged(chunks, position);
+    lighting.takeChanged(changed);
+    result.editUs.push_back(seconds(editStart) * 1e6);
+    result.worstEditUs = std::max(result.worstEditUs, result.editUs.back());
+    result.visited += lighting.visited();
+    result.mostVisited = std::max(result.mostVisited, lighting.visited());
+    result.changed += changed.size();
+    changed.clear();
+  }
+  result.seconds = seconds(start);
+  return result;
+}
+
+/// The worst of the times in `runs`, each of which times the same steps,
+/// after taking each step's best over the runs. A stall of the machine in
+/// one run then does not count against the step.
+auto worstOfBest(const std::vector<std::vector<double>> &runs) -> double {
+  auto best = runs.front();
+  for (const auto &run : runs) {
+    for (size_t i = 0; i < best.size(); ++i) {
+      best[i] = std::min(best[i], run[i]);
+    }
+  }
+  return *std::ranges::max_element(best);
+}
+
+void report(const char *name, const Storm &storm) {
+  std::printf("%-26s %12.0f %12.1f %12.0f %12llu %12.1f\n", name,
+              static_cast<double>(TORCHES) / storm.seconds,
+              static_cast<double>(storm.visited) / TORCHES,
+              storm.worstEditUs,
+              static_cast<unsigned long long>(storm.mostVisited),
+              static_cast<double>(storm.changed) / TORCHES);
+}
+
+} // namespace
+
+auto main() -> int {
+  bool allOk = true;
+  auto chunks =
+      bench::generateWorld(SEED, static_cast<uint32_t>(RADIUS));
+  const auto columnCount = static_cast<double>(columns(chunks).size());
+
+  auto initial = relight(chunks);
+  std::printf("light a column:  %10.1f us\n",
+              initial.lightSeconds * 1e6 / columnCount);
+  std::printf("insert a column: %10.1f us, %.0f blocks visited, "
+              "worst %.1f us\n",
+              initial.insertSeconds * 1e6 / columnCount,
+              static_cast<double>(initial.insertVisited) / columnCount,
+              initial.worstInsertUs);
+  std::printf("light memory:    %10.1f KiB\n",
+              static_cast<double>(initial.lighting.memoryUsage()) / 1024.0);
+
+  // Torches on the surface, stacking where they land on one another.
+  bench::Rng rng;
+  std::vector<glm::ivec3> torches;
+  constexpr auto SPAN =
+      static_cast<uint32_t>(2 * TORCH_RADIUS + 1) * CHUNK_SIZE;
+  constexpr auto FIRST = -TORCH_RADIUS * static_cast<int32_t>(CHUNK_SIZE);
+  auto lighting = initial.lighting;
+  {
+    auto probe = chunks;
+    for (uint32_t i = 0; i < TORCHES; ++i) {
+      const glm::ivec2 at(FIRST + static_cast<int32_t>(rng.below(SPAN)),
+                          FIRST + static_cast<int32_t>(rng.below(SPAN)));
+      const glm::ivec3 position(at.x, bench::surface(probe, at) + 1, at.y);
+      probe.setBlock(position, blocks::TORCH);
+      torches.push_back(position);
+    }
+  }
+
+  std::printf("%-26s %12s %12s %12s %12s %12s\n", "storm", "edits/s",
+              "visited/edit", "worst us", "most visited", "changed/edit");
+  const auto placed = storm(chunks, lighting, torches, blocks::TORCH);
+  report("place torches", placed);
+  const auto afterPlacing = relight(chunks);
+  bench::check("placed light matches relighting",
+               sameLight(chunks, lighting, afterPlacing.lighting), allOk);
+  std::vector<std::vector<double>> placedInserts{afterPlacing.insertUs};
+  for (uint32_t run = 1; run < TIMING_RUNS; ++run) {
+    placedInserts.push_back(relight(chunks).insertUs);
+  }
+
+  // Taken away in another order than placed, so light from torches still
+  // standing has to spread back in.
+  auto removals = torches;
+  for (size_t i = removals.size(); i > 1; --i) {
+    std::swap(removals[i - 1], removals[rng.below(static_cast<uint32_t>(i))]);
+  }
+  const auto removed = storm(chunks, lighting, removals, AIR);
+  report("remove torches", removed);
+  bench::check("removed light matches the start",
+               sameLight(chunks, lighting, initial.lighting), allOk);
+
+  // The world is back where it started, so the same steps can be timed
+  // again.
+  std::vector<std::vector<double>> initialInserts{initial.insertUs};
+  std::vector<std::vector<double>> placeEdits{placed.editUs};
+  std::vector<std::vector<double>> removeEdits{removed.editUs};
+  for (uint32_t run = 1; run < TIMING_RUNS; ++run) {
+    initialInserts.push_back(relight(chunks).insertUs);
+    placeEdits.push_back(
+        storm(chunks, lighting, torches, blocks::TORCH).editUs);
+    removeEdits.push_back(storm(chunks, lighting, removals, AIR).editUs);
+  }
+
+  // A torch's light reaches 13 blocks, a few thousand blocks around it. An
+  // edit that visits a whole chunk has spread past what it changed.
+  bench::check("edits stay local",
+               std::max(placed.mostVisited, removed.mostVisited) < CHUNK_VOLUME,
+               allOk);
+  const auto fullEditUs =
+      (afterPlacing.lightSeconds + afterPlacing.insertSeconds) * 1e6 /
+      columnCount;
+  std::printf("relighting a column instead: %.1f us an edit\n", fullEditUs);
+
+  // Stitching and edits run on the main thread, between frames.
+  bench::check("stitching fits the light budget",
+               STITCHES_PER_UPDATE * std::max(worstOfBest(initialInserts),
+                                              worstOfBest(placedInserts)) <
+                   LIGHT_BUDGET_US,
+               allOk);
+  bench::check("an edit fits the light budget",
+               std::max(worstOfBest(placeEdits), worstOfBest(removeEdits)) <
+                   LIGHT_BUDGET_US,
+               allOk);
+  return allOk ? 0 : 1;
+}
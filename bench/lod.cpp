@@ -0,0 +1,403 @@
+#include "bench.hpp"
+
+#include <engine/jobs.hpp>
+#include <engine/voxel/lod.hpp>
+#include <engine/voxel/mesher.hpp>
+#include <engine/voxel/terrain.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+using engine::JobSystem;
+using engine::voxel::AIR;
+using engine::voxel::BlockId;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::CHUNK_VOLUME;
+using engine::voxel::Chunk;
+using engine::voxel::ChunkNeighbours;
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::COLUMN_HEIGHT;
+using engine::voxel::ColumnSummary;
+using engine::voxel::Face;
+using engine::voxel::LodTile;
+using engine::voxel::LodTree;
+using engine::voxel::Mesher;
+using engine::voxel::Quad;
+using engine::voxel::TerrainGenerator;
+
+namespace {
+
+constexpr int32_t SEED = 1337;
+/// Full detail out to `FULL_DISTANCE` columns, against levels of detail
+/// reaching four times as far with full detail out to half of it, the
+/// app's settings scaled down to generate in a few seconds.
+constexpr uint32_t FULL_DISTANCE = 4;
+constexpr LodTree::Settings LOD{.distance = 2, .levels = 3};
+/// The app's settings, for timing the tree.
+constexpr LodTree::Settings APP_LOD{.distance = 6, .levels = 3};
+
+using Column = std::array<Chunk, COLUMN_CHUNKS>;
+using Key = std::pair<int32_t, int32_t>;
+
+auto keyOf(glm::ivec2 column) -> Key { return {column.x, column.y}; }
+
+/// A cell is solid with half its blocks solid, and takes the top-most one.
+auto checkDownsample() -> bool {
+  auto cell = [](std::array<BlockId, 8> blocks) {
+    std::array<BlockId, 1> out{};
+    engine::voxel::downsample(blocks, glm::uvec3(2), out);
+    return out[0];
+  };
+  constexpr BlockId STONE = engine::voxel::blocks::STONE;
+  constexpr BlockId GRASS = engine::voxel::blocks::GRASS;
+  // Index is (y * 2 + z) * 2 + x, the bottom layer first.
+  return cell({STONE, STONE, STONE, AIR, AIR, AIR, AIR, AIR}) == AIR &&
+         cell({STONE, STONE, STONE, STONE, AIR, AIR, AIR, AIR}) == STONE &&
+         cell({STONE, STONE, STONE, AIR, AIR, GRASS, AIR, AIR}) == GRASS &&
+         cell({AIR, AIR, AIR, AIR, GRASS, GRASS, GRASS, GRASS}) == GRASS;
+}
+
+/// Columns the tiles picked cover, and how many tiles cover each.
+auto coverage(const LodTree &tree) -> std::map<Key, uint32_t> {
+  std::map<Key, uint32_t> covered;
+  for (const auto &tile : tree.tiles()) {
+    const auto first = tile.firstColumn();
+    for (int32_t z = 0; z < tile.size(); ++z) {
+      for (int32_t x = 0; x < tile.size(); ++x) {
+        ++covered[keyOf(first + glm::ivec2(x, z))];
+      }
+    }
+  }
+  return covered;
+}
+
+/// The tiles never overlap, leave no gaps within reach, and are at full
+/// detail within `distance`, give or take the tiles' size.
+auto checkPartition() -> bool {
+  LodTree tree(LOD);
+  for (const auto eye : {glm::vec3(0.0f), glm::vec3(100.0f, 50.0f, -37.0f),
+                         glm::vec3(-1000.5f, 0.0f, 2000.25f)}) {
+    tree.update(eye);
+    const auto covered = coverage(tree);
+    if (std::ranges::any_of(
+            covered, [](const auto &entry) { return entry.second != 1; })) {
+      return false;
+    }
+
+    const auto reach = static_cast<int32_t>(tree.reach());
+    const auto centre = TerrainGenerator::columnAt(eye);
+    for (int32_t dz = -reach; dz <= reach; ++dz) {
+      for (int32_t dx = -reach; dx <= reach; ++dx) {
+        const auto column = centre + glm::ivec2(dx, dz);
+        const LodTile tile{.position = column, .level = 0};
+        const auto distance = LodTree::distance(eye, tile);
+        const auto rootHalf = static_cast<float>(tree.rootSize()) * 0.71f;
+        if (distance < tree.reach() - rootHalf &&
+            !covered.contains(keyOf(column))) {
+          return false;
+        }
+        if (distance < static_cast<float>(LOD.distance) - 0.71f &&
+            std::ranges::find(tree.tiles(), tile) == tree.tiles().end()) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+auto keys(const LodTree &tree) -> std::set<uint64_t> {
+  std::set<uint64_t> result;
+  for (const auto &tile : tree.tiles()) {
+    result.insert(tile.key());
+  }
+  return result;
+}
+
+/// Tiles picked and dropped as the camera wobbles half a column back and
+/// forth, 2.25 and 1.75 columns from the centre of the level 1 tile at (0,
+/// 0), after the first wobble.
+auto wobbleChanges(float hysteresis) -> uint32_t {
+  LodTree tree({.distance = LOD.distance,
+                .levels = LOD.levels,
+                .hysteresis = hysteresis});
+  const glm::vec3 eye(-1.25f * CHUNK_SIZE, 0.0f, 1.0f * CHUNK_SIZE);
+  const glm::vec3 step(0.5f * CHUNK_SIZE, 0.0f, 0.0f);
+  tree.update(eye);
+  tree.update(eye + step);
+  auto previous = keys(tree);
+
+  uint32_t changes = 0;
+  for (uint32_t i = 0; i < 20; ++i) {
+    tree.update(i % 2 == 0 ? eye : eye + step);
+    const auto current = keys(tree);
+    std::vector<uint64_t> difference;
+    std::ranges::set_symmetric_difference(current, previous,
+                                          std::back_inserter(difference));
+    changes += static_cast<uint32_t>(difference.size());
+    previous = current;
+  }
+  return changes;
+}
+
+auto generate(const glm::vec3 &eye, uint32_t radius)
+    -> std::map<Key, Column> {
+  JobSystem jobs;
+  TerrainGenerator generator(jobs, {.seed = SEED});
+  std::map<Key, Column> columns;
+  do {
+    generator.update(eye, radius);
+    generator.wait();
+    for (auto &column : generator.takeFinished()) {
+      columns[keyOf(column.position)] = std::move(column.chunks);
+    }
+  } while (generator.jobsInFlight() != 0);
+  return columns;
+}
+
+/// Level 2 cells straight from the blocks, to check summaries against.
+auto checkSummary(const Column &column) -> bool {
+  constexpr uint32_t HALF = CHUNK_SIZE / 2;
+  std::vector<BlockId> blocks(static_cast<size_t>(COLUMN_HEIGHT) * CHUNK_SIZE *
+                              CHUNK_SIZE);
+  std::array<BlockId, CHUNK_VOLUME> chunkBlocks;
+  for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+    column[i].unpack(chunkBlocks);
+    std::ranges::copy(chunkBlocks, blocks.begin() + i * CHUNK_VOLUME);
+  }
+  std::vector<BlockId> half(static_cast<size_t>(COLUMN_HEIGHT / 2) * HALF *
+                            HALF);
+  engine::voxel::downsample(blocks,
+                            glm::uvec3(CHUNK_SIZE, COLUMN_HEIGHT, CHUNK_SIZE),
+                            half);
+  std::vector<BlockId> quarter(half.size() / 8);
+  engine::voxel::downsample(half, glm::uvec3(HALF, COLUMN_HEIGHT / 2, HALF),
+                            quarter);
+
+  const ColumnSummary summary(column);
+  constexpr auto SIZE = ColumnSummary::SIZE;
+  for (uint32_t y = 0; y < ColumnSummary::HEIGHT; ++y) {
+    for (uint32_t z = 0; z < SIZE; ++z) {
+      for (uint32_t x = 0; x < SIZE; ++x) {
+        if (summary.get(x, y, z) != quarter[(y * SIZE + z) * SIZE + x]) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+auto isAir(const Chunk &chunk) -> bool {
+  return chunk.isUniform() && chunk.getPalette().front() == AIR;
+}
+
+/// Quads of a full detail column, culled against the columns beside it.
+auto meshColumn(Mesher &mesher, const std::map<Key, Column> &columns,
+                glm::ivec2 position, std::vector<Quad> &quads) -> uint64_t {
+  const auto &column = columns.at(keyOf(position));
+  const auto &negX = columns.at(keyOf(position + glm::ivec2(-1, 0)));
+  const auto &posX = columns.at(keyOf(position + glm::ivec2(1, 0)));
+  const auto &negZ = columns.at(keyOf(position + glm::ivec2(0, -1)));
+  const auto &posZ = columns.at(keyOf(position + glm::ivec2(0, 1)));
+
+  uint64_t total = 0;
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    if (isAir(column[y])) {
+      continue;
+    }
+    ChunkNeighbours neighbours;
+    const auto at = [](Face face) { return static_cast<size_t>(face); };
+    neighbours.chunks[at(Face::NegX)] = &negX[y];
+    neighbours.chunks[at(Face::PosX)] = &posX[y];
+    neighbours.chunks[at(Face::NegZ)] = &negZ[y];
+    neighbours.chunks[at(Face::PosZ)] = &posZ[y];
+    neighbours.chunks[at(Face::NegY)] = y > 0 ? &column[y - 1] : nullptr;
+    neighbours.chunks[at(Face::PosY)] =
+        y + 1 < COLUMN_CHUNKS ? &column[y + 1] : nullptr;
+    quads.clear();
+    (void)mesher.mesh(column[y], neighbours, quads);
+    total += quads.size();
+  }
+  return total;
+}
+
+/// Quads of a coarser tile, meshed as the world does.
+auto meshCoarse(Mesher &mesher, const std::map<Key, Column> &columns,
+                const std::map<Key, ColumnSummary> &summaries,
+                const LodTile &tile, std::vector<Quad> &quads) -> uint64_t {
+  const auto first = tile.firstColumn();
+  std::array<Column, 4> full;
+  std::vector<const ColumnSummary *> summarised;
+  for (int32_t z = 0; z < tile.size(); ++z) {
+    for (int32_t x = 0; x < tile.size(); ++x) {
+      const auto key = keyOf(first + glm::ivec2(x, z));
+      if (tile.level == 1) {
+        full[static_cast<size_t>(z * 2 + x)] = columns.at(key);
+      } else {
+        summarised.push_back(&summaries.at(key));
+      }
+    }
+  }
+
+  std::array<Chunk, COLUMN_CHUNKS> nodes;
+  for (uint32_t i = 0; i < tile.meshCount(); ++i) {
+    nodes[i] = tile.level == 1
+                   ? engine::voxel::coarseNode(full, i)
+                   : engine::voxel::coarseNode(summarised, tile.level, i);
+  }
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < tile.meshCount(); ++i) {
+    if (isAir(nodes[i])) {
+      continue;
+    }
+    ChunkNeighbours neighbours;
+    neighbours.chunks[static_cast<size_t>(Face::NegY)] =
+        i > 0 ? &nodes[i - 1] : nullptr;
+    neighbours.chunks[static_cast<size_t>(Face::PosY)] =
+        i + 1 < tile.meshCount() ? &nodes[i + 1] : nullptr;
+    quads.clear();
+    (void)mesher.mesh(nodes[i], neighbours, quads);
+    total += quads.size();
+  }
+  return total;
+}
+
+} // namespace
+
+auto main() -> int {
+  bool allOk = true;
+  bench::check("downsample keeps majority, top-most", checkDownsample(), allOk);
+  bench::check("tiles partition the view", checkPartition(), allOk);
+  const auto steady = wobbleChanges(0.25f);
+  const auto thrashing = wobbleChanges(0.0f);
+  bench::check("hysteresis stops thrashing", steady == 0 && thrashing != 0,
+               allOk);
+
+  // Every column either way needs, full detail ones with their sides.
+  const glm::vec3 eye(0.5f * CHUNK_SIZE, 100.0f, 0.5f * CHUNK_SIZE);
+  LodTree tree(LOD);
+  tree.update(eye);
+  float radius = static_cast<float>(FULL_DISTANCE) + 1.5f;
+  for (const auto &tile : tree.tiles()) {
+    const auto first = tile.firstColumn();
+    for (int32_t z = -1; z <= tile.size(); ++z) {
+      for (int32_t x = -1; x <= tile.size(); ++x) {
+        radius = std::max(radius, TerrainGenerator::distance(
+                                      eye, first + glm::ivec2(x, z)));
+      }
+    }
+  }
+  const auto columns =
+      generate(eye, static_cast<uint32_t>(std::ceil(radius)));
+
+  bench::check("summaries match downsampled blocks",
+               checkSummary(columns.at({0, 0})) &&
+                   checkSummary(columns.at({3, -2})),
+               allOk);
+  if (!allOk) {
+    return 1;
+  }
+
+  std::map<Key, ColumnSummary> summaries;
+  for (const auto &[key, column] : columns) {
+    summaries.emplace(key, ColumnSummary(column));
+  }
+
+  // Quads drawn at full detail out to `FULL_DISTANCE`, as the world used to
+  // draw, against the tiles reaching four times as far.
+  Mesher mesher;
+  std::vector<Quad> quads;
+  uint64_t fullQuads = 0;
+  uint32_t fullColumns = 0;
+  const auto reach = static_cast<int32_t>(FULL_DISTANCE);
+  for (int32_t z = -reach; z <= reach; ++z) {
+    for (int32_t x = -reach; x <= reach; ++x) {
+      const glm::ivec2 column(x, z);
+      if (TerrainGenerator::distance(eye, column) <=
+          static_cast<float>(FULL_DISTANCE)) {
+        fullQuads += meshColumn(mesher, columns, column, quads);
+        ++fullColumns;
+      }
+    }
+  }
+
+  std::array<uint64_t, engine::voxel::LOD_LEVELS> lodQuads{};
+  std::array<uint32_t, engine::voxel::LOD_LEVELS> lodTiles{};
+  for (const auto &tile : tree.tiles()) {
+    lodQuads[tile.level] +=
+        tile.level == 0
+            ? meshColumn(mesher, columns, tile.firstColumn(), quads)
+            : meshCoarse(mesher, columns, summaries, tile, quads);
+    ++lodTiles[tile.level];
+  }
+  uint64_t lodTotal = 0;
+  for (const auto count : lodQuads) {
+    lodTotal += count;
+  }
+  bench::check("4x reach within full detail quads", lodTotal <= fullQuads,
+               allOk);
+
+  std::printf("%-40s %12llu quads, %u columns, reach %u\n", "full detail",
+              static_cast<unsigned long long>(fullQuads), fullColumns,
+              FULL_DISTANCE);
+  for (uint32_t level = 0; level <= LOD.levels; ++level) {
+    std::printf("  level %u %31s %12llu quads, %u tiles\n", level, "",
+                static_cast<unsigned long long>(lodQuads[level]),
+                lodTiles[level]);
+  }
+  std::printf("%-40s %12llu quads, reach %.0f, %.2fx the quads\n",
+              "levels of detail", static_cast<unsigned long long>(lodTotal),
+              static_cast<double>(tree.reach()),
+              static_cast<double>(lodTotal) / static_cast<double>(fullQuads));
+
+  // Timings.
+  std::vector<const Column *> sample;
+  for (const auto &[_, column] : columns) {
+    if (sample.size() == 64) {
+      break;
+    }
+    sample.push_back(&column);
+  }
+  {
+    std::array<BlockId, CHUNK_VOLUME> blocks;
+    std::vector<BlockId> half(CHUNK_VOLUME / 8);
+    bench::report("downsample, per chunk", bench::run([&]() -> uint64_t {
+                    for (const auto *column : sample) {
+                      (*column)[2].unpack(blocks);
+                      engine::voxel::downsample(blocks, glm::uvec3(CHUNK_SIZE),
+                                                half);
+                      bench::doNotOptimize(half[0]);
+                    }
+                    return sample.size();
+                  }));
+  }
+  bench::report("summary, per column", bench::run([&]() -> uint64_t {
+                  for (const auto *column : sample) {
+                    const ColumnSummary summary(*column);
+                    bench::doNotOptimize(summary);
+                  }
+                  return sample.size();
+                }));
+  {
+    LodTree appTree(APP_LOD);
+    float x = 0.0f;
+    bench::report("tree update, reach 48", bench::run([&]() -> uint64_t {
+                    for (uint32_t i = 0; i < 100; ++i) {
+                      x += 1.0f;
+                      appTree.update(glm::vec3(x, 0.0f, 0.0f));
+                      bench::doNotOptimize(appTree.tiles().size());
+                    }
+                    return 100;
+                  }));
+  }
+
+  return allOk ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+#include "corpus.hpp"
+
+#include <engine/voxel/mesher.hpp>
+
+#include <string>
+
+using engine::voxel::AIR;
+using engine::voxel::BlockId;
+using engine::voxel::Chunk;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::CHUNK_VOLUME;
+using engine::voxel::ChunkNeighbours;
+using engine::voxel::FACE_COUNT;
+using engine::voxel::FaceCounts;
+using engine::voxel::Mesher;
+using engine::voxel::Quad;
+
+namespace {
+
+/// Whether each face's quads are contiguous, in `Face` order and as many as
+/// counted.
+auto groupedByFace(const std::vector<Quad> &quads,
+                   const FaceCounts &counts) noexcept -> bool {
+  size_t index = 0;
+  for (uint32_t face = 0; face < engine::voxel::FACE_COUNT; ++face) {
+    for (uint32_t i = 0; i < counts[face]; ++i, ++index) {
+      if (index >= quads.size() ||
+          static_cast<uint32_t>(quads[index].face()) != face) {
+        return false;
+      }
+    }
+  }
+  return index == quads.size();
+}
+
+/// The block at (`x`, `y`, `z`) in blocks from `chunk`'s minimum corner,
+/// which may be one outside it along a single axis, in a neighbour.
+auto blockAt(const Chunk &chunk, const ChunkNeighbours &neighbours, int32_t x,
+             int32_t y, int32_t z) noexcept -> BlockId {
+  const std::array<int32_t, 3> p{x, y, z};
+  for (uint32_t axis = 0; axis < 3; ++axis) {
+    if (p[axis] >= 0 && p[axis] < static_cast<int32_t>(CHUNK_SIZE)) {
+      continue;
+    }
+    const auto face = axis * 2 + (p[axis] < 0 ? 1 : 0);
+    const auto *neighbour = neighbours.chunks[face];
+    if (neighbour == nullptr) {
+      return AIR;
+    }
+    const auto wrap = [](int32_t c) {
+      return static_cast<uint32_t>(c) & (CHUNK_SIZE - 1);
+    };
+    return neighbour->get(wrap(x), wrap(y), wrap(z));
+  }
+  return chunk.get(static_cast<uint32_t>(x), static_cast<uint32_t>(y),
+                   static_cast<uint32_t>(z));
+}
+
+/// Index of the face of a block facing `face`, for a per face table.
+constexpr auto faceIndex(std::array<uint32_t, 3> p, uint32_t face) noexcept
+    -> uint32_t {
+  return Chunk::index(p[0], p[1], p[2]) * FACE_COUNT + face;
+}
+
+/// Whether `quads` cover every visible block face exactly once, with the
+/// block it belongs to, and nothing else. Visible faces are found the naive
+/// way, one block at a time, against the blocks past the chunk's borders.
+auto coversVisibleFaces(const Chunk &chunk, const ChunkNeighbours &neighbours,
+                        const std::vector<Quad> &quads) -> bool {
+  constexpr std::array<std::array<int32_t, 3>, FACE_COUNT> STEPS = {{
+      {1, 0, 0},
+      {-1, 0, 0},
+      {0, 1, 0},
+      {0, -1, 0},
+      {0, 0, 1},
+      {0, 0, -1},
+  }};
+
+  std::vector<BlockId> expected(CHUNK_VOLUME * FACE_COUNT, AIR);
+  for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        const auto block = chunk.get(x, y, z);
+        if (block == AIR) {
+          continue;
+        }
+        for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+          const auto &step = STEPS[face];
+          if (blockAt(chunk, neighbours, static_cast<int32_t>(x) + step[0],
+                      static_cast<int32_t>(y) + step[1],
+                      static_cast<int32_t>(z) + step[2]) == AIR) {
+            expected[faceIndex({x, y, z}, face)] = block;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<BlockId> covered(CHUNK_VOLUME * FACE_COUNT, AIR);
+  for (const auto &quad : quads) {
+    const auto face = static_cast<uint32_t>(quad.face());
+    const auto axis = engine::voxel::faceAxis(quad.face());
+    const auto uAxis = (axis + 1) % 3;
+    const auto vAxis = (axis + 2) % 3;
+    const auto position = quad.position();
+    if (position[uAxis] + quad.width() > CHUNK_SIZE ||
+        position[vAxis] + quad.height() > CHUNK_SIZE) {
+      return false;
+    }
+    for (uint32_t u = 0; u < quad.width(); ++u) {
+      for (uint32_t v = 0; v < quad.height(); ++v) {
+        std::array<uint32_t, 3> p{position[0], position[1], position[2]};
+        p[uAxis] += u;
+        p[vAxis] += v;
+        auto &cover = covered[faceIndex(p, face)];
+        if (cover != AIR || quad.block() == AIR) {
+          return false;
+        }
+        cover = quad.block();
+      }
+    }
+  }
+  return covered == expected;
+}
+
+} // namespace
+
+auto main() -> int {
+  constexpr uint32_t CHUNKS_PER_RUN = 64;
+
+  auto corpus = bench::chunkCorpus();
+  Mesher mesher;
+  std::vector<Quad> quads;
+  quads.reserve(1 << 16);
+
+  bool grouped = true;
+  std::printf("%-14s %10s %8s %14s %16s\n", "chunk", "quads", "facing",
+              "us/chunk", "chunks/s");
+  for (const auto &entry : corpus) {
+    quads.clear();
+    const auto counts = mesher.mesh(entry.chunk, ChunkNeighbours{}, quads);
+    const auto quadCount = quads.size();
+    grouped = grouped && groupedByFace(quads, counts);
+
+    // Share a camera past the chunk's positive corner draws, only the
+    // positive faces can face it.
+    const auto facing = counts[0] + counts[2] + counts[4];
+    const auto facingShare =
+        quadCount == 0 ? 0.0
+                       : static_cast<double>(facing) /
+                             static_cast<double>(quadCount);
+
+    auto result = bench::run([&]() -> uint64_t {
+      for (uint32_t i = 0; i < CHUNKS_PER_RUN; ++i) {
+        quads.clear();
+        mesher.mesh(entry.chunk, ChunkNeighbours{}, quads);
+        bench::doNotOptimize(quads.data());
+      }
+      return CHUNKS_PER_RUN;
+    });
+
+    std::printf("%-14.*s %10zu %7.0f%% %14.2f %16.0f\n",
+                static_cast<int>(entry.name.size()), entry.name.data(),
+                quadCount, facingShare * 100.0, result.nsPerOp() / 1000.0,
+                result.opsPerSecond());
+  }
+
+  bool allOk = true;
+  bench::check("quads grouped by face", grouped, allOk);
+
+  // Every chunk alone, buried in full chunks, and bordering the other
+  // chunks so its borders meet partly solid layers.
+  const Chunk full(1);
+  for (size_t i = 0; i < corpus.size(); ++i) {
+    const auto &entry = corpus[i];
+    // Alone, buried and mixed.
+    std::array<ChunkNeighbours, 3> setups{};
+    for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+      setups[1].chunks[face] = &full;
+      setups[2].chunks[face] = &corpus[(i + face + 1) % corpus.size()].chunk;
+    }
+
+    bool covers = true;
+    for (const auto &neighbours : setups) {
+      quads.clear();
+      mesher.mesh(entry.chunk, neighbours, quads);
+      covers = covers && coversVisibleFaces(entry.chunk, neighbours, quads);
+    }
+    const auto name = std::string(entry.name) + " covers visible faces";
+    bench::check(name.c_str(), covers, allOk);
+  }
+
+  return allOk ? 0 : 1;
+}
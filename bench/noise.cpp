@@ -0,0 +1,174 @@
+#include "bench.hpp"
+
+#include <engine/noise.hpp>
+#include <engine/voxel/chunk.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using engine::noise::Basis;
+using engine::noise::Fractal;
+using engine::noise::Isa;
+using engine::noise::Noise;
+using engine::noise::Warp;
+using engine::voxel::CHUNK_SIZE;
+
+namespace {
+
+constexpr Isa ISAS[] = {Isa::Scalar, Isa::Sse41, Isa::Avx2};
+
+/// A column of four chunks, the unit world generation works in.
+constexpr glm::uvec3 COLUMN{CHUNK_SIZE, CHUNK_SIZE * 4, CHUNK_SIZE};
+
+auto fractal(Basis basis) -> Fractal {
+  return Fractal{.basis = basis,
+                 .seed = 1337,
+                 .frequency = 1.0f / 96.0f,
+                 .octaves = 4,
+                 .lacunarity = 2.0f,
+                 .gain = 0.5f};
+}
+
+auto warped(Basis basis) -> Warp {
+  auto warpFractal = fractal(basis);
+  warpFractal.seed = 42;
+  warpFractal.octaves = 2;
+  return Warp{.amplitude = 24.0f, .fractal = warpFractal};
+}
+
+auto sameBits(const std::vector<float> &a, const std::vector<float> &b)
+    -> bool {
+  return a.size() == b.size() &&
+         std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+/// Every instruction set has to produce exactly the scalar output, for odd
+/// sizes that leave a partial register, negative coordinates and warping.
+/// Single samples have to match the grids too.
+auto checkBitExact(Isa isa, Basis basis, bool warp) -> bool {
+  const auto warping = warp ? warped(basis) : Warp{};
+  const Noise reference(fractal(basis), warping, Isa::Scalar);
+  const Noise noise(fractal(basis), warping, isa);
+  bench::Rng rng(3);
+
+  for (uint32_t i = 0; i < 16; ++i) {
+    const glm::vec3 origin{static_cast<float>(rng.below(20000)) - 10000.0f,
+                           static_cast<float>(rng.below(2000)) - 1000.0f,
+                           static_cast<float>(rng.below(20000)) - 10000.0f};
+    const float step = 0.25f + static_cast<float>(rng.below(8)) * 0.5f;
+    const glm::uvec3 size{1 + rng.below(40), 1 + rng.below(12),
+                          1 + rng.below(40)};
+
+    std::vector<float> expected(size.x * size.y * size.z);
+    std::vector<float> actual(expected.size());
+    reference.grid(origin, size, step, expected);
+    noise.grid(origin, size, step, actual);
+    if (!sameBits(expected, actual)) {
+      return false;
+    }
+
+    const glm::vec2 origin2{origin.x, origin.z};
+    const glm::uvec2 size2{size.x, size.z};
+    expected.resize(size2.x * size2.y);
+    actual.resize(expected.size());
+    reference.grid(origin2, size2, step, expected);
+    noise.grid(origin2, size2, step, actual);
+    if (!sameBits(expected, actual)) {
+      return false;
+    }
+
+    const glm::vec2 last2 =
+        origin2 + glm::vec2(static_cast<float>(size2.x - 1) * step,
+                            static_cast<float>(size2.y - 1) * step);
+    const float sample = noise.sample(last2);
+    if (std::memcmp(&sample, &expected.back(), sizeof(float)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+auto main() -> int {
+  bool allOk = true;
+  for (auto isa : ISAS) {
+    if (!engine::noise::isSupported(isa)) {
+      std::printf("%-40s %s\n", engine::noise::isaName(isa), "unsupported");
+      continue;
+    }
+    for (auto basis : {Basis::Simplex, Basis::Value}) {
+      for (bool warp : {false, true}) {
+        const bool ok = checkBitExact(isa, basis, warp);
+        allOk = allOk && ok;
+        const auto name = std::string("bit exact, ") +
+                          (basis == Basis::Simplex ? "simplex" : "value") +
+                          (warp ? " warped, " : ", ") +
+                          engine::noise::isaName(isa);
+        std::printf("%-40s %s\n", name.c_str(), ok ? "ok" : "FAILED");
+      }
+    }
+  }
+  if (!allOk) {
+    return 1;
+  }
+
+  // Range over a large area, as a sanity check on the normalisation.
+  {
+    const Noise noise(fractal(Basis::Simplex));
+    std::vector<float> values(256 * 256);
+    noise.grid(glm::vec2(-5000.0f), glm::uvec2(256), 7.0f, values);
+    const auto [lo, hi] = std::ranges::minmax(values);
+    std::printf("%-40s [%.3f, %.3f]\n", "simplex fbm range", lo, hi);
+  }
+  std::printf("%-40s %s\n", "best",
+              engine::noise::isaName(engine::noise::bestIsa()));
+
+  // Throughput in voxels (or columns of a heightmap) per second.
+  std::vector<float> out(COLUMN.x * COLUMN.y * COLUMN.z);
+  for (auto isa : ISAS) {
+    if (!engine::noise::isSupported(isa)) {
+      continue;
+    }
+    const std::string suffix = std::string(", ") + engine::noise::isaName(isa);
+
+    struct Case {
+      const char *name;
+      Basis basis;
+      bool warp;
+    };
+    constexpr Case CASES[] = {{"simplex 3D", Basis::Simplex, false},
+                              {"simplex 3D warped", Basis::Simplex, true},
+                              {"value 3D", Basis::Value, false}};
+    for (const auto &c : CASES) {
+      const Noise noise(fractal(c.basis), c.warp ? warped(c.basis) : Warp{},
+                        isa);
+      uint32_t column = 0;
+      const auto result = bench::run([&]() -> uint64_t {
+        const glm::vec3 origin(static_cast<float>(column++ * CHUNK_SIZE),
+                               -64.0f, 0.0f);
+        noise.grid(origin, COLUMN, 1.0f, out);
+        bench::doNotOptimize(out.front());
+        return out.size();
+      });
+      bench::report((c.name + suffix).c_str(), result);
+    }
+
+    const Noise heights(fractal(Basis::Simplex), Warp{}, isa);
+    uint32_t column = 0;
+    const auto result = bench::run([&]() -> uint64_t {
+      for (uint32_t i = 0; i < 64; ++i) {
+        const glm::vec2 origin(static_cast<float>(column++ * CHUNK_SIZE),
+                               0.0f);
+        heights.grid(origin, glm::uvec2(CHUNK_SIZE), 1.0f, out);
+        bench::doNotOptimize(out.front());
+      }
+      return 64 * CHUNK_SIZE * CHUNK_SIZE;
+    });
+    bench::report(("simplex 2D heightmap" + suffix).c_str(), result);
+  }
+
+  return 0;
+}
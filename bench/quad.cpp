@@ -0,0 +1,122 @@
+#include "corpus.hpp"
+
+#include <engine/voxel/mesher.hpp>
+
+#include <cstring>
+
+using engine::voxel::ChunkNeighbours;
+using engine::voxel::Mesher;
+using engine::voxel::Quad;
+
+namespace {
+
+/// The vertex layout the mesh pipeline used before quads were packed, kept
+/// here only to compare against.
+struct LegacyVertex {
+  std::array<float, 3> position;
+  float uvX;
+  std::array<float, 3> normal;
+  float uvY;
+  std::array<float, 4> color;
+};
+static_assert(sizeof(LegacyVertex) == 48);
+
+constexpr std::array<std::array<float, 3>, engine::voxel::FACE_COUNT>
+    FACE_NORMALS = {{{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1},
+                     {0, 0, -1}}};
+
+constexpr std::array<std::array<uint32_t, 6>, 2> CORNERS = {
+    {{0, 1, 2, 0, 2, 3}, {0, 2, 1, 0, 3, 2}}};
+
+/// Expands quads the way the old CPU path did, six vertices per quad.
+void expand(const std::vector<Quad> &quads, std::vector<LegacyVertex> &out) {
+  out.clear();
+  for (const auto &quad : quads) {
+    const auto face = quad.face();
+    const auto axis = engine::voxel::faceAxis(face);
+    const auto position = quad.position();
+    const auto w = static_cast<float>(quad.width());
+    const auto h = static_cast<float>(quad.height());
+    const float shade = (quad.ao() & 1) != 0 ? 0.65f : 1.0f;
+
+    for (auto corner : CORNERS[engine::voxel::isPositive(face) ? 0 : 1]) {
+      const float u = corner == 1 || corner == 2 ? w : 0.0f;
+      const float v = corner >= 2 ? h : 0.0f;
+
+      LegacyVertex vertex{};
+      for (uint32_t i = 0; i < 3; ++i) {
+        vertex.position[i] = static_cast<float>(position[i]);
+      }
+      if (engine::voxel::isPositive(face)) {
+        vertex.position[axis] += 1.0f;
+      }
+      vertex.position[(axis + 1) % 3] += u;
+      vertex.position[(axis + 2) % 3] += v;
+      vertex.uvX = u;
+      vertex.uvY = v;
+      vertex.normal = FACE_NORMALS[static_cast<size_t>(face)];
+      vertex.color = {shade, shade, shade, 1.0f};
+      out.push_back(vertex);
+    }
+  }
+}
+
+} // namespace
+
+auto main() -> int {
+  constexpr uint32_t CHUNKS_PER_RUN = 64;
+
+  auto corpus = bench::chunkCorpus();
+  Mesher mesher;
+  std::vector<Quad> quads;
+  std::vector<LegacyVertex> vertices;
+  // Stands in for a mapped staging buffer.
+  std::vector<std::byte> upload;
+
+  std::printf("%-14s %10s %12s %12s %8s %14s %14s\n", "chunk", "quads",
+              "legacy KiB", "packed KiB", "ratio", "legacy us", "packed us");
+  for (const auto &entry : corpus) {
+    quads.clear();
+    mesher.mesh(entry.chunk, ChunkNeighbours{}, quads);
+    if (quads.empty()) {
+      continue;
+    }
+    expand(quads, vertices);
+
+    const auto legacyBytes = vertices.size() * sizeof(LegacyVertex);
+    const auto packedBytes = quads.size() * sizeof(Quad);
+    upload.resize(legacyBytes);
+
+    // Both sides pay for meshing, the legacy side also expands and copies
+    // six 48 byte vertices per 8 byte quad.
+    auto legacy = bench::run([&]() -> uint64_t {
+      for (uint32_t i = 0; i < CHUNKS_PER_RUN; ++i) {
+        quads.clear();
+        mesher.mesh(entry.chunk, ChunkNeighbours{}, quads);
+        expand(quads, vertices);
+        std::memcpy(upload.data(), vertices.data(), legacyBytes);
+        bench::doNotOptimize(upload.data());
+      }
+      return CHUNKS_PER_RUN;
+    });
+
+    auto packed = bench::run([&]() -> uint64_t {
+      for (uint32_t i = 0; i < CHUNKS_PER_RUN; ++i) {
+        quads.clear();
+        mesher.mesh(entry.chunk, ChunkNeighbours{}, quads);
+        std::memcpy(upload.data(), quads.data(), packedBytes);
+        bench::doNotOptimize(upload.data());
+      }
+      return CHUNKS_PER_RUN;
+    });
+
+    const double ratio =
+        static_cast<double>(legacyBytes) / static_cast<double>(packedBytes);
+    std::printf("%-14.*s %10zu %12.1f %12.1f %7.1fx %14.2f %14.2f\n",
+                static_cast<int>(entry.name.size()), entry.name.data(),
+                quads.size(), static_cast<double>(legacyBytes) / 1024.0,
+                static_cast<double>(packedBytes) / 1024.0, ratio,
+                legacy.nsPerOp() / 1000.0, packed.nsPerOp() / 1000.0);
+  }
+  return 0;
+}
@@ -0,0 +1,347 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <engine/voxel/region.hpp>
+#include <engine/voxel/terrain.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+using engine::JobSystem;
+using engine::voxel::Chunk;
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::RegionFile;
+using engine::voxel::RegionStore;
+using engine::voxel::TerrainGenerator;
+
+namespace {
+
+constexpr int32_t SEED = 1337;
+constexpr uint32_t RADIUS = 6;
+
+using Hashes = std::map<std::pair<int32_t, int32_t>, uint64_t>;
+using Chunks = std::array<Chunk, COLUMN_CHUNKS>;
+
+/// Runs the generator around the origin until it has nothing left to do.
+auto generate(TerrainGenerator &generator)
+    -> std::vector<TerrainGenerator::Column> {
+  std::vector<TerrainGenerator::Column> columns;
+  do {
+    generator.update(glm::vec3(0.0f), RADIUS);
+    generator.wait();
+    for (auto &column : generator.takeFinished()) {
+      columns.push_back(std::move(column));
+    }
+  } while (generator.jobsInFlight() != 0);
+  return columns;
+}
+
+auto hashes(const std::vector<TerrainGenerator::Column> &columns) -> Hashes {
+  Hashes result;
+  for (const auto &column : columns) {
+    result[{column.position.x, column.position.y}] =
+        bench::hashChunks(column.chunks);
+  }
+  return result;
+}
+
+auto metadataOf(glm::ivec2 position) -> std::vector<std::byte> {
+  std::vector<std::byte> metadata(static_cast<size_t>(position.x & 7) * 3);
+  for (size_t i = 0; i < metadata.size(); ++i) {
+    metadata[i] = static_cast<std::byte>(i + static_cast<size_t>(position.y));
+  }
+  return metadata;
+}
+
+/// Everything saved and committed comes back the same after reopening.
+auto checkRoundtrip(const std::filesystem::path &directory,
+                    const std::vector<TerrainGenerator::Column> &columns)
+    -> bool {
+  {
+    auto store = RegionStore::open(directory);
+    if (!store) {
+      return false;
+    }
+    for (const auto &column : columns) {
+      if (!store->save(column.position, column.chunks,
+                       metadataOf(column.position))) {
+        return false;
+      }
+    }
+    if (!store->commit()) {
+      return false;
+    }
+  }
+
+  auto store = RegionStore::open(directory);
+  if (!store) {
+    return false;
+  }
+  Chunks chunks;
+  std::vector<std::byte> metadata;
+  for (const auto &column : columns) {
+    const auto loaded = store->load(column.position, chunks, metadata);
+    if (!loaded || !*loaded ||
+        bench::hashChunks(chunks) != bench::hashChunks(column.chunks) ||
+        metadata != metadataOf(column.position)) {
+      return false;
+    }
+  }
+  const auto missing = store->load(glm::ivec2(1000, 1000), chunks, metadata);
+  return missing && !*missing;
+}
+
+/// Saves that were never committed are as good as never made, even with a
+/// torn write left at the end of the file.
+auto checkCrash(const std::filesystem::path &path, const Chunks &first,
+                const Chunks &second) -> bool {
+  RegionFile::Encoded encoded;
+  {
+    auto file = RegionFile::open(path);
+    if (!file) {
+      return false;
+    }
+    RegionFile::encode(first, {}, encoded);
+    if (!file->save(glm::ivec2(0, 0), encoded) || !file->commit()) {
+      return false;
+    }
+    // Never committed, as if the process died here.
+    RegionFile::encode(second, {}, encoded);
+    if (!file->save(glm::ivec2(0, 0), encoded) ||
+        !file->save(glm::ivec2(1, 0), encoded)) {
+      return false;
+    }
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out << "half a column";
+  }
+
+  auto file = RegionFile::open(path);
+  if (!file || file->contains(glm::ivec2(1, 0))) {
+    return false;
+  }
+  Chunks chunks;
+  std::vector<std::byte> metadata;
+  const auto loaded = file->load(glm::ivec2(0, 0), chunks, metadata);
+  if (!loaded || !*loaded ||
+      bench::hashChunks(chunks) != bench::hashChunks(first)) {
+    return false;
+  }
+
+  // What the crash left past the committed column is free for the next
+  // save.
+  RegionFile::encode(second, {}, encoded);
+  if (!file->save(glm::ivec2(1, 0), encoded) || !file->commit()) {
+    return false;
+  }
+  const auto reloaded = file->load(glm::ivec2(1, 0), chunks, metadata);
+  return reloaded && *reloaded &&
+         bench::hashChunks(chunks) == bench::hashChunks(second);
+}
+
+/// A flipped bit in a committed column is reported, not loaded.
+auto checkCorruption(const std::filesystem::path &path, const Chunks &chunks)
+    -> bool {
+  RegionFile::Encoded encoded;
+  {
+    auto file = RegionFile::open(path);
+    if (!file) {
+      return false;
+    }
+    RegionFile::encode(chunks, {}, encoded);
+    if (!file->save(glm::ivec2(3, 4), encoded) || !file->commit()) {
+      return false;
+    }
+  }
+  {
+    std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+    const std::vector<char> bytes(std::istreambuf_iterator<char>(io), {});
+    const auto *column = reinterpret_cast<const char *>(encoded.bytes.data());
+    const auto found = std::ranges::search(
+        bytes, std::span(column, encoded.bytes.size()));
+    if (found.empty()) {
+      return false;
+    }
+    const auto offset = static_cast<std::streamoff>(
+        found.begin() - bytes.begin() +
+        static_cast<ptrdiff_t>(encoded.bytes.size() / 2));
+    // Reading to the end left the stream at end of file.
+    io.clear();
+    io.seekp(offset);
+    io.put(static_cast<char>(bytes[static_cast<size_t>(offset)] ^ 0x10));
+  }
+
+  auto file = RegionFile::open(path);
+  if (!file) {
+    return false;
+  }
+  Chunks loaded;
+  std::vector<std::byte> metadata;
+  return !file->load(glm::ivec2(3, 4), loaded, metadata);
+}
+
+/// Saving the same columns over and over, committing in between, reuses
+/// the space of the copies each commit replaced rather than growing the
+/// file, before and after reopening it.
+auto checkReuse(const std::filesystem::path &path,
+                const std::vector<TerrainGenerator::Column> &columns)
+    -> bool {
+  RegionFile::Encoded encoded;
+  const auto resave = [&](RegionFile &file) {
+    for (const auto &column : columns) {
+      RegionFile::encode(column.chunks, {}, encoded);
+      if (!file.save(RegionStore::localOf(column.position), encoded)) {
+        return false;
+      }
+    }
+    return file.commit().has_value();
+  };
+
+  uintmax_t settled;
+  {
+    auto file = RegionFile::open(path);
+    // The second round cannot go over the first until it is committed.
+    if (!file || !resave(*file) || !resave(*file)) {
+      return false;
+    }
+    settled = std::filesystem::file_size(path);
+    for (uint32_t round = 0; round < 4; ++round) {
+      if (!resave(*file)) {
+        return false;
+      }
+    }
+  }
+  // Reopening finds the free space again from the table alone.
+  auto file = RegionFile::open(path);
+  return file && resave(*file) &&
+         std::filesystem::file_size(path) == settled;
+}
+
+} // namespace
+
+auto main() -> int {
+  const auto root =
+      std::filesystem::temp_directory_path() / "vve_region_bench";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+
+  std::vector<TerrainGenerator::Column> columns;
+  double generateNs;
+  {
+    JobSystem jobs;
+    TerrainGenerator generator(jobs, {.seed = SEED});
+    const auto start = std::chrono::steady_clock::now();
+    columns = generate(generator);
+    generateNs = bench::elapsedNs(start);
+  }
+  const auto reference = hashes(columns);
+  const auto count = static_cast<uint64_t>(columns.size());
+
+  bool allOk = !columns.empty();
+  bench::check("roundtrip", checkRoundtrip(root / "roundtrip", columns), allOk);
+  bench::check("uncommitted saves dropped",
+               checkCrash(root / "crash.region", columns[0].chunks,
+                          columns[1].chunks),
+               allOk);
+  bench::check("corruption detected",
+               checkCorruption(root / "corrupt.region", columns[0].chunks),
+               allOk);
+  bench::check("replaced columns reused",
+               checkReuse(root / "reuse.region", columns), allOk);
+
+  // The generator saves as it goes and loads everything back the next time.
+  double firstNs;
+  double reopenedNs;
+  {
+    JobSystem jobs;
+    {
+      auto store = RegionStore::open(root / "generated");
+      TerrainGenerator generator(jobs, {.seed = SEED, .store = &*store});
+      const auto start = std::chrono::steady_clock::now();
+      const auto first = generate(generator);
+      firstNs = bench::elapsedNs(start);
+      bench::check("generated with a store", hashes(first) == reference, allOk);
+    }
+
+    auto store = RegionStore::open(root / "generated");
+    TerrainGenerator generator(jobs, {.seed = SEED, .store = &*store});
+    const auto start = std::chrono::steady_clock::now();
+    const auto loaded = generate(generator);
+    reopenedNs = bench::elapsedNs(start);
+    bench::check("loaded from the store", hashes(loaded) == reference, allOk);
+  }
+  if (!allOk) {
+    return 1;
+  }
+
+  std::printf("%-40s %12.2f ms\n", "world, generated", generateNs / 1e6);
+  std::printf("%-40s %12.2f ms\n", "world, generated and saved",
+              firstNs / 1e6);
+  std::printf("%-40s %12.2f ms (%.1fx faster)\n", "world, reopened",
+              reopenedNs / 1e6, generateNs / reopenedNs);
+
+  uint64_t rawBytes = 0;
+  uint64_t compressedBytes = 0;
+  {
+    RegionFile::Encoded encoded;
+    for (const auto &column : columns) {
+      RegionFile::encode(column.chunks, {}, encoded);
+      rawBytes += encoded.rawSize;
+      compressedBytes += encoded.bytes.size();
+    }
+  }
+  std::printf("%-40s %12.2f KiB/column, %.1fx compressed\n", "column size",
+              static_cast<double>(rawBytes) / 1024.0 / count,
+              static_cast<double>(rawBytes) / compressedBytes);
+
+  // Single threaded, every column in turn. Nothing is committed between
+  // repeats, so each one goes over the space of the last.
+  {
+    auto store = RegionStore::open(root / "throughput");
+    const auto result = bench::run([&]() -> uint64_t {
+      for (const auto &column : columns) {
+        (void)store->save(column.position, column.chunks, {});
+      }
+      return count;
+    });
+    bench::report("save, per column", result);
+    std::printf("%-40s %12.1f MB/s uncompressed\n", "save",
+                static_cast<double>(rawBytes) / count / result.nsPerOp() *
+                    1e3);
+
+    const auto start = std::chrono::steady_clock::now();
+    (void)store->commit();
+    std::printf("%-40s %12.2f ms\n", "commit", bench::elapsedNs(start) / 1e6);
+  }
+  {
+    auto store = RegionStore::open(root / "throughput");
+    Chunks chunks;
+    std::vector<std::byte> metadata;
+    const auto result = bench::run([&]() -> uint64_t {
+      for (const auto &column : columns) {
+        (void)store->load(column.position, chunks, metadata);
+        bench::doNotOptimize(chunks);
+      }
+      return count;
+    });
+    bench::report("load, per column", result);
+    std::printf("%-40s %12.1f MB/s uncompressed\n", "load",
+                static_cast<double>(rawBytes) / count / result.nsPerOp() *
+                    1e3);
+  }
+
+  std::filesystem::remove_all(root);
+  return 0;
+}
@@ -0,0 +1,219 @@
+#include "bench.hpp"
+#include "world.hpp"
+
+#include <engine/voxel/chunkMap.hpp>
+#include <engine/voxel/mesher.hpp>
+#include <engine/voxel/terrain.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+using engine::voxel::AIR;
+using engine::voxel::BlockId;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::ChunkMap;
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::COLUMN_HEIGHT;
+using engine::voxel::DirtySlices;
+using engine::voxel::Mesher;
+using engine::voxel::Quad;
+using engine::voxel::SliceCounts;
+using engine::voxel::SliceRun;
+
+namespace {
+
+constexpr int32_t SEED = 1337;
+/// Columns generated out to this radius around the one edited, so it and
+/// the columns beside it have all their neighbours.
+constexpr uint32_t RADIUS = 2;
+constexpr uint32_t EDITS = 2048;
+/// Edits a frame while mass editing, each chunk is meshed once a frame.
+constexpr uint32_t EDITS_PER_FRAME = 64;
+constexpr BlockId PLACED = 1;
+constexpr double FRAME_MS = 1000.0 / 60.0;
+
+struct Mesh {
+  std::vector<Quad> quads;
+  SliceCounts slices;
+};
+
+/// Meshes by `ChunkMap::pack` of their position.
+using Meshes = std::map<uint64_t, Mesh>;
+/// Slices to mesh again by `ChunkMap::pack` of the chunk, see `markBlock`.
+using Dirty = std::unordered_map<uint64_t, DirtySlices>;
+
+struct Run {
+  double seconds = 0.0;
+  double worstFrameMs = 0.0;
+  uint64_t chunksMeshed = 0;
+  /// What would be staged for the GPU, the whole mesh or only its slices
+  /// meshed again.
+  uint64_t bytesUploaded = 0;
+};
+
+auto meshAll(const ChunkMap &chunks, Mesher &mesher) -> Meshes {
+  Meshes meshes;
+  for (int32_t z = -1; z <= 1; ++z) {
+    for (int32_t x = -1; x <= 1; ++x) {
+      for (int32_t y = 0; y < static_cast<int32_t>(COLUMN_CHUNKS); ++y) {
+        const glm::ivec3 position(x, y, z);
+        const auto handle = chunks.find(position);
+        auto &mesh = meshes[ChunkMap::pack(position)];
+        mesher.mesh(*chunks.get(handle), chunks.faceNeighbours(handle),
+                    mesh.quads, &mesh.slices);
+      }
+    }
+  }
+  return meshes;
+}
+
+/// Blocks on the surface of the middle column, alternately dug out and
+/// built on, so every edit shows.
+auto editStream() -> std::vector<std::pair<glm::ivec2, bool>> {
+  bench::Rng rng;
+  std::vector<std::pair<glm::ivec2, bool>> edits;
+  for (uint32_t i = 0; i < EDITS; ++i) {
+    edits.emplace_back(glm::ivec2(rng.below(CHUNK_SIZE), rng.below(CHUNK_SIZE)),
+                       (i & 1) != 0);
+  }
+  return edits;
+}
+
+/// Meshes the chunks in `dirty` again, whole or only their dirty slices.
+void remesh(const ChunkMap &chunks, Mesher &mesher, Meshes &meshes,
+            const Dirty &dirty, bool incremental, Run &run) {
+  std::vector<Quad> quads;
+  std::vector<SliceRun> runs;
+  for (const auto &[key, slices] : dirty) {
+    const auto handle = chunks.find(ChunkMap::unpack(key));
+    const auto it = meshes.find(key);
+    if (!handle.valid() || it == meshes.end()) {
+      continue;
+    }
+    auto &mesh = it->second;
+    const auto &chunk = *chunks.get(handle);
+    const auto neighbours = chunks.faceNeighbours(handle);
+    ++run.chunksMeshed;
+    if (!incremental) {
+      mesh.quads.clear();
+      mesher.mesh(chunk, neighbours, mesh.quads, &mesh.slices);
+      run.bytesUploaded += mesh.quads.size() * sizeof(Quad);
+      continue;
+    }
+
+    quads.clear();
+    runs.clear();
+    auto after = mesh.slices;
+    mesher.remesh(chunk, neighbours, slices, quads, after);
+    engine::voxel::sliceRuns(mesh.slices, after, slices, runs);
+    std::vector<Quad> patched(runs.empty()
+                                  ? 0
+                                  : runs.back().target + runs.back().count);
+    for (const auto &part : runs) {
+      const auto &from = part.remeshed ? quads : mesh.quads;
+      std::copy_n(from.begin() + part.source, part.count,
+                  patched.begin() + part.target);
+      if (part.remeshed) {
+        run.bytesUploaded += part.count * sizeof(Quad);
+      }
+    }
+    mesh.quads = std::move(patched);
+    mesh.slices = after;
+  }
+}
+
+auto edit(ChunkMap chunks, Meshes meshes, uint32_t editsPerFrame,
+          bool incremental, bool &matches) -> Run {
+  Mesher mesher;
+  const auto edits = editStream();
+  Dirty dirty;
+  Run run;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t first = 0; first < edits.size(); first += editsPerFrame) {
+    const auto frameStart = std::chrono::steady_clock::now();
+    const auto end = std::min(edits.size(), first + editsPerFrame);
+    for (auto i = first; i < end; ++i) {
+      const auto [at, build] = edits[i];
+      const auto top = bench::surface(chunks, at);
+      const glm::ivec3 block(at.x, build ? top + 1 : top, at.y);
+      if (block.y < 0 || block.y >= static_cast<int32_t>(COLUMN_HEIGHT) ||
+          !chunks.setBlock(block, build ? PLACED : AIR)) {
+        continue;
+      }
+      engine::voxel::markBlock(block, dirty);
+    }
+    remesh(chunks, mesher, meshes, dirty, incremental, run);
+    dirty.clear();
+    run.worstFrameMs =
+        std::max(run.worstFrameMs,
+                 std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - frameStart)
+                     .count());
+  }
+  run.seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+
+  // Every mesh patched has to be what meshing it whole gives.
+  matches = true;
+  const auto fresh = meshAll(chunks, mesher);
+  for (const auto &[key, mesh] : meshes) {
+    const auto &expected = fresh.at(key);
+    matches = matches && mesh.slices == expected.slices &&
+              std::ranges::equal(mesh.quads, expected.quads,
+                                 [](const Quad &a, const Quad &b) {
+                                   return a.lo == b.lo && a.hi == b.hi;
+                                 });
+  }
+  return run;
+}
+
+void report(const char *name, const Run &run) {
+  std::printf("%-26s %12.0f %12.1f %12.2f %12.0f\n", name,
+              static_cast<double>(EDITS) / run.seconds,
+              static_cast<double>(run.chunksMeshed) / EDITS,
+              run.worstFrameMs,
+              static_cast<double>(run.bytesUploaded) / EDITS);
+}
+
+} // namespace
+
+auto main() -> int {
+  bool allOk = true;
+  const auto chunks = bench::generateWorld(SEED, RADIUS);
+  Mesher mesher;
+  const auto meshes = meshAll(chunks, mesher);
+
+  std::printf("%-26s %12s %12s %12s %12s\n", "mode", "edits/s",
+              "chunks/edit", "worst ms", "bytes/edit");
+  bool matches = false;
+  const auto full = edit(chunks, meshes, 1, false, matches);
+  report("full, each edit", full);
+  bench::check("full meshes match", matches, allOk);
+  const auto incremental = edit(chunks, meshes, 1, true, matches);
+  report("incremental, each edit", incremental);
+  bench::check("patched meshes match full meshes", matches, allOk);
+
+  const auto fullMass = edit(chunks, meshes, EDITS_PER_FRAME, false, matches);
+  report("full, mass editing", fullMass);
+  const auto incrementalMass =
+      edit(chunks, meshes, EDITS_PER_FRAME, true, matches);
+  report("incremental, mass editing", incrementalMass);
+  bench::check("patched mass edits match full meshes", matches, allOk);
+
+  std::printf("speedup each edit: %.1fx, mass editing: %.1fx\n",
+              incremental.seconds > 0.0 ? full.seconds / incremental.seconds
+                                        : 0.0,
+              incrementalMass.seconds > 0.0
+                  ? fullMass.seconds / incrementalMass.seconds
+                  : 0.0);
+  bench::check("mass editing fits in a frame",
+               incrementalMass.worstFrameMs < FRAME_MS, allOk);
+  return allOk ? 0 : 1;
+}
@@ -0,0 +1,312 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <engine/voxel/chunkMap.hpp>
+#include <engine/voxel/region.hpp>
+#include <engine/voxel/saver.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+using engine::voxel::AUTOSAVE_COLUMNS;
+using engine::voxel::BackgroundSaver;
+using engine::voxel::BlockId;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::CHUNK_VOLUME;
+using engine::voxel::Chunk;
+using engine::voxel::ChunkMap;
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::RegionStore;
+
+namespace {
+
+/// 36 x 36 columns of 8 chunks, a little over 10k chunks, spread over four
+/// regions.
+constexpr int32_t WORLD_COLUMNS = 36;
+constexpr int32_t WORLD_MIN = -WORLD_COLUMNS / 2;
+/// Blocks edited per frame for the first `EDIT_FRAMES` frames, so the saver
+/// reads snapshots of chunks the main thread is writing.
+constexpr uint32_t EDITS_PER_FRAME = 64;
+constexpr uint32_t EDIT_FRAMES = 30;
+/// Longest the main thread may hold or wait for a lock in one call.
+constexpr double LOCK_BUDGET_NS = 500'000.0;
+/// Longest the main thread may spend saving in one frame, taking the
+/// snapshots included, a sixteenth of a 60 Hz frame.
+constexpr double FRAME_BUDGET_NS = 1'000'000.0;
+
+using Chunks = std::array<Chunk, COLUMN_CHUNKS>;
+
+/// CPU time the calling thread has used. Unlike wall time it leaves out
+/// time the thread spent waiting for a core while others, such as the
+/// saver's, ran.
+auto threadCpuNs() -> double {
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+  FILETIME creation, exit, kernel, user;
+  GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+  auto ticks = [](FILETIME time) {
+    return (static_cast<uint64_t>(time.dwHighDateTime) << 32) |
+           time.dwLowDateTime;
+  };
+  // In 100 ns ticks.
+  return static_cast<double>(ticks(kernel) + ticks(user)) * 100.0;
+#else
+  timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return static_cast<double>(now.tv_sec) * 1e9 +
+         static_cast<double>(now.tv_nsec);
+#endif
+}
+
+/// A handful of chunks to copy the world from: layered ground with random
+/// blocks scattered through it, a few bits per voxel.
+auto templates() -> std::vector<Chunk> {
+  bench::Rng rng;
+  std::vector<Chunk> result(16);
+  std::array<BlockId, CHUNK_VOLUME> blocks;
+  for (auto &chunk : result) {
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+      for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+          blocks[Chunk::index(x, y, z)] =
+              rng.below(16) == 0 ? static_cast<BlockId>(1 + rng.below(12))
+                                 : static_cast<BlockId>(y / 8);
+        }
+      }
+    }
+    chunk.pack(blocks);
+  }
+  return result;
+}
+
+/// Every chunk of the world, sharing its index storage with a template until
+/// written.
+void fill(ChunkMap &map) {
+  const auto sources = templates();
+  bench::Rng rng(7);
+  for (int32_t z = WORLD_MIN; z < WORLD_MIN + WORLD_COLUMNS; ++z) {
+    for (int32_t x = WORLD_MIN; x < WORLD_MIN + WORLD_COLUMNS; ++x) {
+      for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+        const auto handle = map.insert(glm::ivec3(x, y, z),
+                                       sources[rng.below(16)]);
+        map.markDirty(handle);
+      }
+    }
+  }
+}
+
+auto randomBlock(bench::Rng &rng) -> glm::ivec3 {
+  const auto span = static_cast<uint32_t>(WORLD_COLUMNS) * CHUNK_SIZE;
+  return {static_cast<int32_t>(rng.below(span)) +
+                  WORLD_MIN * static_cast<int32_t>(CHUNK_SIZE),
+          static_cast<int32_t>(rng.below(COLUMN_CHUNKS * CHUNK_SIZE)),
+          static_cast<int32_t>(rng.below(span)) +
+                  WORLD_MIN * static_cast<int32_t>(CHUNK_SIZE)};
+}
+
+auto columnOf(const ChunkMap &map, glm::ivec2 column, Chunks &out) -> bool {
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    const auto *chunk =
+        map.get(map.find(glm::ivec3(column.x, y, column.y)));
+    if (chunk == nullptr) {
+      return false;
+    }
+    out[y] = *chunk;
+  }
+  return true;
+}
+
+/// Copies up to `AUTOSAVE_COLUMNS` columns with dirty chunks, cleaning all
+/// their chunks, as the world's autosave does.
+auto snapshot(ChunkMap &map) -> std::vector<BackgroundSaver::Column> {
+  std::vector<glm::ivec2> positions;
+  map.takeDirtyColumns(AUTOSAVE_COLUMNS, positions);
+  std::ranges::sort(positions, [](glm::ivec2 a, glm::ivec2 b) {
+    return a.x != b.x ? a.x < b.x : a.y < b.y;
+  });
+  positions.erase(std::unique(positions.begin(), positions.end()),
+                  positions.end());
+
+  std::vector<BackgroundSaver::Column> columns(positions.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    columns[i].position = positions[i];
+    (void)columnOf(map, positions[i], columns[i].chunks);
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      map.clearDirty(
+          map.find(glm::ivec3(positions[i].x, y, positions[i].y)));
+    }
+  }
+  return columns;
+}
+
+auto percentile(std::vector<double> values, double p) -> double {
+  std::ranges::sort(values);
+  const auto index = static_cast<size_t>(p * (values.size() - 1));
+  return values[index];
+}
+
+/// A snapshot keeps its blocks while the chunk it came from is edited, and
+/// the other way round.
+auto checkSnapshot() -> bool {
+  const auto sources = templates();
+  Chunk chunk = sources[0];
+  const Chunk copy = chunk;
+  const auto before = copy.get(3, 4, 5);
+  chunk.set(3, 4, 5, 100);
+  Chunk other = copy;
+  other.set(6, 7, 8, 200);
+  return copy.get(3, 4, 5) == before && chunk.get(3, 4, 5) == 100 &&
+         copy.get(6, 7, 8) == sources[0].get(6, 7, 8) &&
+         chunk.get(6, 7, 8) == sources[0].get(6, 7, 8) &&
+         other.get(3, 4, 5) == before;
+}
+
+/// The throttle spaces saves out, and a flush does not wait for it.
+auto checkThrottle(const std::filesystem::path &directory) -> bool {
+  const auto sources = templates();
+  auto columns = [&](int32_t count) {
+    std::vector<BackgroundSaver::Column> result(static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i) {
+      result[static_cast<size_t>(i)].position = glm::ivec2(i, 0);
+      result[static_cast<size_t>(i)].chunks.fill(sources[1]);
+    }
+    return result;
+  };
+
+  auto store = RegionStore::open(directory);
+  if (!store) {
+    return false;
+  }
+  BackgroundSaver saver(*store, {.maxColumnsPerSecond = 200});
+
+  // 20 columns at 200 a second take at least 95 ms.
+  auto start = std::chrono::steady_clock::now();
+  const auto ticket = saver.submit(columns(20));
+  while (saver.saved() < ticket) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const bool throttled = bench::elapsedNs(start) >= 90e6;
+
+  // 400 columns would take two seconds.
+  start = std::chrono::steady_clock::now();
+  saver.submit(columns(400));
+  saver.flush();
+  return throttled && bench::elapsedNs(start) < 1.5e9 && saver.backlog() == 0;
+}
+
+} // namespace
+
+auto main() -> int {
+  const auto root = std::filesystem::temp_directory_path() / "vve_saver_bench";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+
+  bool allOk = true;
+  bench::check("snapshots isolated from edits", checkSnapshot(), allOk);
+  bench::check("throttled, flush ignores throttle",
+               checkThrottle(root / "throttle"), allOk);
+
+  ChunkMap map;
+  fill(map);
+  const auto chunkCount = map.dirtyCount();
+
+  // Frames edit a few blocks and hand the autosave's snapshots to the
+  // saver, timing everything the main thread does for saving. The budget
+  // holds the thread's CPU time: with fewer cores than threads, wall time
+  // also counts the saver running on the main thread's core, which is
+  // down to the scheduler rather than the work done here.
+  std::vector<double> frameNs;
+  std::vector<double> frameCpuNs;
+  std::vector<double> submitNs;
+  uint64_t columnsSaved = 0;
+  double saveNs;
+  {
+    auto store = RegionStore::open(root / "world");
+    if (!store) {
+      return 1;
+    }
+    BackgroundSaver saver(*store, {});
+    bench::Rng rng(99);
+    uint64_t ticket = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; map.dirtyCount() != 0 || saver.saved() < ticket;
+         ++frame) {
+      if (frame < EDIT_FRAMES) {
+        for (uint32_t i = 0; i < EDITS_PER_FRAME; ++i) {
+          map.setBlock(randomBlock(rng), static_cast<BlockId>(rng.below(20)));
+        }
+      }
+
+      if (map.dirtyCount() != 0) {
+        const auto frameStart = std::chrono::steady_clock::now();
+        const auto cpuStart = threadCpuNs();
+        auto columns = snapshot(map);
+        columnsSaved += columns.size();
+        const auto submitStart = std::chrono::steady_clock::now();
+        ticket = saver.submit(std::move(columns));
+        submitNs.push_back(bench::elapsedNs(submitStart));
+        frameCpuNs.push_back(threadCpuNs() - cpuStart);
+        frameNs.push_back(bench::elapsedNs(frameStart));
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    saveNs = bench::elapsedNs(start);
+  }
+
+  const auto maxSubmit = *std::ranges::max_element(submitNs);
+  const auto maxFrameCpu = *std::ranges::max_element(frameCpuNs);
+  bench::check("lock held within budget", maxSubmit < LOCK_BUDGET_NS, allOk);
+  bench::check("frames within budget", maxFrameCpu < FRAME_BUDGET_NS,
+               allOk);
+
+  // What is on disk is what the map holds, edits included.
+  {
+    auto store = RegionStore::open(root / "world");
+    bool saved = store.has_value();
+    Chunks loaded;
+    Chunks expected;
+    std::vector<std::byte> metadata;
+    for (int32_t z = WORLD_MIN; saved && z < WORLD_MIN + WORLD_COLUMNS; ++z) {
+      for (int32_t x = WORLD_MIN; saved && x < WORLD_MIN + WORLD_COLUMNS;
+           ++x) {
+        const auto result = store->load(glm::ivec2(x, z), loaded, metadata);
+        saved = result && *result &&
+                columnOf(map, glm::ivec2(x, z), expected) &&
+                bench::hashChunks(loaded) == bench::hashChunks(expected);
+      }
+    }
+    bench::check("everything saved", saved, allOk);
+  }
+  if (!allOk) {
+    return 1;
+  }
+
+  std::printf("%-40s %12u chunks in %zu frames\n", "autosave", chunkCount,
+              frameNs.size());
+  std::printf("%-40s %12.2f us max, %.2f us p99\n", "submit",
+              maxSubmit / 1e3, percentile(submitNs, 0.99) / 1e3);
+  std::printf("%-40s %12.2f us max, %.2f us p99\n", "autosave, per frame",
+              maxFrameCpu / 1e3, percentile(frameCpuNs, 0.99) / 1e3);
+  std::printf("%-40s %12.2f us max, %.2f us p99\n",
+              "autosave, per frame, wall",
+              *std::ranges::max_element(frameNs) / 1e3,
+              percentile(frameNs, 0.99) / 1e3);
+  std::printf("%-40s %12.0f columns/s\n", "saved",
+              static_cast<double>(columnsSaved) * 1e9 / saveNs);
+
+  std::filesystem::remove_all(root);
+  return 0;
+}
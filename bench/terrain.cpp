@@ -0,0 +1,122 @@
+#include "bench.hpp"
+#include "corpus.hpp"
+
+#include <engine/voxel/terrain.hpp>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+
+using engine::JobSystem;
+using engine::noise::Isa;
+using engine::voxel::CHUNK_SIZE;
+using engine::voxel::TerrainGenerator;
+
+namespace {
+
+constexpr int32_t SEED = 1337;
+constexpr uint32_t RADIUS = 4;
+
+using Hashes = std::map<std::pair<int32_t, int32_t>, uint64_t>;
+
+/// Runs the generator around `eye` until it has nothing left to do, adding
+/// the hash of every column it finishes to `hashes`.
+void generate(TerrainGenerator &generator, const glm::vec3 &eye,
+              Hashes &hashes) {
+  do {
+    generator.update(eye, RADIUS);
+    generator.wait();
+    for (const auto &column : generator.takeFinished()) {
+      hashes[{column.position.x, column.position.y}] =
+          bench::hashChunks(column.chunks);
+    }
+  } while (generator.jobsInFlight() != 0);
+}
+
+auto generate(uint32_t workers, Isa isa, uint32_t maxJobs) -> Hashes {
+  JobSystem jobs(workers);
+  TerrainGenerator generator(
+      jobs, {.seed = SEED, .isa = isa, .maxJobs = maxJobs});
+  Hashes hashes;
+  generate(generator, glm::vec3(0.0f), hashes);
+  return hashes;
+}
+
+auto combined(const Hashes &hashes) -> uint64_t {
+  uint64_t hash = 0;
+  for (const auto &[_, column] : hashes) {
+    hash = (hash ^ column) * 0x100000001B3ull;
+  }
+  return hash;
+}
+
+/// Approaching from far away finishes columns in a different order, with
+/// different neighbours loaded at the time. Every column finished both ways
+/// has to come out the same.
+auto checkApproach(const Hashes &reference) -> bool {
+  JobSystem jobs;
+  TerrainGenerator generator(jobs, {.seed = SEED});
+  Hashes hashes;
+  for (float x = 6.0f; x >= 0.0f; x -= 2.0f) {
+    generate(generator, glm::vec3(x * CHUNK_SIZE, 0.0f, 0.0f), hashes);
+  }
+
+  uint32_t shared = 0;
+  for (const auto &[position, hash] : hashes) {
+    const auto it = reference.find(position);
+    if (it != reference.end()) {
+      if (it->second != hash) {
+        return false;
+      }
+      ++shared;
+    }
+  }
+  return shared == reference.size();
+}
+
+} // namespace
+
+auto main() -> int {
+  const auto threads = JobSystem::defaultWorkerCount();
+  const auto reference = generate(0, engine::noise::bestIsa(), 64);
+  std::printf("%-40s %zu columns, %016llx\n", "reference", reference.size(),
+              static_cast<unsigned long long>(combined(reference)));
+
+  bool allOk = !reference.empty();
+  bench::check("1 worker",
+               generate(1, engine::noise::bestIsa(), 0) == reference, allOk);
+  // More workers than cores still interleaves the jobs differently.
+  const auto many = std::max(threads, 4u);
+  bench::check((std::to_string(many) + " workers").c_str(),
+               generate(many, engine::noise::bestIsa(), 0) == reference,
+               allOk);
+  bench::check("1 job in flight",
+               generate(threads, engine::noise::bestIsa(), 1) == reference,
+               allOk);
+  bench::check("scalar noise",
+               generate(threads, Isa::Scalar, 0) == reference, allOk);
+  bench::check("approach from a distance", checkApproach(reference), allOk);
+  if (!allOk) {
+    return 1;
+  }
+
+  // Columns finished per second on every worker, walking in a straight
+  // line so each step needs a fresh edge.
+  {
+    JobSystem jobs;
+    TerrainGenerator generator(jobs, {.seed = SEED});
+    Hashes hashes;
+    float x = 0.0f;
+    const auto result = bench::run([&]() -> uint64_t {
+      const auto before = hashes.size();
+      generate(generator, glm::vec3(x, 0.0f, 0.0f), hashes);
+      x += 4.0f * CHUNK_SIZE;
+      return hashes.size() - before;
+    });
+    bench::report(("columns, " + std::to_string(threads) + " workers").c_str(),
+                  result);
+  }
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+#include "bench.hpp"
+
+#include <engine/timestep.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using engine::FixedTimestep;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint32_t TICK_RATE = 30;
+constexpr uint32_t FRAMES = 1'000'000;
+
+/// Frames at 144 Hz, the common case of at most one tick.
+auto frames() -> uint64_t {
+  FixedTimestep timestep(TICK_RATE);
+  uint64_t ticks = 0;
+  for (uint32_t i = 0; i < FRAMES; ++i) {
+    ticks += timestep.advance(6'944'444ns);
+    bench::doNotOptimize(ticks);
+  }
+  return FRAMES;
+}
+
+} // namespace
+
+auto main() -> int {
+  bool allOk = true;
+
+  bench::report("advance", bench::run(frames));
+
+  // Ten seconds however it is cut into frames.
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int64_t> frameTime(1'000'000, 40'000'000);
+  FixedTimestep jittery(TICK_RATE);
+  FixedTimestep::Duration elapsed{0};
+  bool alphaInRange = true;
+  while (elapsed < 10s) {
+    const auto frame =
+        std::min(FixedTimestep::Duration(frameTime(rng)), 10s - elapsed);
+    elapsed += frame;
+    jittery.advance(frame);
+    const auto alpha = jittery.alpha();
+    alphaInRange = alphaInRange && alpha >= 0.0f && alpha < 1.0f;
+  }
+  bench::check("ticks follow time, not frames",
+               jittery.getTicks() == 10 * TICK_RATE &&
+                   jittery.getDroppedTicks() == 0,
+               allOk);
+  bench::check("alpha stays within a tick", alphaInRange, allOk);
+
+  FixedTimestep fast(TICK_RATE);
+  uint32_t ticked = 0;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    ticked += fast.advance(1ms);
+  }
+  bench::check("fast frames tick at the tick rate", ticked == TICK_RATE, allOk);
+
+  // A two second stall runs a bounded number of ticks and keeps the rest of
+  // the tick it was part way through.
+  FixedTimestep stalled(TICK_RATE);
+  stalled.advance(stalled.getStep() / 2);
+  const auto caughtUp = stalled.advance(2s);
+  bench::check("a stall is clamped",
+               caughtUp == FixedTimestep::DEFAULT_MAX_TICKS, allOk);
+  bench::check("what a stall owes is dropped",
+               stalled.getDroppedTicks() ==
+                   2 * TICK_RATE - FixedTimestep::DEFAULT_MAX_TICKS,
+               allOk);
+  bench::check("a stall keeps the partial tick",
+               stalled.alpha() > 0.49f && stalled.alpha() < 0.51f, allOk);
+  bench::check("the next frame is not slowed", stalled.advance(10ms) == 0,
+               allOk);
+
+  // Locked, real frame times make no difference.
+  FixedTimestep locked(TICK_RATE);
+  locked.lockFrameTime(locked.getStep());
+  bool oneEach = true;
+  for (uint32_t i = 0; i < 100; ++i) {
+    oneEach = oneEach &&
+              locked.advance(FixedTimestep::Duration(frameTime(rng))) == 1;
+  }
+  bench::check("a locked frame time ignores real time", oneEach, allOk);
+
+  return allOk ? 0 : 1;
+}
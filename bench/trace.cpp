@@ -0,0 +1,170 @@
+#include "bench.hpp"
+
+#include <engine/jobs.hpp>
+#include <engine/trace.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using engine::JobCounter;
+using engine::JobSystem;
+namespace trace = engine::trace;
+
+namespace {
+
+constexpr uint32_t ZONES = 1'000'000;
+constexpr uint32_t BATCHES = 4096;
+
+/// Zones nested in a loop, as cheap as a zone can be.
+auto zones() -> uint64_t {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < ZONES; ++i) {
+    EG_ZONE("Zone");
+    sum += i;
+    bench::doNotOptimize(sum);
+  }
+  return ZONES;
+}
+
+auto bare() -> uint64_t {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < ZONES; ++i) {
+    sum += i;
+    bench::doNotOptimize(sum);
+  }
+  return ZONES;
+}
+
+auto total(const std::vector<trace::ZoneTotal> &totals, std::string_view name)
+    -> trace::ZoneTotal {
+  for (const auto &zone : totals) {
+    if (name == zone.name) {
+      return zone;
+    }
+  }
+  return {.name = "", .count = 0, .nanoseconds = 0};
+}
+
+auto count(std::string_view text, std::string_view what) -> uint32_t {
+  uint32_t found = 0;
+  for (auto at = text.find(what); at != std::string_view::npos;
+       at = text.find(what, at + what.size())) {
+    ++found;
+  }
+  return found;
+}
+
+/// Writes what was recorded and reads it back.
+auto capture(const std::filesystem::path &path) -> std::string {
+  trace::stop();
+  if (auto written = trace::write(path); !written) {
+    std::printf("%s\n", written.error().c_str());
+    return {};
+  }
+  std::ifstream file(path);
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+} // namespace
+
+auto main() -> int {
+  if (!EG_TRACING) {
+    std::printf("zones are compiled out, nothing to measure\n");
+    return 0;
+  }
+
+  bool allOk = true;
+  const auto path = std::filesystem::temp_directory_path() / "trace_bench.json";
+
+  bench::report("loop without zones", bench::run(bare));
+  bench::report("zone, not recording", bench::run(zones));
+  trace::start();
+  bench::report("zone, recording", bench::run(zones));
+  trace::stop();
+
+  // Only the newest zones survive on a thread that overflows its ring.
+  trace::start();
+  for (uint32_t i = 0; i < trace::CAPACITY + 100; ++i) {
+    EG_ZONE("Overflow");
+  }
+  const auto overflowed = capture(path);
+  bench::check("ring keeps the newest zones",
+               count(overflowed, "\"Overflow\"") == trace::CAPACITY, allOk);
+
+  {
+    EG_ZONE("Not recording");
+  }
+
+  JobSystem jobs(3);
+
+  // Jobs that wait for each other, so workers run some of them however
+  // quickly the main thread helps.
+  std::atomic<uint32_t> arrived = 0;
+  JobCounter met;
+  trace::start();
+  for (uint32_t i = 0; i < jobs.workerCount(); ++i) {
+    jobs.submit(
+        [&]() {
+          arrived.fetch_add(1);
+          while (arrived.load() < jobs.workerCount()) {
+            std::this_thread::yield();
+          }
+        },
+        &met);
+  }
+  jobs.waitAndHelp(met);
+  const auto named = capture(path);
+
+  JobCounter done;
+  trace::start();
+  jobs.parallelFor(
+      BATCHES * 4, 4,
+      [](uint32_t begin, uint32_t end) {
+        EG_ZONE("Batch");
+        uint64_t sum = 0;
+        for (auto i = begin; i < end; ++i) {
+          sum += i;
+        }
+        bench::doNotOptimize(sum);
+      },
+      done);
+  jobs.waitAndHelp(done);
+  const auto traced = capture(path);
+  std::filesystem::remove(path);
+  const auto totals = trace::totals();
+
+  bench::check("writes trace event JSON",
+               traced.starts_with(
+                       "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[") &&
+                   traced.ends_with("]}\n"),
+               allOk);
+  bench::check("every job is a zone", count(traced, "\"Job\"") == BATCHES,
+               allOk);
+  bench::check("zones nest inside jobs", count(traced, "\"Batch\"") == BATCHES,
+               allOk);
+  bench::check("zones before start are left out",
+               count(traced, "\"Overflow\"") == 0, allOk);
+  bench::check("nothing recorded while stopped",
+               count(traced, "\"Not recording\"") == 0, allOk);
+  const auto jobTotal = total(totals, "Job");
+  const auto batchTotal = total(totals, "Batch");
+  bench::check("totals count every zone",
+               jobTotal.count == BATCHES && batchTotal.count == BATCHES, allOk);
+  bench::check("totals include nested zones",
+               jobTotal.nanoseconds >= batchTotal.nanoseconds &&
+                   batchTotal.nanoseconds > 0,
+               allOk);
+  bench::check("totals leave out older zones",
+               total(totals, "Overflow").count == 0, allOk);
+  bench::check("workers are named", count(named, "\"Worker ") > 0, allOk);
+  return allOk ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <engine/jobs.hpp>
+#include <engine/voxel/chunkMap.hpp>
+#include <engine/voxel/terrain.hpp>
+
+#include <cstdint>
+#include <utility>
+
+namespace bench {
+
+/// Generates every column within `radius` columns of the one at the origin,
+/// seeded with `seed`, and loads their chunks into a map.
+inline auto generateWorld(int32_t seed, uint32_t radius)
+    -> engine::voxel::ChunkMap {
+  using engine::voxel::CHUNK_SIZE;
+  using engine::voxel::COLUMN_CHUNKS;
+
+  engine::JobSystem jobs;
+  engine::voxel::TerrainGenerator generator(jobs, {.seed = seed});
+  const glm::vec3 eye(0.5f * CHUNK_SIZE, 0.0f, 0.5f * CHUNK_SIZE);
+  engine::voxel::ChunkMap chunks;
+  do {
+    generator.update(eye, radius);
+    generator.wait();
+    for (auto &column : generator.takeFinished()) {
+      for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+        chunks.insert(glm::ivec3(column.position.x, y, column.position.y),
+                      std::move(column.chunks[y]));
+      }
+    }
+  } while (generator.jobsInFlight() != 0);
+  return chunks;
+}
+
+/// Height of the topmost block at `at` that is not air, -1 if there is
+/// none.
+inline auto surface(const engine::voxel::ChunkMap &chunks, glm::ivec2 at)
+    -> int32_t {
+  for (auto y = static_cast<int32_t>(engine::voxel::COLUMN_HEIGHT) - 1; y >= 0;
+       --y) {
+    if (chunks.getBlock(glm::ivec3(at.x, y, at.y)) != engine::voxel::AIR) {
+      return y;
+    }
+  }
+  return -1;
+}
+
+} // namespace bench
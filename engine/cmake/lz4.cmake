@@ -0,0 +1,5 @@
+add_subdirectory(vendor/lz4 lz4_cmake)
+
+function(link_lz4 TARGET_NAME ACCESS)
+  target_link_libraries(${TARGET_NAME} ${ACCESS} lz4::lz4)
+endfunction()
@@ -34,7 +34,7 @@ endfunction()
 
 
 function(compile_shader target shader_target link_target)
-  set(MULTIVALUE SOURCES INCLUDES)
+  set(MULTIVALUE SOURCES COMPUTE INCLUDES)
   cmake_parse_arguments(PARSE_ARGV 0 arg "" "" "${MULTIVALUE}")
 
   set(VALID_OUTPUT_TARGETS GLSL SPIRV)
@@ -67,6 +67,19 @@ function(compile_shader target shader_target link_target)
     endif()
   endforeach()
 
+  # Compute shaders have a single `main` entry point.
+  foreach(source ${arg_COMPUTE})
+    set(SOURCE_FILE ${CMAKE_CURRENT_SOURCE_DIR}/${source}.slang)
+
+    if(${shader_target} STREQUAL SPIRV)
+      set(OUT_FILE ${CMAKE_BINARY_DIR}/shaders/${source}.spv)
+    else()
+      set(OUT_FILE ${CMAKE_BINARY_DIR}/shaders/${source}_comp.glsl)
+    endif()
+    _compile_slang_file(SOURCE ${SOURCE_FILE} TARGET ${shader_target} ENTRIES main OUT ${OUT_FILE})
+    set(OUTPUTS ${OUTPUTS} ${OUT_FILE})
+  endforeach()
+
 
   add_custom_target(${target} ALL
     DEPENDS ${OUTPUTS}
@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <expected>
+#include <optional>
 #include <string>
 
 #include "backends/imgui_impl_vulkan.h"
@@ -14,8 +15,12 @@
 #include <engine/image.hpp>
 
 #include "defines.hpp"
+#include "engine/deletion.hpp"
 #include "engine/input.hpp"
+#include "engine/jobs.hpp"
 #include "engine/structs.hpp"
+#include "engine/timestep.hpp"
+#include "engine/trace.hpp"
 #include <vkh/structs.hpp>
 
 #include <vk_mem_alloc.hpp>
@@ -47,8 +52,12 @@ public:
   struct Queues {
     vkh::Queue graphics;
     vkh::Queue present;
+    /// A dedicated transfer family when the device has one, otherwise the
+    /// graphics queue.
+    vkh::Queue transfer;
   };
 
+  /// Resources that live as long as the app, destroyed on shutdown.
   struct ObjectsToDelete {
     std::vector<vkh::AllocatedBuffer> buffers;
     std::vector<vkh::AllocatedImage> images;
@@ -63,10 +72,14 @@ public:
     if (moveGuard.moved())
       return;
 
-    ImGui_ImplVulkan_Shutdown();
+    if (!isHeadless()) {
+      ImGui_ImplVulkan_Shutdown();
+    }
 
     device.waitIdle();
 
+    deletionQueue.flush(allocator, device);
+
     for (auto &buf : toDelete.buffers) {
       buf.destroy(allocator);
     }
@@ -78,7 +91,17 @@ public:
     allocator.destroy();
   }
 
-  void poll() const noexcept { glfwPollEvents(); }
+  void poll() const noexcept {
+    if (!isHeadless()) {
+      glfwPollEvents();
+    }
+  }
+
+  /// Rendering offscreen into `renderImage` alone, with no window,
+  /// swapchain or ImGui.
+  [[nodiscard]] auto isHeadless() const noexcept -> bool {
+    return !swapchain.has_value();
+  }
 
   struct FrameInfo {
     uint32_t frameIndex;
@@ -89,20 +112,39 @@ public:
 
   std::expected<FrameInfo, TickResult> newFrame() noexcept;
 
-  TickResult presentFrame(FrameInfo frameInfo,
-                          std::span<vk::CommandBuffer> cmdBuffers) noexcept;
+  /// Submits `cmdBuffers` and presents, or only submits when headless.
+  /// `waits` are extra semaphores the submission waits on, such as finished
+  /// uploads.
+  TickResult
+  presentFrame(FrameInfo frameInfo, std::span<vk::CommandBuffer> cmdBuffers,
+               std::span<const vk::SemaphoreSubmitInfo> waits = {}) noexcept;
 
+  /// Once a frame, given the seconds since the last, for work that follows
+  /// the frame rate such as looking around.
   virtual TickResult update(float deltaTime) noexcept = 0;
-  virtual TickResult render() noexcept = 0;
+  /// Steps the simulation by `getTimestep().stepSeconds()`, as many times a
+  /// frame as have come due.
+  virtual TickResult tick(float tickSeconds) noexcept = 0;
+  /// `interpolation` is how far the frame is between the last two ticks, in
+  /// [0, 1), to draw the simulation in between them.
+  virtual TickResult render(float interpolation) noexcept = 0;
+
+  [[nodiscard]] auto getTimestep() noexcept -> FixedTimestep & {
+    return timestep;
+  }
 
   void drawImGui(vk::raii::CommandBuffer &cmdBuffer,
                  uint32_t imageIndex) const noexcept;
 
   [[nodiscard]]
   auto shouldClose() const noexcept -> bool {
-    return core.getWindow().shouldClose();
+    return closeRequested ||
+           (!core.isHeadless() && core.getWindow().shouldClose());
   }
 
+  /// Ends `run` after the current frame, the only way out when headless.
+  void requestClose() noexcept { closeRequested = true; }
+
   virtual void onWindowResize(Dimensions dim) noexcept = 0;
 
   auto recreateSwapchain() noexcept -> std::expected<void, std::string>;
@@ -125,6 +167,11 @@ public:
 
   std::expected<SwapchainImageResult, std::string> getNextImage() noexcept;
 
+  /// Counts a new frame once `currentFrame`'s fence has been waited on and
+  /// moves on to the next frame in flight. Returns the frame index to
+  /// record.
+  auto advanceFrame() noexcept -> uint32_t;
+
   void registerBuffer(vkh::AllocatedBuffer buffer) noexcept {
     toDelete.buffers.push_back(buffer);
   }
@@ -133,10 +180,33 @@ public:
     toDelete.images.push_back(image);
   }
 
+  /// Destroys `buffer` once every frame started so far has retired, so it
+  /// can be released while the frame being recorded still uses it.
+  void destroyLater(vkh::AllocatedBuffer buffer) noexcept {
+    deletionQueue.push(frameNumber, buffer);
+  }
+
+  void destroyLater(vkh::AllocatedImage image) noexcept {
+    deletionQueue.push(frameNumber, image,
+                       allocator.getAllocationInfo(image.alloc).size);
+  }
+
+  /// Runs `release` once every frame started so far has retired.
+  void destroyLater(std::function<void()> release,
+                    vk::DeviceSize size = 0) noexcept {
+    deletionQueue.push(frameNumber, std::move(release), size);
+  }
+
+  [[nodiscard]] auto getDeletionQueue() const noexcept
+      -> const DeletionQueue & {
+    return deletionQueue;
+  }
+
 protected:
   MoveGuard moveGuard;
 
   ObjectsToDelete toDelete = {};
+  DeletionQueue deletionQueue;
 
   engine::rendering::Core core;
 
@@ -147,7 +217,8 @@ protected:
 
   Queues queues;
 
-  vkh::Swapchain swapchain;
+  /// Empty when headless.
+  std::optional<vkh::Swapchain> swapchain;
   vkh::AllocatedImage renderImage;
 
   vk::raii::CommandPool commandPool;
@@ -155,6 +226,10 @@ protected:
   std::array<SyncObjects, MAX_FRAMES_IN_FLIGHT> syncObjects;
 
   uint32_t currentFrame = 0;
+  /// Frames started so far, the current frame's number while recording.
+  uint64_t frameNumber = 0;
+  bool closeRequested = false;
+  FixedTimestep timestep{TICK_RATE};
 
   struct OldSwapchain {
     vkh::Swapchain swapchain;
@@ -165,10 +240,14 @@ protected:
 
   ImGuiVkObjects imguiObjects;
 
+  /// Shared by chunk generation and meshing. Held by pointer so the app
+  /// stays movable.
+  std::unique_ptr<JobSystem> jobs = std::make_unique<JobSystem>();
+
   App(engine::rendering::Core &&core, vk::raii::PhysicalDevice &&physicalDevice,
       vk::raii::Device &&device, vma::Allocator allocator, Queues &&queues,
-      vkh::Swapchain &&swapchain, vkh::AllocatedImage &&renderImage,
-      vk::raii::CommandPool &&commandPool,
+      std::optional<vkh::Swapchain> &&swapchain,
+      vkh::AllocatedImage &&renderImage, vk::raii::CommandPool &&commandPool,
       std::array<SyncObjects, MAX_FRAMES_IN_FLIGHT> &&syncObjects,
       ImGuiVkObjects &&imGuiObjects) noexcept
       : core(std::move(core)), physicalDevice(std::move(physicalDevice)),
@@ -185,14 +264,40 @@ protected:
 template <class T>
   requires std::is_base_of_v<App, T>
 void run(T &app) {
-  auto lastFrame = std::chrono::high_resolution_clock::now();
+  trace::setThreadName("Main");
+  auto lastFrame = std::chrono::steady_clock::now();
   while (!app.shouldClose()) {
-    app.poll();
-    auto now = std::chrono::high_resolution_clock::now();
-    auto deltaTime = std::chrono::duration<float, std::chrono::seconds::period>(
-                         now - lastFrame)
-                         .count();
-    switch (app.update(deltaTime)) {
+    EG_ZONE("Frame");
+    {
+      EG_ZONE("Poll");
+      app.poll();
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto frameTime = now - lastFrame;
+    // Zoned inside a lambda, the gotos below may not jump past a variable.
+    switch ([&]() {
+      EG_ZONE("Update");
+      return app.update(std::chrono::duration<float>(frameTime).count());
+    }()) {
+    case App::TickResult::Success:
+      break;
+    case App::TickResult::Recoverable:
+      goto next;
+    case App::TickResult::Bail:
+      goto end;
+    }
+
+    switch ([&]() {
+      auto &timestep = app.getTimestep();
+      for (auto due = timestep.advance(frameTime); due > 0; --due) {
+        EG_ZONE("Tick");
+        const auto result = app.tick(timestep.stepSeconds());
+        if (result != App::TickResult::Success) {
+          return result;
+        }
+      }
+      return App::TickResult::Success;
+    }()) {
     case App::TickResult::Success:
       break;
     case App::TickResult::Recoverable:
@@ -201,7 +306,10 @@ void run(T &app) {
       goto end;
     }
 
-    switch (app.render()) {
+    switch ([&]() {
+      EG_ZONE("Render");
+      return app.render(app.getTimestep().alpha());
+    }()) {
     case App::TickResult::Success:
     case App::TickResult::Recoverable:
       break;
@@ -210,7 +318,10 @@ void run(T &app) {
     }
 
   next:
-    app.endFrame();
+    {
+      EG_ZONE("End frame");
+      app.endFrame();
+    }
 
     lastFrame = now;
   }
@@ -40,7 +40,24 @@ public:
     }
   }
 
+  /// Once a frame.
   virtual void update(const FrameData &) noexcept = 0;
+  /// Once a fixed tick, after `beginTick`. Moving here is drawn smoothly
+  /// through `interpolate`.
+  virtual void tick(const FrameData &) noexcept {}
+
+  /// Remembers where the camera was before the tick about to run.
+  void beginTick() noexcept { previousPosition = position; }
+
+  /// Views from `alpha` of the way from where the camera was before the
+  /// last tick to where that tick left it.
+  void interpolate(float alpha) noexcept { interpolation = alpha; }
+
+  /// Where the camera is drawn from, which trails `getPosition` by up to a
+  /// tick.
+  [[nodiscard]] auto eye() const noexcept -> glm::vec3 {
+    return glm::mix(previousPosition, position, interpolation);
+  }
 
   void moveAbsolute(const glm::vec3 &delta) noexcept { position += delta; }
 
@@ -48,6 +65,7 @@ public:
 
   void center() noexcept {
     position = glm::vec3(0.0f);
+    previousPosition = position;
     rotation = Axes{.yaw = 0.0f, .pitch = 0.0f};
   }
 
@@ -97,13 +115,19 @@ public:
 
 protected:
   glm::vec3 position;
+  /// Before the last tick.
+  glm::vec3 previousPosition;
+  /// Of the way from `previousPosition` to `position`.
+  float interpolation = 1.0f;
 
   Axes rotation;
 
-  Camera() : position(0.0f), rotation({.yaw = 0.0f, .pitch = 0.0f}) {}
+  Camera()
+      : position(0.0f), previousPosition(0.0f),
+        rotation({.yaw = 0.0f, .pitch = 0.0f}) {}
   Camera(const glm::vec3 &position = glm::vec3(0.0f),
          const Axes rotation = {.yaw = 0.0f, .pitch = 0.0f}) noexcept
-      : position(position), rotation(rotation) {}
+      : position(position), previousPosition(position), rotation(rotation) {}
 
   [[nodiscard]] glm::vec3 rotateVec(const glm::vec3 &v) const noexcept {
     auto yawRad = glm::radians(rotation.yaw);
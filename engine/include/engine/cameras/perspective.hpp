@@ -31,7 +31,8 @@ public:
   }
 
   [[nodiscard]] auto view() const noexcept -> glm::mat4 override {
-    return glm::lookAt(position, position + forward(), engine::UP);
+    const auto from = eye();
+    return glm::lookAt(from, from + forward(), engine::UP);
   }
 
   [[nodiscard]] auto projection() const noexcept -> glm::mat4 override {
@@ -39,7 +40,8 @@ public:
     float f = 1.0f / tan(params.fov / 2.0f);
 
     proj[0][0] = f / params.aspectRatio;
-    proj[1][1] = f;
+    // Vulkan's clip space points y down.
+    proj[1][1] = -f;
     proj[2][3] = 1.0f;
     proj[3][2] = params.nearPlane;
 
@@ -2,6 +2,7 @@
 
 #include "engine/window.hpp"
 #include <GLFW/glfw3.h>
+#include <optional>
 #include <vulkan/vulkan_raii.hpp>
 
 namespace engine::rendering {
@@ -12,13 +13,15 @@ struct InstanceAdditions {
 };
 
 class Core {
-  engine::Window window;
+  /// Empty when headless.
+  std::optional<engine::Window> window;
   vk::raii::Context context;
   vk::raii::Instance instance;
   vk::raii::DebugUtilsMessengerEXT debugMessenger = nullptr;
+  /// Null when headless.
   vk::raii::SurfaceKHR surface;
 
-  Core(engine::Window &window, vk::raii::Context &context,
+  Core(std::optional<engine::Window> &window, vk::raii::Context &context,
        vk::raii::Instance &instance, vk::raii::SurfaceKHR &surface) noexcept
       : window(std::move(window)), context(std::move(context)),
         instance(std::move(instance)), surface(std::move(surface)) {}
@@ -29,16 +32,32 @@ class Core {
     debugMessenger = std::move(dbgMessenger);
   }
 
+  /// Attaches the debug messenger in debug builds.
+  static auto finish(Core core) noexcept -> std::expected<Core, std::string>;
+
 public:
   static auto create(const engine::Window::Attribs windowAttribs,
                      const InstanceAdditions &instanceAdditions = {},
                      const bool enableValidationLayers = false) noexcept
       -> std::expected<Core, std::string>;
 
-  [[nodiscard]] inline auto getWindow() noexcept -> Window & { return window; }
+  /// Without a window or surface, for rendering offscreen where there is no
+  /// display. GLFW need not be initialised.
+  static auto createHeadless(const InstanceAdditions &instanceAdditions = {},
+                             const bool enableValidationLayers = false) noexcept
+      -> std::expected<Core, std::string>;
+
+  [[nodiscard]] inline auto isHeadless() const noexcept -> bool {
+    return !window.has_value();
+  }
+
+  /// Only when not headless.
+  [[nodiscard]] inline auto getWindow() noexcept -> Window & {
+    return *window;
+  }
 
   [[nodiscard]] inline auto getWindow() const noexcept -> const Window & {
-    return window;
+    return *window;
   }
 
   [[nodiscard]] inline auto getContext() noexcept -> vk::raii::Context & {
@@ -1,3 +1,5 @@
 #pragma once
 
 constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+/// Fixed simulation ticks a second, however fast frames are drawn.
+constexpr int TICK_RATE = 30;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <variant>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+/// Holds released GPU resources until the frames that may still use them
+/// have retired.
+///
+/// Entries are tagged with the number of the latest frame that was started
+/// when they were released. Frame numbers only grow, so the queue is in
+/// release order and `retire` only ever pops from the front.
+class DeletionQueue {
+public:
+  void push(uint64_t frame, vkh::AllocatedBuffer buffer) noexcept;
+  void push(uint64_t frame, vkh::AllocatedImage image,
+            vk::DeviceSize size) noexcept;
+  /// For anything that is not a whole allocation, such as a mega buffer
+  /// range. `size` is only used for the stats.
+  void push(uint64_t frame, std::function<void()> release,
+            vk::DeviceSize size = 0) noexcept;
+
+  /// Destroys every entry released during or before `frame`.
+  void retire(uint64_t frame, vma::Allocator &allocator,
+              const vk::raii::Device &device) noexcept;
+
+  /// Destroys everything, the device has to be idle.
+  void flush(vma::Allocator &allocator,
+             const vk::raii::Device &device) noexcept;
+
+  [[nodiscard]] auto depth() const noexcept -> size_t {
+    return entries.size();
+  }
+  [[nodiscard]] auto pendingBytes() const noexcept -> vk::DeviceSize {
+    return bytes;
+  }
+
+private:
+  struct Entry {
+    uint64_t frame;
+    vk::DeviceSize bytes;
+    std::variant<vkh::AllocatedBuffer, vkh::AllocatedImage,
+                 std::function<void()>>
+        object;
+  };
+
+  std::deque<Entry> entries;
+  vk::DeviceSize bytes = 0;
+
+  void destroy(Entry &entry, vma::Allocator &allocator,
+               const vk::raii::Device &device) noexcept;
+};
+
+} // namespace engine
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+/// Reads rendered frames back and writes them out as binary PPM images, so
+/// runs without a display can still be looked at and compared.
+///
+/// Every frame in flight copies into its own partition of one readback
+/// buffer, which is only read by `write` once that frame's fence has been
+/// waited on, so capturing never stalls the GPU.
+///
+/// Only `eR16G16B16A16Sfloat` images, the render image's format, can be
+/// captured. Their linear colour is encoded as sRGB, as blitting to the
+/// swapchain would.
+class FrameCapture {
+public:
+  /// Captures images of `extent` into `directory`, creating it if needed.
+  static auto create(vma::Allocator &allocator, vk::Extent3D extent,
+                     vk::Format format,
+                     std::filesystem::path directory) noexcept
+      -> std::expected<FrameCapture, std::string>;
+
+  /// Copies `image`, in the transfer source layout, into `frameIndex`'s
+  /// partition to be written out as frame `number`.
+  void record(const vk::raii::CommandBuffer &cmdBuffer, vk::Image image,
+              uint32_t frameIndex, uint64_t number) noexcept;
+
+  /// Writes out what `frameIndex` captured the last time round, if
+  /// anything. Only call once its fence has been waited on.
+  auto write(uint32_t frameIndex) noexcept -> std::expected<void, std::string>;
+
+  [[nodiscard]] auto getBuffer() const noexcept
+      -> const vkh::AllocatedBuffer & {
+    return buffer;
+  }
+
+private:
+  static constexpr vk::DeviceSize TEXEL_SIZE = 8;
+
+  vkh::AllocatedBuffer buffer;
+  vk::Extent3D extent;
+  std::filesystem::path directory;
+  /// The frame number waiting in each partition.
+  std::array<std::optional<uint64_t>, MAX_FRAMES_IN_FLIGHT> pending{};
+  /// sRGB byte of every half float bit pattern.
+  std::vector<uint8_t> encode;
+  /// Of the frame being written, reused between frames.
+  std::vector<uint8_t> pixels;
+
+  FrameCapture(vkh::AllocatedBuffer buffer, vk::Extent3D extent,
+               std::filesystem::path directory) noexcept;
+
+  [[nodiscard]] auto partitionSize() const noexcept -> vk::DeviceSize {
+    return vk::DeviceSize{extent.width} * extent.height * TEXEL_SIZE;
+  }
+};
+
+} // namespace engine
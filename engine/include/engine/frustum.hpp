@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+namespace engine {
+
+/// View frustum as six inward facing planes, taken from the rows of a view
+/// projection matrix with Vulkan's clip volume, `-w <= x, y <= w` and
+/// `0 <= z <= w`.
+///
+/// This is the CPU reference for the cull compute shader, the two have to
+/// stay the same test.
+class Frustum {
+public:
+  explicit Frustum(const glm::mat4 &viewProjection) noexcept {
+    const auto row = [&](int i) {
+      return glm::vec4(viewProjection[0][i], viewProjection[1][i],
+                       viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    planes = {row(3) + row(0), row(3) - row(0), row(3) + row(1),
+              row(3) - row(1), row(2),          row(3) - row(2)};
+  }
+
+  /// Whether any part of the box `[min, max]` may be inside. Boxes near a
+  /// corner of the frustum can pass without touching it. `margin` grows the
+  /// box on every side, or shrinks it when negative.
+  [[nodiscard]] auto intersects(glm::vec3 min, glm::vec3 max,
+                                float margin = 0.0f) const noexcept -> bool {
+    min -= margin;
+    max += margin;
+
+    // Planes are left unnormalised, only the sign of the distance matters.
+    for (const auto &plane : planes) {
+      const glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+                             plane.y >= 0.0f ? max.y : min.y,
+                             plane.z >= 0.0f ? max.z : min.z);
+      if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  [[nodiscard]] auto getPlanes() const noexcept
+      -> const std::array<glm::vec4, 6> & {
+    return planes;
+  }
+
+private:
+  std::array<glm::vec4, 6> planes;
+};
+
+} // namespace engine
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+/// Times named regions of each frame's command buffer with GPU timestamps.
+///
+/// Every frame in flight owns a slice of one query pool. `beginFrame` reads
+/// back what the slice's previous frame wrote, which its fence has retired
+/// by then, so results arrive a frame late and reading them never stalls.
+/// It then resets the slice for the frame being recorded. A slice is only
+/// read back once `markSubmitted` says the command buffer that reset it was
+/// submitted, as queries that were never reset must not be read.
+///
+/// A timestamp is written once every command before it is done, so a scope
+/// covers the work recorded inside it and not what was still running from
+/// before. Scopes may nest, and are keyed by name across frames.
+///
+/// On a queue without timestamps nothing is recorded and `stats` stays
+/// empty.
+class GpuProfiler {
+public:
+  /// Per frame, the rest are not timed.
+  static constexpr uint32_t MAX_SCOPES = 32;
+  /// Frames the statistics are taken over.
+  static constexpr uint32_t HISTORY = 120;
+
+  struct ScopeStats {
+    const char *name;
+    /// Scopes open around it when it was first seen.
+    uint32_t depth;
+    /// In milliseconds, `min`, `avg` and `max` over the last `HISTORY`
+    /// frames the scope ran in.
+    float last;
+    float min;
+    float avg;
+    float max;
+  };
+
+  /// Times work submitted to `queue`, whose family decides which bits of a
+  /// timestamp are valid.
+  static auto create(const vk::raii::Device &device,
+                     const vk::raii::PhysicalDevice &physicalDevice,
+                     const vkh::Queue &queue) noexcept
+      -> std::expected<GpuProfiler, std::string>;
+
+  /// Takes in the results of `frameIndex`'s last use and resets its queries
+  /// in `cmdBuffer`, which must be the first thing recorded into it. Only
+  /// call once `frameIndex`'s fence has been waited on.
+  void beginFrame(const vk::raii::CommandBuffer &cmdBuffer,
+                  uint32_t frameIndex) noexcept;
+
+  /// Starts timing `name`, a string that outlives the profiler. Returns what
+  /// to pass to `end`.
+  [[nodiscard]] auto begin(const vk::raii::CommandBuffer &cmdBuffer,
+                           const char *name) noexcept -> uint32_t;
+  void end(const vk::raii::CommandBuffer &cmdBuffer, uint32_t scope) noexcept;
+
+  /// Call once the command buffer recorded for `frameIndex` since
+  /// `beginFrame` has been submitted. A frame abandoned before then is not
+  /// read back.
+  void markSubmitted(uint32_t frameIndex) noexcept {
+    submitted[frameIndex] = true;
+  }
+
+  /// In the order the scopes were first seen.
+  [[nodiscard]] auto stats() const noexcept -> std::span<const ScopeStats> {
+    return summaries;
+  }
+
+  [[nodiscard]] auto isEnabled() const noexcept -> bool {
+    return *pool != nullptr;
+  }
+
+private:
+  static constexpr uint32_t NONE = ~0u;
+  static constexpr uint32_t QUERIES_PER_FRAME = MAX_SCOPES * 2;
+
+  struct Recorded {
+    const char *name;
+    uint32_t depth;
+  };
+
+  struct History {
+    std::array<float, HISTORY> samples;
+    uint32_t count = 0;
+    uint32_t next = 0;
+  };
+
+  /// Null without timestamps.
+  vk::raii::QueryPool pool;
+  /// Nanoseconds a tick.
+  float period;
+  /// The bits of a timestamp that are valid.
+  uint64_t validMask;
+
+  uint32_t frameIndex = 0;
+  uint32_t open = 0;
+  /// Scope `i` of a frame uses queries `2 * i` and `2 * i + 1` of its slice.
+  std::array<std::vector<Recorded>, MAX_FRAMES_IN_FLIGHT> recorded;
+  /// Whether each slice's reset and the scopes after it were submitted.
+  std::array<bool, MAX_FRAMES_IN_FLIGHT> submitted{};
+  /// Parallel to `summaries`.
+  std::vector<History> histories;
+  std::vector<ScopeStats> summaries;
+
+  GpuProfiler(vk::raii::QueryPool &&pool, float period,
+              uint64_t validMask) noexcept
+      : pool(std::move(pool)), period(period), validMask(validMask) {}
+
+  void addSample(const Recorded &scope, float milliseconds) noexcept;
+};
+
+} // namespace engine
@@ -9,5 +9,7 @@ void transitionImageLayout(const vk::raii::CommandBuffer &commandBuffer,
                            vk::AccessFlags2 srcAccessMask,
                            vk::AccessFlags2 dstAccessMask,
                            vk::PipelineStageFlags2 srcStageMask,
-                           vk::PipelineStageFlags2 dstStageMask) noexcept;
+                           vk::PipelineStageFlags2 dstStageMask,
+                           vk::ImageAspectFlags aspectMask =
+                               vk::ImageAspectFlagBits::eColor) noexcept;
 } // namespace engine
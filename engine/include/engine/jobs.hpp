@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+class JobSystem;
+
+/// Tracks a group of outstanding jobs. Jobs submitted against a counter keep
+/// it above zero until they have run, and other jobs can be held back until
+/// it drains.
+///
+/// A counter must outlive every job that signals or depends on it, and must
+/// not be reused until it is done.
+class JobCounter {
+public:
+  JobCounter() noexcept = default;
+  JobCounter(const JobCounter &) = delete;
+  JobCounter &operator=(const JobCounter &) = delete;
+
+  [[nodiscard]] auto isDone() const noexcept -> bool {
+    return pending.load(std::memory_order_acquire) == 0;
+  }
+
+  [[nodiscard]] auto remaining() const noexcept -> uint32_t {
+    return pending.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<uint32_t> pending = 0;
+
+  friend class JobSystem;
+};
+
+/// Fixed pool of worker threads with one deque each. Workers pop their own
+/// newest job first and steal the oldest job from another worker when they
+/// run dry, so nested work stays cache local while idle threads pick up the
+/// big batches.
+///
+/// Jobs submitted from a worker go to its own deque, anything else is spread
+/// round robin. The main thread has no deque, it joins in through
+/// `waitAndHelp`. With zero workers jobs only run inside `waitAndHelp`.
+class JobSystem {
+public:
+  using Job = std::function<void()>;
+
+  /// One fewer worker than hardware threads, leaving a core for the main
+  /// thread.
+  [[nodiscard]] static auto defaultWorkerCount() noexcept -> uint32_t;
+
+  explicit JobSystem(uint32_t workerCount = defaultWorkerCount()) noexcept;
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+  /// Stops and joins the workers. Jobs still queued are dropped.
+  ~JobSystem();
+
+  /// Queues `job`. If `counter` is set it stays above zero until the job has
+  /// run. If `dependency` is set the job is only queued once that counter is
+  /// done, so submit the jobs it waits on first.
+  void submit(Job job, JobCounter *counter = nullptr,
+              const JobCounter *dependency = nullptr) noexcept;
+
+  /// Splits `[0, count)` into batches of at most `batchSize` and runs
+  /// `fn(begin, end)` for each as its own job.
+  void parallelFor(uint32_t count, uint32_t batchSize,
+                   std::function<void(uint32_t, uint32_t)> fn,
+                   JobCounter &counter,
+                   const JobCounter *dependency = nullptr) noexcept;
+
+  /// Runs queued jobs on the calling thread until `counter` is done.
+  void waitAndHelp(const JobCounter &counter) noexcept;
+
+  [[nodiscard]] auto workerCount() const noexcept -> uint32_t {
+    return threadCount;
+  }
+
+private:
+  struct QueuedJob {
+    Job fn;
+    JobCounter *counter;
+  };
+
+  struct WaitingJob {
+    const JobCounter *dependency;
+    QueuedJob job;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<QueuedJob> jobs;
+    std::thread thread;
+  };
+
+  /// Always at least one, so there is somewhere to queue with no threads.
+  std::vector<std::unique_ptr<Worker>> workers;
+  uint32_t threadCount;
+
+  /// Number of jobs sitting in a deque. Idle workers sleep on it.
+  std::atomic<uint32_t> queued = 0;
+  std::atomic<uint32_t> nextWorker = 0;
+  std::atomic<bool> stopping = false;
+
+  /// Jobs held back until their dependency is done.
+  std::mutex waitingMutex;
+  std::vector<WaitingJob> waiting;
+
+  void workerLoop(uint32_t index) noexcept;
+  void enqueue(QueuedJob job) noexcept;
+  [[nodiscard]] auto take(uint32_t self, QueuedJob &out) noexcept -> bool;
+  void execute(QueuedJob &job) noexcept;
+  void release(const JobCounter *counter) noexcept;
+};
+
+} // namespace engine
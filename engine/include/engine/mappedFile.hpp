@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+
+namespace engine {
+
+/// A file opened for reading and writing whose contents are read through a
+/// read only memory mapping, so reading costs no copies or system calls.
+///
+/// Writes go through the file handle and land in the same page cache the
+/// mapping views, so bytes already mapped see them straight away. Bytes
+/// written past the end of the mapping need a `remap` first, or `reserve`
+/// ahead of the writes so they land inside it.
+class MappedFile {
+public:
+  /// Creates the file if it does not exist.
+  static auto open(const std::filesystem::path &path) noexcept
+      -> std::expected<MappedFile, std::string>;
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  /// The mapped bytes, the whole file as of the last `remap`.
+  [[nodiscard]] auto data() const noexcept -> std::span<const std::byte> {
+    return {mapping, mappedSize};
+  }
+
+  [[nodiscard]] auto size() const noexcept -> uint64_t { return fileSize; }
+
+  /// Writes `bytes` at `offset`, growing the file if it runs past the end.
+  auto write(uint64_t offset, std::span<const std::byte> bytes) noexcept
+      -> std::expected<void, std::string>;
+
+  /// Blocks until every write so far is on disk. Safe to call while another
+  /// thread writes or remaps.
+  auto sync() const noexcept -> std::expected<void, std::string>;
+
+  /// Maps the whole file as it is now. Spans from `data` are invalidated.
+  auto remap() noexcept -> std::expected<void, std::string>;
+
+  /// Grows the file with zeros to at least `size` bytes and maps all of it.
+  /// Spans from `data` are invalidated if it grew.
+  auto reserve(uint64_t size) noexcept -> std::expected<void, std::string>;
+
+private:
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+  using Handle = void *;
+#else
+  using Handle = int;
+#endif
+
+  Handle handle;
+  const std::byte *mapping = nullptr;
+  size_t mappedSize = 0;
+  uint64_t fileSize = 0;
+
+  MappedFile(Handle handle, uint64_t size) noexcept
+      : handle(handle), fileSize(size) {}
+
+  void unmap() noexcept;
+  void close() noexcept;
+};
+
+} // namespace engine
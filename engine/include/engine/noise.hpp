@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <glm/glm.hpp>
+
+namespace engine::noise {
+
+/// Instruction sets the noise kernels are built for, narrowest first.
+enum class Isa : uint8_t { Scalar, Sse41, Avx2 };
+
+[[nodiscard]] auto isaName(Isa isa) noexcept -> const char *;
+
+/// Whether this build and this CPU can both run `isa`.
+[[nodiscard]] auto isSupported(Isa isa) noexcept -> bool;
+
+/// The widest supported instruction set.
+[[nodiscard]] auto bestIsa() noexcept -> Isa;
+
+enum class Basis : uint8_t {
+  /// Gradient noise on a simplex grid, smooth and without axis artifacts.
+  Simplex,
+  /// Random values on the integer lattice blended with a quintic curve.
+  /// Cheaper and blockier.
+  Value,
+};
+
+/// Fractal Brownian motion: `octaves` layers of the basis, each at
+/// `lacunarity` times the frequency and `gain` times the amplitude of the
+/// one before, normalised back to about [-1, 1].
+struct Fractal {
+  Basis basis = Basis::Simplex;
+  int32_t seed = 0;
+  /// Of the first octave, in cycles per world unit.
+  float frequency = 1.0f / 64.0f;
+  uint32_t octaves = 4;
+  float lacunarity = 2.0f;
+  float gain = 0.5f;
+};
+
+/// Domain warping: each sample position is first pushed around by
+/// `amplitude` times a second fractal, one channel per axis.
+struct Warp {
+  /// In world units, 0 turns warping off.
+  float amplitude = 0.0f;
+  Fractal fractal;
+};
+
+/// Fractal noise evaluated in batches with SIMD kernels picked at runtime.
+///
+/// Every instruction set runs the same operations in the same order without
+/// contraction, so the output is bit for bit identical whichever is used and
+/// terrain does not depend on the CPU it was generated on.
+class Noise {
+public:
+  /// Falls back to `bestIsa()` when `isa` is not supported.
+  explicit Noise(const Fractal &fractal, const Warp &warp = {},
+                 Isa isa = bestIsa()) noexcept;
+
+  [[nodiscard]] auto sample(glm::vec2 position) const noexcept -> float;
+  [[nodiscard]] auto sample(glm::vec3 position) const noexcept -> float;
+
+  /// Samples `size.x * size.y` points spaced `step` apart from `origin`,
+  /// x fastest. `out` needs room for all of them.
+  void grid(glm::vec2 origin, glm::uvec2 size, float step,
+            std::span<float> out) const noexcept;
+
+  /// Samples `size.x * size.y * size.z` points spaced `step` apart from
+  /// `origin`, ordered x, then z, then y like `voxel::Chunk::index`, so a
+  /// column of chunks is one call with each chunk a contiguous slab.
+  void grid(glm::vec3 origin, glm::uvec3 size, float step,
+            std::span<float> out) const noexcept;
+
+  [[nodiscard]] auto isa() const noexcept -> Isa { return _isa; }
+
+private:
+  Fractal fractal;
+  Warp warp;
+  Isa _isa;
+  float scale;
+  float warpScale;
+
+  void warp2(float *x, float *y, uint32_t count) const noexcept;
+  void warp3(float *x, float *y, float *z, uint32_t count) const noexcept;
+};
+
+} // namespace engine::noise
@@ -33,9 +33,18 @@ struct CoreQueueFamilyIndices {
   }
 };
 
+/// With a null surface, as when headless, only a graphics family is needed
+/// and presenting shares it.
 std::expected<CoreQueueFamilyIndices, std::string>
 findCoreQueues(const vk::raii::PhysicalDevice &, const vk::raii::SurfaceKHR &);
 
+/// Finds a transfer capable family other than `graphicsFamily`, preferring
+/// one without graphics or compute support. Empty when the device only has
+/// the one family, uploads then share the graphics family.
+auto findTransferQueue(const vk::raii::PhysicalDevice &physicalDevice,
+                       uint32_t graphicsFamily) noexcept
+    -> std::optional<uint32_t>;
+
 struct QueueCreateInfo {
   uint32_t familyIndex;
   float priority = 1.0f;
@@ -48,7 +57,9 @@ const vk::StructureChain<
     ENGINE_DEVICE_EXTENSIONS = {
         {},
         {.shaderDrawParameters = true},
-        {.bufferDeviceAddress = true},
+        {.drawIndirectCount = true,
+         .timelineSemaphore = true,
+         .bufferDeviceAddress = true},
         {.synchronization2 = true, .dynamicRendering = true},
         {.extendedDynamicState = true}};
 
@@ -59,13 +70,16 @@ createLogicalDevice(const vk::raii::PhysicalDevice &physicalDevice,
                     const vk::StructureChain<Ts...> &chain,
                     std::span<const char *const> deviceExtensions) {
   std::vector<vk::DeviceQueueCreateInfo> queueCreateInfo;
+  // Priorities must outlive the create infos pointing at them.
+  std::vector<float> queuePriorities;
   queueCreateInfo.reserve(indices.size());
+  queuePriorities.reserve(indices.size());
   for (const auto &index : indices) {
-    std::array<float, 1> queuePriority = {index.priority};
+    queuePriorities.push_back(index.priority);
     queueCreateInfo.push_back(
         vk::DeviceQueueCreateInfo{.queueFamilyIndex = index.familyIndex,
                                   .queueCount = 1,
-                                  .pQueuePriorities = queuePriority.data()});
+                                  .pQueuePriorities = &queuePriorities.back()});
   }
 
   // Source - https://stackoverflow.com/a
@@ -107,8 +121,14 @@ createSwapchain(const vk::raii::PhysicalDevice &physicalDevice,
 
 std::expected<vkh::AllocatedImage, std::string>
 createRenderImage(const vk::raii::Device &device, const vma::Allocator &alloc,
-                  const vkh::SwapchainConfig &swapchainConfig,
-                  vk::Format format);
+                  vk::Extent2D extent, vk::Format format);
+
+/// Depth attachment the size of `extent` that can also be sampled, for
+/// building depth pyramids.
+auto createDepthImage(const vk::raii::Device &device,
+                      const vma::Allocator &alloc, vk::Extent3D extent,
+                      vk::Format format) noexcept
+    -> std::expected<vkh::AllocatedImage, std::string>;
 
 auto createSyncObjects(const vk::raii::Device &device) noexcept
     -> std::expected<SyncObjects, std::string>;
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+/// Persistently mapped upload buffer split into one partition per frame in
+/// flight.
+///
+/// Uploads are copied into the active partition straight away and the GPU
+/// side copies are recorded by `flush`, one `copyBuffer` per destination. A
+/// flushed partition is guarded by the frame it was recorded in and only
+/// handed out again once `beginFrame` is called for that frame, which must
+/// be after its `drawingFence` has been waited on.
+///
+/// Uploads to the same destination within one frame must not overlap.
+class StagingRing {
+public:
+  /// Keeps every copy's source offset aligned for the widest texel or index
+  /// type we upload. Each upload can take up to this much more than its
+  /// size.
+  static constexpr vk::DeviceSize UPLOAD_ALIGNMENT = 16;
+
+  struct Stats {
+    vk::DeviceSize bytes = 0;
+    uint32_t uploads = 0;
+    /// `copyBuffer` calls recorded, one per destination buffer.
+    uint32_t copyCommands = 0;
+    /// Uploads that did not fit and have to be retried next frame.
+    uint32_t rejected = 0;
+    /// Copied within destination buffers by `copy`, never staged.
+    vk::DeviceSize copiedBytes = 0;
+  };
+
+  static auto create(vma::Allocator &allocator,
+                     vk::DeviceSize partitionSize) noexcept
+      -> std::expected<StagingRing, std::string>;
+
+  /// Starts a new frame. Partitions flushed during `frameIndex`'s last use
+  /// are free again. Uploads that were never flushed stay queued.
+  void beginFrame(uint32_t frameIndex) noexcept;
+
+  /// Stages `data` for `dst` at `dstOffset`. Returns false when the active
+  /// partition is full or was already flushed this frame, nothing is queued
+  /// in that case.
+  [[nodiscard]] auto upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                            std::span<const std::byte> data) noexcept -> bool;
+
+  template <typename T>
+  [[nodiscard]] auto upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                            std::span<const T> data) noexcept -> bool {
+    return upload(dst, dstOffset, std::as_bytes(data));
+  }
+
+  /// Bytes `upload` can still take this frame, see `UPLOAD_ALIGNMENT`.
+  [[nodiscard]] auto room() const noexcept -> vk::DeviceSize {
+    return guards[active].has_value() || head >= size ? 0 : size - head;
+  }
+
+  /// Makes this frame's uploads and copies wait for every command submitted
+  /// before them, so they may write over what frames still in flight read.
+  /// Costs those frames' overlap with this one, so only when needed.
+  void waitForReads() noexcept { overwrites = true; }
+
+  /// Copies `size` bytes within `buffer` on the GPU from `srcOffset` to
+  /// `dstOffset`, for keeping what did not change when a range is written
+  /// again somewhere else. Recorded along with the uploads, so neither they
+  /// nor other copies this frame may write the source. Never fails.
+  void copy(vk::Buffer buffer, vk::DeviceSize srcOffset,
+            vk::DeviceSize dstOffset, vk::DeviceSize size) noexcept;
+
+  /// Records the queued uploads and copies into `cmdBuffer`, followed by a
+  /// barrier that makes them visible to every later stage.
+  void flush(const vk::raii::CommandBuffer &cmdBuffer,
+             uint32_t frameIndex) noexcept;
+
+  /// Totals for the frame in progress.
+  [[nodiscard]] auto frameStats() const noexcept -> const Stats & {
+    return current;
+  }
+  /// Totals for the previous frame, stable for UI display.
+  [[nodiscard]] auto lastFrameStats() const noexcept -> const Stats & {
+    return last;
+  }
+  [[nodiscard]] auto totalBytes() const noexcept -> uint64_t {
+    return total;
+  }
+  [[nodiscard]] auto partitionSize() const noexcept -> vk::DeviceSize {
+    return size;
+  }
+
+  [[nodiscard]] auto getBuffer() const noexcept
+      -> const vkh::AllocatedBuffer & {
+    return buffer;
+  }
+
+private:
+  struct PendingCopy {
+    vk::Buffer dst;
+    vk::BufferCopy region;
+  };
+
+  vkh::AllocatedBuffer buffer;
+  std::byte *mapped;
+  vk::DeviceSize size;
+
+  uint32_t active = 0;
+  vk::DeviceSize head = 0;
+  /// Frame whose fence protects each partition, empty while it is free or
+  /// being written.
+  std::array<std::optional<uint32_t>, MAX_FRAMES_IN_FLIGHT> guards{};
+
+  /// Set by `waitForReads` until the next `flush`.
+  bool overwrites = false;
+  std::vector<PendingCopy> pending;
+  /// From `copy`, their source is the destination buffer.
+  std::vector<PendingCopy> copies;
+  std::vector<vk::BufferCopy> regions;
+
+  Stats current;
+  Stats last;
+  uint64_t total = 0;
+
+  StagingRing(vkh::AllocatedBuffer buffer, vk::DeviceSize size) noexcept
+      : buffer(buffer),
+        mapped(static_cast<std::byte *>(buffer.allocInfo.pMappedData)),
+        size(size) {}
+};
+
+} // namespace engine
@@ -11,7 +11,8 @@ struct SyncObjects {
 };
 
 struct FrameData {
-  float deltaTimeMs;
+  /// In seconds, of the frame or of the tick.
+  float deltaTime;
   const Input &input;
 };
 
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace engine {
+
+/// Turns frames of any length into a whole number of fixed length ticks, so
+/// simulation runs at the same rate however fast frames are drawn.
+///
+/// Time a frame leaves over carries into the next, and `alpha` says how far
+/// it got towards the next tick, for drawing between the last two. Time is
+/// kept in integer nanoseconds so the same frame times always give the same
+/// ticks.
+///
+/// A frame runs at most `maxTicks` ticks. Whatever is still owed past that
+/// is dropped, as catching up on it would only make the next frame slower
+/// and owe more, so after a stall simulation slows down instead.
+class FixedTimestep {
+public:
+  using Duration = std::chrono::nanoseconds;
+
+  /// Enough to cover a frame of 1/6 s at 30 ticks a second.
+  static constexpr uint32_t DEFAULT_MAX_TICKS = 5;
+
+  explicit FixedTimestep(uint32_t ticksPerSecond,
+                         uint32_t maxTicks = DEFAULT_MAX_TICKS) noexcept
+      : step(Duration(std::chrono::seconds(1)) /
+             std::max(ticksPerSecond, 1u)),
+        maxTicks(std::max(maxTicks, 1u)) {}
+
+  /// Adds a frame that took `frameTime` and returns the ticks now due.
+  auto advance(Duration frameTime) noexcept -> uint32_t {
+    accumulated += lockedFrameTime.value_or(std::max(frameTime, Duration(0)));
+    auto due = static_cast<uint64_t>(accumulated / step);
+    if (due > maxTicks) {
+      droppedTicks += due - maxTicks;
+      due = maxTicks;
+      // Keeps the part of a tick already accumulated.
+      accumulated %= step;
+    } else {
+      accumulated -= step * static_cast<int64_t>(due);
+    }
+    ticks += due;
+    return static_cast<uint32_t>(due);
+  }
+
+  /// Counts every frame as `frameTime` whatever it really took, so runs that
+  /// must simulate the same way each time tick the same, or goes back to
+  /// real time when empty.
+  void lockFrameTime(std::optional<Duration> frameTime) noexcept {
+    lockedFrameTime = frameTime;
+  }
+
+  /// How far time has got from the last tick to the next, in [0, 1).
+  [[nodiscard]] auto alpha() const noexcept -> float {
+    return std::chrono::duration<float>(accumulated) /
+           std::chrono::duration<float>(step);
+  }
+
+  [[nodiscard]] auto getStep() const noexcept -> Duration { return step; }
+
+  [[nodiscard]] auto stepSeconds() const noexcept -> float {
+    return std::chrono::duration<float>(step).count();
+  }
+
+  /// Run so far.
+  [[nodiscard]] auto getTicks() const noexcept -> uint64_t { return ticks; }
+
+  /// Skipped to stay within `maxTicks` a frame.
+  [[nodiscard]] auto getDroppedTicks() const noexcept -> uint64_t {
+    return droppedTicks;
+  }
+
+private:
+  Duration step;
+  uint32_t maxTicks;
+  /// Not yet ticked, always under a step between frames.
+  Duration accumulated{0};
+  std::optional<Duration> lockedFrameTime;
+  uint64_t ticks = 0;
+  uint64_t droppedTicks = 0;
+};
+
+} // namespace engine
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// Zones are compiled in unless the build turns `ENGINE_TRACING` off, and
+/// then only recorded between `trace::start` and `trace::stop`.
+#ifndef EG_TRACING
+#define EG_TRACING 1
+#endif
+
+/// Times the rest of the enclosing scope as `name`, a string literal, on
+/// the calling thread's timeline.
+#if EG_TRACING
+#define EG_ZONE_CONCAT_(_A, _B) _A##_B
+#define EG_ZONE_CONCAT(_A, _B) EG_ZONE_CONCAT_(_A, _B)
+#define EG_ZONE(_NAME)                                                         \
+  const ::engine::trace::Zone EG_ZONE_CONCAT(egZone, __LINE__)(_NAME)
+#else
+#define EG_ZONE(_NAME) static_cast<void>(0)
+#endif
+
+/// CPU timeline of named zones, written out as Chrome trace event JSON for
+/// chrome://tracing or Perfetto.
+///
+/// Each thread records into a ring buffer of its own that only it writes,
+/// so recording never takes a lock. A thread's buffer is allocated the
+/// first time it records, and the newest `CAPACITY` zones are kept. While
+/// not recording, a zone costs a relaxed load and a branch.
+namespace engine::trace {
+
+/// Zones kept per thread.
+constexpr uint32_t CAPACITY = 1 << 16;
+
+namespace detail {
+extern std::atomic<bool> recording;
+
+[[nodiscard]] inline auto now() noexcept -> uint64_t {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void record(const char *name, uint64_t start, uint64_t end) noexcept;
+} // namespace detail
+
+[[nodiscard]] inline auto isRecording() noexcept -> bool {
+  return detail::recording.load(std::memory_order_relaxed);
+}
+
+/// Starts recording, leaving out anything recorded before.
+void start() noexcept;
+void stop() noexcept;
+
+/// Writes the zones recorded since `start`, as many as each thread still
+/// holds. Call once recording has stopped: a zone that ends while its ring
+/// is being read may come out torn.
+auto write(const std::filesystem::path &path) noexcept
+    -> std::expected<void, std::string>;
+
+/// Time spent in every zone of one name, summed over threads.
+struct ZoneTotal {
+  const char *name;
+  uint64_t count;
+  uint64_t nanoseconds;
+};
+
+/// Totals of the zones `write` would write, busiest first. Nested zones
+/// count towards their own name and their parents' alike.
+[[nodiscard]] auto totals() noexcept -> std::vector<ZoneTotal>;
+
+/// Names the calling thread's timeline.
+void setThreadName(std::string name) noexcept;
+
+class Zone {
+public:
+  explicit Zone(const char *name) noexcept
+      : name(name), start(isRecording() ? detail::now() : 0) {}
+
+  Zone(const Zone &) = delete;
+  Zone &operator=(const Zone &) = delete;
+
+  ~Zone() {
+    if (start != 0) {
+      detail::record(name, start, detail::now());
+    }
+  }
+
+private:
+  const char *name;
+  /// Zero when not recording at the start.
+  uint64_t start;
+};
+
+} // namespace engine::trace
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "defines.hpp"
+#include "engine/staging.hpp"
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace engine {
+
+/// Uploads buffers on the transfer queue so large copies overlap rendering.
+///
+/// Staged data is submitted in batches that each signal the next value of a
+/// timeline semaphore. A graphics submission only has to wait on the
+/// semaphore info `takeWait` returns, which also makes the copies visible.
+///
+/// Destinations are never transferred between queue families, which would
+/// cover a whole buffer and leave the rest of a shared buffer undefined.
+/// Instead they must be created with concurrent sharing between
+/// `getFamilies`, so any range of them can be written without disturbing
+/// the others. Without a separate family the same path runs on a second
+/// command pool of the graphics family and exclusive buffers are fine.
+class AsyncUploader {
+public:
+  static auto create(const vk::raii::Device &device, vma::Allocator &allocator,
+                     const vkh::Queue &transferQueue, uint32_t graphicsFamily,
+                     vk::DeviceSize stagingSize) noexcept
+      -> std::expected<AsyncUploader, std::string>;
+
+  /// Stages `data` for `dst` at `dstOffset` in the current batch. Returns
+  /// false when the batch is out of staging space.
+  [[nodiscard]] auto upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                            std::span<const std::byte> data) noexcept -> bool;
+
+  template <typename T>
+  [[nodiscard]] auto upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                            std::span<const T> data) noexcept -> bool {
+    return upload(dst, dstOffset, std::as_bytes(data));
+  }
+
+  /// Submits the current batch. Returns the timeline value it signals, or
+  /// nothing if the batch was empty. Blocks only if every batch slot is
+  /// still in flight.
+  auto submit(const vk::raii::Device &device) noexcept
+      -> std::expected<std::optional<uint64_t>, std::string>;
+
+  /// The wait the next graphics submission needs for every batch submitted
+  /// since the last call, if any.
+  auto takeWait() noexcept -> std::optional<vk::SemaphoreSubmitInfo>;
+
+  [[nodiscard]] auto isComplete(const vk::raii::Device &device,
+                                uint64_t value) const noexcept -> bool;
+
+  [[nodiscard]] auto isDedicated() const noexcept -> bool {
+    return queue.index != graphicsFamily;
+  }
+
+  /// Destinations are shared between these, the graphics family first. The
+  /// two are the same without a dedicated family.
+  [[nodiscard]] auto getFamilies() const noexcept -> std::array<uint32_t, 2> {
+    return {graphicsFamily, queue.index};
+  }
+
+  [[nodiscard]] auto getStaging() const noexcept -> const StagingRing & {
+    return staging;
+  }
+
+private:
+  vkh::Queue queue;
+  uint32_t graphicsFamily;
+
+  vk::raii::CommandPool commandPool;
+  std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers;
+  vk::raii::Semaphore timeline;
+
+  /// Partitions are keyed by batch slot rather than frame.
+  StagingRing staging;
+
+  /// Timeline value each slot was last submitted with.
+  std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> slotValues{};
+  uint32_t slot = 0;
+  uint64_t lastValue = 0;
+
+  /// Whether the current batch has anything to copy.
+  bool batchStaged = false;
+  /// Last batch submitted that no graphics submission waits on yet.
+  std::optional<uint64_t> unwaited;
+
+  using CommandBuffers =
+      std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT>;
+
+  AsyncUploader(vkh::Queue queue, uint32_t graphicsFamily,
+                vk::raii::CommandPool &&commandPool,
+                CommandBuffers &&commandBuffers, vk::raii::Semaphore &&timeline,
+                StagingRing &&staging) noexcept
+      : queue(std::move(queue)), graphicsFamily(graphicsFamily),
+        commandPool(std::move(commandPool)),
+        commandBuffers(std::move(commandBuffers)),
+        timeline(std::move(timeline)), staging(std::move(staging)) {}
+};
+
+} // namespace engine
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace engine::voxel {
+
+using BlockId = uint16_t;
+
+constexpr BlockId AIR = 0;
+
+constexpr uint32_t CHUNK_SIZE = 32;
+constexpr uint32_t CHUNK_SIZE_SHIFT = 5;
+constexpr uint32_t CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+constexpr uint32_t CHUNK_VOLUME = CHUNK_AREA * CHUNK_SIZE;
+
+/// Fixed length array of integers packed into 64-bit words. The width is
+/// always a power of two so an entry never straddles two words.
+///
+/// Copies share their words until one of them is written, which copies them
+/// first. Copying is then cheap enough to snapshot a chunk for another
+/// thread to read while this one keeps editing it.
+class PackedArray {
+public:
+  PackedArray() = default;
+  PackedArray(uint32_t length, uint8_t bits) noexcept;
+  PackedArray(const PackedArray &other) noexcept;
+  PackedArray(PackedArray &&other) noexcept;
+  PackedArray &operator=(const PackedArray &other) noexcept;
+  PackedArray &operator=(PackedArray &&other) noexcept;
+  ~PackedArray();
+
+  [[nodiscard]] inline auto get(uint32_t index) const noexcept -> uint32_t {
+    const auto word = words[index >> perWordShift];
+    const auto shift = (index & perWordMask) << bitsShift;
+    return static_cast<uint32_t>((word >> shift) & mask);
+  }
+
+  inline void set(uint32_t index, uint32_t value) noexcept {
+    if (shared()) [[unlikely]] {
+      detach();
+    }
+    setUnshared(index, value);
+  }
+
+  [[nodiscard]] auto bits() const noexcept -> uint8_t { return _bits; }
+  [[nodiscard]] auto data() const noexcept -> std::span<const uint64_t> {
+    return {words, wordCount};
+  }
+  /// Copies the words first if they are shared.
+  [[nodiscard]] auto data() noexcept -> std::span<uint64_t> {
+    if (shared()) {
+      detach();
+    }
+    return {words, wordCount};
+  }
+
+  [[nodiscard]] auto byteSize() const noexcept -> size_t {
+    return wordCount * sizeof(uint64_t);
+  }
+
+  /// Whether another copy still shares the words.
+  [[nodiscard]] auto shared() const noexcept -> bool {
+    // Acquire pairs with the release of the last other copy, so its reads
+    // are done before this one writes.
+    return storage != nullptr &&
+           storage->refs.load(std::memory_order_acquire) != 1;
+  }
+
+  /// Returns a copy of this array with every entry widened to `bits`.
+  [[nodiscard]] auto widen(uint32_t length, uint8_t bits) const noexcept
+      -> PackedArray;
+
+private:
+  struct Storage {
+    std::atomic<uint32_t> refs;
+    std::vector<uint64_t> words;
+  };
+
+  Storage *storage = nullptr;
+  /// `storage->words`, saving an indirection on every access.
+  uint64_t *words = nullptr;
+  uint32_t wordCount = 0;
+  uint64_t mask = 0;
+  uint8_t _bits = 0;
+  uint8_t bitsShift = 0;
+  uint8_t perWordShift = 0;
+  uint32_t perWordMask = 0;
+
+  /// For filling arrays just built, which nothing shares yet.
+  inline void setUnshared(uint32_t index, uint32_t value) noexcept {
+    auto &word = words[index >> perWordShift];
+    const auto shift = (index & perWordMask) << bitsShift;
+    word = (word & ~(mask << shift)) | (static_cast<uint64_t>(value) << shift);
+  }
+
+  /// Gives this array words of its own.
+  void detach() noexcept;
+  void release() noexcept;
+
+  friend class Chunk;
+};
+
+/// A CHUNK_SIZE^3 block of voxels stored as a per-chunk palette of block ids
+/// plus one bit-packed palette index per voxel.
+///
+/// A chunk made of a single block type needs no index storage at all, and the
+/// index width only grows (1, 2, 4, 8, 16 bits) once the palette no longer
+/// fits. Palette entries are reference counted so slots freed by `set` are
+/// reused before the palette grows.
+///
+/// Copies share their index storage until written, see `PackedArray`, so a
+/// copy costs little more than the palette.
+class Chunk {
+public:
+  explicit Chunk(BlockId fill = AIR) noexcept;
+
+  [[nodiscard]] static constexpr auto index(uint32_t x, uint32_t y,
+                                            uint32_t z) noexcept -> uint32_t {
+    return (((y << CHUNK_SIZE_SHIFT) | z) << CHUNK_SIZE_SHIFT) | x;
+  }
+
+  [[nodiscard]] inline auto get(uint32_t x, uint32_t y, uint32_t z) const noexcept
+      -> BlockId {
+    return getIndex(index(x, y, z));
+  }
+
+  [[nodiscard]] inline auto getIndex(uint32_t i) const noexcept -> BlockId {
+    if (indices.bits() == 0) {
+      return palette.front();
+    }
+    return palette[indices.get(i)];
+  }
+
+  void set(uint32_t x, uint32_t y, uint32_t z, BlockId block) noexcept {
+    setIndex(index(x, y, z), block);
+  }
+
+  void setIndex(uint32_t i, BlockId block) noexcept;
+
+  /// Replaces every voxel with `block`, dropping the index storage.
+  void fill(BlockId block) noexcept;
+
+  /// Decodes every voxel into `out`, ordered by `Chunk::index`.
+  void unpack(std::span<BlockId, CHUNK_VOLUME> out) const noexcept;
+
+  /// Replaces the contents of the chunk with `blocks`, ordered by
+  /// `Chunk::index`.
+  void pack(std::span<const BlockId, CHUNK_VOLUME> blocks) noexcept;
+
+  /// Calls `fn(index, block)` for every voxel in index order.
+  template <typename Fn> void forEach(Fn &&fn) const {
+    if (indices.bits() == 0) {
+      const auto block = palette.front();
+      for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+        fn(i, block);
+      }
+      return;
+    }
+
+    const auto bits = indices.bits();
+    const uint32_t perWord = 64 / bits;
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    uint32_t i = 0;
+    for (auto word : indices.data()) {
+      for (uint32_t j = 0; j < perWord; ++j, ++i) {
+        fn(i, palette[static_cast<uint32_t>(word & mask)]);
+        word >>= bits;
+      }
+    }
+  }
+
+  /// Drops unused palette entries and narrows the index storage if the
+  /// remaining palette fits in fewer bits.
+  void compact() noexcept;
+
+  [[nodiscard]] auto isUniform() const noexcept -> bool {
+    return indices.bits() == 0;
+  }
+
+  [[nodiscard]] auto getPalette() const noexcept -> std::span<const BlockId> {
+    return palette;
+  }
+
+  [[nodiscard]] auto bitsPerIndex() const noexcept -> uint8_t {
+    return indices.bits();
+  }
+
+  /// Bytes of heap and inline storage owned by this chunk.
+  [[nodiscard]] auto memoryUsage() const noexcept -> size_t;
+
+  /// Appends the palette, its reference counts and the packed indices to
+  /// `out` as they are, for storage.
+  void serialize(std::vector<std::byte> &out) const noexcept;
+
+  /// Reads a chunk `serialize` wrote from the front of `in` and moves `in`
+  /// past it. Empty when `in` does not start with a valid chunk.
+  [[nodiscard]] static auto deserialize(std::span<const std::byte> &in) noexcept
+      -> std::optional<Chunk>;
+
+private:
+  std::vector<BlockId> palette;
+  std::vector<uint16_t> refCounts;
+  PackedArray indices;
+
+  [[nodiscard]] auto paletteSlot(BlockId block, uint32_t replacing) noexcept
+      -> uint32_t;
+  void resize(uint8_t bits) noexcept;
+};
+
+} // namespace engine::voxel
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/mesher.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+/// Names a chunk in a `ChunkMap`. Stays valid until that chunk is erased,
+/// however the map grows, and a handle to an erased chunk never resolves to
+/// a later one reusing its slot.
+struct ChunkHandle {
+  static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+  uint32_t index = NONE;
+  uint32_t generation = 0;
+
+  [[nodiscard]] constexpr auto valid() const noexcept -> bool {
+    return index != NONE;
+  }
+
+  constexpr auto operator==(const ChunkHandle &) const noexcept
+      -> bool = default;
+};
+
+/// Sparse set of loaded chunks keyed by chunk coordinate.
+///
+/// Chunks live in a slot array that never moves them, so handles are slot
+/// indices plus a generation. The generations are kept in an array of their
+/// own, so checking a handle never touches the chunk.
+///
+/// Chunks are grouped into bricks of 4x4x4, each a small array of slot
+/// indices. Bricks are found through an open addressing table of
+/// `{key, brick}` buckets keyed by packed brick coordinate, probed linearly
+/// from a Fibonacci hash, kept at most half full and compacted with backward
+/// shift deletion. A loaded area has 64 times fewer bricks than chunks, so
+/// the table stays in cache, and chunks next to each other mostly share a
+/// brick, so a lookup near the last one finds its brick's cache line
+/// already loaded. Lookups never touch a node.
+///
+/// Each slot also links to the 26 chunks around it. The links are patched
+/// when chunks come and go, so the neighbour queries meshing and lighting
+/// make in their inner loops are array reads instead of 26 hash probes.
+///
+/// Chunks edited since they were last saved are flagged dirty and queued in
+/// the order they were first edited, so saving can pick them up a few at a
+/// time without scanning every slot.
+class ChunkMap {
+public:
+  /// Slots in a 3x3x3 block of chunks, see `neighbourIndex`.
+  static constexpr uint32_t NEIGHBOURHOOD = 27;
+  /// `neighbourIndex(0, 0, 0)`, the chunk itself.
+  static constexpr uint32_t SELF = 13;
+
+  /// Coordinates pack into 21 signed bits each, wider ones wrap.
+  static constexpr uint32_t KEY_BITS = 21;
+
+  explicit ChunkMap(uint32_t expectedChunks = 0) noexcept;
+
+  [[nodiscard]] static constexpr auto pack(glm::ivec3 position) noexcept
+      -> uint64_t {
+    constexpr uint64_t MASK = (uint64_t{1} << KEY_BITS) - 1;
+    return (static_cast<uint64_t>(static_cast<uint32_t>(position.x)) & MASK) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(position.y)) & MASK)
+            << KEY_BITS) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(position.z)) & MASK)
+            << (KEY_BITS * 2));
+  }
+
+  [[nodiscard]] static constexpr auto unpack(uint64_t key) noexcept
+      -> glm::ivec3 {
+    constexpr uint32_t SHIFT = 32 - KEY_BITS;
+    auto axis = [](uint64_t bits) {
+      // Sign extends the 21 bit field.
+      return static_cast<int32_t>(static_cast<uint32_t>(bits) << SHIFT) >>
+             SHIFT;
+    };
+    return {axis(key), axis(key >> KEY_BITS), axis(key >> (KEY_BITS * 2))};
+  }
+
+  /// Index of the chunk at offset `(dx, dy, dz)`, each in [-1, 1], within a
+  /// neighbourhood. Opposite offsets sum to 26.
+  [[nodiscard]] static constexpr auto neighbourIndex(int dx, int dy,
+                                                     int dz) noexcept
+      -> uint32_t {
+    return static_cast<uint32_t>((dx + 1) + (dy + 1) * 3 + (dz + 1) * 9);
+  }
+
+  /// The chunk containing the world position `position`.
+  [[nodiscard]] static auto chunkAt(const glm::vec3 &position) noexcept
+      -> glm::ivec3 {
+    return glm::ivec3(glm::floor(position / static_cast<float>(CHUNK_SIZE)));
+  }
+
+  /// The chunk containing the block at `block`, in world blocks.
+  [[nodiscard]] static auto chunkOf(glm::ivec3 block) noexcept -> glm::ivec3 {
+    return glm::ivec3(block.x >> CHUNK_SIZE_SHIFT, block.y >> CHUNK_SIZE_SHIFT,
+                      block.z >> CHUNK_SIZE_SHIFT);
+  }
+
+  /// Adds `chunk` at `position`, replacing and keeping the handle of any
+  /// chunk already there.
+  auto insert(glm::ivec3 position, Chunk chunk) noexcept -> ChunkHandle;
+
+  /// Returns whether there was a chunk to erase.
+  auto erase(glm::ivec3 position) noexcept -> bool;
+  auto erase(ChunkHandle handle) noexcept -> bool;
+
+  void clear() noexcept;
+
+  /// An invalid handle when there is no chunk at `position`.
+  [[nodiscard]] auto find(glm::ivec3 position) const noexcept -> ChunkHandle {
+    return handleOf(findSlot(position));
+  }
+
+  /// Null for handles to erased chunks.
+  [[nodiscard]] auto get(ChunkHandle handle) noexcept -> Chunk *;
+  [[nodiscard]] auto get(ChunkHandle handle) const noexcept -> const Chunk *;
+
+  [[nodiscard]] auto contains(ChunkHandle handle) const noexcept -> bool {
+    // Handles are only made for live slots, and a slot's generation moves on
+    // when its chunk is erased.
+    return handle.index < generations.size() &&
+           generations[handle.index] == handle.generation;
+  }
+
+  /// Only meaningful for live handles.
+  [[nodiscard]] auto position(ChunkHandle handle) const noexcept
+      -> glm::ivec3 {
+    return slots[handle.index].position;
+  }
+
+  /// The chunk at offset `(dx, dy, dz)`, each in [-1, 1], from the live
+  /// chunk `handle`.
+  [[nodiscard]] auto neighbour(ChunkHandle handle, int dx, int dy,
+                               int dz) const noexcept -> ChunkHandle {
+    return handleOf(
+        links[handle.index][neighbourIndex(dx, dy, dz)]);
+  }
+
+  /// The 3x3x3 chunks around the live chunk `handle`, indexed by
+  /// `neighbourIndex` with `handle` itself at `SELF`.
+  [[nodiscard]] auto neighbours(ChunkHandle handle) const noexcept
+      -> std::array<ChunkHandle, NEIGHBOURHOOD>;
+
+  /// The six face neighbours of the live chunk `handle`, as the mesher
+  /// wants them.
+  [[nodiscard]] auto faceNeighbours(ChunkHandle handle) const noexcept
+      -> ChunkNeighbours;
+
+  /// The block at `position` in world blocks, `AIR` where no chunk is
+  /// loaded.
+  [[nodiscard]] auto getBlock(glm::ivec3 position) const noexcept -> BlockId;
+
+  /// Sets the block at `position` in world blocks and marks its chunk dirty.
+  /// False where no chunk is loaded.
+  auto setBlock(glm::ivec3 position, BlockId block) noexcept -> bool;
+
+  /// Flags the live chunk `handle` as edited. Chunks are inserted clean,
+  /// including over a dirty one.
+  void markDirty(ChunkHandle handle) noexcept;
+  void clearDirty(ChunkHandle handle) noexcept;
+
+  [[nodiscard]] auto isDirty(ChunkHandle handle) const noexcept -> bool {
+    return contains(handle) && slots[handle.index].dirty;
+  }
+
+  [[nodiscard]] auto dirtyCount() const noexcept -> uint32_t {
+    return dirtyChunks;
+  }
+
+  /// Clears the flags of dirty chunks, those dirty the longest first, until
+  /// they span `maxColumns` columns, and appends each of those columns'
+  /// `(x, z)` to `out` once. Saving copies whole columns, so this bounds
+  /// the copying however the edits are spread.
+  void takeDirtyColumns(uint32_t maxColumns,
+                        std::vector<glm::ivec2> &out) noexcept;
+
+  /// Calls `fn(handle, position, chunk)` for every chunk.
+  template <typename Fn> void forEach(Fn &&fn) {
+    for (uint32_t i = 0; i < slots.size(); ++i) {
+      if (isLive(generations[i])) {
+        fn(ChunkHandle{.index = i, .generation = generations[i]},
+           slots[i].position, slots[i].chunk);
+      }
+    }
+  }
+
+  /// Calls `fn(handle, position, chunk)` for every chunk whose box comes
+  /// closer than `radius` to the world position `center`, such as
+  /// `Camera::getPosition()`. Probes the table for each chunk in the
+  /// bounding cube, or walks every slot when there are fewer of those.
+  template <typename Fn>
+  void forEachInRadius(const glm::vec3 &center, float radius, Fn &&fn) {
+    const auto size = static_cast<float>(CHUNK_SIZE);
+    const auto min = chunkAt(center - radius);
+    const auto max = chunkAt(center + radius);
+    const auto radiusSquared = radius * radius;
+
+    auto inRadius = [&](glm::ivec3 position) {
+      const auto lo = glm::vec3(position) * size;
+      const auto closest = glm::clamp(center, lo, lo + size);
+      const auto offset = closest - center;
+      return glm::dot(offset, offset) < radiusSquared;
+    };
+
+    const auto extent = glm::i64vec3(max - min) + int64_t{1};
+    if (extent.x * extent.y * extent.z > static_cast<int64_t>(liveCount)) {
+      forEach([&](ChunkHandle handle, glm::ivec3 position, Chunk &chunk) {
+        if (glm::all(glm::greaterThanEqual(position, min)) &&
+            glm::all(glm::lessThanEqual(position, max)) &&
+            inRadius(position)) {
+          fn(handle, position, chunk);
+        }
+      });
+      return;
+    }
+
+    for (int z = min.z; z <= max.z; ++z) {
+      for (int y = min.y; y <= max.y; ++y) {
+        for (int x = min.x; x <= max.x; ++x) {
+          const glm::ivec3 position{x, y, z};
+          if (!inRadius(position)) {
+            continue;
+          }
+          const auto slot = findSlot(position);
+          if (slot != ChunkHandle::NONE) {
+            fn(handleOf(slot), position, slots[slot].chunk);
+          }
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] auto size() const noexcept -> uint32_t { return liveCount; }
+  [[nodiscard]] auto empty() const noexcept -> bool { return liveCount == 0; }
+  /// Buckets in the brick table.
+  [[nodiscard]] auto capacity() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(buckets.size());
+  }
+  /// Bricks holding at least one chunk.
+  [[nodiscard]] auto brickCount() const noexcept -> uint32_t {
+    return brickLiveCount;
+  }
+
+private:
+  /// Bricks are `1 << BRICK_SHIFT` chunks along each axis.
+  static constexpr uint32_t BRICK_SHIFT = 2;
+  static constexpr int32_t BRICK_MASK = (1 << BRICK_SHIFT) - 1;
+  static constexpr uint32_t BRICK_VOLUME = 1u << (BRICK_SHIFT * 3);
+
+  struct Bucket {
+    /// `pack` of the brick's coordinate.
+    uint64_t key;
+    /// `ChunkHandle::NONE` when empty.
+    uint32_t brick;
+  };
+
+  struct Brick {
+    /// Indexed by `brickIndex`, `ChunkHandle::NONE` where there is no chunk.
+    std::array<uint32_t, BRICK_VOLUME> slots;
+    uint32_t count;
+  };
+
+  struct Slot {
+    Chunk chunk;
+    glm::ivec3 position;
+    bool dirty;
+  };
+
+  /// Slot of each chunk around one, `ChunkHandle::NONE` if missing.
+  using Links = std::array<uint32_t, NEIGHBOURHOOD>;
+
+  std::vector<Bucket> buckets;
+  /// `64 - log2(buckets.size())`, so the hash's top bits pick the bucket.
+  uint32_t shift = 64;
+  std::vector<Brick> bricks;
+  std::vector<uint32_t> freeBricks;
+  uint32_t brickLiveCount = 0;
+  std::vector<Slot> slots;
+  /// Of each slot, apart from `slots` so a lookup reads no more of the slot
+  /// than the chunk.
+  std::vector<Links> links;
+  /// Of each slot, odd while it holds a chunk. Bumped when a chunk is erased
+  /// and again when the slot is reused.
+  std::vector<uint32_t> generations;
+  std::vector<uint32_t> freeSlots;
+  uint32_t liveCount = 0;
+  /// Dirty chunks in the order they were marked. Chunks cleaned or erased
+  /// since are skipped when they come up.
+  std::deque<ChunkHandle> dirtyQueue;
+  uint32_t dirtyChunks = 0;
+
+  [[nodiscard]] static constexpr auto isLive(uint32_t generation) noexcept
+      -> bool {
+    return (generation & 1) != 0;
+  }
+
+  [[nodiscard]] static constexpr auto brickKey(glm::ivec3 position) noexcept
+      -> uint64_t {
+    return pack(glm::ivec3(position.x >> BRICK_SHIFT,
+                           position.y >> BRICK_SHIFT,
+                           position.z >> BRICK_SHIFT));
+  }
+
+  /// Where the chunk at `position` goes within its brick.
+  [[nodiscard]] static constexpr auto brickIndex(glm::ivec3 position) noexcept
+      -> uint32_t {
+    return static_cast<uint32_t>(
+        (position.x & BRICK_MASK) |
+        ((position.y & BRICK_MASK) << BRICK_SHIFT) |
+        ((position.z & BRICK_MASK) << (BRICK_SHIFT * 2)));
+  }
+
+  [[nodiscard]] auto home(uint64_t key) const noexcept -> uint32_t {
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+  }
+
+  [[nodiscard]] auto handleOf(uint32_t slot) const noexcept -> ChunkHandle {
+    if (slot == ChunkHandle::NONE) {
+      return {};
+    }
+    return ChunkHandle{.index = slot, .generation = generations[slot]};
+  }
+
+  /// `ChunkHandle::NONE` when there is no brick with `key`.
+  [[nodiscard]] auto findBrick(uint64_t key) const noexcept -> uint32_t {
+    const auto mask = static_cast<uint32_t>(buckets.size() - 1);
+    for (auto i = home(key);; i = (i + 1) & mask) {
+      const auto &bucket = buckets[i];
+      if (bucket.brick == ChunkHandle::NONE) {
+        return ChunkHandle::NONE;
+      }
+      if (bucket.key == key) {
+        return bucket.brick;
+      }
+    }
+  }
+  [[nodiscard]] auto findSlot(glm::ivec3 position) const noexcept
+      -> uint32_t {
+    const auto brick = findBrick(brickKey(position));
+    return brick == ChunkHandle::NONE
+               ? ChunkHandle::NONE
+               : bricks[brick].slots[brickIndex(position)];
+  }
+  /// Adds an empty brick with `key`, growing the table if it has to.
+  auto addBrick(uint64_t key) noexcept -> uint32_t;
+  void rehash(uint32_t bucketCount) noexcept;
+  void insertBucket(uint64_t key, uint32_t brick) noexcept;
+  void eraseBucket(uint64_t key) noexcept;
+  void link(uint32_t slot) noexcept;
+  void unlink(uint32_t slot) noexcept;
+};
+
+/// Marks in `dirty`, by `ChunkMap::pack` of the chunk, the slices a change
+/// to the block at `position`, in world blocks, shows in. Faces on a
+/// chunk's border are culled and shaded against the chunks beside it, so
+/// those are marked too when the block is on their border.
+void markBlock(glm::ivec3 position,
+               std::unordered_map<uint64_t, DirtySlices> &dirty) noexcept;
+
+} // namespace engine::voxel
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/terrain.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+class ChunkMap;
+
+/// Light levels run from 0, dark, to `MAX_LIGHT` and drop by one a block.
+constexpr uint8_t MAX_LIGHT = 15;
+
+/// A voxel's light, block light in the low four bits and sky light in the
+/// high four, as baked into `Quad`.
+[[nodiscard]] constexpr auto packLight(uint8_t block, uint8_t sky) noexcept
+    -> uint8_t {
+  return static_cast<uint8_t>(block | (sky << 4));
+}
+[[nodiscard]] constexpr auto blockLight(uint8_t light) noexcept -> uint8_t {
+  return light & 0xF;
+}
+[[nodiscard]] constexpr auto skyLight(uint8_t light) noexcept -> uint8_t {
+  return light >> 4;
+}
+
+/// Under the open sky with no block light, what is assumed where no light
+/// was worked out.
+constexpr uint8_t SKY_LIT = packLight(0, MAX_LIGHT);
+
+/// Lit columns `Lighting::insertColumn` stitches in per frame, so a burst
+/// of finished columns is spread over several. bench/light.cpp holds this
+/// many within its budget next to a few hundred torches.
+constexpr uint32_t STITCHES_PER_UPDATE = 2;
+
+/// Light `block` gives off.
+[[nodiscard]] auto emission(BlockId block) noexcept -> uint8_t;
+
+/// Whether light passes through `block`. Only air does: a block giving off
+/// light lights its neighbours, but nothing passes through it.
+[[nodiscard]] constexpr auto isTransparent(BlockId block) noexcept -> bool {
+  return block == AIR;
+}
+
+/// The light of every voxel of a chunk, ordered by `Chunk::index`.
+///
+/// Stored as a single value until a voxel differs, chunks in the open sky or
+/// deep underground never need more. Copies share their storage until one
+/// of them is written, see `PackedArray`, so mesh jobs can take a snapshot.
+class ChunkLight {
+public:
+  ChunkLight() noexcept = default;
+  explicit ChunkLight(uint8_t fill) noexcept : fill(fill) {}
+  explicit ChunkLight(std::span<const uint8_t, CHUNK_VOLUME> values) noexcept;
+
+  [[nodiscard]] auto get(uint32_t index) const noexcept -> uint8_t {
+    return isUniform() ? fill : static_cast<uint8_t>(values.get(index));
+  }
+
+  void set(uint32_t index, uint8_t value) noexcept;
+
+  [[nodiscard]] auto isUniform() const noexcept -> bool {
+    return values.bits() == 0;
+  }
+
+  /// Bytes of heap and inline storage owned by this chunk's light.
+  [[nodiscard]] auto memoryUsage() const noexcept -> size_t {
+    return sizeof(*this) + values.byteSize();
+  }
+
+private:
+  PackedArray values;
+  uint8_t fill = 0;
+};
+
+using ColumnLight = std::array<ChunkLight, COLUMN_CHUNKS>;
+
+/// Block and sky light of the loaded columns, spread breadth first.
+///
+/// Sky light is `MAX_LIGHT` from the top of the world down to the first
+/// block that is not air, and block light starts at the blocks that give it
+/// off. Both then spread to neighbouring air, one level darker a block,
+/// except that full sky light keeps going straight down undimmed.
+///
+/// A column is lit on its own by `lightColumn`, the bulk of the work, which
+/// only reads its chunks and so runs on a job. `insertColumn` then spreads
+/// light across its borders with the columns already lit, and
+/// `blockChanged` relights around an edit: light that came from the old
+/// block is taken out breadth first, then what is left spreads back in.
+/// Both only visit the blocks whose light changes and those beside them, so
+/// they stay bounded by the light's reach rather than the chunks touched.
+/// Neither recurses, both work off queues kept between calls.
+///
+/// Light that reached a column through a column since erased stays until it
+/// is next relit. Columns are erased far past the ones drawn at full detail,
+/// further than any light carries sideways.
+class Lighting {
+public:
+  /// Lights `chunks`, a column bottom up, as if nothing were beside it.
+  [[nodiscard]] static auto
+  lightColumn(std::span<const Chunk, COLUMN_CHUNKS> chunks) noexcept
+      -> ColumnLight;
+
+  /// Adds the light of `column`, from `lightColumn` on the chunks now in
+  /// `chunks`, and spreads light between it and the lit columns beside it.
+  void insertColumn(const ChunkMap &chunks, glm::ivec2 column,
+                    ColumnLight light) noexcept;
+  void eraseColumn(glm::ivec2 column) noexcept;
+
+  /// Relights around `position`, in world blocks, after its block in
+  /// `chunks` changed. Its column must be lit.
+  void blockChanged(const ChunkMap &chunks, glm::ivec3 position) noexcept;
+
+  /// Null where the chunk is not lit.
+  [[nodiscard]] auto get(glm::ivec3 chunk) const noexcept
+      -> const ChunkLight *;
+  /// `SKY_LIT` where the block is not lit.
+  [[nodiscard]] auto getLight(glm::ivec3 position) const noexcept -> uint8_t;
+
+  /// Appends the blocks whose light changed since the last call to `out`,
+  /// in world blocks, possibly more than once.
+  void takeChanged(std::vector<glm::ivec3> &out) noexcept;
+
+  /// Blocks the last `insertColumn` or `blockChanged` looked at.
+  [[nodiscard]] auto visited() const noexcept -> uint64_t {
+    return lastVisited;
+  }
+
+  [[nodiscard]] auto memoryUsage() const noexcept -> size_t;
+
+private:
+  struct Removal {
+    glm::ivec3 position;
+    uint8_t level;
+  };
+
+  /// Spreads the light in the bits at `shift` of each of `queue`'s blocks
+  /// to its neighbours, and theirs in turn, emptying `queue`.
+  template <typename Volume>
+  static auto spread(Volume &volume, uint32_t shift,
+                     std::vector<glm::ivec3> &queue) noexcept -> uint64_t;
+  /// Takes out the light that came from `removals`, emptying it, and queues
+  /// the blocks lit from elsewhere that border the dark left behind.
+  template <typename Volume>
+  static auto unspread(Volume &volume, uint32_t shift,
+                       std::vector<Removal> &removals,
+                       std::vector<glm::ivec3> &queue) noexcept -> uint64_t;
+
+  /// By `ChunkMap::pack` of the chunk.
+  std::unordered_map<uint64_t, ChunkLight> lights;
+  std::vector<glm::ivec3> changed;
+  std::vector<glm::ivec3> spreads;
+  std::vector<Removal> removals;
+  uint64_t lastVisited = 0;
+};
+
+} // namespace engine::voxel
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/terrain.hpp"
+
+#include <array>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+/// Levels of detail. Level 0 is the chunks as they are, and each level
+/// after halves the resolution along every axis, so a level `l` cell covers
+/// `1 << l` blocks a side.
+constexpr uint32_t LOD_LEVELS = 4;
+
+/// Halves a grid of blocks of `size`, ordered like `Chunk::index` with x
+/// innermost, along every axis into `out`. A cell is solid when at least
+/// half of its eight blocks are, and takes the block of its top-most solid
+/// one, so hillsides keep their shape and the grass stays on top.
+void downsample(std::span<const BlockId> in, glm::uvec3 size,
+                std::span<BlockId> out) noexcept;
+
+/// A column at level `LEVEL`, kept instead of its chunks once it is too far
+/// away to draw at a finer level. The air above the highest solid cell is
+/// not stored.
+class ColumnSummary {
+public:
+  static constexpr uint32_t LEVEL = 2;
+  static constexpr uint32_t SIZE = CHUNK_SIZE >> LEVEL;
+  static constexpr uint32_t HEIGHT = COLUMN_HEIGHT >> LEVEL;
+
+  ColumnSummary() = default;
+  explicit ColumnSummary(
+      std::span<const Chunk, COLUMN_CHUNKS> chunks) noexcept;
+
+  [[nodiscard]] auto get(uint32_t x, uint32_t y, uint32_t z) const noexcept
+      -> BlockId {
+    return y < layers ? cells[(y * SIZE + z) * SIZE + x] : AIR;
+  }
+
+  [[nodiscard]] auto memoryUsage() const noexcept -> size_t {
+    return sizeof(*this) + cells.capacity() * sizeof(BlockId);
+  }
+
+private:
+  std::vector<BlockId> cells;
+  uint32_t layers = 0;
+};
+
+/// The cells of mesh `index` of a level 1 tile as a chunk, 32 cells of two
+/// blocks a side, from the tile's four columns, x first.
+[[nodiscard]] auto coarseNode(
+    std::span<const std::array<Chunk, COLUMN_CHUNKS>, 4> columns,
+    uint32_t index) noexcept -> Chunk;
+
+/// The cells of mesh `index` of a tile of `level`, 2 or more, as a chunk,
+/// from the summaries of the tile's `1 << level` by `1 << level` columns, x
+/// first.
+[[nodiscard]] auto coarseNode(std::span<const ColumnSummary *const> summaries,
+                              uint32_t level, uint32_t index) noexcept
+    -> Chunk;
+
+/// A square of columns drawn at one level of detail: `1 << level` columns a
+/// side, as `COLUMN_CHUNKS >> level` meshes stacked from the bottom up.
+struct LodTile {
+  /// In tiles of this level.
+  glm::ivec2 position;
+  uint32_t level;
+
+  [[nodiscard]] constexpr auto size() const noexcept -> int32_t {
+    return 1 << level;
+  }
+  /// The column in its minimum corner.
+  [[nodiscard]] constexpr auto firstColumn() const noexcept -> glm::ivec2 {
+    return position * size();
+  }
+  [[nodiscard]] constexpr auto meshCount() const noexcept -> uint32_t {
+    return COLUMN_CHUNKS >> level;
+  }
+  /// The chunk in the minimum corner of mesh `index`.
+  [[nodiscard]] constexpr auto meshPosition(uint32_t index) const noexcept
+      -> glm::ivec3 {
+    const auto first = firstColumn();
+    return {first.x, static_cast<int32_t>(index) * size(), first.y};
+  }
+
+  [[nodiscard]] constexpr auto parent() const noexcept -> LodTile {
+    return {.position = {position.x >> 1, position.y >> 1},
+            .level = level + 1};
+  }
+  /// `index` in [0, 4), x first.
+  [[nodiscard]] constexpr auto child(uint32_t index) const noexcept
+      -> LodTile {
+    return {.position = position * 2 + glm::ivec2(index & 1, index >> 1),
+            .level = level - 1};
+  }
+  /// The tile of `level` holding `column`.
+  [[nodiscard]] static constexpr auto of(glm::ivec2 column,
+                                         uint32_t level) noexcept
+      -> LodTile {
+    return {.position = {column.x >> level, column.y >> level},
+            .level = level};
+  }
+
+  /// Unique across levels, coordinates wrap past 29 bits.
+  [[nodiscard]] constexpr auto key() const noexcept -> uint64_t {
+    constexpr uint64_t MASK = (uint64_t{1} << 29) - 1;
+    return (static_cast<uint64_t>(level) << 58) |
+           ((static_cast<uint64_t>(static_cast<uint32_t>(position.x)) & MASK)
+            << 29) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(position.y)) & MASK);
+  }
+
+  constexpr auto operator==(const LodTile &) const noexcept -> bool = default;
+};
+
+/// Picks the tiles to draw around the camera, a quadtree over the columns
+/// with clipmap-like rings: full detail out to about `distance` columns, and
+/// each level after reaching twice as far as the one before. A ring then
+/// covers four times the area of the one inside it with cells four times
+/// the area, so every ring costs about as many quads as the inside of the
+/// first, and doubling the reach costs one more ring.
+///
+/// A tile splits into its four children once the camera comes within its
+/// level's distance of its centre, and merges back only once the camera is
+/// `hysteresis` times that distance further away, so a camera hovering on a
+/// boundary does not keep switching the tiles on it. The tiles picked never
+/// overlap and leave no gaps.
+class LodTree {
+public:
+  struct Settings {
+    /// In columns, drawn at full detail.
+    uint32_t distance;
+    /// Levels past full detail, below `LOD_LEVELS`.
+    uint32_t levels;
+    float hysteresis = 0.25f;
+  };
+
+  explicit LodTree(const Settings &settings) noexcept;
+
+  /// Picks the tiles for `eye`, such as `Camera::getPosition()`.
+  void update(const glm::vec3 &eye) noexcept;
+
+  [[nodiscard]] auto tiles() const noexcept -> std::span<const LodTile> {
+    return selected;
+  }
+
+  /// In columns, how far from the camera tiles are drawn, give or take half
+  /// a tile of the coarsest level.
+  [[nodiscard]] auto reach() const noexcept -> float {
+    return static_cast<float>(settings.distance << settings.levels);
+  }
+  /// In columns, from the camera to the centre of the furthest column a tile
+  /// picked can cover.
+  [[nodiscard]] auto coverage() const noexcept -> float {
+    return reach() * (1.0f + settings.hysteresis) +
+           static_cast<float>(rootSize()) * std::numbers::sqrt2_v<float> *
+               0.5f;
+  }
+  /// Columns a tile of the coarsest level spans.
+  [[nodiscard]] auto rootSize() const noexcept -> int32_t {
+    return 1 << settings.levels;
+  }
+
+  /// In columns, horizontally from `eye` to the centre of `tile`.
+  [[nodiscard]] static auto distance(const glm::vec3 &eye,
+                                     const LodTile &tile) noexcept -> float;
+
+private:
+  Settings settings;
+  /// Tiles split, and roots shown, by the last update.
+  std::unordered_set<uint64_t> split;
+  std::unordered_set<uint64_t> roots;
+  std::vector<LodTile> selected;
+
+  void select(const glm::vec3 &eye, const LodTile &tile,
+              std::unordered_set<uint64_t> &nextSplit) noexcept;
+};
+
+} // namespace engine::voxel
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/quad.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine::voxel {
+
+/// Chunks bordering the one being meshed, indexed by the `Face` pointing at
+/// them. Missing neighbours are treated as air.
+///
+/// `light` is the meshed chunk's and `lights` the neighbours', baked into
+/// each face from the voxel in front of it. Where missing, faces are lit as
+/// if under the open sky.
+struct ChunkNeighbours {
+  std::array<const Chunk *, FACE_COUNT> chunks{};
+  const ChunkLight *light = nullptr;
+  std::array<const ChunkLight *, FACE_COUNT> lights{};
+};
+
+/// Quads `Mesher::mesh` appended for each face, indexed by `Face`.
+using FaceCounts = std::array<uint32_t, FACE_COUNT>;
+
+/// Quads `Mesher::mesh` appended for each depth slice of each face, indexed
+/// [face][depth]. A slice never holds more than CHUNK_SIZE * CHUNK_SIZE.
+using SliceCounts = std::array<std::array<uint16_t, CHUNK_SIZE>, FACE_COUNT>;
+
+[[nodiscard]] auto faceCounts(const SliceCounts &slices) noexcept
+    -> FaceCounts;
+
+/// Slices of a chunk's mesh to build again, bit `depth` of `layers[face]`.
+///
+/// A face's quads at one depth only depend on the blocks in that layer and
+/// the layer in front of it, which the occlusion is sampled from, so an edit
+/// dirties at most two slices of each face.
+struct DirtySlices {
+  std::array<uint32_t, FACE_COUNT> layers{};
+
+  [[nodiscard]] static auto all() noexcept -> DirtySlices;
+
+  /// Marks the slices a change to the block at (`x`, `y`, `z`) shows in, in
+  /// blocks from the chunk's minimum corner. Blocks one outside the chunk
+  /// are its neighbours' layers it is meshed against.
+  void mark(int32_t x, int32_t y, int32_t z) noexcept;
+
+  void merge(const DirtySlices &other) noexcept {
+    for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+      layers[face] |= other.layers[face];
+    }
+  }
+
+  [[nodiscard]] auto empty() const noexcept -> bool {
+    for (const auto face : layers) {
+      if (face != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/// A run of quads of a patched mesh, from its previous quads or from the
+/// ones `Mesher::remesh` built.
+struct SliceRun {
+  bool remeshed;
+  /// In quads, into the previous mesh or the remeshed quads.
+  uint32_t source;
+  /// In quads, into the patched mesh.
+  uint32_t target;
+  uint32_t count;
+};
+
+/// Appends the runs that put together a mesh whose slices were `before`,
+/// with the slices in `dirty` meshed again into `after`. Neighbouring runs
+/// from the same source are merged, so a single edit takes a handful.
+void sliceRuns(const SliceCounts &before, const SliceCounts &after,
+               const DirtySlices &dirty, std::vector<SliceRun> &out) noexcept;
+
+/// Greedy mesher built on 64-bit occupancy columns.
+///
+/// Each axis gets a CHUNK_SIZE x CHUNK_SIZE grid of columns whose bits mark
+/// solid voxels along that axis, padded by one voxel from the neighbouring
+/// chunks. Visible faces fall out of a shift and mask per column, and are
+/// merged into quads one 32-bit plane row at a time using ctz/countr_one.
+///
+/// Faces are bucketed by block, ambient occlusion pattern and light, and a
+/// quad only grows along a direction its corner pattern is constant in, so
+/// merging never changes how the occlusion is interpolated. Neighbour chunks
+/// only contribute their touching face layer, so corners on chunk edges see
+/// air past them.
+///
+/// Within a face, quads are ordered by depth, so each slice of a face is a
+/// contiguous range that `remesh` can build again on its own after an edit.
+///
+/// A mesher keeps its scratch buffers between calls, so reuse one per thread.
+class Mesher {
+public:
+  Mesher() noexcept;
+
+  /// Appends the quads of `chunk` to `out`, grouped by face in `Face` order
+  /// so each direction can be drawn on its own, then by depth. Returns how
+  /// many quads each face got, and if given, each slice in `slices`.
+  auto mesh(const Chunk &chunk, const ChunkNeighbours &neighbours,
+            std::vector<Quad> &out, SliceCounts *slices = nullptr) noexcept
+      -> FaceCounts;
+
+  /// Appends the quads of only the slices in `dirty` to `out`, in the same
+  /// order as `mesh`, and sets their counts in `slices`. Together with the
+  /// other slices of the previous mesh, see `sliceRuns`, they make what
+  /// `mesh` would have.
+  void remesh(const Chunk &chunk, const ChunkNeighbours &neighbours,
+              const DirtySlices &dirty, std::vector<Quad> &out,
+              SliceCounts &slices) noexcept;
+
+private:
+  static constexpr uint32_t PADDED_SIZE = CHUNK_SIZE + 2;
+  static constexpr uint32_t PADDED_VOLUME =
+      PADDED_SIZE * PADDED_SIZE * PADDED_SIZE;
+
+  struct Plane {
+    BlockId block;
+    uint8_t ao;
+    uint8_t light;
+    uint8_t depth;
+    std::array<uint32_t, CHUNK_SIZE> rows;
+  };
+
+  /// Block ids of the chunk with a one voxel border from its neighbours.
+  std::unique_ptr<std::array<BlockId, PADDED_VOLUME>> blocks;
+  std::unique_ptr<std::array<BlockId, CHUNK_VOLUME>> unpacked;
+
+  /// Occupancy columns indexed [axis][u][v], except axis Z which is stored
+  /// [v][u] so every axis is built walking x innermost.
+  std::array<std::array<std::array<uint64_t, CHUNK_SIZE>, CHUNK_SIZE>, 3>
+      columns;
+
+  std::vector<Plane> planes;
+  /// Index of the first plane of each depth slice, rebuilt per face.
+  std::array<std::vector<uint32_t>, CHUNK_SIZE> planesAtDepth;
+
+  [[nodiscard]] static constexpr auto paddedIndex(uint32_t x, uint32_t y,
+                                                  uint32_t z) noexcept
+      -> uint32_t {
+    return (y * PADDED_SIZE + z) * PADDED_SIZE + x;
+  }
+
+  void gather(const Chunk &chunk, const ChunkNeighbours &neighbours) noexcept;
+  void buildColumns() noexcept;
+  /// Builds only the bits of the columns in `layers`, padded layers along
+  /// each axis, leaving the rest clear.
+  void buildLayers(const std::array<uint64_t, 3> &layers) noexcept;
+  /// Meshes the slices of `face` set in `layers`.
+  void meshFace(Face face, uint32_t layers, const ChunkNeighbours &neighbours,
+                std::vector<Quad> &out,
+                std::array<uint16_t, CHUNK_SIZE> &slices) noexcept;
+  /// Merges the faces of `plane` into quads, consuming its rows.
+  static void mergePlane(Plane &plane, Face face,
+                         std::vector<Quad> &out) noexcept;
+  [[nodiscard]] auto planeFor(uint32_t depth, BlockId block, uint8_t ao,
+                              uint8_t light) noexcept -> Plane &;
+  [[nodiscard]] auto occlusion(std::array<uint32_t, 3> front, uint32_t uAxis,
+                               uint32_t vAxis) const noexcept -> uint8_t;
+};
+
+} // namespace engine::voxel
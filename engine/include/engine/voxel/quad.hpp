@@ -0,0 +1,98 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/light.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace engine::voxel {
+
+/// Direction a quad faces. Axis is `face / 2`, positive faces are even.
+enum class Face : uint8_t { PosX, NegX, PosY, NegY, PosZ, NegZ };
+
+constexpr uint32_t FACE_COUNT = 6;
+
+[[nodiscard]] constexpr auto faceAxis(Face face) noexcept -> uint32_t {
+  return static_cast<uint32_t>(face) / 2;
+}
+
+[[nodiscard]] constexpr auto isPositive(Face face) noexcept -> bool {
+  return (static_cast<uint32_t>(face) & 1) == 0;
+}
+
+/// One merged rectangle of block faces packed into 8 bytes. This is the
+/// vertex format, `mesh.slang` expands six vertices per quad from it.
+///
+/// `position` is the minimum voxel covered by the quad. For a face on axis A
+/// the quad spans `width` voxels along axis (A + 1) % 3 and `height` voxels
+/// along axis (A + 2) % 3. Positive faces lie on the far side of the voxel.
+///
+/// Layout, low word first:
+///   lo:  x:6 y:6 z:6 face:3 (width-1):5 (height-1):5
+///   hi:  block:16 ao:4 light:8
+///
+/// Each `ao` bit marks one occluded corner, in the order (0,0), (w,0), (w,h),
+/// (0,h) of the quad's (u, v) plane. `light` is the light of the voxels in
+/// front of the face, as packed by `packLight`.
+struct Quad {
+  uint32_t lo;
+  uint32_t hi;
+
+  static constexpr uint32_t POSITION_BITS = 6;
+  static constexpr uint32_t FACE_SHIFT = 18;
+  static constexpr uint32_t WIDTH_SHIFT = 21;
+  static constexpr uint32_t HEIGHT_SHIFT = 26;
+  static constexpr uint32_t AO_SHIFT = 16;
+  static constexpr uint32_t LIGHT_SHIFT = 20;
+
+  [[nodiscard]] static constexpr auto
+  make(std::array<uint8_t, 3> position, Face face, uint32_t width,
+       uint32_t height, BlockId block, uint8_t ao = 0,
+       uint8_t light = SKY_LIT) noexcept -> Quad {
+    return Quad{
+        .lo = static_cast<uint32_t>(position[0]) |
+              (static_cast<uint32_t>(position[1]) << POSITION_BITS) |
+              (static_cast<uint32_t>(position[2]) << (POSITION_BITS * 2)) |
+              (static_cast<uint32_t>(face) << FACE_SHIFT) |
+              ((width - 1) << WIDTH_SHIFT) | ((height - 1) << HEIGHT_SHIFT),
+        .hi = static_cast<uint32_t>(block) |
+              (static_cast<uint32_t>(ao & 0xF) << AO_SHIFT) |
+              (static_cast<uint32_t>(light) << LIGHT_SHIFT)};
+  }
+
+  [[nodiscard]] constexpr auto position() const noexcept
+      -> std::array<uint8_t, 3> {
+    return {static_cast<uint8_t>(lo & 0x3F),
+            static_cast<uint8_t>((lo >> POSITION_BITS) & 0x3F),
+            static_cast<uint8_t>((lo >> (POSITION_BITS * 2)) & 0x3F)};
+  }
+
+  [[nodiscard]] constexpr auto face() const noexcept -> Face {
+    return static_cast<Face>((lo >> FACE_SHIFT) & 0x7);
+  }
+
+  [[nodiscard]] constexpr auto width() const noexcept -> uint32_t {
+    return ((lo >> WIDTH_SHIFT) & 0x1F) + 1;
+  }
+
+  [[nodiscard]] constexpr auto height() const noexcept -> uint32_t {
+    return ((lo >> HEIGHT_SHIFT) & 0x1F) + 1;
+  }
+
+  [[nodiscard]] constexpr auto block() const noexcept -> BlockId {
+    return static_cast<BlockId>(hi & 0xFFFF);
+  }
+
+  [[nodiscard]] constexpr auto ao() const noexcept -> uint8_t {
+    return static_cast<uint8_t>((hi >> AO_SHIFT) & 0xF);
+  }
+
+  [[nodiscard]] constexpr auto light() const noexcept -> uint8_t {
+    return static_cast<uint8_t>((hi >> LIGHT_SHIFT) & 0xFF);
+  }
+};
+
+static_assert(sizeof(Quad) == 8);
+
+} // namespace engine::voxel
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "engine/mappedFile.hpp"
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/terrain.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+/// Columns along each side of a region.
+constexpr uint32_t REGION_SIZE = 32;
+constexpr uint32_t REGION_COLUMNS = REGION_SIZE * REGION_SIZE;
+
+/// One file holding the columns of a `REGION_SIZE` square, each stored as
+/// its serialized chunks plus caller metadata, compressed with LZ4.
+///
+/// The file starts with a table of where each column lives. Saving never
+/// writes over anything the table points to: the column goes in free space
+/// and its new table entry is only kept in memory until `commit` has
+/// flushed the column to disk and then writes the entries. A crash at any
+/// point leaves every entry pointing at the old or the new copy of a
+/// column, both intact, and each entry carries a checksum to catch a torn
+/// disk anyway. A replaced copy's space is free again once the commit that
+/// replaced it is on disk, and whatever a failed commit left unused is
+/// found again the next time the file is opened.
+///
+/// Reads decompress straight out of a memory mapping of the file, with no
+/// system call or copy into a read buffer first. The file grows ahead of
+/// saves by doubling, so it is only mapped again every so often.
+///
+/// Not thread safe, `RegionStore` adds the locking.
+class RegionFile {
+  struct Extent {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  struct Entry {
+    uint64_t offset;
+    /// Compressed bytes, 0 for a column never saved.
+    uint32_t size;
+    uint32_t rawSize;
+    uint32_t checksum;
+    uint32_t reserved[3];
+  };
+
+public:
+  /// A column compressed by `encode`, ready for `save`.
+  struct Encoded {
+    std::vector<std::byte> bytes;
+    uint32_t rawSize = 0;
+  };
+
+  /// Creates the file if it does not exist.
+  static auto open(const std::filesystem::path &path) noexcept
+      -> std::expected<RegionFile, std::string>;
+
+  /// Compresses a column. Touches no file, so any thread can encode while
+  /// another saves.
+  static void encode(std::span<const Chunk, COLUMN_CHUNKS> chunks,
+                     std::span<const std::byte> metadata,
+                     Encoded &out) noexcept;
+
+  /// Whether the column at `local` within the region has been saved.
+  [[nodiscard]] auto contains(glm::ivec2 local) const noexcept -> bool;
+
+  /// Reads the column at `local` within the region into `chunks` and
+  /// `metadata`. False if it was never saved, an error if it is damaged.
+  auto load(glm::ivec2 local, std::span<Chunk, COLUMN_CHUNKS> chunks,
+            std::vector<std::byte> &metadata) const noexcept
+      -> std::expected<bool, std::string>;
+
+  /// Saves the column at `local` within the region. Loads see it straight
+  /// away, but it only survives a crash once committed.
+  auto save(glm::ivec2 local, const Encoded &column) noexcept
+      -> std::expected<void, std::string>;
+
+  /// Makes every save so far durable, with two flushes however many there
+  /// were.
+  auto commit() noexcept -> std::expected<void, std::string>;
+
+  /// `commit` in steps, so a caller locking the file only has to hold its
+  /// lock around `prepareCommit`, `finishCommit` and `endCommit`, not the
+  /// flushes: prepare, `flush`, finish, `flush`, end. Saves made in between
+  /// are left for the next commit. One commit at a time.
+  struct Batch {
+    std::vector<std::pair<uint32_t, Entry>> entries;
+    /// Where the entries' columns were before, free once on disk.
+    std::vector<Extent> replaced;
+  };
+  [[nodiscard]] auto prepareCommit() noexcept -> Batch;
+  auto finishCommit(Batch &batch) noexcept
+      -> std::expected<void, std::string>;
+  /// Ends the commit `prepareCommit` began, however far it got. `durable`
+  /// if it was finished and flushed, only then is the space it replaced
+  /// freed.
+  void endCommit(const Batch &batch, bool durable) noexcept;
+  /// Safe to call while another thread uses the file.
+  auto flush() const noexcept -> std::expected<void, std::string> {
+    return file.sync();
+  }
+
+  /// Saves not yet committed.
+  [[nodiscard]] auto pendingCount() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(pending.size());
+  }
+
+private:
+  MappedFile file;
+  /// Past every column, where a save goes if nothing in `gaps` fits.
+  uint64_t end;
+  /// Free space before `end`, in order and never touching.
+  std::vector<Extent> gaps;
+  /// Saved but not committed, by column index.
+  std::unordered_map<uint32_t, Entry> pending;
+  /// Offsets of the entries in the batch being committed, which stay taken
+  /// even if saved over, as the commit still writes them to the table.
+  std::vector<uint64_t> committing;
+
+  RegionFile(MappedFile file, uint64_t end) noexcept
+      : file(std::move(file)), end(end) {}
+
+  [[nodiscard]] auto entry(uint32_t index) const noexcept -> Entry;
+  /// Takes `size` bytes from the first gap they fit in, or from `end`.
+  auto allocate(uint64_t size) noexcept -> uint64_t;
+  void release(Extent extent) noexcept;
+};
+
+/// A directory of region files, one per region, opened as they are first
+/// needed.
+///
+/// Safe to use from any thread. Loads from a region run in parallel with
+/// each other, saves and commits take the region to themselves, and
+/// different regions never wait on each other.
+class RegionStore {
+public:
+  /// Creates the directory if it does not exist.
+  static auto open(const std::filesystem::path &directory) noexcept
+      -> std::expected<RegionStore, std::string>;
+
+  /// Reads a column. False if it was never saved, without creating its
+  /// region file.
+  auto load(glm::ivec2 column, std::span<Chunk, COLUMN_CHUNKS> chunks,
+            std::vector<std::byte> &metadata) noexcept
+      -> std::expected<bool, std::string>;
+
+  auto save(glm::ivec2 column, std::span<const Chunk, COLUMN_CHUNKS> chunks,
+            std::span<const std::byte> metadata) noexcept
+      -> std::expected<void, std::string>;
+
+  /// Commits every region with saves pending.
+  auto commit() noexcept -> std::expected<void, std::string>;
+  /// Commits only the region at `region`, see `regionOf`.
+  auto commit(glm::ivec2 region) noexcept -> std::expected<void, std::string>;
+
+  /// The region holding `column`, and where in it.
+  [[nodiscard]] static auto regionOf(glm::ivec2 column) noexcept
+      -> glm::ivec2 {
+    return glm::ivec2(column.x >> 5, column.y >> 5);
+  }
+  [[nodiscard]] static auto localOf(glm::ivec2 column) noexcept
+      -> glm::ivec2 {
+    return glm::ivec2(column.x & 31, column.y & 31);
+  }
+
+private:
+  static_assert(REGION_SIZE == 32, "regionOf and localOf shift by 5");
+
+  struct Region {
+    /// Held through a whole commit, so two never overlap.
+    std::mutex committing;
+    std::shared_mutex mutex;
+    /// Empty until the first save if the file did not exist when the
+    /// region was first asked for.
+    std::optional<RegionFile> file;
+  };
+
+  struct Regions {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::unique_ptr<Region>> byKey;
+  };
+
+  std::filesystem::path directory;
+  /// Held by pointer so the store stays movable.
+  std::unique_ptr<Regions> regions;
+
+  explicit RegionStore(std::filesystem::path directory) noexcept
+      : directory(std::move(directory)),
+        regions(std::make_unique<Regions>()) {}
+
+  [[nodiscard]] auto path(glm::ivec2 region) const noexcept
+      -> std::filesystem::path;
+  auto commit(Region &region) noexcept -> std::expected<void, std::string>;
+  /// Finds a region, opening its file the first time if it exists.
+  auto find(glm::ivec2 region) noexcept
+      -> std::expected<Region *, std::string>;
+};
+
+} // namespace engine::voxel
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "engine/voxel/chunk.hpp"
+#include "engine/voxel/region.hpp"
+#include "engine/voxel/terrain.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+/// Columns an autosave copies per frame, see `ChunkMap::takeDirtyColumns`.
+/// bench/saver.cpp holds the main thread's part of saving this many within
+/// its frame budget.
+constexpr uint32_t AUTOSAVE_COLUMNS = 16;
+
+/// Writes columns to a `RegionStore` on a thread of its own, so saving never
+/// holds up the frame.
+///
+/// Callers hand over snapshots, copies of the chunks they keep editing,
+/// which share their index storage until either side writes (see
+/// `PackedArray`), so taking one costs about as much as copying the
+/// palettes. `submit` only queues the batch under a lock held for a push,
+/// without waking the thread, which picks up what is queued every 50 ms.
+///
+/// The thread takes everything queued at once, drops all but the newest
+/// snapshot of each column, and saves them a region at a time, committing
+/// each region as it finishes so a region file's lock is never held while
+/// the disk flushes. Saving can be throttled to a number of columns per
+/// second so an autosave does not compete with loading for the disk.
+class BackgroundSaver {
+public:
+  struct Settings {
+    /// 0 to save as fast as the disk allows.
+    uint32_t maxColumnsPerSecond = 0;
+  };
+
+  struct Column {
+    glm::ivec2 position;
+    std::array<Chunk, COLUMN_CHUNKS> chunks;
+    /// Passed on to `RegionStore::save`.
+    std::vector<std::byte> metadata;
+  };
+
+  /// `store` must outlive the saver.
+  BackgroundSaver(RegionStore &store, const Settings &settings) noexcept;
+  BackgroundSaver(const BackgroundSaver &) = delete;
+  BackgroundSaver &operator=(const BackgroundSaver &) = delete;
+  /// Saves everything submitted, ignoring the throttle, and stops the
+  /// thread.
+  ~BackgroundSaver();
+
+  /// Queues `columns` and returns a ticket for them, see `saved`.
+  auto submit(std::vector<Column> columns) noexcept -> uint64_t;
+
+  /// The ticket of the last batch saved and committed. Tickets count up from
+  /// 1, so every batch with a ticket up to this one is on disk, and loading
+  /// one of its columns returns what was submitted. Saves that fail are
+  /// logged and count as done, there is no retrying a broken store.
+  [[nodiscard]] auto saved() const noexcept -> uint64_t {
+    return savedTicket.load(std::memory_order_acquire);
+  }
+
+  /// Blocks until everything submitted so far is saved, ignoring the
+  /// throttle.
+  void flush() noexcept;
+
+  /// Columns submitted and not yet saved.
+  [[nodiscard]] auto backlog() const noexcept -> uint32_t {
+    return queuedColumns.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Batch {
+    uint64_t ticket;
+    std::vector<Column> columns;
+  };
+
+  RegionStore *store;
+  Settings settings;
+
+  std::mutex mutex;
+  /// Signalled on a flush or when stopping.
+  std::condition_variable wake;
+  std::vector<Batch> queue;
+  uint64_t lastTicket = 0;
+  /// Flushes waiting, the throttle is off while there are any.
+  uint32_t flushing = 0;
+  bool stopping = false;
+
+  std::atomic<uint64_t> savedTicket = 0;
+  std::atomic<uint32_t> queuedColumns = 0;
+
+  std::thread thread;
+
+  void run() noexcept;
+  void save(std::vector<Batch> &batches) noexcept;
+  /// Waits out the throttle before the next column, returning early for a
+  /// flush.
+  void throttle(std::chrono::steady_clock::time_point until) noexcept;
+};
+
+} // namespace engine::voxel
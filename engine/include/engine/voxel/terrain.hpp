@@ -0,0 +1,198 @@
+#pragma once
+
+#include "engine/jobs.hpp"
+#include "engine/noise.hpp"
+#include "engine/voxel/chunk.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace engine::voxel {
+
+class RegionStore;
+
+/// Chunks stacked in a generated column, which spans world y [0,
+/// `COLUMN_HEIGHT`).
+constexpr uint32_t COLUMN_CHUNKS = 8;
+constexpr uint32_t COLUMN_HEIGHT = COLUMN_CHUNKS * CHUNK_SIZE;
+
+/// Blocks the generator places.
+namespace blocks {
+constexpr BlockId STONE = 1;
+constexpr BlockId DIRT = 2;
+constexpr BlockId GRASS = 3;
+constexpr BlockId SAND = 4;
+constexpr BlockId WOOD = 5;
+constexpr BlockId LEAVES = 6;
+/// Never generated, only placed. Gives off light, see `emission`.
+constexpr BlockId TORCH = 7;
+} // namespace blocks
+
+/// Generates terrain one column of chunks at a time on a `JobSystem`.
+///
+/// A column goes through four passes: heightmap, caves, surface decoration
+/// and structures. The first three only touch the column itself and run as
+/// one job. Structures such as trees may reach into neighbouring columns,
+/// so instead of writing into them, each column's structure pass stamps
+/// every structure anchored in itself or its eight neighbours, keeping only
+/// the blocks that land inside itself. It runs once those neighbours have
+/// decorated their surface, whose heights and anchors never change after,
+/// so neighbouring columns run their passes in parallel with each only ever
+/// writing its own chunks and no locks on chunk data.
+///
+/// Every pass is a pure function of the seed and the column's position (and
+/// its neighbours' earlier passes), and structures combine the same way in
+/// any order, so the output does not depend on the thread count or on which
+/// column finishes first.
+///
+/// With a `RegionStore` set, finished columns are saved to it and columns
+/// found in it are loaded instead of generated, skipping every pass. The
+/// tree anchors are saved along with the chunks, as neighbours still being
+/// generated stamp them.
+class TerrainGenerator {
+public:
+  struct Settings {
+    int32_t seed = 0;
+    /// Every instruction set generates the same terrain.
+    noise::Isa isa = noise::bestIsa();
+    /// Jobs in flight at once. Fewer keeps the queue short, so the nearest
+    /// columns stay first in line as the camera moves. 0 picks twice the
+    /// worker count.
+    uint32_t maxJobs = 0;
+    /// Where to load and save columns, optional. Must outlive the
+    /// generator.
+    RegionStore *store = nullptr;
+  };
+
+  /// A finished column, its chunks from the bottom up.
+  struct Column {
+    /// In chunks, the column's chunks sit at (x, 0..COLUMN_CHUNKS, y).
+    glm::ivec2 position;
+    std::array<Chunk, COLUMN_CHUNKS> chunks;
+    /// What the generator needs back from a saved column, to pass along to
+    /// `RegionStore::save` when saving the column again.
+    std::vector<std::byte> metadata;
+  };
+
+  TerrainGenerator(JobSystem &jobs, const Settings &settings) noexcept;
+  TerrainGenerator(TerrainGenerator &&) noexcept;
+  TerrainGenerator &operator=(TerrainGenerator &&) noexcept = delete;
+  /// Waits for the jobs in flight and commits the columns saved.
+  ~TerrainGenerator();
+
+  /// Collects finished jobs and starts the next passes, nearest to `eye`
+  /// first. Columns within `radius` columns of `eye` are generated in full,
+  /// the ring around them up to their surface for their neighbours'
+  /// structures. Columns well past that are dropped, and generated again if
+  /// they come back into range.
+  void update(const glm::vec3 &eye, uint32_t radius) noexcept;
+
+  /// Moves out the columns finished since the last call.
+  [[nodiscard]] auto takeFinished() noexcept -> std::vector<Column>;
+
+  /// Hands `column` out of `takeFinished` again, loaded from the store or
+  /// generated again, for a caller that let go of its chunks. Does nothing
+  /// for a column not kept, or one still in the making, which is handed out
+  /// when done. A column whose neighbours are reading it is left alone, so
+  /// call again later until it comes back.
+  void request(glm::ivec2 column) noexcept;
+
+  /// Runs jobs on the calling thread until every job in flight is done.
+  void wait() noexcept;
+
+  [[nodiscard]] auto jobsInFlight() const noexcept -> uint32_t {
+    return running;
+  }
+  /// Columns kept for generation, finished or not.
+  [[nodiscard]] auto columnCount() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(columns.size());
+  }
+
+  /// The column holding the world position `position`.
+  [[nodiscard]] static auto columnAt(const glm::vec3 &position) noexcept
+      -> glm::ivec2 {
+    return glm::ivec2(glm::floor(glm::vec2(position.x, position.z) /
+                                 static_cast<float>(CHUNK_SIZE)));
+  }
+
+  /// Distance in columns from `eye` to the centre of `column`, horizontally.
+  [[nodiscard]] static auto distance(const glm::vec3 &eye,
+                                     glm::ivec2 column) noexcept -> float {
+    const auto centre =
+        (glm::vec2(column) + 0.5f) * static_cast<float>(CHUNK_SIZE);
+    return glm::length(centre - glm::vec2(eye.x, eye.z)) /
+           static_cast<float>(CHUNK_SIZE);
+  }
+
+private:
+  /// Scheduling only tracks the passes other columns wait on.
+  enum class Stage : uint8_t { Empty, Surface, Structures };
+
+  struct TreeAnchor {
+    /// World position of the block above the ground.
+    glm::ivec3 base;
+    uint32_t height;
+  };
+
+  struct ColumnState {
+    glm::ivec2 position;
+    /// Main thread only. The last stage finished and the one the job in
+    /// flight finishes.
+    Stage stage = Stage::Empty;
+    Stage target = Stage::Empty;
+    bool running = false;
+    /// Neighbour structure passes reading this column.
+    uint32_t pins = 0;
+    JobCounter done;
+    /// Set by the local job when it loaded the finished column instead.
+    bool loaded = false;
+
+    // Written by this column's own jobs. Heights and trees are read only
+    // once `stage` reaches `Surface`.
+    std::array<uint16_t, CHUNK_AREA> heights{};
+    std::vector<TreeAnchor> trees;
+    std::array<Chunk, COLUMN_CHUNKS> chunks;
+    /// `trees` as saved, written by the structures job or the load.
+    std::vector<std::byte> metadata;
+  };
+
+  struct Passes;
+
+  JobSystem *jobs;
+  /// Held by pointer so jobs keep their view of it if the generator moves.
+  std::unique_ptr<const Passes> passes;
+  uint32_t maxJobs;
+  uint32_t running = 0;
+  RegionStore *store;
+  /// Columns saved since the last commit started.
+  uint32_t unsaved = 0;
+  /// Held by pointer so the generator stays movable.
+  std::unique_ptr<JobCounter> committing;
+  std::unordered_map<uint64_t, std::unique_ptr<ColumnState>> columns;
+  std::vector<Column> finished;
+
+  [[nodiscard]] static auto key(glm::ivec2 column) noexcept -> uint64_t {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(column.x)) << 32) |
+           static_cast<uint32_t>(column.y);
+  }
+
+  [[nodiscard]] auto find(glm::ivec2 column) const noexcept -> ColumnState *;
+  void retire(ColumnState &column) noexcept;
+  void startLocal(ColumnState &column) noexcept;
+  void startStructures(ColumnState &column) noexcept;
+  void startCommit() noexcept;
+  [[nodiscard]] static auto load(RegionStore &store,
+                                 ColumnState &column) noexcept -> bool;
+  static void encodeTrees(ColumnState &column) noexcept;
+  /// Calls `fn(ColumnState *)` for the eight neighbours of `column` in a
+  /// fixed order, with null for the ones not kept.
+  template <typename Fn>
+  void forEachNeighbour(const ColumnState &column, Fn &&fn) const noexcept;
+};
+
+} // namespace engine::voxel
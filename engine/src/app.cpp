@@ -15,6 +15,18 @@
 namespace engine {
 
 std::expected<App::FrameInfo, App::TickResult> App::newFrame() noexcept {
+  if (isHeadless()) {
+    const auto &fence = syncObjects[currentFrame].drawingFence;
+    if (const auto waited =
+            device.waitForFences({*fence}, VK_TRUE, UINT64_MAX);
+        waited != vk::Result::eSuccess) {
+      Logger::critical("Failed to wait for frame: {}", vk::to_string(waited));
+      return std::unexpected(App::TickResult::Bail);
+    }
+    device.resetFences({*fence});
+    return App::FrameInfo{.frameIndex = advanceFrame(), .imageIndex = 0};
+  }
+
   checkSwapchain();
   auto nextImage_res = getNextImage();
   if (!nextImage_res) {
@@ -44,28 +56,49 @@ std::expected<App::FrameInfo, App::TickResult> App::newFrame() noexcept {
 }
 
 App::TickResult
-App::presentFrame(FrameInfo frameInfo,
-                  std::span<vk::CommandBuffer> cmdBuffers) noexcept {
-  vk::PipelineStageFlags waitStage(
-      vk::PipelineStageFlagBits::eColorAttachmentOutput);
-
+App::presentFrame(FrameInfo frameInfo, std::span<vk::CommandBuffer> cmdBuffers,
+                  std::span<const vk::SemaphoreSubmitInfo> waits) noexcept {
   const auto &so = this->syncObjects[frameInfo.frameIndex];
-  const vk::SubmitInfo submitInfo{
-      .waitSemaphoreCount = 1,
-      .pWaitSemaphores = &*so.presentCompleteSemaphore,
-      .pWaitDstStageMask = &waitStage,
-      .commandBufferCount = 1,
-      .pCommandBuffers = cmdBuffers.data(),
-      .signalSemaphoreCount = 1,
-      .pSignalSemaphores = &*so.renderCompleteSemaphore};
+  const auto presenting = !isHeadless();
+
+  std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+  waitInfos.reserve(waits.size() + 1);
+  if (presenting) {
+    waitInfos.push_back(vk::SemaphoreSubmitInfo{
+        .semaphore = *so.presentCompleteSemaphore,
+        .stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput});
+  }
+  waitInfos.insert(waitInfos.end(), waits.begin(), waits.end());
 
-  queues.graphics.queue->submit(submitInfo, *so.drawingFence);
+  std::vector<vk::CommandBufferSubmitInfo> cmdInfos;
+  cmdInfos.reserve(cmdBuffers.size());
+  for (auto cmdBuffer : cmdBuffers) {
+    cmdInfos.push_back(vk::CommandBufferSubmitInfo{.commandBuffer = cmdBuffer});
+  }
+
+  const vk::SemaphoreSubmitInfo signalInfo{
+      .semaphore = *so.renderCompleteSemaphore,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands};
+
+  const vk::SubmitInfo2 submitInfo{
+      .waitSemaphoreInfoCount = static_cast<uint32_t>(waitInfos.size()),
+      .pWaitSemaphoreInfos = waitInfos.data(),
+      .commandBufferInfoCount = static_cast<uint32_t>(cmdInfos.size()),
+      .pCommandBufferInfos = cmdInfos.data(),
+      .signalSemaphoreInfoCount = presenting ? 1u : 0u,
+      .pSignalSemaphoreInfos = &signalInfo};
+
+  queues.graphics.queue->submit2(submitInfo, *so.drawingFence);
+  if (!presenting) {
+    return TickResult::Success;
+  }
 
   const vk::PresentInfoKHR presentInfo{.waitSemaphoreCount = 1,
                                        .pWaitSemaphores =
                                            &*so.renderCompleteSemaphore,
                                        .swapchainCount = 1,
-                                       .pSwapchains = &**swapchain,
+                                       .pSwapchains =
+                                           &*swapchain->getSwapchain(),
                                        .pImageIndices = &frameInfo.imageIndex};
 
   auto result = static_cast<vk::Result>(
@@ -94,7 +127,9 @@ App::presentFrame(FrameInfo frameInfo,
 
 void App::endFrame() noexcept {
   Input::instance().onFrameEnd();
-  ImGui::EndFrame();
+  if (!isHeadless()) {
+    ImGui::EndFrame();
+  }
 }
 
 void App::drawImGui(vk::raii::CommandBuffer &cmdBuffer,
@@ -102,7 +137,7 @@ void App::drawImGui(vk::raii::CommandBuffer &cmdBuffer,
   ImGui::Render();
 
   vk::RenderingAttachmentInfo attachmentInfo{
-      .imageView = swapchain.nImageView(imageIndex),
+      .imageView = swapchain->nImageView(imageIndex),
       .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
       .loadOp = vk::AttachmentLoadOp::eLoad,
       .storeOp = vk::AttachmentStoreOp::eStore,
@@ -116,8 +151,8 @@ void App::drawImGui(vk::raii::CommandBuffer &cmdBuffer,
   vk::RenderingInfo renderingInfo{
       .renderArea =
           vk::Rect2D{.offset = {.x = 0, .y = 0},
-                     .extent = {.width = swapchain.config().extent.width,
-                                .height = swapchain.config().extent.height}},
+                     .extent = {.width = swapchain->config().extent.width,
+                                .height = swapchain->config().extent.height}},
       .layerCount = 1,
       .colorAttachmentCount = 1,
       .pColorAttachments = &attachmentInfo};
@@ -138,10 +173,10 @@ auto App::recreateSwapchain() noexcept -> std::expected<void, std::string> {
   EG_MAKE(newSwapchain,
           setup::createSwapchain(physicalDevice, device, window, surface,
                                  {queues.graphics.index, queues.present.index},
-                                 &*swapchain),
+                                 &**swapchain),
           "Failed to create new swapchain");
   oldSwapchain = OldSwapchain{
-      .swapchain = std::move(swapchain),
+      .swapchain = std::move(*swapchain),
       .frameIndex = currentFrame,
   };
 
@@ -158,8 +193,8 @@ void App::setupCmdBuffer(
                       .y = 0.0f,
                       .width = static_cast<float>(renderImage.extent.width),
                       .height = static_cast<float>(renderImage.extent.height),
-                      .minDepth = 1.0f,
-                      .maxDepth = 0.0f});
+                      .minDepth = 0.0f,
+                      .maxDepth = 1.0f});
 
   cmdBuffer.setScissor(
       0, vk::Rect2D{.offset = {.x = 0, .y = 0},
@@ -207,16 +242,28 @@ void App::checkSwapchain() noexcept {
 auto App::getNextImage() noexcept
     -> std::expected<SwapchainImageResult, std::string> {
   auto &sync = syncObjects[currentFrame];
-  auto res = swapchain.getNextImage(device, sync.drawingFence,
-                                    sync.presentCompleteSemaphore);
+  auto res = swapchain->getNextImage(device, sync.drawingFence,
+                                     sync.presentCompleteSemaphore);
   if (res.has_value()) {
-
-    SwapchainImageResult val = {.thisFrame = currentFrame, .img = res.value()};
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
-    return val;
+    return SwapchainImageResult{.thisFrame = advanceFrame(),
+                                .img = res.value()};
   }
 
   return std::unexpected(res.error());
 }
 
+auto App::advanceFrame() noexcept -> uint32_t {
+  ++frameNumber;
+  // The fence just waited on was signalled by frame `frameNumber -
+  // MAX_FRAMES_IN_FLIGHT`, every frame before it was waited on earlier.
+  if (frameNumber > MAX_FRAMES_IN_FLIGHT) {
+    deletionQueue.retire(frameNumber - MAX_FRAMES_IN_FLIGHT, allocator,
+                         device);
+  }
+
+  const auto thisFrame = currentFrame;
+  currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+  return thisFrame;
+}
+
 } // namespace engine
@@ -13,7 +13,7 @@ auto Core::create(const engine::Window::Attribs windowAttribs,
                   const bool enableValidationLayers) noexcept
     -> std::expected<Core, std::string> {
   Logger::info("Creating GLFW window...");
-  auto window = engine::Window(windowAttribs);
+  std::optional<engine::Window> window(windowAttribs);
 
   Logger::trace("Creating Context");
   auto context = vk::raii::Context();
@@ -27,16 +27,38 @@ auto Core::create(const engine::Window::Attribs windowAttribs,
   auto instance = std::move(instance_res.value());
 
   VkSurfaceKHR rawSurface = nullptr;
-  if (glfwCreateWindowSurface(*instance, window.get(), nullptr, &rawSurface) !=
-      VK_SUCCESS) {
+  if (glfwCreateWindowSurface(*instance, window->get(), nullptr,
+                              &rawSurface) != VK_SUCCESS) {
     Logger::error("Failed to create window surface");
     return std::unexpected("Failed to create window surface");
   }
 
   auto surface = vk::raii::SurfaceKHR(instance, rawSurface);
 
-  Core core(window, context, instance, surface);
+  return finish(Core(window, context, instance, surface));
+}
+
+auto Core::createHeadless(const InstanceAdditions &instanceAdditions,
+                          const bool enableValidationLayers) noexcept
+    -> std::expected<Core, std::string> {
+  Logger::info("Creating headless core");
+  auto context = vk::raii::Context();
+
+  auto instance_res = vkh::createInstance(
+      context, "Voxel Engine", enableValidationLayers,
+      instanceAdditions.extraExtensions, instanceAdditions.extraLayers,
+      false);
+  if (!instance_res) {
+    return std::unexpected(instance_res.error());
+  }
+  auto instance = std::move(instance_res.value());
+
+  std::optional<engine::Window> window;
+  vk::raii::SurfaceKHR surface = nullptr;
+  return finish(Core(window, context, instance, surface));
+}
 
+auto Core::finish(Core core) noexcept -> std::expected<Core, std::string> {
 #ifndef NDEBUG
   EG_MAKE(dbgCallback, engine::makeDebugMessenger(core.instance),
           "Failed to create debug messenger");
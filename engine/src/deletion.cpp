@@ -0,0 +1,52 @@
+#include "engine/deletion.hpp"
+
+namespace engine {
+
+void DeletionQueue::push(uint64_t frame, vkh::AllocatedBuffer buffer) noexcept {
+  const auto size = buffer.allocInfo.size;
+  bytes += size;
+  entries.push_back(Entry{.frame = frame, .bytes = size, .object = buffer});
+}
+
+void DeletionQueue::push(uint64_t frame, vkh::AllocatedImage image,
+                         vk::DeviceSize size) noexcept {
+  bytes += size;
+  entries.push_back(Entry{.frame = frame, .bytes = size, .object = image});
+}
+
+void DeletionQueue::push(uint64_t frame, std::function<void()> release,
+                         vk::DeviceSize size) noexcept {
+  bytes += size;
+  entries.push_back(
+      Entry{.frame = frame, .bytes = size, .object = std::move(release)});
+}
+
+void DeletionQueue::retire(uint64_t frame, vma::Allocator &allocator,
+                           const vk::raii::Device &device) noexcept {
+  while (!entries.empty() && entries.front().frame <= frame) {
+    destroy(entries.front(), allocator, device);
+    entries.pop_front();
+  }
+}
+
+void DeletionQueue::flush(vma::Allocator &allocator,
+                          const vk::raii::Device &device) noexcept {
+  for (auto &entry : entries) {
+    destroy(entry, allocator, device);
+  }
+  entries.clear();
+}
+
+void DeletionQueue::destroy(Entry &entry, vma::Allocator &allocator,
+                            const vk::raii::Device &device) noexcept {
+  if (auto *buffer = std::get_if<vkh::AllocatedBuffer>(&entry.object)) {
+    buffer->destroy(allocator);
+  } else if (auto *image = std::get_if<vkh::AllocatedImage>(&entry.object)) {
+    image->destroy(allocator, device);
+  } else {
+    std::get<std::function<void()>>(entry.object)();
+  }
+  bytes -= entry.bytes;
+}
+
+} // namespace engine
@@ -0,0 +1,145 @@
+#include "engine/frameCapture.hpp"
+
+#include "logger.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <system_error>
+
+#include <engine/util/macros.hpp>
+#include <glm/gtc/packing.hpp>
+
+namespace engine {
+
+namespace {
+auto toSrgb(float linear) noexcept -> uint8_t {
+  if (!(linear > 0.0f)) {
+    // Also catches NaN.
+    return 0;
+  }
+  if (linear >= 1.0f) {
+    return 255;
+  }
+  const auto encoded = linear <= 0.0031308f
+                           ? 12.92f * linear
+                           : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+  return static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+}
+} // namespace
+
+auto FrameCapture::create(vma::Allocator &allocator, vk::Extent3D extent,
+                          vk::Format format,
+                          std::filesystem::path directory) noexcept
+    -> std::expected<FrameCapture, std::string> {
+  if (format != vk::Format::eR16G16B16A16Sfloat) {
+    Logger::error("Cannot capture {} images", vk::to_string(format));
+    return std::unexpected("Unsupported capture format");
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    Logger::error("Failed to create {}: {}", directory.string(),
+                  error.message());
+    return std::unexpected("Failed to create capture directory");
+  }
+
+  const auto partitionSize =
+      vk::DeviceSize{extent.width} * extent.height * TEXEL_SIZE;
+  EG_MAKE(buffer,
+          vkh::AllocatedBuffer::create(
+              allocator,
+              vk::BufferCreateInfo{.size = partitionSize * MAX_FRAMES_IN_FLIGHT,
+                                   .usage =
+                                       vk::BufferUsageFlagBits::eTransferDst,
+                                   .sharingMode = vk::SharingMode::eExclusive},
+              vma::AllocationCreateInfo{
+                  .flags = vma::AllocationCreateFlagBits::eMapped |
+                           vma::AllocationCreateFlagBits::eHostAccessRandom,
+                  .usage = vma::MemoryUsage::eAuto,
+                  .requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible |
+                                   vk::MemoryPropertyFlagBits::eHostCoherent,
+              }),
+          "Failed to create capture buffer");
+
+  Logger::info("Capturing {}x{} frames into {}", extent.width, extent.height,
+               directory.string());
+  return FrameCapture(buffer, extent, std::move(directory));
+}
+
+FrameCapture::FrameCapture(vkh::AllocatedBuffer buffer, vk::Extent3D extent,
+                           std::filesystem::path directory) noexcept
+    : buffer(buffer), extent(extent), directory(std::move(directory)),
+      encode(1 << 16) {
+  for (uint32_t bits = 0; bits < encode.size(); ++bits) {
+    encode[bits] = toSrgb(glm::unpackHalf1x16(static_cast<uint16_t>(bits)));
+  }
+}
+
+void FrameCapture::record(const vk::raii::CommandBuffer &cmdBuffer,
+                          vk::Image image, uint32_t frameIndex,
+                          uint64_t number) noexcept {
+  cmdBuffer.copyImageToBuffer(
+      image, vk::ImageLayout::eTransferSrcOptimal, buffer.buffer,
+      vk::BufferImageCopy{
+          .bufferOffset = partitionSize() * frameIndex,
+          .bufferRowLength = 0,
+          .bufferImageHeight = 0,
+          .imageSubresource = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                               .mipLevel = 0,
+                               .baseArrayLayer = 0,
+                               .layerCount = 1},
+          .imageOffset = {.x = 0, .y = 0, .z = 0},
+          .imageExtent = extent});
+
+  // The fence alone does not make the copy visible to the host.
+  const vk::MemoryBarrier2 barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+      .dstAccessMask = vk::AccessFlagBits2::eHostRead};
+  cmdBuffer.pipelineBarrier2(
+      vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &barrier});
+
+  pending[frameIndex] = number;
+}
+
+auto FrameCapture::write(uint32_t frameIndex) noexcept
+    -> std::expected<void, std::string> {
+  auto &number = pending[frameIndex];
+  if (!number.has_value()) {
+    return {};
+  }
+
+  std::array<char, 32> name{};
+  std::snprintf(name.data(), name.size(), "frame_%06llu.ppm",
+                static_cast<unsigned long long>(*number));
+  number = std::nullopt;
+  const auto path = directory / name.data();
+
+  const auto texelCount = size_t{extent.width} * extent.height;
+  const auto *texels = reinterpret_cast<const uint16_t *>(
+      static_cast<const std::byte *>(buffer.allocInfo.pMappedData) +
+      partitionSize() * frameIndex);
+  pixels.resize(texelCount * 3);
+  for (size_t i = 0; i < texelCount; ++i) {
+    // Alpha, the fourth channel, is dropped.
+    for (size_t c = 0; c < 3; ++c) {
+      pixels[i * 3 + c] = encode[texels[i * 4 + c]];
+    }
+  }
+
+  auto *file = std::fopen(path.string().c_str(), "wb");
+  if (file == nullptr) {
+    return std::unexpected("Failed to open " + path.string());
+  }
+  std::fprintf(file, "P6\n%u %u\n255\n", extent.width, extent.height);
+  std::fwrite(pixels.data(), 1, pixels.size(), file);
+  const auto failed = std::ferror(file) != 0;
+  if (std::fclose(file) != 0 || failed) {
+    return std::unexpected("Failed to write " + path.string());
+  }
+  return {};
+}
+
+} // namespace engine
@@ -0,0 +1,129 @@
+#include "engine/gpuProfiler.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <string_view>
+
+#include <engine/util/macros.hpp>
+
+namespace engine {
+
+auto GpuProfiler::create(const vk::raii::Device &device,
+                         const vk::raii::PhysicalDevice &physicalDevice,
+                         const vkh::Queue &queue) noexcept
+    -> std::expected<GpuProfiler, std::string> {
+  const auto families = physicalDevice.getQueueFamilyProperties();
+  const auto validBits = queue.index < families.size()
+                             ? families[queue.index].timestampValidBits
+                             : 0;
+  if (validBits == 0) {
+    Logger::warn("Queue family {} has no timestamps, not profiling the GPU",
+                 queue.index);
+    return GpuProfiler(nullptr, 0.0f, 0);
+  }
+
+  VK_MAKE(pool,
+          device.createQueryPool(vk::QueryPoolCreateInfo{
+              .queryType = vk::QueryType::eTimestamp,
+              .queryCount = QUERIES_PER_FRAME * MAX_FRAMES_IN_FLIGHT}),
+          "Failed to create timestamp query pool");
+
+  const auto period = physicalDevice.getProperties().limits.timestampPeriod;
+  const auto validMask =
+      validBits >= 64 ? ~uint64_t{0} : (uint64_t{1} << validBits) - 1;
+  return GpuProfiler(std::move(pool), period, validMask);
+}
+
+void GpuProfiler::beginFrame(const vk::raii::CommandBuffer &cmdBuffer,
+                             uint32_t frameIndex) noexcept {
+  this->frameIndex = frameIndex;
+  open = 0;
+  if (!isEnabled()) {
+    return;
+  }
+
+  const auto first = frameIndex * QUERIES_PER_FRAME;
+  auto &scopes = recorded[frameIndex];
+  if (!scopes.empty() && submitted[frameIndex]) {
+    // A value and its availability per query. Queries that never ended
+    // stay unavailable and are skipped rather than waited on.
+    const auto count = static_cast<uint32_t>(scopes.size() * 2);
+    const auto [result, values] = pool.getResults<uint64_t>(
+        first, count, sizeof(uint64_t) * 2 * count, sizeof(uint64_t) * 2,
+        vk::QueryResultFlagBits::e64 |
+            vk::QueryResultFlagBits::eWithAvailability);
+    if (result == vk::Result::eSuccess || result == vk::Result::eNotReady) {
+      for (size_t i = 0; i < scopes.size(); ++i) {
+        const auto *query = values.data() + i * 4;
+        if (query[1] == 0 || query[3] == 0) {
+          continue;
+        }
+        const auto ticks = (query[2] - query[0]) & validMask;
+        addSample(scopes[i], static_cast<float>(ticks) * period * 1e-6f);
+      }
+    }
+  }
+  scopes.clear();
+  submitted[frameIndex] = false;
+
+  cmdBuffer.resetQueryPool(*pool, first, QUERIES_PER_FRAME);
+}
+
+auto GpuProfiler::begin(const vk::raii::CommandBuffer &cmdBuffer,
+                        const char *name) noexcept -> uint32_t {
+  auto &scopes = recorded[frameIndex];
+  if (!isEnabled() || scopes.size() == MAX_SCOPES) {
+    return NONE;
+  }
+  const auto scope = static_cast<uint32_t>(scopes.size());
+  scopes.push_back(Recorded{.name = name, .depth = open++});
+  cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *pool,
+                            frameIndex * QUERIES_PER_FRAME + scope * 2);
+  return scope;
+}
+
+void GpuProfiler::end(const vk::raii::CommandBuffer &cmdBuffer,
+                      uint32_t scope) noexcept {
+  if (scope == NONE) {
+    return;
+  }
+  --open;
+  cmdBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *pool,
+                            frameIndex * QUERIES_PER_FRAME + scope * 2 + 1);
+}
+
+void GpuProfiler::addSample(const Recorded &scope,
+                            float milliseconds) noexcept {
+  const auto it = std::ranges::find_if(summaries, [&](const ScopeStats &s) {
+    return std::string_view(s.name) == scope.name;
+  });
+  const auto index = static_cast<size_t>(it - summaries.begin());
+  if (it == summaries.end()) {
+    summaries.push_back(ScopeStats{.name = scope.name,
+                                   .depth = scope.depth,
+                                   .last = 0.0f,
+                                   .min = 0.0f,
+                                   .avg = 0.0f,
+                                   .max = 0.0f});
+    histories.emplace_back();
+  }
+
+  auto &history = histories[index];
+  history.samples[history.next] = milliseconds;
+  history.next = (history.next + 1) % HISTORY;
+  history.count = std::min(history.count + 1, HISTORY);
+
+  const auto samples = std::span(history.samples).first(history.count);
+  auto &stats = summaries[index];
+  stats.last = milliseconds;
+  stats.min = std::ranges::min(samples);
+  stats.max = std::ranges::max(samples);
+  float total = 0.0f;
+  for (const auto sample : samples) {
+    total += sample;
+  }
+  stats.avg = total / static_cast<float>(history.count);
+}
+
+} // namespace engine
@@ -7,7 +7,8 @@ void transitionImageLayout(const vk::raii::CommandBuffer &commandBuffer,
                            vk::AccessFlags2 srcAccessMask,
                            vk::AccessFlags2 dstAccessMask,
                            vk::PipelineStageFlags2 srcStageMask,
-                           vk::PipelineStageFlags2 dstStageMask) noexcept {
+                           vk::PipelineStageFlags2 dstStageMask,
+                           vk::ImageAspectFlags aspectMask) noexcept {
   vk::ImageMemoryBarrier2 barrier = {
       .srcStageMask = srcStageMask,
       .srcAccessMask = srcAccessMask,
@@ -18,7 +19,7 @@ void transitionImageLayout(const vk::raii::CommandBuffer &commandBuffer,
       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
       .image = image,
-      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+      .subresourceRange = {.aspectMask = aspectMask,
                            .baseMipLevel = 0,
                            .levelCount = 1,
                            .baseArrayLayer = 0,
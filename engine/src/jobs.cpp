@@ -0,0 +1,202 @@
+#include "engine/jobs.hpp"
+
+#include "engine/trace.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace engine {
+
+namespace {
+constexpr uint32_t NOT_A_WORKER = UINT32_MAX;
+
+/// Lets `submit` and `take` find the calling worker's own deque.
+thread_local const JobSystem *currentSystem = nullptr;
+thread_local uint32_t currentWorker = NOT_A_WORKER;
+} // namespace
+
+auto JobSystem::defaultWorkerCount() noexcept -> uint32_t {
+  const auto hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 1;
+}
+
+JobSystem::JobSystem(uint32_t workerCount) noexcept
+    : threadCount(workerCount) {
+  const auto queues = std::max(workerCount, 1u);
+  workers.reserve(queues);
+  for (uint32_t i = 0; i < queues; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+
+  for (uint32_t i = 0; i < workerCount; ++i) {
+    workers[i]->thread = std::thread([this, i]() { workerLoop(i); });
+  }
+}
+
+JobSystem::~JobSystem() {
+  stopping.store(true, std::memory_order_release);
+  // Wake every sleeping worker so it sees `stopping`.
+  queued.fetch_add(1, std::memory_order_release);
+  queued.notify_all();
+
+  for (auto &worker : workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+void JobSystem::submit(Job job, JobCounter *counter,
+                       const JobCounter *dependency) noexcept {
+  if (counter != nullptr) {
+    counter->pending.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  QueuedJob queuedJob{.fn = std::move(job), .counter = counter};
+
+  if (dependency != nullptr) {
+    // Checked under the lock, the last job of `dependency` takes the same
+    // lock before releasing what waits on it.
+    std::lock_guard lock(waitingMutex);
+    if (!dependency->isDone()) {
+      waiting.push_back(
+          WaitingJob{.dependency = dependency, .job = std::move(queuedJob)});
+      return;
+    }
+  }
+
+  enqueue(std::move(queuedJob));
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t batchSize,
+                            std::function<void(uint32_t, uint32_t)> fn,
+                            JobCounter &counter,
+                            const JobCounter *dependency) noexcept {
+  batchSize = std::max(batchSize, 1u);
+  auto shared =
+      std::make_shared<std::function<void(uint32_t, uint32_t)>>(std::move(fn));
+
+  for (uint32_t begin = 0; begin < count; begin += batchSize) {
+    const auto end = std::min(begin + batchSize, count);
+    submit([shared, begin, end]() { (*shared)(begin, end); }, &counter,
+           dependency);
+  }
+}
+
+void JobSystem::waitAndHelp(const JobCounter &counter) noexcept {
+  const auto self = currentSystem == this ? currentWorker : NOT_A_WORKER;
+  while (!counter.isDone()) {
+    QueuedJob job;
+    if (take(self, job)) {
+      execute(job);
+    } else {
+      // The remaining jobs are running elsewhere or waiting on a dependency.
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::workerLoop(uint32_t index) noexcept {
+  currentSystem = this;
+  currentWorker = index;
+  trace::setThreadName("Worker " + std::to_string(index));
+
+  while (!stopping.load(std::memory_order_acquire)) {
+    QueuedJob job;
+    if (take(index, job)) {
+      execute(job);
+      continue;
+    }
+    queued.wait(0, std::memory_order_acquire);
+  }
+}
+
+void JobSystem::enqueue(QueuedJob job) noexcept {
+  uint32_t index = 0;
+  if (currentSystem == this && currentWorker != NOT_A_WORKER) {
+    index = currentWorker;
+  } else {
+    index = nextWorker.fetch_add(1, std::memory_order_relaxed) %
+            static_cast<uint32_t>(workers.size());
+  }
+
+  {
+    auto &worker = *workers[index];
+    std::lock_guard lock(worker.mutex);
+    worker.jobs.push_back(std::move(job));
+  }
+
+  queued.fetch_add(1, std::memory_order_release);
+  queued.notify_one();
+}
+
+auto JobSystem::take(uint32_t self, QueuedJob &out) noexcept -> bool {
+  const auto count = static_cast<uint32_t>(workers.size());
+
+  if (self != NOT_A_WORKER) {
+    auto &own = *workers[self];
+    std::lock_guard lock(own.mutex);
+    if (!own.jobs.empty()) {
+      out = std::move(own.jobs.back());
+      own.jobs.pop_back();
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  // Steal the oldest job, starting after ourselves so thieves spread out.
+  const auto start = self == NOT_A_WORKER ? 0 : self + 1;
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto victimIndex = (start + i) % count;
+    if (victimIndex == self) {
+      continue;
+    }
+
+    auto &victim = *workers[victimIndex];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.jobs.empty()) {
+      out = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobSystem::execute(QueuedJob &job) noexcept {
+  {
+    EG_ZONE("Job");
+    job.fn();
+  }
+
+  auto *counter = job.counter;
+  if (counter != nullptr &&
+      counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    release(counter);
+  }
+}
+
+void JobSystem::release(const JobCounter *counter) noexcept {
+  std::vector<QueuedJob> released;
+  {
+    std::lock_guard lock(waitingMutex);
+    // `counter` may already be gone if nothing waits on it, so it is only
+    // compared. A waiting job keeps its dependency alive, and a match that
+    // is not done is a newer counter at the same address.
+    auto it = std::ranges::partition(waiting, [&](const WaitingJob &w) {
+                return w.dependency != counter || !w.dependency->isDone();
+              }).begin();
+    for (auto job = it; job != waiting.end(); ++job) {
+      released.push_back(std::move(job->job));
+    }
+    waiting.erase(it, waiting.end());
+  }
+
+  for (auto &job : released) {
+    enqueue(std::move(job));
+  }
+}
+
+} // namespace engine
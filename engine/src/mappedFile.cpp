@@ -0,0 +1,230 @@
+#include "engine/mappedFile.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#define ENGINE_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+
+namespace {
+
+#ifdef ENGINE_WINDOWS
+const HANDLE INVALID = INVALID_HANDLE_VALUE;
+
+auto lastError(const char *what) -> std::string {
+  return std::string(what) + " failed with error " +
+         std::to_string(GetLastError());
+}
+#else
+constexpr int INVALID = -1;
+
+auto lastError(const char *what) -> std::string {
+  return std::string(what) + " failed: " + std::strerror(errno);
+}
+#endif
+
+} // namespace
+
+auto MappedFile::open(const std::filesystem::path &path) noexcept
+    -> std::expected<MappedFile, std::string> {
+#ifdef ENGINE_WINDOWS
+  const auto handle =
+      CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                  nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return std::unexpected(lastError("CreateFileW"));
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size)) {
+    CloseHandle(handle);
+    return std::unexpected(lastError("GetFileSizeEx"));
+  }
+  MappedFile file(handle, static_cast<uint64_t>(size.QuadPart));
+#else
+  const int handle = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (handle == -1) {
+    return std::unexpected(lastError("open"));
+  }
+  struct stat info;
+  if (fstat(handle, &info) != 0) {
+    ::close(handle);
+    return std::unexpected(lastError("fstat"));
+  }
+  MappedFile file(handle, static_cast<uint64_t>(info.st_size));
+#endif
+
+  if (auto mapped = file.remap(); !mapped) {
+    return std::unexpected(mapped.error());
+  }
+  return file;
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : handle(std::exchange(other.handle, INVALID)),
+      mapping(std::exchange(other.mapping, nullptr)),
+      mappedSize(std::exchange(other.mappedSize, 0)),
+      fileSize(std::exchange(other.fileSize, 0)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    handle = std::exchange(other.handle, INVALID);
+    mapping = std::exchange(other.mapping, nullptr);
+    mappedSize = std::exchange(other.mappedSize, 0);
+    fileSize = std::exchange(other.fileSize, 0);
+  }
+  return *this;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+auto MappedFile::write(uint64_t offset,
+                       std::span<const std::byte> bytes) noexcept
+    -> std::expected<void, std::string> {
+  while (!bytes.empty()) {
+#ifdef ENGINE_WINDOWS
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    const auto count = static_cast<DWORD>(
+        std::min<size_t>(bytes.size(), 1u << 30));
+    DWORD written = 0;
+    if (!WriteFile(handle, bytes.data(), count, &written, &overlapped)) {
+      return std::unexpected(lastError("WriteFile"));
+    }
+#else
+    const auto written =
+        pwrite(handle, bytes.data(), bytes.size(), static_cast<off_t>(offset));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return std::unexpected(lastError("pwrite"));
+    }
+#endif
+    offset += static_cast<uint64_t>(written);
+    bytes = bytes.subspan(static_cast<size_t>(written));
+  }
+  fileSize = std::max(fileSize, offset);
+  return {};
+}
+
+auto MappedFile::sync() const noexcept -> std::expected<void, std::string> {
+#ifdef ENGINE_WINDOWS
+  if (!FlushFileBuffers(handle)) {
+    return std::unexpected(lastError("FlushFileBuffers"));
+  }
+#elif defined(__APPLE__)
+  // fsync alone only reaches the drive's cache on macOS.
+  if (fcntl(handle, F_FULLFSYNC) != 0 && fsync(handle) != 0) {
+    return std::unexpected(lastError("fsync"));
+  }
+#else
+  if (fdatasync(handle) != 0) {
+    return std::unexpected(lastError("fdatasync"));
+  }
+#endif
+  return {};
+}
+
+auto MappedFile::remap() noexcept -> std::expected<void, std::string> {
+  unmap();
+  // Nothing to map, and neither platform maps an empty file.
+  if (fileSize == 0) {
+    return {};
+  }
+
+#ifdef ENGINE_WINDOWS
+  const auto section =
+      CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (section == nullptr) {
+    return std::unexpected(lastError("CreateFileMappingW"));
+  }
+  // The view keeps the section alive.
+  const auto *view = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(section);
+  if (view == nullptr) {
+    return std::unexpected(lastError("MapViewOfFile"));
+  }
+#else
+  const auto *view = mmap(nullptr, static_cast<size_t>(fileSize), PROT_READ,
+                          MAP_SHARED, handle, 0);
+  if (view == MAP_FAILED) {
+    return std::unexpected(lastError("mmap"));
+  }
+#endif
+
+  mapping = static_cast<const std::byte *>(view);
+  mappedSize = static_cast<size_t>(fileSize);
+  return {};
+}
+
+auto MappedFile::reserve(uint64_t size) noexcept
+    -> std::expected<void, std::string> {
+  if (size <= fileSize) {
+    return {};
+  }
+  // Windows cannot resize a file while a view of it is open.
+  unmap();
+#ifdef ENGINE_WINDOWS
+  LARGE_INTEGER end;
+  end.QuadPart = static_cast<LONGLONG>(size);
+  if (!SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) ||
+      !SetEndOfFile(handle)) {
+    auto error = lastError("SetEndOfFile");
+    // Keeps what was mapped readable.
+    (void)remap();
+    return std::unexpected(std::move(error));
+  }
+#else
+  if (ftruncate(handle, static_cast<off_t>(size)) != 0) {
+    auto error = lastError("ftruncate");
+    (void)remap();
+    return std::unexpected(std::move(error));
+  }
+#endif
+  fileSize = size;
+  return remap();
+}
+
+void MappedFile::unmap() noexcept {
+  if (mapping == nullptr) {
+    return;
+  }
+#ifdef ENGINE_WINDOWS
+  UnmapViewOfFile(mapping);
+#else
+  munmap(const_cast<std::byte *>(mapping), mappedSize);
+#endif
+  mapping = nullptr;
+  mappedSize = 0;
+}
+
+void MappedFile::close() noexcept {
+  unmap();
+  if (handle == INVALID) {
+    return;
+  }
+#ifdef ENGINE_WINDOWS
+  CloseHandle(handle);
+#else
+  ::close(handle);
+#endif
+  handle = INVALID;
+}
+
+} // namespace engine
@@ -0,0 +1,112 @@
+#include "kernels.hpp"
+
+#ifdef ENGINE_NOISE_X86
+
+#include <immintrin.h>
+
+namespace engine::noise::detail {
+
+namespace avx2 {
+
+struct Mask {
+  __m256 v;
+
+  friend auto operator&(Mask a, Mask b) -> Mask {
+    return {_mm256_and_ps(a.v, b.v)};
+  }
+  friend auto operator|(Mask a, Mask b) -> Mask {
+    return {_mm256_or_ps(a.v, b.v)};
+  }
+  friend auto operator~(Mask a) -> Mask {
+    return {_mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1)))};
+  }
+};
+
+struct Int {
+  __m256i v;
+
+  Int(__m256i value) : v(value) {}
+  Int(int32_t value) : v(_mm256_set1_epi32(value)) {}
+
+  friend auto operator+(Int a, Int b) -> Int {
+    return _mm256_add_epi32(a.v, b.v);
+  }
+  friend auto operator*(Int a, Int b) -> Int {
+    return _mm256_mullo_epi32(a.v, b.v);
+  }
+  friend auto operator^(Int a, Int b) -> Int {
+    return _mm256_xor_si256(a.v, b.v);
+  }
+  friend auto operator&(Int a, Int b) -> Int {
+    return _mm256_and_si256(a.v, b.v);
+  }
+  friend auto operator<<(Int a, int shift) -> Int {
+    return _mm256_slli_epi32(a.v, shift);
+  }
+  friend auto operator>>(Int a, int shift) -> Int {
+    return _mm256_srli_epi32(a.v, shift);
+  }
+  friend auto operator<(Int a, Int b) -> Mask {
+    return {_mm256_castsi256_ps(_mm256_cmpgt_epi32(b.v, a.v))};
+  }
+  friend auto operator==(Int a, Int b) -> Mask {
+    return {_mm256_castsi256_ps(_mm256_cmpeq_epi32(a.v, b.v))};
+  }
+};
+
+struct Float {
+  __m256 v;
+
+  Float(__m256 value) : v(value) {}
+  Float(float value) : v(_mm256_set1_ps(value)) {}
+
+  static auto load(const float *p) -> Float { return _mm256_loadu_ps(p); }
+  void store(float *p) const { _mm256_storeu_ps(p, v); }
+
+  friend auto operator+(Float a, Float b) -> Float {
+    return _mm256_add_ps(a.v, b.v);
+  }
+  friend auto operator-(Float a, Float b) -> Float {
+    return _mm256_sub_ps(a.v, b.v);
+  }
+  friend auto operator*(Float a, Float b) -> Float {
+    return _mm256_mul_ps(a.v, b.v);
+  }
+  friend auto operator>(Float a, Float b) -> Mask {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)};
+  }
+  friend auto operator>=(Float a, Float b) -> Mask {
+    return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+  }
+
+  friend auto floor(Float a) -> Float { return _mm256_floor_ps(a.v); }
+  friend auto max(Float a, Float b) -> Float {
+    return _mm256_max_ps(a.v, b.v);
+  }
+  friend auto flipSign(Float a, Int bits) -> Float {
+    return _mm256_xor_ps(a.v, _mm256_castsi256_ps(bits.v));
+  }
+  friend auto select(Mask mask, Float a, Float b) -> Float {
+    return _mm256_blendv_ps(b.v, a.v, mask.v);
+  }
+};
+
+inline auto toInt(Float a) -> Int { return _mm256_cvttps_epi32(a.v); }
+inline auto toFloat(Int a) -> Float { return _mm256_cvtepi32_ps(a.v); }
+
+struct Lanes {
+  using Float = avx2::Float;
+  using Int = avx2::Int;
+  static constexpr size_t WIDTH = 8;
+};
+
+} // namespace avx2
+
+auto avx2Kernels() noexcept -> const Kernels & {
+  static const Kernels kernels = makeKernels<avx2::Lanes>();
+  return kernels;
+}
+
+} // namespace engine::noise::detail
+
+#endif
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "engine/noise.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// The noise algorithms, written once against a set of lane types and
+// instantiated by each instruction set's translation unit:
+//
+//   Float, Int, Mask  constructible from a scalar (broadcast), with
+//                     `Float::load/store` and `L::WIDTH` lanes
+//   Float             + - *, `>` and `>=` giving a Mask, `floor`, `max`,
+//                     `toInt` (of whole numbers), `flipSign(f, bits)`
+//                     xoring `bits` into the float's sign
+//   Int               + * ^ &, `<<` and logical `>>` by a constant, `<`
+//                     and `==` giving a Mask, `toFloat`
+//   Mask              & | ~, `select(mask, Float, Float)`
+//
+// Only IEEE operations that round identically on every set are used, and
+// nothing here may call a non-template inline function: each instruction set
+// compiles this with its own flags, and the linker would be free to pick an
+// AVX2 copy for the scalar path.
+
+namespace engine::noise::detail {
+
+using FractalFn = void (*)(const Fractal &fractal, float scale,
+                           const float *x, const float *y, const float *z,
+                           float *out, size_t count) noexcept;
+
+/// Fractal noise over `count` points, `z` is ignored by the 2D kernels.
+/// Output is the octave sum times `scale`.
+struct Kernels {
+  FractalFn simplex2;
+  FractalFn simplex3;
+  FractalFn value2;
+  FractalFn value3;
+};
+
+auto scalarKernels() noexcept -> const Kernels &;
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENGINE_NOISE_X86 1
+auto sse41Kernels() noexcept -> const Kernels &;
+auto avx2Kernels() noexcept -> const Kernels &;
+#endif
+
+constexpr int32_t PRIME_X = 501125321;
+constexpr int32_t PRIME_Y = 1136930381;
+constexpr int32_t PRIME_Z = 1720413743;
+constexpr int32_t MIX = 0x27d4eb2d;
+
+/// Hashes lattice coordinates already multiplied by their axis prime.
+template <typename L>
+inline auto hash(typename L::Int seed, typename L::Int x, typename L::Int y)
+    -> typename L::Int {
+  auto h = (seed ^ x ^ y) * typename L::Int(MIX);
+  return h ^ (h >> 15);
+}
+
+template <typename L>
+inline auto hash(typename L::Int seed, typename L::Int x, typename L::Int y,
+                 typename L::Int z) -> typename L::Int {
+  auto h = (seed ^ x ^ y ^ z) * typename L::Int(MIX);
+  return h ^ (h >> 15);
+}
+
+/// One of eight gradients, (+-1, +-2) and (+-2, +-1), dotted with (x, y).
+template <typename L>
+inline auto gradient(typename L::Int h, typename L::Float x,
+                     typename L::Float y) -> typename L::Float {
+  using Int = typename L::Int;
+  const auto xFirst = (h & Int(4)) == Int(0);
+  const auto u = select(xFirst, x, y);
+  const auto v = select(xFirst, y, x);
+  return flipSign(u, (h & Int(1)) << 31) +
+         flipSign(v * typename L::Float(2.0f), (h & Int(2)) << 30);
+}
+
+/// One of the twelve cube edge gradients, four of them twice, dotted with
+/// (x, y, z).
+template <typename L>
+inline auto gradient(typename L::Int h, typename L::Float x,
+                     typename L::Float y, typename L::Float z) ->
+    typename L::Float {
+  using Int = typename L::Int;
+  h = h & Int(15);
+  const auto u = select(h < Int(8), x, y);
+  // 12 and 14 pick x, they would otherwise repeat the z gradients.
+  const auto v =
+      select(h < Int(4), y, select((h & Int(13)) == Int(12), x, z));
+  return flipSign(u, (h & Int(1)) << 31) + flipSign(v, (h & Int(2)) << 30);
+}
+
+template <typename L>
+inline auto simplex(typename L::Int seed, typename L::Float x,
+                    typename L::Float y) -> typename L::Float {
+  using Float = typename L::Float;
+  using Int = typename L::Int;
+  // (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6.
+  constexpr float SKEW = 0.366025403784f;
+  constexpr float UNSKEW = 0.211324865405f;
+
+  const auto s = (x + y) * Float(SKEW);
+  const auto i = floor(x + s);
+  const auto j = floor(y + s);
+  const auto t = (i + j) * Float(UNSKEW);
+  const auto x0 = x - (i - t);
+  const auto y0 = y - (j - t);
+
+  const auto xFirst = x0 > y0;
+  const auto i1 = select(xFirst, Float(1.0f), Float(0.0f));
+  const auto j1 = select(xFirst, Float(0.0f), Float(1.0f));
+  const auto x1 = x0 - i1 + Float(UNSKEW);
+  const auto y1 = y0 - j1 + Float(UNSKEW);
+  const auto x2 = x0 + Float(2.0f * UNSKEW - 1.0f);
+  const auto y2 = y0 + Float(2.0f * UNSKEW - 1.0f);
+
+  const auto px = toInt(i) * Int(PRIME_X);
+  const auto py = toInt(j) * Int(PRIME_Y);
+  const auto h0 = hash<L>(seed, px, py);
+  const auto h1 = hash<L>(seed, px + toInt(i1) * Int(PRIME_X),
+                          py + toInt(j1) * Int(PRIME_Y));
+  const auto h2 = hash<L>(seed, px + Int(PRIME_X), py + Int(PRIME_Y));
+
+  auto corner = [](Int h, Float cx, Float cy) {
+    auto falloff = max(Float(0.5f) - cx * cx - cy * cy, Float(0.0f));
+    falloff = falloff * falloff;
+    return falloff * falloff * gradient<L>(h, cx, cy);
+  };
+  return (corner(h0, x0, y0) + corner(h1, x1, y1) + corner(h2, x2, y2)) *
+         Float(40.0f);
+}
+
+template <typename L>
+inline auto simplex(typename L::Int seed, typename L::Float x,
+                    typename L::Float y, typename L::Float z) ->
+    typename L::Float {
+  using Float = typename L::Float;
+  using Int = typename L::Int;
+  constexpr float SKEW = 1.0f / 3.0f;
+  constexpr float UNSKEW = 1.0f / 6.0f;
+
+  const auto s = (x + y + z) * Float(SKEW);
+  const auto i = floor(x + s);
+  const auto j = floor(y + s);
+  const auto k = floor(z + s);
+  const auto t = (i + j + k) * Float(UNSKEW);
+  const auto x0 = x - (i - t);
+  const auto y0 = y - (j - t);
+  const auto z0 = z - (k - t);
+
+  // Which of the six tetrahedra, as the ranks of x0, y0 and z0.
+  const auto xy = x0 >= y0;
+  const auto yz = y0 >= z0;
+  const auto xz = x0 >= z0;
+  const Float one(1.0f);
+  const Float zero(0.0f);
+  const auto i1 = select(xy & xz, one, zero);
+  const auto j1 = select(~xy & yz, one, zero);
+  const auto k1 = select(~yz & ~(xy & xz), one, zero);
+  const auto i2 = select(xy | (yz & xz), one, zero);
+  const auto j2 = select(~xy | yz, one, zero);
+  const auto k2 = select(~(yz & xz), one, zero);
+
+  const auto x1 = x0 - i1 + Float(UNSKEW);
+  const auto y1 = y0 - j1 + Float(UNSKEW);
+  const auto z1 = z0 - k1 + Float(UNSKEW);
+  const auto x2 = x0 - i2 + Float(2.0f * UNSKEW);
+  const auto y2 = y0 - j2 + Float(2.0f * UNSKEW);
+  const auto z2 = z0 - k2 + Float(2.0f * UNSKEW);
+  const auto x3 = x0 + Float(3.0f * UNSKEW - 1.0f);
+  const auto y3 = y0 + Float(3.0f * UNSKEW - 1.0f);
+  const auto z3 = z0 + Float(3.0f * UNSKEW - 1.0f);
+
+  const auto px = toInt(i) * Int(PRIME_X);
+  const auto py = toInt(j) * Int(PRIME_Y);
+  const auto pz = toInt(k) * Int(PRIME_Z);
+  const auto h0 = hash<L>(seed, px, py, pz);
+  const auto h1 =
+      hash<L>(seed, px + toInt(i1) * Int(PRIME_X),
+              py + toInt(j1) * Int(PRIME_Y), pz + toInt(k1) * Int(PRIME_Z));
+  const auto h2 =
+      hash<L>(seed, px + toInt(i2) * Int(PRIME_X),
+              py + toInt(j2) * Int(PRIME_Y), pz + toInt(k2) * Int(PRIME_Z));
+  const auto h3 = hash<L>(seed, px + Int(PRIME_X), py + Int(PRIME_Y),
+                          pz + Int(PRIME_Z));
+
+  auto corner = [](Int h, Float cx, Float cy, Float cz) {
+    auto falloff =
+        max(Float(0.6f) - cx * cx - cy * cy - cz * cz, Float(0.0f));
+    falloff = falloff * falloff;
+    return falloff * falloff * gradient<L>(h, cx, cy, cz);
+  };
+  return (corner(h0, x0, y0, z0) + corner(h1, x1, y1, z1) +
+          corner(h2, x2, y2, z2) + corner(h3, x3, y3, z3)) *
+         Float(32.0f);
+}
+
+/// A lattice hash mapped to [-1, 1].
+template <typename L>
+inline auto latticeValue(typename L::Int h) -> typename L::Float {
+  using Float = typename L::Float;
+  return toFloat(h & typename L::Int(0xFFFFFF)) *
+             Float(2.0f / 16777215.0f) -
+         Float(1.0f);
+}
+
+/// 6t^5 - 15t^4 + 10t^3, flat at both ends so cells join smoothly.
+template <typename L>
+inline auto fade(typename L::Float t) -> typename L::Float {
+  using Float = typename L::Float;
+  return t * t * t * (t * (t * Float(6.0f) - Float(15.0f)) + Float(10.0f));
+}
+
+template <typename L>
+inline auto lerp(typename L::Float a, typename L::Float b,
+                 typename L::Float t) -> typename L::Float {
+  return a + t * (b - a);
+}
+
+template <typename L>
+inline auto value(typename L::Int seed, typename L::Float x,
+                  typename L::Float y) -> typename L::Float {
+  using Int = typename L::Int;
+  const auto i = floor(x);
+  const auto j = floor(y);
+  const auto sx = fade<L>(x - i);
+  const auto sy = fade<L>(y - j);
+
+  const auto x0 = toInt(i) * Int(PRIME_X);
+  const auto y0 = toInt(j) * Int(PRIME_Y);
+  const auto x1 = x0 + Int(PRIME_X);
+  const auto y1 = y0 + Int(PRIME_Y);
+
+  auto at = [&](Int cx, Int cy) {
+    return latticeValue<L>(hash<L>(seed, cx, cy));
+  };
+  return lerp<L>(lerp<L>(at(x0, y0), at(x1, y0), sx),
+                 lerp<L>(at(x0, y1), at(x1, y1), sx), sy);
+}
+
+template <typename L>
+inline auto value(typename L::Int seed, typename L::Float x,
+                  typename L::Float y, typename L::Float z) ->
+    typename L::Float {
+  using Int = typename L::Int;
+  const auto i = floor(x);
+  const auto j = floor(y);
+  const auto k = floor(z);
+  const auto sx = fade<L>(x - i);
+  const auto sy = fade<L>(y - j);
+  const auto sz = fade<L>(z - k);
+
+  const auto x0 = toInt(i) * Int(PRIME_X);
+  const auto y0 = toInt(j) * Int(PRIME_Y);
+  const auto z0 = toInt(k) * Int(PRIME_Z);
+  const auto x1 = x0 + Int(PRIME_X);
+  const auto y1 = y0 + Int(PRIME_Y);
+  const auto z1 = z0 + Int(PRIME_Z);
+
+  auto at = [&](Int cx, Int cy, Int cz) {
+    return latticeValue<L>(hash<L>(seed, cx, cy, cz));
+  };
+  auto plane = [&](Int cz) {
+    return lerp<L>(lerp<L>(at(x0, y0, cz), at(x1, y0, cz), sx),
+                   lerp<L>(at(x0, y1, cz), at(x1, y1, cz), sx), sy);
+  };
+  return lerp<L>(plane(z0), plane(z1), sz);
+}
+
+enum class Shape : uint8_t { Simplex2, Simplex3, Value2, Value3 };
+
+/// Sums the octaves for one register of points. Each octave gets its own
+/// seed so their lattices do not line up.
+template <typename L, Shape S>
+inline auto octaves(const Fractal &fractal, typename L::Float x,
+                    typename L::Float y, typename L::Float z) ->
+    typename L::Float {
+  using Float = typename L::Float;
+  using Int = typename L::Int;
+
+  Float sum(0.0f);
+  float frequency = fractal.frequency;
+  float amplitude = 1.0f;
+  for (uint32_t octave = 0; octave < fractal.octaves; ++octave) {
+    const Int seed(
+        static_cast<int32_t>(static_cast<uint32_t>(fractal.seed) + octave));
+    const Float f(frequency);
+    Float n(0.0f);
+    if constexpr (S == Shape::Simplex2) {
+      n = simplex<L>(seed, x * f, y * f);
+    } else if constexpr (S == Shape::Simplex3) {
+      n = simplex<L>(seed, x * f, y * f, z * f);
+    } else if constexpr (S == Shape::Value2) {
+      n = value<L>(seed, x * f, y * f);
+    } else {
+      n = value<L>(seed, x * f, y * f, z * f);
+    }
+    sum = sum + n * Float(amplitude);
+    frequency *= fractal.lacunarity;
+    amplitude *= fractal.gain;
+  }
+  return sum;
+}
+
+template <typename L, Shape S>
+void batch(const Fractal &fractal, float scale, const float *x,
+             const float *y, const float *z, float *out,
+             size_t count) noexcept {
+  using Float = typename L::Float;
+  constexpr size_t WIDTH = L::WIDTH;
+  constexpr bool THREE_D = S == Shape::Simplex3 || S == Shape::Value3;
+
+  size_t i = 0;
+  for (; i + WIDTH <= count; i += WIDTH) {
+    const auto zs = THREE_D ? Float::load(z + i) : Float(0.0f);
+    const auto n = octaves<L, S>(fractal, Float::load(x + i),
+                                 Float::load(y + i), zs);
+    (n * Float(scale)).store(out + i);
+  }
+  if (i == count) {
+    return;
+  }
+
+  // Pads the tail out to a full register.
+  float tail[3][WIDTH] = {};
+  for (size_t j = 0; i + j < count; ++j) {
+    tail[0][j] = x[i + j];
+    tail[1][j] = y[i + j];
+    tail[2][j] = THREE_D ? z[i + j] : 0.0f;
+  }
+  float result[WIDTH];
+  const auto n =
+      octaves<L, S>(fractal, Float::load(tail[0]), Float::load(tail[1]),
+                    Float::load(tail[2]));
+  (n * Float(scale)).store(result);
+  for (size_t j = 0; i + j < count; ++j) {
+    out[i + j] = result[j];
+  }
+}
+
+template <typename L> auto makeKernels() noexcept -> Kernels {
+  return Kernels{.simplex2 = &batch<L, Shape::Simplex2>,
+                 .simplex3 = &batch<L, Shape::Simplex3>,
+                 .value2 = &batch<L, Shape::Value2>,
+                 .value3 = &batch<L, Shape::Value3>};
+}
+
+} // namespace engine::noise::detail
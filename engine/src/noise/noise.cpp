@@ -0,0 +1,218 @@
+#include "engine/noise.hpp"
+
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(ENGINE_NOISE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace engine::noise {
+
+namespace {
+
+/// Points per kernel call. Coordinates for a block live on the stack.
+constexpr uint32_t BLOCK = 256;
+
+/// Seed offsets of the warp channels, so x, y and z move independently.
+constexpr int32_t WARP_SEEDS[3] = {0, 0x1000, 0x2000};
+
+#ifdef ENGINE_NOISE_X86
+auto cpuSupports(Isa isa) noexcept -> bool {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 1);
+  const bool sse41 = (info[2] & (1 << 19)) != 0;
+  // AVX state has to be enabled by the OS as well as present.
+  const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 &&
+                     (_xgetbv(0) & 6) == 6;
+  __cpuidex(info, 7, 0);
+  const bool avx2 = osAvx && (info[1] & (1 << 5)) != 0;
+#else
+  __builtin_cpu_init();
+  const bool sse41 = __builtin_cpu_supports("sse4.1");
+  const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+  switch (isa) {
+  case Isa::Scalar:
+    return true;
+  case Isa::Sse41:
+    return sse41;
+  case Isa::Avx2:
+    return avx2;
+  }
+  return false;
+}
+#endif
+
+auto kernelsFor(Isa isa) noexcept -> const detail::Kernels & {
+  switch (isa) {
+#ifdef ENGINE_NOISE_X86
+  case Isa::Avx2:
+    return detail::avx2Kernels();
+  case Isa::Sse41:
+    return detail::sse41Kernels();
+#endif
+  default:
+    return detail::scalarKernels();
+  }
+}
+
+auto kernelFor(const detail::Kernels &kernels, Basis basis, bool threeD)
+    -> detail::FractalFn {
+  if (basis == Basis::Value) {
+    return threeD ? kernels.value3 : kernels.value2;
+  }
+  return threeD ? kernels.simplex3 : kernels.simplex2;
+}
+
+/// One over the sum of the octave amplitudes.
+auto normalisation(const Fractal &fractal) noexcept -> float {
+  float sum = 0.0f;
+  float amplitude = 1.0f;
+  for (uint32_t i = 0; i < fractal.octaves; ++i) {
+    sum += amplitude;
+    amplitude *= fractal.gain;
+  }
+  return sum > 0.0f ? 1.0f / sum : 0.0f;
+}
+
+auto withSeedOffset(Fractal fractal, int32_t offset) noexcept -> Fractal {
+  fractal.seed = static_cast<int32_t>(static_cast<uint32_t>(fractal.seed) +
+                                      static_cast<uint32_t>(offset));
+  return fractal;
+}
+
+} // namespace
+
+auto isaName(Isa isa) noexcept -> const char * {
+  switch (isa) {
+  case Isa::Scalar:
+    return "scalar";
+  case Isa::Sse41:
+    return "sse4.1";
+  case Isa::Avx2:
+    return "avx2";
+  }
+  return "unknown";
+}
+
+auto isSupported(Isa isa) noexcept -> bool {
+#ifdef ENGINE_NOISE_X86
+  return cpuSupports(isa);
+#else
+  return isa == Isa::Scalar;
+#endif
+}
+
+auto bestIsa() noexcept -> Isa {
+  static const Isa best = []() {
+    for (auto isa : {Isa::Avx2, Isa::Sse41}) {
+      if (isSupported(isa)) {
+        return isa;
+      }
+    }
+    return Isa::Scalar;
+  }();
+  return best;
+}
+
+Noise::Noise(const Fractal &fractal, const Warp &warp, Isa isa) noexcept
+    : fractal(fractal), warp(warp),
+      _isa(isSupported(isa) ? isa : bestIsa()),
+      scale(normalisation(fractal)), warpScale(normalisation(warp.fractal)) {}
+
+auto Noise::sample(glm::vec2 position) const noexcept -> float {
+  float out;
+  grid(position, glm::uvec2(1), 0.0f, std::span(&out, 1));
+  return out;
+}
+
+auto Noise::sample(glm::vec3 position) const noexcept -> float {
+  float out;
+  grid(position, glm::uvec3(1), 0.0f, std::span(&out, 1));
+  return out;
+}
+
+void Noise::grid(glm::vec2 origin, glm::uvec2 size, float step,
+                 std::span<float> out) const noexcept {
+  const auto kernel = kernelFor(kernelsFor(_isa), fractal.basis, false);
+  const uint32_t count = size.x * size.y;
+
+  float x[BLOCK];
+  float y[BLOCK];
+  for (uint32_t start = 0; start < count; start += BLOCK) {
+    const auto n = std::min(BLOCK, count - start);
+    for (uint32_t i = 0; i < n; ++i) {
+      const auto point = start + i;
+      x[i] = origin.x + static_cast<float>(point % size.x) * step;
+      y[i] = origin.y + static_cast<float>(point / size.x) * step;
+    }
+    warp2(x, y, n);
+    kernel(fractal, scale, x, y, nullptr, out.data() + start, n);
+  }
+}
+
+void Noise::grid(glm::vec3 origin, glm::uvec3 size, float step,
+                 std::span<float> out) const noexcept {
+  const auto kernel = kernelFor(kernelsFor(_isa), fractal.basis, true);
+  const uint32_t layer = size.x * size.z;
+  const uint32_t count = layer * size.y;
+
+  float x[BLOCK];
+  float y[BLOCK];
+  float z[BLOCK];
+  for (uint32_t start = 0; start < count; start += BLOCK) {
+    const auto n = std::min(BLOCK, count - start);
+    for (uint32_t i = 0; i < n; ++i) {
+      const auto point = start + i;
+      const auto inLayer = point % layer;
+      x[i] = origin.x + static_cast<float>(inLayer % size.x) * step;
+      y[i] = origin.y + static_cast<float>(point / layer) * step;
+      z[i] = origin.z + static_cast<float>(inLayer / size.x) * step;
+    }
+    warp3(x, y, z, n);
+    kernel(fractal, scale, x, y, z, out.data() + start, n);
+  }
+}
+
+void Noise::warp2(float *x, float *y, uint32_t count) const noexcept {
+  if (warp.amplitude == 0.0f) {
+    return;
+  }
+  const auto kernel = kernelFor(kernelsFor(_isa), warp.fractal.basis, false);
+
+  // Both channels sample the unwarped position.
+  float dx[BLOCK];
+  float dy[BLOCK];
+  kernel(withSeedOffset(warp.fractal, WARP_SEEDS[0]), warpScale, x, y,
+         nullptr, dx, count);
+  kernel(withSeedOffset(warp.fractal, WARP_SEEDS[1]), warpScale, x, y,
+         nullptr, dy, count);
+  for (uint32_t i = 0; i < count; ++i) {
+    x[i] += dx[i] * warp.amplitude;
+    y[i] += dy[i] * warp.amplitude;
+  }
+}
+
+void Noise::warp3(float *x, float *y, float *z,
+                  uint32_t count) const noexcept {
+  if (warp.amplitude == 0.0f) {
+    return;
+  }
+  const auto kernel = kernelFor(kernelsFor(_isa), warp.fractal.basis, true);
+
+  float offsets[3][BLOCK];
+  for (uint32_t axis = 0; axis < 3; ++axis) {
+    kernel(withSeedOffset(warp.fractal, WARP_SEEDS[axis]), warpScale, x, y,
+           z, offsets[axis], count);
+  }
+  for (uint32_t i = 0; i < count; ++i) {
+    x[i] += offsets[0][i] * warp.amplitude;
+    y[i] += offsets[1][i] * warp.amplitude;
+    z[i] += offsets[2][i] * warp.amplitude;
+  }
+}
+
+} // namespace engine::noise
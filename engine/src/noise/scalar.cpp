@@ -0,0 +1,85 @@
+#include "kernels.hpp"
+
+#include <bit>
+#include <cmath>
+
+namespace engine::noise::detail {
+
+namespace scalar {
+
+struct Mask {
+  bool v;
+
+  friend auto operator&(Mask a, Mask b) -> Mask { return {a.v && b.v}; }
+  friend auto operator|(Mask a, Mask b) -> Mask { return {a.v || b.v}; }
+  friend auto operator~(Mask a) -> Mask { return {!a.v}; }
+};
+
+struct Int {
+  int32_t v;
+
+  Int(int32_t value) : v(value) {}
+
+  // Unsigned so overflow wraps like the vector lanes.
+  friend auto operator+(Int a, Int b) -> Int {
+    return static_cast<int32_t>(static_cast<uint32_t>(a.v) +
+                                static_cast<uint32_t>(b.v));
+  }
+  friend auto operator*(Int a, Int b) -> Int {
+    return static_cast<int32_t>(static_cast<uint32_t>(a.v) *
+                                static_cast<uint32_t>(b.v));
+  }
+  friend auto operator^(Int a, Int b) -> Int { return a.v ^ b.v; }
+  friend auto operator&(Int a, Int b) -> Int { return a.v & b.v; }
+  friend auto operator<<(Int a, int shift) -> Int {
+    return static_cast<int32_t>(static_cast<uint32_t>(a.v) << shift);
+  }
+  friend auto operator>>(Int a, int shift) -> Int {
+    return static_cast<int32_t>(static_cast<uint32_t>(a.v) >> shift);
+  }
+  friend auto operator<(Int a, Int b) -> Mask { return {a.v < b.v}; }
+  friend auto operator==(Int a, Int b) -> Mask { return {a.v == b.v}; }
+};
+
+struct Float {
+  float v;
+
+  Float(float value) : v(value) {}
+
+  static auto load(const float *p) -> Float { return *p; }
+  void store(float *p) const { *p = v; }
+
+  friend auto operator+(Float a, Float b) -> Float { return a.v + b.v; }
+  friend auto operator-(Float a, Float b) -> Float { return a.v - b.v; }
+  friend auto operator*(Float a, Float b) -> Float { return a.v * b.v; }
+  friend auto operator>(Float a, Float b) -> Mask { return {a.v > b.v}; }
+  friend auto operator>=(Float a, Float b) -> Mask { return {a.v >= b.v}; }
+
+  friend auto floor(Float a) -> Float { return std::floor(a.v); }
+  // Same operand order as maxps.
+  friend auto max(Float a, Float b) -> Float { return a.v > b.v ? a : b; }
+  friend auto flipSign(Float a, Int bits) -> Float {
+    return std::bit_cast<float>(std::bit_cast<int32_t>(a.v) ^ bits.v);
+  }
+  friend auto select(Mask mask, Float a, Float b) -> Float {
+    return mask.v ? a : b;
+  }
+};
+
+inline auto toInt(Float a) -> Int { return static_cast<int32_t>(a.v); }
+inline auto toFloat(Int a) -> Float { return static_cast<float>(a.v); }
+
+struct Lanes {
+  using Float = scalar::Float;
+  using Int = scalar::Int;
+  static constexpr size_t WIDTH = 1;
+};
+
+} // namespace scalar
+
+auto scalarKernels() noexcept -> const Kernels & {
+  static const Kernels kernels = makeKernels<scalar::Lanes>();
+  return kernels;
+}
+
+} // namespace engine::noise::detail
@@ -0,0 +1,110 @@
+#include "kernels.hpp"
+
+#ifdef ENGINE_NOISE_X86
+
+#include <smmintrin.h>
+
+namespace engine::noise::detail {
+
+namespace sse41 {
+
+struct Mask {
+  __m128 v;
+
+  friend auto operator&(Mask a, Mask b) -> Mask {
+    return {_mm_and_ps(a.v, b.v)};
+  }
+  friend auto operator|(Mask a, Mask b) -> Mask {
+    return {_mm_or_ps(a.v, b.v)};
+  }
+  friend auto operator~(Mask a) -> Mask {
+    return {_mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1)))};
+  }
+};
+
+struct Int {
+  __m128i v;
+
+  Int(__m128i value) : v(value) {}
+  Int(int32_t value) : v(_mm_set1_epi32(value)) {}
+
+  friend auto operator+(Int a, Int b) -> Int {
+    return _mm_add_epi32(a.v, b.v);
+  }
+  friend auto operator*(Int a, Int b) -> Int {
+    return _mm_mullo_epi32(a.v, b.v);
+  }
+  friend auto operator^(Int a, Int b) -> Int {
+    return _mm_xor_si128(a.v, b.v);
+  }
+  friend auto operator&(Int a, Int b) -> Int {
+    return _mm_and_si128(a.v, b.v);
+  }
+  friend auto operator<<(Int a, int shift) -> Int {
+    return _mm_slli_epi32(a.v, shift);
+  }
+  friend auto operator>>(Int a, int shift) -> Int {
+    return _mm_srli_epi32(a.v, shift);
+  }
+  friend auto operator<(Int a, Int b) -> Mask {
+    return {_mm_castsi128_ps(_mm_cmplt_epi32(a.v, b.v))};
+  }
+  friend auto operator==(Int a, Int b) -> Mask {
+    return {_mm_castsi128_ps(_mm_cmpeq_epi32(a.v, b.v))};
+  }
+};
+
+struct Float {
+  __m128 v;
+
+  Float(__m128 value) : v(value) {}
+  Float(float value) : v(_mm_set1_ps(value)) {}
+
+  static auto load(const float *p) -> Float { return _mm_loadu_ps(p); }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+
+  friend auto operator+(Float a, Float b) -> Float {
+    return _mm_add_ps(a.v, b.v);
+  }
+  friend auto operator-(Float a, Float b) -> Float {
+    return _mm_sub_ps(a.v, b.v);
+  }
+  friend auto operator*(Float a, Float b) -> Float {
+    return _mm_mul_ps(a.v, b.v);
+  }
+  friend auto operator>(Float a, Float b) -> Mask {
+    return {_mm_cmpgt_ps(a.v, b.v)};
+  }
+  friend auto operator>=(Float a, Float b) -> Mask {
+    return {_mm_cmpge_ps(a.v, b.v)};
+  }
+
+  friend auto floor(Float a) -> Float { return _mm_floor_ps(a.v); }
+  friend auto max(Float a, Float b) -> Float { return _mm_max_ps(a.v, b.v); }
+  friend auto flipSign(Float a, Int bits) -> Float {
+    return _mm_xor_ps(a.v, _mm_castsi128_ps(bits.v));
+  }
+  friend auto select(Mask mask, Float a, Float b) -> Float {
+    return _mm_blendv_ps(b.v, a.v, mask.v);
+  }
+};
+
+inline auto toInt(Float a) -> Int { return _mm_cvttps_epi32(a.v); }
+inline auto toFloat(Int a) -> Float { return _mm_cvtepi32_ps(a.v); }
+
+struct Lanes {
+  using Float = sse41::Float;
+  using Int = sse41::Int;
+  static constexpr size_t WIDTH = 4;
+};
+
+} // namespace sse41
+
+auto sse41Kernels() noexcept -> const Kernels & {
+  static const Kernels kernels = makeKernels<sse41::Lanes>();
+  return kernels;
+}
+
+} // namespace engine::noise::detail
+
+#endif
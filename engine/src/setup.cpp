@@ -48,6 +48,17 @@ auto findCoreQueues(const vk::raii::PhysicalDevice &physicalDevice,
 
   QueueFinder finder(physicalDevice);
 
+  if (*surface == nullptr) {
+    auto graphicsFinder = finder.findType(
+        QueueFinder::QueueType{.type = QueueFinder::QueueTypeFlags::Graphics});
+    if (!graphicsFinder.hasQueue()) {
+      Logger::error("No graphics queue family found");
+      return std::unexpected("No graphics queue family found");
+    }
+    const auto index = graphicsFinder.first().index;
+    return CoreQueueFamilyIndices{.graphics = index, .present = index};
+  }
+
   auto combinedFinder = finder.findCombined(
       {{QueueFinder::QueueType{.type = QueueFinder::QueueTypeFlags::Graphics}},
        {QueueFinder::QueueType{.type = QueueFinder::QueueTypeFlags::Present,
@@ -90,6 +101,31 @@ auto findCoreQueues(const vk::raii::PhysicalDevice &physicalDevice,
   return ind;
 }
 
+auto findTransferQueue(const vk::raii::PhysicalDevice &physicalDevice,
+                       uint32_t graphicsFamily) noexcept
+    -> std::optional<uint32_t> {
+  using vkh::QueueFinder;
+
+  auto others =
+      QueueFinder(physicalDevice)
+          .findType(QueueFinder::QueueType{
+              .type = QueueFinder::QueueTypeFlags::Transfer})
+          .find([graphicsFamily](const QueueFinder::QueueFamily &family) {
+            return family.index != graphicsFamily;
+          });
+
+  if (!others.hasQueue()) {
+    return std::nullopt;
+  }
+
+  auto dedicated = others.find([](const QueueFinder::QueueFamily &family) {
+    return !(family.properties.queueFlags &
+             (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute));
+  });
+
+  return dedicated.hasQueue() ? dedicated.first().index : others.first().index;
+}
+
 auto retrieveQueues(const vk::raii::Device &device,
                     const std::vector<uint32_t> &indices)
     -> std::expected<std::vector<vkh::Queue>, std::string> {
@@ -183,13 +219,12 @@ auto createSyncObjects(const vk::raii::Device &device) noexcept
 
 std::expected<vkh::AllocatedImage, std::string>
 createRenderImage(const vk::raii::Device &device, const vma::Allocator &alloc,
-                  const vkh::SwapchainConfig &swapchainConfig,
-                  vk::Format format) {
+                  vk::Extent2D extent, vk::Format format) {
   vk::ImageCreateInfo imageCreateInfo{
       .imageType = vk::ImageType::e2D,
       .format = format,
-      .extent = vk::Extent3D{.width = swapchainConfig.extent.width,
-                             .height = swapchainConfig.extent.height,
+      .extent = vk::Extent3D{.width = extent.width,
+                             .height = extent.height,
                              .depth = 1},
       .mipLevels = 1,
       .arrayLayers = 1,
@@ -238,6 +273,51 @@ createRenderImage(const vk::raii::Device &device, const vma::Allocator &alloc,
   return std::move(allocatedImage);
 }
 
+auto createDepthImage(const vk::raii::Device &device,
+                      const vma::Allocator &alloc, vk::Extent3D extent,
+                      vk::Format format) noexcept
+    -> std::expected<vkh::AllocatedImage, std::string> {
+  vk::ImageCreateInfo imageCreateInfo{
+      .imageType = vk::ImageType::e2D,
+      .format = format,
+      .extent = extent,
+      .mipLevels = 1,
+      .arrayLayers = 1,
+      .samples = vk::SampleCountFlagBits::e1,
+      .tiling = vk::ImageTiling::eOptimal,
+      .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment |
+               vk::ImageUsageFlagBits::eSampled,
+      .sharingMode = vk::SharingMode::eExclusive,
+      .initialLayout = vk::ImageLayout::eUndefined};
+
+  vma::AllocationCreateInfo allocInfo{
+      .usage = vma::MemoryUsage::eGpuOnly,
+      .requiredFlags =
+          vk::MemoryPropertyFlags(vk::MemoryPropertyFlagBits::eDeviceLocal)};
+
+  VMA_MAKE(imagePair, alloc.createImage(imageCreateInfo, allocInfo),
+           "Failed to create depth image");
+
+  VK_MAKE(imageView,
+          device.createImageView(vk::ImageViewCreateInfo{
+              .image = imagePair.first,
+              .viewType = vk::ImageViewType::e2D,
+              .format = format,
+              .subresourceRange = {.aspectMask =
+                                       vk::ImageAspectFlagBits::eDepth,
+                                   .baseMipLevel = 0,
+                                   .levelCount = 1,
+                                   .baseArrayLayer = 0,
+                                   .layerCount = 1}}),
+          "Failed to create image view for depth image");
+
+  return vkh::AllocatedImage{.image = imagePair.first,
+                             .view = imageView.release(),
+                             .alloc = imagePair.second,
+                             .extent = extent,
+                             .format = format};
+}
+
 std::expected<ImGuiVkObjects, std::string>
 setupImGui(GLFWwindow *window, const vk::raii::Instance &instance,
            const vk::raii::Device &device,
@@ -0,0 +1,190 @@
+#include "engine/staging.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <engine/util/macros.hpp>
+
+namespace engine {
+
+auto StagingRing::create(vma::Allocator &allocator,
+                         vk::DeviceSize partitionSize) noexcept
+    -> std::expected<StagingRing, std::string> {
+  partitionSize =
+      (partitionSize + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+
+  EG_MAKE(buffer,
+          vkh::AllocatedBuffer::create(
+              allocator,
+              vk::BufferCreateInfo{.size = partitionSize * MAX_FRAMES_IN_FLIGHT,
+                                   .usage =
+                                       vk::BufferUsageFlagBits::eTransferSrc,
+                                   .sharingMode = vk::SharingMode::eExclusive},
+              vma::AllocationCreateInfo{
+                  .flags = vma::AllocationCreateFlagBits::eMapped |
+                           vma::AllocationCreateFlagBits::
+                               eHostAccessSequentialWrite,
+                  .usage = vma::MemoryUsage::eAuto,
+              }),
+          "Failed to create staging ring buffer");
+
+  Logger::trace("Created staging ring with {} partitions of {} bytes",
+                MAX_FRAMES_IN_FLIGHT, partitionSize);
+
+  return StagingRing(buffer, partitionSize);
+}
+
+void StagingRing::beginFrame(uint32_t frameIndex) noexcept {
+  for (auto &guard : guards) {
+    if (guard == frameIndex) {
+      guard = std::nullopt;
+    }
+  }
+
+  last = current;
+  current = {};
+
+  // Whatever is queued still lives in the active partition.
+  if (!pending.empty()) {
+    return;
+  }
+
+  auto freePartition = std::ranges::find(guards, std::nullopt);
+  if (freePartition == guards.end()) {
+    // Only reachable if frames are begun out of order, keep appending to the
+    // active partition rather than overwrite one in flight.
+    Logger::warn("No free staging partition for frame {}", frameIndex);
+    return;
+  }
+
+  active = static_cast<uint32_t>(freePartition - guards.begin());
+  head = 0;
+}
+
+auto StagingRing::upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                         std::span<const std::byte> data) noexcept -> bool {
+  if (data.empty()) {
+    return true;
+  }
+
+  const auto offset = (head + UPLOAD_ALIGNMENT - 1) & ~(UPLOAD_ALIGNMENT - 1);
+  if (guards[active].has_value() || offset + data.size() > size) {
+    ++current.rejected;
+    return false;
+  }
+
+  const auto srcOffset = active * size + offset;
+  std::memcpy(mapped + srcOffset, data.data(), data.size());
+  head = offset + data.size();
+
+  pending.push_back(PendingCopy{.dst = dst,
+                                .region = vk::BufferCopy{
+                                    .srcOffset = srcOffset,
+                                    .dstOffset = dstOffset,
+                                    .size = data.size(),
+                                }});
+
+  ++current.uploads;
+  current.bytes += data.size();
+  total += data.size();
+  return true;
+}
+
+void StagingRing::copy(vk::Buffer buffer, vk::DeviceSize srcOffset,
+                       vk::DeviceSize dstOffset, vk::DeviceSize size) noexcept {
+  if (size == 0) {
+    return;
+  }
+  copies.push_back(PendingCopy{.dst = buffer,
+                               .region = vk::BufferCopy{
+                                   .srcOffset = srcOffset,
+                                   .dstOffset = dstOffset,
+                                   .size = size,
+                               }});
+  current.copiedBytes += size;
+}
+
+void StagingRing::flush(const vk::raii::CommandBuffer &cmdBuffer,
+                        uint32_t frameIndex) noexcept {
+  const bool wait = std::exchange(overwrites, false);
+  if (pending.empty() && copies.empty()) {
+    return;
+  }
+
+  if (wait) {
+    // Only has to wait for the reads, which leave nothing to make visible.
+    vk::MemoryBarrier2 wait{
+        .srcStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+        .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+    };
+    cmdBuffer.pipelineBarrier2(vk::DependencyInfo{
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &wait,
+    });
+  }
+
+  // Nothing this frame writes their sources, so they need no barrier
+  // against the uploads.
+  std::ranges::stable_sort(copies, {}, [](const PendingCopy &copy) {
+    return static_cast<VkBuffer>(copy.dst);
+  });
+  for (auto it = copies.begin(); it != copies.end();) {
+    const auto dst = it->dst;
+    regions.clear();
+    for (; it != copies.end() && it->dst == dst; ++it) {
+      regions.push_back(it->region);
+    }
+    cmdBuffer.copyBuffer(dst, dst, regions);
+    ++current.copyCommands;
+  }
+  copies.clear();
+
+  // Group by destination. Uploads to one destination in one frame share a
+  // copy command, so they must not overlap.
+  std::ranges::stable_sort(pending, {}, [](const PendingCopy &copy) {
+    return static_cast<VkBuffer>(copy.dst);
+  });
+
+  for (auto it = pending.begin(); it != pending.end();) {
+    const auto dst = it->dst;
+    regions.clear();
+    for (; it != pending.end() && it->dst == dst; ++it) {
+      auto &region = it->region;
+      // Uploads staged back to back into a contiguous range become one
+      // region.
+      if (!regions.empty()) {
+        auto &prev = regions.back();
+        if (prev.srcOffset + prev.size == region.srcOffset &&
+            prev.dstOffset + prev.size == region.dstOffset) {
+          prev.size += region.size;
+          continue;
+        }
+      }
+      regions.push_back(region);
+    }
+
+    cmdBuffer.copyBuffer(buffer.buffer, dst, regions);
+    ++current.copyCommands;
+  }
+
+  if (!pending.empty()) {
+    pending.clear();
+    guards[active] = frameIndex;
+  }
+
+  vk::MemoryBarrier2 barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eAllCommands,
+      .dstAccessMask = vk::AccessFlagBits2::eMemoryRead,
+  };
+  cmdBuffer.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = 1,
+      .pMemoryBarriers = &barrier,
+  });
+}
+
+} // namespace engine
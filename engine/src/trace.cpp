@@ -0,0 +1,199 @@
+#include "engine/trace.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace engine::trace {
+
+namespace detail {
+std::atomic<bool> recording = false;
+} // namespace detail
+
+namespace {
+
+struct Event {
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+struct ThreadBuffer {
+  /// Guarded by the registry's mutex.
+  std::string name;
+  uint32_t id;
+  /// Allocated by the owning thread before it publishes its first zone.
+  std::unique_ptr<Event[]> events;
+  /// Zones recorded so far, the next goes at `head % CAPACITY`.
+  std::atomic<uint64_t> head = 0;
+};
+
+struct Registry {
+  std::mutex mutex;
+  /// Kept once their threads exit, so what those recorded is still written.
+  std::vector<std::unique_ptr<ThreadBuffer>> threads;
+  /// When recording last started.
+  std::atomic<uint64_t> since = 0;
+};
+
+auto registry() noexcept -> Registry & {
+  static Registry instance;
+  return instance;
+}
+
+thread_local ThreadBuffer *current = nullptr;
+
+auto currentThread() noexcept -> ThreadBuffer & {
+  if (current == nullptr) {
+    auto &reg = registry();
+    std::lock_guard lock(reg.mutex);
+    auto thread = std::make_unique<ThreadBuffer>();
+    thread->id = static_cast<uint32_t>(reg.threads.size());
+    thread->name = "Thread " + std::to_string(thread->id);
+    current = thread.get();
+    reg.threads.push_back(std::move(thread));
+  }
+  return *current;
+}
+
+/// Calls `visit` with every zone recorded since `since` that its thread still
+/// holds. Hold the registry's mutex.
+template <typename F>
+void forEachEvent(const ThreadBuffer &thread, uint64_t since,
+                  F &&visit) noexcept {
+  const auto head = thread.head.load(std::memory_order_acquire);
+  const auto oldest = head > CAPACITY ? head - CAPACITY : 0;
+  for (auto i = oldest; i < head; ++i) {
+    const auto &event = thread.events[i % CAPACITY];
+    if (event.start >= since) {
+      visit(event);
+    }
+  }
+}
+
+/// Zone names are literals, but a quote or backslash would still break the
+/// file.
+void writeString(std::FILE *file, std::string_view text) noexcept {
+  std::fputc('"', file);
+  for (const auto c : text) {
+    if (c == '"' || c == '\\') {
+      std::fputc('\\', file);
+      std::fputc(c, file);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      std::fprintf(file, "\\u%04x", static_cast<unsigned>(c));
+    } else {
+      std::fputc(c, file);
+    }
+  }
+  std::fputc('"', file);
+}
+
+} // namespace
+
+void detail::record(const char *name, uint64_t start, uint64_t end) noexcept {
+  auto &thread = currentThread();
+  if (thread.events == nullptr) {
+    thread.events = std::make_unique_for_overwrite<Event[]>(CAPACITY);
+  }
+  const auto head = thread.head.load(std::memory_order_relaxed);
+  thread.events[head % CAPACITY] =
+      Event{.name = name, .start = start, .end = end};
+  thread.head.store(head + 1, std::memory_order_release);
+}
+
+void start() noexcept {
+  registry().since.store(detail::now(), std::memory_order_relaxed);
+  detail::recording.store(true, std::memory_order_relaxed);
+}
+
+void stop() noexcept {
+  detail::recording.store(false, std::memory_order_relaxed);
+}
+
+auto write(const std::filesystem::path &path) noexcept
+    -> std::expected<void, std::string> {
+  auto *file = std::fopen(path.string().c_str(), "wb");
+  if (file == nullptr) {
+    return std::unexpected("Failed to open " + path.string());
+  }
+
+  auto &reg = registry();
+  const auto since = reg.since.load(std::memory_order_relaxed);
+  std::lock_guard lock(reg.mutex);
+
+  // Complete events, "X", in microseconds from the start of recording.
+  std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+  bool first = true;
+  const auto separate = [&]() {
+    std::fputs(first ? "\n" : ",\n", file);
+    first = false;
+  };
+
+  for (const auto &thread : reg.threads) {
+    const auto head = thread->head.load(std::memory_order_acquire);
+    if (head == 0) {
+      continue;
+    }
+
+    separate();
+    std::fprintf(file,
+                 "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\","
+                 "\"args\":{\"name\":",
+                 thread->id);
+    writeString(file, thread->name);
+    std::fputs("}}", file);
+
+    forEachEvent(*thread, since, [&](const Event &event) {
+      separate();
+      std::fputs("{\"ph\":\"X\",\"pid\":1,\"name\":", file);
+      writeString(file, event.name);
+      std::fprintf(file, ",\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                   static_cast<double>(event.start - since) * 1e-3,
+                   static_cast<double>(event.end - event.start) * 1e-3);
+    });
+  }
+  std::fputs("\n]}\n", file);
+
+  const auto failed = std::ferror(file) != 0;
+  if (std::fclose(file) != 0 || failed) {
+    return std::unexpected("Failed to write " + path.string());
+  }
+  return {};
+}
+
+auto totals() noexcept -> std::vector<ZoneTotal> {
+  auto &reg = registry();
+  const auto since = reg.since.load(std::memory_order_relaxed);
+  std::lock_guard lock(reg.mutex);
+
+  std::vector<ZoneTotal> found;
+  for (const auto &thread : reg.threads) {
+    forEachEvent(*thread, since, [&](const Event &event) {
+      // Equal literals from different translation units may not share an
+      // address, so names are compared by their text.
+      auto total = std::ranges::find_if(found, [&](const ZoneTotal &t) {
+        return std::string_view(t.name) == event.name;
+      });
+      if (total == found.end()) {
+        total = found.insert(
+            found.end(), ZoneTotal{.name = event.name, .count = 0,
+                                   .nanoseconds = 0});
+      }
+      ++total->count;
+      total->nanoseconds += event.end - event.start;
+    });
+  }
+  std::ranges::sort(found, std::greater{}, &ZoneTotal::nanoseconds);
+  return found;
+}
+
+void setThreadName(std::string name) noexcept {
+  auto &thread = currentThread();
+  std::lock_guard lock(registry().mutex);
+  thread.name = std::move(name);
+}
+
+} // namespace engine::trace
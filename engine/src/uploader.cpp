@@ -0,0 +1,134 @@
+#include "engine/uploader.hpp"
+
+#include "logger.hpp"
+
+#include <engine/util/macros.hpp>
+
+namespace engine {
+
+auto AsyncUploader::create(const vk::raii::Device &device,
+                           vma::Allocator &allocator,
+                           const vkh::Queue &transferQueue,
+                           uint32_t graphicsFamily,
+                           vk::DeviceSize stagingSize) noexcept
+    -> std::expected<AsyncUploader, std::string> {
+  VK_MAKE(commandPool,
+          device.createCommandPool(vk::CommandPoolCreateInfo{
+              .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+              .queueFamilyIndex = transferQueue.index}),
+          "Failed to create upload command pool");
+
+  VK_MAKE(commandBuffersV,
+          device.allocateCommandBuffers(vk::CommandBufferAllocateInfo{
+              .commandPool = *commandPool,
+              .level = vk::CommandBufferLevel::ePrimary,
+              .commandBufferCount = MAX_FRAMES_IN_FLIGHT}),
+          "Failed to allocate upload command buffers");
+
+  std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers{
+      std::move(commandBuffersV[0]), std::move(commandBuffersV[1])};
+
+  vk::SemaphoreTypeCreateInfo timelineInfo{
+      .semaphoreType = vk::SemaphoreType::eTimeline, .initialValue = 0};
+  VK_MAKE(
+      timeline,
+      device.createSemaphore(vk::SemaphoreCreateInfo{.pNext = &timelineInfo}),
+      "Failed to create upload timeline semaphore");
+
+  EG_MAKE(staging, StagingRing::create(allocator, stagingSize),
+          "Failed to create upload staging ring");
+
+  if (transferQueue.index != graphicsFamily) {
+    Logger::info("Uploading on dedicated transfer queue family {}, into "
+                 "buffers shared with graphics family {}",
+                 transferQueue.index, graphicsFamily);
+  } else {
+    Logger::info("No separate transfer queue family, uploading on the "
+                 "graphics family");
+  }
+
+  return AsyncUploader(transferQueue, graphicsFamily, std::move(commandPool),
+                       std::move(commandBuffers), std::move(timeline),
+                       std::move(staging));
+}
+
+auto AsyncUploader::upload(vk::Buffer dst, vk::DeviceSize dstOffset,
+                           std::span<const std::byte> data) noexcept -> bool {
+  if (!staging.upload(dst, dstOffset, data)) {
+    return false;
+  }
+
+  batchStaged = batchStaged || !data.empty();
+  return true;
+}
+
+auto AsyncUploader::submit(const vk::raii::Device &device) noexcept
+    -> std::expected<std::optional<uint64_t>, std::string> {
+  if (!batchStaged) {
+    return std::nullopt;
+  }
+
+  auto &cmdBuffer = commandBuffers[slot];
+  cmdBuffer.reset();
+  cmdBuffer.begin(vk::CommandBufferBeginInfo{
+      .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
+
+  staging.flush(cmdBuffer, slot);
+
+  cmdBuffer.end();
+
+  const auto value = ++lastValue;
+
+  vk::CommandBufferSubmitInfo cmdInfo{.commandBuffer = *cmdBuffer};
+  vk::SemaphoreSubmitInfo signalInfo{
+      .semaphore = *timeline,
+      .value = value,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands};
+  queue.queue->submit2(vk::SubmitInfo2{.commandBufferInfoCount = 1,
+                                       .pCommandBufferInfos = &cmdInfo,
+                                       .signalSemaphoreInfoCount = 1,
+                                       .pSignalSemaphoreInfos = &signalInfo});
+
+  slotValues[slot] = value;
+  unwaited = value;
+  batchStaged = false;
+
+  // The next slot's command buffer and staging partition are reused, so its
+  // previous batch has to be done.
+  slot = (slot + 1) % MAX_FRAMES_IN_FLIGHT;
+  if (slotValues[slot] != 0) {
+    vk::SemaphoreWaitInfo waitInfo{.semaphoreCount = 1,
+                                   .pSemaphores = &*timeline,
+                                   .pValues = &slotValues[slot]};
+    if (device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+      return std::unexpected("Failed to wait for upload batch");
+    }
+  }
+  staging.beginFrame(slot);
+
+  return value;
+}
+
+auto AsyncUploader::takeWait() noexcept
+    -> std::optional<vk::SemaphoreSubmitInfo> {
+  if (!unwaited.has_value()) {
+    return std::nullopt;
+  }
+
+  // Batches complete in order, so waiting on the last covers the rest.
+  const auto value = *unwaited;
+  unwaited = std::nullopt;
+  return vk::SemaphoreSubmitInfo{
+      .semaphore = *timeline,
+      .value = value,
+      .stageMask = vk::PipelineStageFlagBits2::eAllCommands};
+}
+
+auto AsyncUploader::isComplete(const vk::raii::Device &device,
+                               uint64_t value) const noexcept -> bool {
+  vk::SemaphoreWaitInfo waitInfo{
+      .semaphoreCount = 1, .pSemaphores = &*timeline, .pValues = &value};
+  return device.waitSemaphores(waitInfo, 0) == vk::Result::eSuccess;
+}
+
+} // namespace engine
@@ -0,0 +1,345 @@
+#include "engine/voxel/chunk.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <utility>
+
+namespace engine::voxel {
+
+namespace {
+[[nodiscard]] constexpr auto bitsForPalette(size_t size) noexcept -> uint8_t {
+  if (size <= 1) {
+    return 0;
+  }
+  if (size <= 2) {
+    return 1;
+  }
+  if (size <= 4) {
+    return 2;
+  }
+  if (size <= 16) {
+    return 4;
+  }
+  if (size <= 256) {
+    return 8;
+  }
+  return 16;
+}
+
+[[nodiscard]] constexpr auto paletteCapacity(uint8_t bits) noexcept -> size_t {
+  return size_t{1} << bits;
+}
+
+/// Leads each serialized chunk, followed by the palette and the index words.
+struct SerialHeader {
+  uint32_t paletteSize;
+  uint8_t bits;
+  uint8_t reserved[3];
+};
+static_assert(sizeof(SerialHeader) == 8);
+
+void append(std::vector<std::byte> &out, const void *data, size_t size) {
+  const auto *bytes = static_cast<const std::byte *>(data);
+  out.insert(out.end(), bytes, bytes + size);
+}
+} // namespace
+
+PackedArray::PackedArray(uint32_t length, uint8_t bits) noexcept
+    : mask((uint64_t{1} << bits) - 1), _bits(bits) {
+  if (bits == 0) {
+    return;
+  }
+  bitsShift = static_cast<uint8_t>(std::countr_zero(bits));
+  perWordShift = static_cast<uint8_t>(6 - bitsShift);
+  perWordMask = (1u << perWordShift) - 1;
+  wordCount = (length + perWordMask) >> perWordShift;
+  storage = new Storage{.refs = 1, .words = std::vector<uint64_t>(wordCount)};
+  words = storage->words.data();
+}
+
+PackedArray::PackedArray(const PackedArray &other) noexcept
+    : storage(other.storage), words(other.words),
+      wordCount(other.wordCount), mask(other.mask), _bits(other._bits),
+      bitsShift(other.bitsShift), perWordShift(other.perWordShift),
+      perWordMask(other.perWordMask) {
+  if (storage != nullptr) {
+    storage->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+PackedArray::PackedArray(PackedArray &&other) noexcept
+    : storage(std::exchange(other.storage, nullptr)),
+      words(std::exchange(other.words, nullptr)),
+      wordCount(std::exchange(other.wordCount, 0)), mask(other.mask),
+      _bits(other._bits), bitsShift(other.bitsShift),
+      perWordShift(other.perWordShift), perWordMask(other.perWordMask) {}
+
+PackedArray &PackedArray::operator=(const PackedArray &other) noexcept {
+  if (this != &other) {
+    *this = PackedArray(other);
+  }
+  return *this;
+}
+
+PackedArray &PackedArray::operator=(PackedArray &&other) noexcept {
+  if (this != &other) {
+    release();
+    storage = std::exchange(other.storage, nullptr);
+    words = std::exchange(other.words, nullptr);
+    wordCount = std::exchange(other.wordCount, 0);
+    mask = other.mask;
+    _bits = other._bits;
+    bitsShift = other.bitsShift;
+    perWordShift = other.perWordShift;
+    perWordMask = other.perWordMask;
+  }
+  return *this;
+}
+
+PackedArray::~PackedArray() { release(); }
+
+void PackedArray::detach() noexcept {
+  auto *copy = new Storage{.refs = 1, .words = storage->words};
+  release();
+  storage = copy;
+  words = copy->words.data();
+}
+
+void PackedArray::release() noexcept {
+  if (storage != nullptr &&
+      storage->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete storage;
+  }
+  storage = nullptr;
+  words = nullptr;
+}
+
+auto PackedArray::widen(uint32_t length, uint8_t bits) const noexcept
+    -> PackedArray {
+  PackedArray out(length, bits);
+  if (_bits == 0) {
+    return out;
+  }
+  for (uint32_t i = 0; i < length; ++i) {
+    out.setUnshared(i, get(i));
+  }
+  return out;
+}
+
+Chunk::Chunk(BlockId fill) noexcept
+    : palette{fill}, refCounts{static_cast<uint16_t>(CHUNK_VOLUME)} {}
+
+void Chunk::setIndex(uint32_t i, BlockId block) noexcept {
+  const uint32_t old = indices.bits() == 0 ? 0 : indices.get(i);
+  if (palette[old] == block) {
+    return;
+  }
+
+  const auto slot = paletteSlot(block, old);
+  if (slot == old) {
+    // The voxel held the last reference to its entry, which now names the
+    // new block instead.
+    return;
+  }
+
+  --refCounts[old];
+  ++refCounts[slot];
+  indices.set(i, slot);
+}
+
+auto Chunk::paletteSlot(BlockId block, uint32_t replacing) noexcept
+    -> uint32_t {
+  auto it = std::ranges::find(palette, block);
+  if (it != palette.end()) {
+    return static_cast<uint32_t>(it - palette.begin());
+  }
+
+  if (refCounts[replacing] == 1) {
+    palette[replacing] = block;
+    return replacing;
+  }
+
+  auto freeSlot = std::ranges::find(refCounts, uint16_t{0});
+  if (freeSlot != refCounts.end()) {
+    const auto slot = static_cast<uint32_t>(freeSlot - refCounts.begin());
+    palette[slot] = block;
+    return slot;
+  }
+
+  palette.push_back(block);
+  refCounts.push_back(0);
+
+  if (palette.size() > paletteCapacity(indices.bits())) {
+    resize(bitsForPalette(palette.size()));
+  }
+
+  return static_cast<uint32_t>(palette.size() - 1);
+}
+
+void Chunk::resize(uint8_t bits) noexcept {
+  indices = indices.widen(CHUNK_VOLUME, bits);
+}
+
+void Chunk::fill(BlockId block) noexcept {
+  palette.assign(1, block);
+  refCounts.assign(1, static_cast<uint16_t>(CHUNK_VOLUME));
+  indices = PackedArray();
+}
+
+void Chunk::unpack(std::span<BlockId, CHUNK_VOLUME> out) const noexcept {
+  forEach([&out](uint32_t i, BlockId block) { out[i] = block; });
+}
+
+void Chunk::pack(std::span<const BlockId, CHUNK_VOLUME> blocks) noexcept {
+  palette.clear();
+  refCounts.clear();
+
+  std::vector<uint32_t> slots(CHUNK_VOLUME);
+
+  BlockId lastBlock = blocks[0];
+  uint32_t lastSlot = 0;
+  palette.push_back(lastBlock);
+  refCounts.push_back(0);
+
+  for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+    const auto block = blocks[i];
+    if (block != lastBlock) {
+      auto it = std::ranges::find(palette, block);
+      if (it == palette.end()) {
+        palette.push_back(block);
+        refCounts.push_back(0);
+        it = palette.end() - 1;
+      }
+      lastBlock = block;
+      lastSlot = static_cast<uint32_t>(it - palette.begin());
+    }
+    slots[i] = lastSlot;
+    ++refCounts[lastSlot];
+  }
+
+  indices = PackedArray(CHUNK_VOLUME, bitsForPalette(palette.size()));
+  if (indices.bits() == 0) {
+    return;
+  }
+  for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+    indices.setUnshared(i, slots[i]);
+  }
+}
+
+void Chunk::compact() noexcept {
+  std::vector<uint32_t> remap(palette.size(), 0);
+  std::vector<BlockId> newPalette;
+  std::vector<uint16_t> newRefCounts;
+
+  for (size_t i = 0; i < palette.size(); ++i) {
+    if (refCounts[i] == 0) {
+      continue;
+    }
+    remap[i] = static_cast<uint32_t>(newPalette.size());
+    newPalette.push_back(palette[i]);
+    newRefCounts.push_back(refCounts[i]);
+  }
+
+  const auto bits = bitsForPalette(newPalette.size());
+  if (newPalette.size() == palette.size() && bits == indices.bits()) {
+    return;
+  }
+
+  PackedArray newIndices(CHUNK_VOLUME, bits);
+  if (bits != 0) {
+    for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+      newIndices.setUnshared(i, remap[indices.get(i)]);
+    }
+  }
+
+  palette = std::move(newPalette);
+  refCounts = std::move(newRefCounts);
+  indices = std::move(newIndices);
+}
+
+auto Chunk::memoryUsage() const noexcept -> size_t {
+  return sizeof(Chunk) + palette.capacity() * sizeof(BlockId) +
+         refCounts.capacity() * sizeof(uint16_t) + indices.byteSize();
+}
+
+void Chunk::serialize(std::vector<std::byte> &out) const noexcept {
+  const SerialHeader header{
+      .paletteSize = static_cast<uint32_t>(palette.size()),
+      .bits = indices.bits(),
+      .reserved = {}};
+  append(out, &header, sizeof(header));
+  append(out, palette.data(), palette.size() * sizeof(BlockId));
+  append(out, refCounts.data(), refCounts.size() * sizeof(uint16_t));
+  append(out, indices.data().data(), indices.byteSize());
+}
+
+auto Chunk::deserialize(std::span<const std::byte> &in) noexcept
+    -> std::optional<Chunk> {
+  SerialHeader header;
+  if (in.size() < sizeof(header)) {
+    return std::nullopt;
+  }
+  std::memcpy(&header, in.data(), sizeof(header));
+
+  const auto bits = header.bits;
+  const bool validBits = bits == 0 || bits == 1 || bits == 2 || bits == 4 ||
+                         bits == 8 || bits == 16;
+  if (!validBits || header.paletteSize == 0 ||
+      header.paletteSize > std::max<size_t>(paletteCapacity(bits), 1) ||
+      (bits == 0 && header.paletteSize != 1)) {
+    return std::nullopt;
+  }
+
+  Chunk chunk;
+  chunk.indices = PackedArray(CHUNK_VOLUME, bits);
+  const auto paletteBytes = header.paletteSize * sizeof(BlockId);
+  const auto countBytes = header.paletteSize * sizeof(uint16_t);
+  const auto indexBytes = chunk.indices.byteSize();
+  const auto size = sizeof(header) + paletteBytes + countBytes + indexBytes;
+  if (in.size() < size) {
+    return std::nullopt;
+  }
+
+  const auto *at = in.data() + sizeof(header);
+  chunk.palette.resize(header.paletteSize);
+  std::memcpy(chunk.palette.data(), at, paletteBytes);
+  chunk.refCounts.resize(header.paletteSize);
+  std::memcpy(chunk.refCounts.data(), at + paletteBytes, countBytes);
+  std::memcpy(chunk.indices.data().data(), at + paletteBytes + countBytes,
+              indexBytes);
+  in = in.subspan(size);
+
+  uint32_t total = 0;
+  for (auto count : chunk.refCounts) {
+    total += count;
+  }
+  if (total != CHUNK_VOLUME) {
+    return std::nullopt;
+  }
+  if (bits == 0 || header.paletteSize == paletteCapacity(bits)) {
+    return chunk;
+  }
+
+  // Checks no index runs past the palette, every index of a word at once:
+  // spread the even and odd indices into lanes twice their width, add
+  // enough that any index past the palette carries into the lane's top
+  // half, and look for a carry.
+  uint64_t lanes = 0;
+  for (uint32_t i = 0; i < 64; i += 2 * bits) {
+    lanes |= ((uint64_t{1} << bits) - 1) << i;
+  }
+  const auto bias = (lanes / ((uint64_t{1} << bits) - 1)) *
+                    (paletteCapacity(bits) - header.paletteSize);
+  const auto carries = lanes << bits;
+  for (const auto word : chunk.indices.data()) {
+    const auto even = (word & lanes) + bias;
+    const auto odd = ((word >> bits) & lanes) + bias;
+    if (((even | odd) & carries) != 0) {
+      return std::nullopt;
+    }
+  }
+  return chunk;
+}
+
+} // namespace engine::voxel
@@ -0,0 +1,326 @@
+#include "engine/voxel/chunkMap.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+namespace engine::voxel {
+
+namespace {
+constexpr uint32_t MIN_BUCKETS = 16;
+} // namespace
+
+ChunkMap::ChunkMap(uint32_t expectedChunks) noexcept {
+  // Enough for the chunks in bricks a quarter full.
+  const auto expectedBricks = expectedChunks * 4 / BRICK_VOLUME;
+  rehash(std::max(MIN_BUCKETS, std::bit_ceil(expectedBricks * 2)));
+  slots.reserve(expectedChunks);
+  links.reserve(expectedChunks);
+  generations.reserve(expectedChunks);
+}
+
+auto ChunkMap::insert(glm::ivec3 position, Chunk chunk) noexcept
+    -> ChunkHandle {
+  const auto key = brickKey(position);
+  auto brick = findBrick(key);
+  if (brick != ChunkHandle::NONE) {
+    if (const auto existing = bricks[brick].slots[brickIndex(position)];
+        existing != ChunkHandle::NONE) {
+      slots[existing].chunk = std::move(chunk);
+      clearDirty(handleOf(existing));
+      return handleOf(existing);
+    }
+  } else {
+    brick = addBrick(key);
+  }
+
+  uint32_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+    auto &reused = slots[slot];
+    reused.chunk = std::move(chunk);
+    reused.position = position;
+    reused.dirty = false;
+    ++generations[slot];
+  } else {
+    slot = static_cast<uint32_t>(slots.size());
+    slots.push_back(
+        Slot{.chunk = std::move(chunk), .position = position, .dirty = false});
+    links.emplace_back();
+    generations.push_back(1);
+  }
+
+  auto &entry = bricks[brick];
+  entry.slots[brickIndex(position)] = slot;
+  ++entry.count;
+  ++liveCount;
+  link(slot);
+  return handleOf(slot);
+}
+
+auto ChunkMap::erase(glm::ivec3 position) noexcept -> bool {
+  return erase(find(position));
+}
+
+auto ChunkMap::erase(ChunkHandle handle) noexcept -> bool {
+  if (!contains(handle)) {
+    return false;
+  }
+
+  clearDirty(handle);
+  auto &slot = slots[handle.index];
+  unlink(handle.index);
+
+  const auto key = brickKey(slot.position);
+  const auto brick = findBrick(key);
+  auto &entry = bricks[brick];
+  entry.slots[brickIndex(slot.position)] = ChunkHandle::NONE;
+  if (--entry.count == 0) {
+    eraseBucket(key);
+    freeBricks.push_back(brick);
+    --brickLiveCount;
+  }
+
+  // Frees the chunk's storage now rather than when the slot is reused.
+  slot.chunk = Chunk();
+  ++generations[handle.index];
+  freeSlots.push_back(handle.index);
+  --liveCount;
+  return true;
+}
+
+void ChunkMap::clear() noexcept {
+  for (auto &bucket : buckets) {
+    bucket.brick = ChunkHandle::NONE;
+  }
+  bricks.clear();
+  freeBricks.clear();
+  brickLiveCount = 0;
+  for (uint32_t i = 0; i < slots.size(); ++i) {
+    if (isLive(generations[i])) {
+      slots[i].chunk = Chunk();
+      slots[i].dirty = false;
+      ++generations[i];
+      freeSlots.push_back(i);
+    }
+  }
+  liveCount = 0;
+  dirtyQueue.clear();
+  dirtyChunks = 0;
+}
+
+auto ChunkMap::get(ChunkHandle handle) noexcept -> Chunk * {
+  return contains(handle) ? &slots[handle.index].chunk : nullptr;
+}
+
+auto ChunkMap::get(ChunkHandle handle) const noexcept -> const Chunk * {
+  return contains(handle) ? &slots[handle.index].chunk : nullptr;
+}
+
+auto ChunkMap::getBlock(glm::ivec3 position) const noexcept -> BlockId {
+  const auto *chunk = get(find(chunkOf(position)));
+  if (chunk == nullptr) {
+    return AIR;
+  }
+  constexpr int32_t MASK = CHUNK_SIZE - 1;
+  return chunk->get(static_cast<uint32_t>(position.x & MASK),
+                    static_cast<uint32_t>(position.y & MASK),
+                    static_cast<uint32_t>(position.z & MASK));
+}
+
+auto ChunkMap::setBlock(glm::ivec3 position, BlockId block) noexcept -> bool {
+  const auto handle = find(chunkOf(position));
+  if (!handle.valid()) {
+    return false;
+  }
+  constexpr int32_t MASK = CHUNK_SIZE - 1;
+  slots[handle.index].chunk.set(static_cast<uint32_t>(position.x & MASK),
+                                static_cast<uint32_t>(position.y & MASK),
+                                static_cast<uint32_t>(position.z & MASK),
+                                block);
+  markDirty(handle);
+  return true;
+}
+
+void ChunkMap::markDirty(ChunkHandle handle) noexcept {
+  if (!contains(handle) || slots[handle.index].dirty) {
+    return;
+  }
+  slots[handle.index].dirty = true;
+  dirtyQueue.push_back(handle);
+  ++dirtyChunks;
+}
+
+void ChunkMap::clearDirty(ChunkHandle handle) noexcept {
+  if (!isDirty(handle)) {
+    return;
+  }
+  slots[handle.index].dirty = false;
+  --dirtyChunks;
+}
+
+void ChunkMap::takeDirtyColumns(uint32_t maxColumns,
+                                std::vector<glm::ivec2> &out) noexcept {
+  const auto first = out.size();
+  while (out.size() - first < maxColumns && !dirtyQueue.empty()) {
+    const auto handle = dirtyQueue.front();
+    dirtyQueue.pop_front();
+    if (!isDirty(handle)) {
+      continue;
+    }
+    clearDirty(handle);
+    const auto position = slots[handle.index].position;
+    const glm::ivec2 column(position.x, position.z);
+    // Few enough columns are taken at a time for a linear search.
+    if (std::find(out.begin() + static_cast<ptrdiff_t>(first), out.end(),
+                  column) == out.end()) {
+      out.push_back(column);
+    }
+  }
+}
+
+auto ChunkMap::neighbours(ChunkHandle handle) const noexcept
+    -> std::array<ChunkHandle, NEIGHBOURHOOD> {
+  const auto &around = links[handle.index];
+  std::array<ChunkHandle, NEIGHBOURHOOD> out;
+  for (uint32_t i = 0; i < NEIGHBOURHOOD; ++i) {
+    out[i] = handleOf(around[i]);
+  }
+  return out;
+}
+
+auto ChunkMap::faceNeighbours(ChunkHandle handle) const noexcept
+    -> ChunkNeighbours {
+  const auto &around = links[handle.index];
+  // Indexed by `Face`.
+  constexpr std::array<uint32_t, FACE_COUNT> FACE_LINKS = {
+      neighbourIndex(1, 0, 0),  neighbourIndex(-1, 0, 0),
+      neighbourIndex(0, 1, 0),  neighbourIndex(0, -1, 0),
+      neighbourIndex(0, 0, 1),  neighbourIndex(0, 0, -1)};
+
+  ChunkNeighbours out;
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    const auto slot = around[FACE_LINKS[face]];
+    out.chunks[face] =
+        slot == ChunkHandle::NONE ? nullptr : &slots[slot].chunk;
+  }
+  return out;
+}
+
+auto ChunkMap::addBrick(uint64_t key) noexcept -> uint32_t {
+  // At most half full.
+  if ((brickLiveCount + 1) * 2 > buckets.size()) {
+    rehash(static_cast<uint32_t>(buckets.size() * 2));
+  }
+
+  uint32_t brick;
+  if (!freeBricks.empty()) {
+    brick = freeBricks.back();
+    freeBricks.pop_back();
+  } else {
+    brick = static_cast<uint32_t>(bricks.size());
+    bricks.emplace_back();
+  }
+  bricks[brick].slots.fill(ChunkHandle::NONE);
+  bricks[brick].count = 0;
+  insertBucket(key, brick);
+  ++brickLiveCount;
+  return brick;
+}
+
+void ChunkMap::rehash(uint32_t bucketCount) noexcept {
+  constexpr Bucket EMPTY{.key = 0, .brick = ChunkHandle::NONE};
+  auto old = std::exchange(buckets, std::vector<Bucket>(bucketCount, EMPTY));
+  shift = 64 - static_cast<uint32_t>(std::countr_zero(bucketCount));
+
+  for (const auto &bucket : old) {
+    if (bucket.brick != ChunkHandle::NONE) {
+      insertBucket(bucket.key, bucket.brick);
+    }
+  }
+}
+
+void ChunkMap::insertBucket(uint64_t key, uint32_t brick) noexcept {
+  const auto mask = static_cast<uint32_t>(buckets.size() - 1);
+  auto i = home(key);
+  while (buckets[i].brick != ChunkHandle::NONE) {
+    i = (i + 1) & mask;
+  }
+  buckets[i] = Bucket{.key = key, .brick = brick};
+}
+
+void ChunkMap::eraseBucket(uint64_t key) noexcept {
+  const auto mask = static_cast<uint32_t>(buckets.size() - 1);
+  auto hole = home(key);
+  while (buckets[hole].key != key ||
+         buckets[hole].brick == ChunkHandle::NONE) {
+    hole = (hole + 1) & mask;
+  }
+
+  // Backward shift: pull later entries of the run into the hole unless that
+  // would move them before their home bucket.
+  for (auto i = (hole + 1) & mask; buckets[i].brick != ChunkHandle::NONE;
+       i = (i + 1) & mask) {
+    const auto wanted = home(buckets[i].key);
+    const auto distance = (i - wanted) & mask;
+    const auto toHole = (i - hole) & mask;
+    if (distance >= toHole) {
+      buckets[hole] = buckets[i];
+      hole = i;
+    }
+  }
+  buckets[hole].brick = ChunkHandle::NONE;
+}
+
+void ChunkMap::link(uint32_t slot) noexcept {
+  auto &around = links[slot];
+  const auto position = slots[slot].position;
+
+  for (int dz = -1; dz <= 1; ++dz) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dx = -1; dx <= 1; ++dx) {
+        const auto index = neighbourIndex(dx, dy, dz);
+        if (index == SELF) {
+          around[index] = slot;
+          continue;
+        }
+
+        const auto other = findSlot(position + glm::ivec3(dx, dy, dz));
+        around[index] = other;
+        if (other != ChunkHandle::NONE) {
+          links[other][NEIGHBOURHOOD - 1 - index] = slot;
+        }
+      }
+    }
+  }
+}
+
+void ChunkMap::unlink(uint32_t slot) noexcept {
+  const auto &around = links[slot];
+  for (uint32_t index = 0; index < NEIGHBOURHOOD; ++index) {
+    const auto other = around[index];
+    if (index != SELF && other != ChunkHandle::NONE) {
+      links[other][NEIGHBOURHOOD - 1 - index] = ChunkHandle::NONE;
+    }
+  }
+}
+
+void markBlock(glm::ivec3 position,
+               std::unordered_map<uint64_t, DirtySlices> &dirty) noexcept {
+  const auto chunk = ChunkMap::chunkOf(position);
+  const auto size = static_cast<int32_t>(CHUNK_SIZE);
+  const auto local = position - chunk * size;
+  dirty[ChunkMap::pack(chunk)].mark(local.x, local.y, local.z);
+  for (glm::length_t axis = 0; axis < 3; ++axis) {
+    if (local[axis] != 0 && local[axis] != size - 1) {
+      continue;
+    }
+    glm::ivec3 offset(0);
+    offset[axis] = local[axis] == 0 ? -1 : 1;
+    const auto beside = local - offset * size;
+    dirty[ChunkMap::pack(chunk + offset)].mark(beside.x, beside.y, beside.z);
+  }
+}
+
+} // namespace engine::voxel
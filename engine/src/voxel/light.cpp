@@ -0,0 +1,443 @@
+#include "engine/voxel/light.hpp"
+
+#include "engine/voxel/chunkMap.hpp"
+
+#include <algorithm>
+#include <climits>
+
+namespace engine::voxel {
+
+namespace {
+
+/// Where each channel sits in a voxel's light.
+constexpr uint32_t BLOCK = 0;
+constexpr uint32_t SKY = 4;
+
+constexpr std::array<glm::ivec3, 6> DIRECTIONS = {
+    glm::ivec3(1, 0, 0),  glm::ivec3(-1, 0, 0), glm::ivec3(0, 1, 0),
+    glm::ivec3(0, -1, 0), glm::ivec3(0, 0, 1),  glm::ivec3(0, 0, -1)};
+constexpr uint32_t DOWN = 3;
+
+constexpr std::array<glm::ivec2, 4> SIDES = {
+    glm::ivec2(-1, 0), glm::ivec2(1, 0), glm::ivec2(0, -1), glm::ivec2(0, 1)};
+
+[[nodiscard]] auto levelOf(uint8_t light, uint32_t shift) noexcept
+    -> uint8_t {
+  return (light >> shift) & 0xF;
+}
+
+[[nodiscard]] auto withLevel(uint8_t light, uint32_t shift,
+                             uint8_t level) noexcept -> uint8_t {
+  return static_cast<uint8_t>((light & ~(0xF << shift)) | (level << shift));
+}
+
+/// What a block lit to `level` passes on to its neighbour in `direction`.
+[[nodiscard]] auto passed(uint8_t level, uint32_t shift,
+                          uint32_t direction) noexcept -> uint8_t {
+  if (shift == SKY && direction == DOWN && level == MAX_LIGHT) {
+    return MAX_LIGHT;
+  }
+  return static_cast<uint8_t>(level - 1);
+}
+
+/// A column being lit on its own, blocks and light unpacked bottom up.
+class ColumnVolume {
+public:
+  using Cell = uint32_t;
+
+  ColumnVolume(std::span<const BlockId> blocks,
+               std::span<uint8_t> light) noexcept
+      : blocks(blocks), light(light) {}
+
+  auto at(glm::ivec3 position, Cell &cell) const noexcept -> bool {
+    if (static_cast<uint32_t>(position.x) >= CHUNK_SIZE ||
+        static_cast<uint32_t>(position.z) >= CHUNK_SIZE ||
+        static_cast<uint32_t>(position.y) >= COLUMN_HEIGHT) {
+      return false;
+    }
+    cell = (static_cast<uint32_t>(position.y) * CHUNK_SIZE +
+            static_cast<uint32_t>(position.z)) *
+               CHUNK_SIZE +
+           static_cast<uint32_t>(position.x);
+    return true;
+  }
+
+  [[nodiscard]] auto block(Cell cell) const noexcept -> BlockId {
+    return blocks[cell];
+  }
+  [[nodiscard]] auto getLight(Cell cell) const noexcept -> uint8_t {
+    return light[cell];
+  }
+  void setLight(Cell cell, glm::ivec3, uint8_t value) noexcept {
+    light[cell] = value;
+  }
+
+private:
+  std::span<const BlockId> blocks;
+  std::span<uint8_t> light;
+};
+
+/// The loaded world, where only lit chunks can be looked at. Remembers the
+/// last chunk looked up, as the blocks visited one after another are mostly
+/// in the same one.
+class WorldVolume {
+public:
+  struct Cell {
+    const Chunk *chunk;
+    ChunkLight *light;
+    uint32_t index;
+  };
+
+  WorldVolume(const ChunkMap &chunks,
+              std::unordered_map<uint64_t, ChunkLight> &lights,
+              std::vector<glm::ivec3> &changed) noexcept
+      : chunks(chunks), lights(lights), changed(changed) {}
+
+  auto at(glm::ivec3 position, Cell &cell) noexcept -> bool {
+    if (static_cast<uint32_t>(position.y) >= COLUMN_HEIGHT) {
+      return false;
+    }
+    const auto chunk = ChunkMap::chunkOf(position);
+    if (chunk != cached) {
+      cached = chunk;
+      const auto it = lights.find(ChunkMap::pack(chunk));
+      cachedLight = it == lights.end() ? nullptr : &it->second;
+      cachedChunk =
+          cachedLight == nullptr ? nullptr : chunks.get(chunks.find(chunk));
+    }
+    if (cachedChunk == nullptr) {
+      return false;
+    }
+    constexpr int32_t MASK = CHUNK_SIZE - 1;
+    cell = {.chunk = cachedChunk,
+            .light = cachedLight,
+            .index = Chunk::index(static_cast<uint32_t>(position.x & MASK),
+                                  static_cast<uint32_t>(position.y & MASK),
+                                  static_cast<uint32_t>(position.z & MASK))};
+    return true;
+  }
+
+  [[nodiscard]] auto block(const Cell &cell) const noexcept -> BlockId {
+    return cell.chunk->getIndex(cell.index);
+  }
+  [[nodiscard]] auto getLight(const Cell &cell) const noexcept -> uint8_t {
+    return cell.light->get(cell.index);
+  }
+  void setLight(const Cell &cell, glm::ivec3 position, uint8_t value) noexcept {
+    cell.light->set(cell.index, value);
+    changed.push_back(position);
+  }
+
+private:
+  const ChunkMap &chunks;
+  std::unordered_map<uint64_t, ChunkLight> &lights;
+  std::vector<glm::ivec3> &changed;
+  glm::ivec3 cached{INT_MIN};
+  const Chunk *cachedChunk = nullptr;
+  ChunkLight *cachedLight = nullptr;
+};
+
+[[nodiscard]] auto columnKey(glm::ivec2 column, uint32_t y) noexcept
+    -> uint64_t {
+  return ChunkMap::pack(
+      glm::ivec3(column.x, static_cast<int32_t>(y), column.y));
+}
+
+} // namespace
+
+auto emission(BlockId block) noexcept -> uint8_t {
+  return block == blocks::TORCH ? 14 : 0;
+}
+
+ChunkLight::ChunkLight(std::span<const uint8_t, CHUNK_VOLUME> light) noexcept
+    : fill(light.front()) {
+  if (std::ranges::all_of(light, [&](uint8_t l) { return l == fill; })) {
+    return;
+  }
+  values = PackedArray(CHUNK_VOLUME, 8);
+  auto words = values.data();
+  for (size_t w = 0; w < words.size(); ++w) {
+    uint64_t word = 0;
+    for (uint32_t b = 0; b < 8; ++b) {
+      word |= static_cast<uint64_t>(light[w * 8 + b]) << (b * 8);
+    }
+    words[w] = word;
+  }
+}
+
+void ChunkLight::set(uint32_t index, uint8_t value) noexcept {
+  if (isUniform()) {
+    if (value == fill) {
+      return;
+    }
+    values = PackedArray(CHUNK_VOLUME, 8);
+    std::ranges::fill(values.data(), fill * 0x0101010101010101ull);
+  }
+  values.set(index, value);
+}
+
+template <typename Volume>
+auto Lighting::spread(Volume &volume, uint32_t shift,
+                      std::vector<glm::ivec3> &queue) noexcept -> uint64_t {
+  typename Volume::Cell cell;
+  typename Volume::Cell next;
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const auto position = queue[head];
+    if (!volume.at(position, cell)) {
+      continue;
+    }
+    const auto level = levelOf(volume.getLight(cell), shift);
+    if (level <= 1) {
+      continue;
+    }
+    for (uint32_t d = 0; d < DIRECTIONS.size(); ++d) {
+      const auto to = position + DIRECTIONS[d];
+      if (!volume.at(to, next) || !isTransparent(volume.block(next))) {
+        continue;
+      }
+      const auto light = volume.getLight(next);
+      const auto lit = passed(level, shift, d);
+      if (levelOf(light, shift) < lit) {
+        volume.setLight(next, to, withLevel(light, shift, lit));
+        queue.push_back(to);
+      }
+    }
+  }
+  const auto visited = queue.size();
+  queue.clear();
+  return visited;
+}
+
+template <typename Volume>
+auto Lighting::unspread(Volume &volume, uint32_t shift,
+                        std::vector<Removal> &removals,
+                        std::vector<glm::ivec3> &queue) noexcept -> uint64_t {
+  typename Volume::Cell next;
+  for (size_t head = 0; head < removals.size(); ++head) {
+    const auto [position, removed] = removals[head];
+    for (uint32_t d = 0; d < DIRECTIONS.size(); ++d) {
+      const auto to = position + DIRECTIONS[d];
+      if (!volume.at(to, next)) {
+        continue;
+      }
+      const auto light = volume.getLight(next);
+      const auto level = levelOf(light, shift);
+      if (level == 0) {
+        continue;
+      }
+      // No brighter than what the removed block passed on, so it may have
+      // come from there. Anything brighter came from elsewhere and spreads
+      // back into the dark.
+      if (isTransparent(volume.block(next)) &&
+          level <= passed(removed, shift, d)) {
+        volume.setLight(next, to, withLevel(light, shift, 0));
+        removals.push_back({.position = to, .level = level});
+      } else {
+        queue.push_back(to);
+      }
+    }
+  }
+  const auto visited = removals.size();
+  removals.clear();
+  return visited;
+}
+
+auto Lighting::lightColumn(
+    std::span<const Chunk, COLUMN_CHUNKS> chunks) noexcept -> ColumnLight {
+  constexpr size_t VOLUME = static_cast<size_t>(COLUMN_HEIGHT) * CHUNK_AREA;
+  thread_local std::vector<BlockId> blocks;
+  thread_local std::vector<uint8_t> light;
+  thread_local std::vector<glm::ivec3> queue;
+
+  blocks.resize(VOLUME);
+  light.assign(VOLUME, 0);
+  for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+    chunks[i].unpack(std::span<BlockId, CHUNK_VOLUME>(
+        blocks.data() + static_cast<size_t>(i) * CHUNK_VOLUME, CHUNK_VOLUME));
+  }
+  ColumnVolume volume(blocks, light);
+  ColumnVolume::Cell cell = 0;
+
+  // Full sky light straight down to the first block that stops it.
+  std::array<int32_t, CHUNK_AREA> heights;
+  for (int32_t z = 0; z < static_cast<int32_t>(CHUNK_SIZE); ++z) {
+    for (int32_t x = 0; x < static_cast<int32_t>(CHUNK_SIZE); ++x) {
+      auto y = static_cast<int32_t>(COLUMN_HEIGHT);
+      while (volume.at(glm::ivec3(x, y - 1, z), cell) &&
+             isTransparent(volume.block(cell))) {
+        volume.setLight(cell, {}, SKY_LIT);
+        --y;
+      }
+      heights[z * CHUNK_SIZE + x] = y;
+    }
+  }
+
+  // From there it only spreads sideways, into the air beside the sky under
+  // overhangs and down cliffs.
+  for (int32_t z = 0; z < static_cast<int32_t>(CHUNK_SIZE); ++z) {
+    for (int32_t x = 0; x < static_cast<int32_t>(CHUNK_SIZE); ++x) {
+      const auto height = heights[z * CHUNK_SIZE + x];
+      for (const auto side : SIDES) {
+        const auto nx = x + side.x;
+        const auto nz = z + side.y;
+        if (static_cast<uint32_t>(nx) >= CHUNK_SIZE ||
+            static_cast<uint32_t>(nz) >= CHUNK_SIZE) {
+          continue;
+        }
+        for (auto y = height; y < heights[nz * CHUNK_SIZE + nx]; ++y) {
+          queue.emplace_back(x, y, z);
+        }
+      }
+    }
+  }
+  spread(volume, SKY, queue);
+
+  for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+    const auto palette = chunks[i].getPalette();
+    if (std::ranges::none_of(palette,
+                             [](BlockId block) { return emission(block); })) {
+      continue;
+    }
+    const auto first = i * CHUNK_VOLUME;
+    for (auto c = first; c < first + CHUNK_VOLUME; ++c) {
+      if (const auto level = emission(blocks[c]); level != 0) {
+        light[c] = withLevel(light[c], BLOCK, level);
+        const auto xz = c % CHUNK_AREA;
+        queue.emplace_back(xz % CHUNK_SIZE, c / CHUNK_AREA, xz / CHUNK_SIZE);
+      }
+    }
+  }
+  spread(volume, BLOCK, queue);
+
+  ColumnLight column;
+  for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+    column[i] = ChunkLight(std::span<const uint8_t, CHUNK_VOLUME>(
+        light.data() + static_cast<size_t>(i) * CHUNK_VOLUME, CHUNK_VOLUME));
+  }
+  return column;
+}
+
+void Lighting::insertColumn(const ChunkMap &chunks, glm::ivec2 column,
+                            ColumnLight light) noexcept {
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    lights.insert_or_assign(columnKey(column, y), std::move(light[y]));
+  }
+
+  // Light only needs to cross a border where the blocks either side of it
+  // differ by more than a level, from the brighter one.
+  constexpr auto last = CHUNK_SIZE - 1;
+  const auto origin = glm::ivec3(column.x, 0, column.y) *
+                      static_cast<int32_t>(CHUNK_SIZE);
+  WorldVolume volume(chunks, lights, changed);
+  lastVisited = 0;
+  for (const auto shift : {BLOCK, SKY}) {
+    for (const auto side : SIDES) {
+      for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+        const auto it = lights.find(columnKey(column + side, y));
+        if (it == lights.end()) {
+          continue;
+        }
+        const auto &own = lights.at(columnKey(column, y));
+        const auto &other = it->second;
+        for (uint32_t v = 0; v < CHUNK_SIZE; ++v) {
+          for (uint32_t u = 0; u < CHUNK_SIZE; ++u) {
+            // `u` runs along the border, `v` up it.
+            const auto x = side.x < 0 ? 0 : side.x > 0 ? last : u;
+            const auto z = side.y < 0 ? 0 : side.y > 0 ? last : u;
+            const auto otherX = side.x != 0 ? last - x : x;
+            const auto otherZ = side.y != 0 ? last - z : z;
+            const auto a = levelOf(own.get(Chunk::index(x, v, z)), shift);
+            const auto b =
+                levelOf(other.get(Chunk::index(otherX, v, otherZ)), shift);
+            const glm::ivec3 at(static_cast<int32_t>(x),
+                                static_cast<int32_t>(y * CHUNK_SIZE + v),
+                                static_cast<int32_t>(z));
+            if (a > b + 1) {
+              spreads.push_back(origin + at);
+            } else if (b > a + 1) {
+              spreads.push_back(origin + at +
+                                glm::ivec3(side.x, 0, side.y));
+            }
+          }
+        }
+      }
+    }
+    lastVisited += spread(volume, shift, spreads);
+  }
+}
+
+void Lighting::eraseColumn(glm::ivec2 column) noexcept {
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    lights.erase(columnKey(column, y));
+  }
+}
+
+void Lighting::blockChanged(const ChunkMap &chunks,
+                            glm::ivec3 position) noexcept {
+  WorldVolume volume(chunks, lights, changed);
+  WorldVolume::Cell cell{};
+  lastVisited = 0;
+  if (!volume.at(position, cell)) {
+    return;
+  }
+  const auto block = volume.block(cell);
+  for (const auto shift : {BLOCK, SKY}) {
+    // The block's own light goes, and with it all it passed on.
+    if (const auto old = levelOf(volume.getLight(cell), shift); old != 0) {
+      volume.setLight(cell, position,
+                      withLevel(volume.getLight(cell), shift, 0));
+      removals.push_back({.position = position, .level = old});
+      lastVisited += unspread(volume, shift, removals, spreads);
+    }
+
+    if (shift == BLOCK && emission(block) != 0) {
+      volume.setLight(cell, position,
+                      withLevel(volume.getLight(cell), shift, emission(block)));
+      spreads.push_back(position);
+    }
+    if (isTransparent(block)) {
+      if (shift == SKY &&
+          position.y == static_cast<int32_t>(COLUMN_HEIGHT) - 1) {
+        volume.setLight(cell, position,
+                        withLevel(volume.getLight(cell), shift, MAX_LIGHT));
+        spreads.push_back(position);
+      }
+      // Those dark or not lit just get skipped.
+      for (const auto direction : DIRECTIONS) {
+        spreads.push_back(position + direction);
+      }
+    }
+    lastVisited += spread(volume, shift, spreads);
+  }
+}
+
+auto Lighting::get(glm::ivec3 chunk) const noexcept -> const ChunkLight * {
+  const auto it = lights.find(ChunkMap::pack(chunk));
+  return it == lights.end() ? nullptr : &it->second;
+}
+
+auto Lighting::getLight(glm::ivec3 position) const noexcept -> uint8_t {
+  const auto *light = get(ChunkMap::chunkOf(position));
+  if (light == nullptr) {
+    return SKY_LIT;
+  }
+  constexpr int32_t MASK = CHUNK_SIZE - 1;
+  return light->get(Chunk::index(static_cast<uint32_t>(position.x & MASK),
+                                 static_cast<uint32_t>(position.y & MASK),
+                                 static_cast<uint32_t>(position.z & MASK)));
+}
+
+void Lighting::takeChanged(std::vector<glm::ivec3> &out) noexcept {
+  out.insert(out.end(), changed.begin(), changed.end());
+  changed.clear();
+}
+
+auto Lighting::memoryUsage() const noexcept -> size_t {
+  size_t bytes = sizeof(*this);
+  for (const auto &[key, light] : lights) {
+    bytes += sizeof(key) + light.memoryUsage();
+  }
+  return bytes;
+}
+
+} // namespace engine::voxel
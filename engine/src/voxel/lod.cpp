@@ -0,0 +1,221 @@
+#include "engine/voxel/lod.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace engine::voxel {
+
+void downsample(std::span<const BlockId> in, glm::uvec3 size,
+                std::span<BlockId> out) noexcept {
+  const auto half = size / 2u;
+  auto at = [&](uint32_t x, uint32_t y, uint32_t z) {
+    return in[(y * size.z + z) * size.x + x];
+  };
+
+  for (uint32_t y = 0; y < half.y; ++y) {
+    for (uint32_t z = 0; z < half.z; ++z) {
+      for (uint32_t x = 0; x < half.x; ++x) {
+        uint32_t solid = 0;
+        BlockId top = AIR;
+        // Bottom layer first, so the top one's blocks win.
+        for (uint32_t dy = 0; dy < 2; ++dy) {
+          for (uint32_t dz = 0; dz < 2; ++dz) {
+            for (uint32_t dx = 0; dx < 2; ++dx) {
+              const auto block = at(x * 2 + dx, y * 2 + dy, z * 2 + dz);
+              if (block != AIR) {
+                ++solid;
+                top = block;
+              }
+            }
+          }
+        }
+        out[(y * half.z + z) * half.x + x] = solid >= 4 ? top : AIR;
+      }
+    }
+  }
+}
+
+ColumnSummary::ColumnSummary(
+    std::span<const Chunk, COLUMN_CHUNKS> chunks) noexcept {
+  constexpr uint32_t HALF = CHUNK_SIZE / 2;
+  constexpr uint32_t CHUNK_LAYERS = CHUNK_SIZE >> LEVEL;
+  static_assert(LEVEL == 2, "summaries halve each chunk twice");
+
+  std::vector<BlockId> summary(static_cast<size_t>(HEIGHT) * SIZE * SIZE, AIR);
+  std::array<BlockId, CHUNK_VOLUME> blocks;
+  std::array<BlockId, HALF * HALF * HALF> halved;
+  for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+    const auto &chunk = chunks[i];
+    auto *layer = summary.data() + static_cast<size_t>(i) * CHUNK_LAYERS *
+                                       SIZE * SIZE;
+    if (chunk.isUniform()) {
+      std::fill_n(layer, CHUNK_LAYERS * SIZE * SIZE, chunk.getPalette()[0]);
+      continue;
+    }
+    chunk.unpack(blocks);
+    downsample(blocks, glm::uvec3(CHUNK_SIZE), halved);
+    downsample(halved, glm::uvec3(HALF),
+               std::span(layer, CHUNK_LAYERS * SIZE * SIZE));
+  }
+
+  layers = HEIGHT;
+  while (layers > 0 &&
+         std::all_of(summary.begin() + (layers - 1) * SIZE * SIZE,
+                     summary.begin() + layers * SIZE * SIZE,
+                     [](BlockId block) { return block == AIR; })) {
+    --layers;
+  }
+  summary.resize(static_cast<size_t>(layers) * SIZE * SIZE);
+  summary.shrink_to_fit();
+  cells = std::move(summary);
+}
+
+namespace {
+
+/// Halves the cube of blocks in `grid` `times` times, using `scratch`.
+void halve(std::vector<BlockId> &grid, uint32_t size, uint32_t times,
+           std::vector<BlockId> &scratch) noexcept {
+  for (uint32_t i = 0; i < times; ++i, size /= 2) {
+    const auto half = size / 2;
+    scratch.resize(static_cast<size_t>(half) * half * half);
+    downsample(grid, glm::uvec3(size), scratch);
+    grid.swap(scratch);
+  }
+}
+
+auto packed(std::span<const BlockId> grid) noexcept -> Chunk {
+  Chunk chunk;
+  chunk.pack(std::span<const BlockId, CHUNK_VOLUME>(grid.data(), CHUNK_VOLUME));
+  return chunk;
+}
+
+} // namespace
+
+auto coarseNode(std::span<const std::array<Chunk, COLUMN_CHUNKS>, 4> columns,
+                uint32_t index) noexcept -> Chunk {
+  constexpr uint32_t SIZE = CHUNK_SIZE * 2;
+  thread_local std::vector<BlockId> grid;
+  thread_local std::vector<BlockId> scratch;
+  thread_local std::array<BlockId, CHUNK_VOLUME> blocks;
+
+  // The 2 x 2 x 2 chunks under the node, halved once.
+  grid.resize(static_cast<size_t>(SIZE) * SIZE * SIZE);
+  for (uint32_t c = 0; c < 8; ++c) {
+    const auto cx = c & 1;
+    const auto cy = (c >> 1) & 1;
+    const auto cz = c >> 2;
+    const auto &chunk = columns[cz * 2 + cx][index * 2 + cy];
+    const bool uniform = chunk.isUniform();
+    if (!uniform) {
+      chunk.unpack(blocks);
+    }
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+      for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+        auto *row = grid.data() +
+                    ((cy * CHUNK_SIZE + y) * SIZE + cz * CHUNK_SIZE + z) *
+                        SIZE +
+                    cx * CHUNK_SIZE;
+        if (uniform) {
+          std::fill_n(row, CHUNK_SIZE, chunk.getPalette().front());
+        } else {
+          std::copy_n(blocks.data() + Chunk::index(0, y, z), CHUNK_SIZE, row);
+        }
+      }
+    }
+  }
+  halve(grid, SIZE, 1, scratch);
+  return packed(grid);
+}
+
+auto coarseNode(std::span<const ColumnSummary *const> summaries,
+                uint32_t level, uint32_t index) noexcept -> Chunk {
+  constexpr uint32_t CELLS = ColumnSummary::SIZE;
+  thread_local std::vector<BlockId> grid;
+  thread_local std::vector<BlockId> scratch;
+
+  // The summaries' cells under the node, halved down to `level`.
+  const auto size = CHUNK_SIZE << (level - ColumnSummary::LEVEL);
+  const auto columnsPerSide = 1u << level;
+  grid.resize(static_cast<size_t>(size) * size * size);
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t z = 0; z < size; ++z) {
+      for (uint32_t x = 0; x < size; ++x) {
+        const auto &summary =
+            *summaries[(z / CELLS) * columnsPerSide + x / CELLS];
+        grid[(y * size + z) * size + x] =
+            summary.get(x % CELLS, index * size + y, z % CELLS);
+      }
+    }
+  }
+  halve(grid, size, level - ColumnSummary::LEVEL, scratch);
+  return packed(grid);
+}
+
+LodTree::LodTree(const Settings &settings) noexcept : settings(settings) {}
+
+auto LodTree::distance(const glm::vec3 &eye, const LodTile &tile) noexcept
+    -> float {
+  const auto size = static_cast<float>(CHUNK_SIZE);
+  const auto centre = (glm::vec2(tile.firstColumn()) +
+                       static_cast<float>(tile.size()) * 0.5f) *
+                      size;
+  return glm::length(centre - glm::vec2(eye.x, eye.z)) / size;
+}
+
+void LodTree::update(const glm::vec3 &eye) noexcept {
+  selected.clear();
+  std::unordered_set<uint64_t> nextSplit;
+  std::unordered_set<uint64_t> nextRoots;
+
+  const auto reach = this->reach();
+  const auto level = settings.levels;
+  const auto centre = LodTile::of(TerrainGenerator::columnAt(eye), level);
+  const auto span = static_cast<int32_t>(
+                        std::ceil(reach * (1.0f + settings.hysteresis))) /
+                        rootSize() +
+                    1;
+  for (int32_t dz = -span; dz <= span; ++dz) {
+    for (int32_t dx = -span; dx <= span; ++dx) {
+      const LodTile root{.position = centre.position + glm::ivec2(dx, dz),
+                         .level = level};
+      const auto d = distance(eye, root);
+      const bool shown =
+          d < reach || (roots.contains(root.key()) &&
+                        d < reach * (1.0f + settings.hysteresis));
+      if (shown) {
+        nextRoots.insert(root.key());
+        select(eye, root, nextSplit);
+      }
+    }
+  }
+
+  split = std::move(nextSplit);
+  roots = std::move(nextRoots);
+}
+
+void LodTree::select(const glm::vec3 &eye, const LodTile &tile,
+                     std::unordered_set<uint64_t> &nextSplit) noexcept {
+  if (tile.level == 0) {
+    selected.push_back(tile);
+    return;
+  }
+
+  const auto d = distance(eye, tile);
+  const auto threshold = static_cast<float>(settings.distance
+                                            << (tile.level - 1));
+  const bool splits =
+      d < threshold || (split.contains(tile.key()) &&
+                        d < threshold * (1.0f + settings.hysteresis));
+  if (!splits) {
+    selected.push_back(tile);
+    return;
+  }
+
+  nextSplit.insert(tile.key());
+  for (uint32_t i = 0; i < 4; ++i) {
+    select(eye, tile.child(i), nextSplit);
+  }
+}
+
+} // namespace engine::voxel
@@ -0,0 +1,425 @@
+#include "engine/voxel/mesher.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace engine::voxel {
+
+namespace {
+constexpr uint32_t LAST = CHUNK_SIZE - 1;
+constexpr uint32_t ALL_LAYERS = ~0u;
+static_assert(CHUNK_SIZE == 32, "a face's layers are one bit each in a u32");
+} // namespace
+
+auto faceCounts(const SliceCounts &slices) noexcept -> FaceCounts {
+  FaceCounts counts{};
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    for (const auto count : slices[face]) {
+      counts[face] += count;
+    }
+  }
+  return counts;
+}
+
+auto DirtySlices::all() noexcept -> DirtySlices {
+  DirtySlices dirty;
+  dirty.layers.fill(ALL_LAYERS);
+  return dirty;
+}
+
+void DirtySlices::mark(int32_t x, int32_t y, int32_t z) noexcept {
+  const std::array<int32_t, 3> position{x, y, z};
+  const auto bit = [](int32_t depth) {
+    return depth >= 0 && depth < static_cast<int32_t>(CHUNK_SIZE)
+               ? 1u << depth
+               : 0u;
+  };
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    const auto depth = position[faceAxis(static_cast<Face>(face))];
+    // The block's own slice, and the one whose front layer it is in.
+    const auto behind = isPositive(static_cast<Face>(face)) ? depth - 1
+                                                             : depth + 1;
+    layers[face] |= bit(depth) | bit(behind);
+  }
+}
+
+void sliceRuns(const SliceCounts &before, const SliceCounts &after,
+               const DirtySlices &dirty, std::vector<SliceRun> &out) noexcept {
+  const auto first = out.size();
+  uint32_t source = 0;
+  uint32_t remeshed = 0;
+  uint32_t target = 0;
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    for (uint32_t depth = 0; depth < CHUNK_SIZE; ++depth) {
+      const bool fresh = ((dirty.layers[face] >> depth) & 1) != 0;
+      const uint32_t count = fresh ? after[face][depth] : before[face][depth];
+      const auto from = fresh ? remeshed : source;
+      if (count != 0) {
+        if (out.size() > first && out.back().remeshed == fresh &&
+            out.back().source + out.back().count == from) {
+          out.back().count += count;
+        } else {
+          out.push_back(SliceRun{.remeshed = fresh,
+                                 .source = from,
+                                 .target = target,
+                                 .count = count});
+        }
+      }
+      source += before[face][depth];
+      remeshed += fresh ? count : 0;
+      target += count;
+    }
+  }
+}
+
+Mesher::Mesher() noexcept
+    : blocks(std::make_unique<std::array<BlockId, PADDED_VOLUME>>()),
+      unpacked(std::make_unique<std::array<BlockId, CHUNK_VOLUME>>()),
+      columns() {}
+
+auto Mesher::mesh(const Chunk &chunk, const ChunkNeighbours &neighbours,
+                  std::vector<Quad> &out, SliceCounts *slices) noexcept
+    -> FaceCounts {
+  SliceCounts counts{};
+  if (chunk.isUniform() && chunk.getPalette().front() == AIR) {
+    if (slices != nullptr) {
+      *slices = counts;
+    }
+    return {};
+  }
+  remesh(chunk, neighbours, DirtySlices::all(), out, counts);
+  if (slices != nullptr) {
+    *slices = counts;
+  }
+  return faceCounts(counts);
+}
+
+void Mesher::remesh(const Chunk &chunk, const ChunkNeighbours &neighbours,
+                    const DirtySlices &dirty, std::vector<Quad> &out,
+                    SliceCounts &slices) noexcept {
+  if (chunk.isUniform() && chunk.getPalette().front() == AIR) {
+    for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+      for (uint32_t depth = 0; depth < CHUNK_SIZE; ++depth) {
+        if (((dirty.layers[face] >> depth) & 1) != 0) {
+          slices[face][depth] = 0;
+        }
+      }
+    }
+    return;
+  }
+
+  // Each slice reads its own layer and the one in front of it, in padded
+  // layers one further along.
+  std::array<uint64_t, 3> needed{};
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    const auto layers = static_cast<uint64_t>(dirty.layers[face]);
+    needed[faceAxis(static_cast<Face>(face))] |=
+        isPositive(static_cast<Face>(face)) ? (layers << 1) | (layers << 2)
+                                            : layers | (layers << 1);
+  }
+
+  gather(chunk, neighbours);
+  // Building every column costs about as much as building a padded chunk's
+  // worth of layers one at a time.
+  const auto layerCount = std::popcount(needed[0]) + std::popcount(needed[1]) +
+                          std::popcount(needed[2]);
+  if (layerCount > static_cast<int>(PADDED_SIZE)) {
+    buildColumns();
+  } else {
+    buildLayers(needed);
+  }
+
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    if (dirty.layers[face] != 0) {
+      meshFace(static_cast<Face>(face), dirty.layers[face], neighbours, out,
+               slices[face]);
+    }
+  }
+}
+
+void Mesher::gather(const Chunk &chunk,
+                    const ChunkNeighbours &neighbours) noexcept {
+  auto &padded = *blocks;
+  padded.fill(AIR);
+
+  chunk.unpack(*unpacked);
+  const auto &inner = *unpacked;
+  for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      const auto src = Chunk::index(0, y, z);
+      const auto dst = paddedIndex(1, y + 1, z + 1);
+      std::copy_n(inner.begin() + src, CHUNK_SIZE, padded.begin() + dst);
+    }
+  }
+
+  // Only the layer touching this chunk is needed from each neighbour.
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    const auto *neighbour = neighbours.chunks[face];
+    if (neighbour == nullptr) {
+      continue;
+    }
+
+    const auto axis = faceAxis(static_cast<Face>(face));
+    const bool positive = isPositive(static_cast<Face>(face));
+    const uint32_t srcLayer = positive ? 0 : LAST;
+    const uint32_t dstLayer = positive ? PADDED_SIZE - 1 : 0;
+
+    for (uint32_t a = 0; a < CHUNK_SIZE; ++a) {
+      for (uint32_t b = 0; b < CHUNK_SIZE; ++b) {
+        std::array<uint32_t, 3> src{};
+        std::array<uint32_t, 3> dst{};
+        src[axis] = srcLayer;
+        dst[axis] = dstLayer;
+        src[(axis + 1) % 3] = a;
+        dst[(axis + 1) % 3] = a + 1;
+        src[(axis + 2) % 3] = b;
+        dst[(axis + 2) % 3] = b + 1;
+        padded[paddedIndex(dst[0], dst[1], dst[2])] =
+            neighbour->get(src[0], src[1], src[2]);
+      }
+    }
+  }
+}
+
+void Mesher::buildColumns() noexcept {
+  const auto &padded = *blocks;
+  auto &xCols = columns[0];
+  auto &yCols = columns[1];
+  auto &zCols = columns[2];
+
+  for (auto &axis : columns) {
+    for (auto &row : axis) {
+      row.fill(0);
+    }
+  }
+
+  // Every loop keeps x innermost so the padded blocks are read in order and
+  // the y/z column updates vectorise. Axis Z columns are stored transposed,
+  // indexed (y, x), see `column`.
+  for (uint32_t y = 0; y < PADDED_SIZE; ++y) {
+    const bool yInner = y - 1 < CHUNK_SIZE;
+    for (uint32_t z = 0; z < PADDED_SIZE; ++z) {
+      const bool zInner = z - 1 < CHUNK_SIZE;
+      const auto *row = &padded[paddedIndex(0, y, z)];
+
+      if (yInner && zInner) {
+        uint64_t column = 0;
+        for (uint32_t x = 0; x < PADDED_SIZE; ++x) {
+          column |= static_cast<uint64_t>(row[x] != AIR) << x;
+        }
+        xCols[y - 1][z - 1] = column;
+      }
+
+      if (zInner) {
+        auto &cols = yCols[z - 1];
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+          cols[x] |= static_cast<uint64_t>(row[x + 1] != AIR) << y;
+        }
+      }
+
+      if (yInner) {
+        auto &cols = zCols[y - 1];
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+          cols[x] |= static_cast<uint64_t>(row[x + 1] != AIR) << z;
+        }
+      }
+    }
+  }
+}
+
+void Mesher::buildLayers(const std::array<uint64_t, 3> &layers) noexcept {
+  const auto &padded = *blocks;
+  auto &xCols = columns[0];
+  auto &yCols = columns[1];
+  auto &zCols = columns[2];
+
+  for (auto &axis : columns) {
+    for (auto &row : axis) {
+      row.fill(0);
+    }
+  }
+
+  if (layers[0] != 0) {
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+      for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+        const auto *row = &padded[paddedIndex(0, y + 1, z + 1)];
+        uint64_t column = 0;
+        for (auto bits = layers[0]; bits != 0; bits &= bits - 1) {
+          const auto x = std::countr_zero(bits);
+          column |= static_cast<uint64_t>(row[x] != AIR) << x;
+        }
+        xCols[y][z] = column;
+      }
+    }
+  }
+
+  for (auto bits = layers[1]; bits != 0; bits &= bits - 1) {
+    const auto y = static_cast<uint32_t>(std::countr_zero(bits));
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      const auto *row = &padded[paddedIndex(1, y, z + 1)];
+      auto &cols = yCols[z];
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        cols[x] |= static_cast<uint64_t>(row[x] != AIR) << y;
+      }
+    }
+  }
+
+  for (auto bits = layers[2]; bits != 0; bits &= bits - 1) {
+    const auto z = static_cast<uint32_t>(std::countr_zero(bits));
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+      const auto *row = &padded[paddedIndex(1, y + 1, z)];
+      auto &cols = zCols[y];
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        cols[x] |= static_cast<uint64_t>(row[x] != AIR) << z;
+      }
+    }
+  }
+}
+
+auto Mesher::planeFor(uint32_t depth, BlockId block, uint8_t ao,
+                      uint8_t light) noexcept -> Plane & {
+  auto &indices = planesAtDepth[depth];
+  for (auto index : indices) {
+    const auto &plane = planes[index];
+    if (plane.block == block && plane.ao == ao && plane.light == light) {
+      return planes[index];
+    }
+  }
+
+  indices.push_back(static_cast<uint32_t>(planes.size()));
+  return planes.emplace_back(Plane{.block = block,
+                                   .ao = ao,
+                                   .light = light,
+                                   .depth = static_cast<uint8_t>(depth),
+                                   .rows = {}});
+}
+
+auto Mesher::occlusion(std::array<uint32_t, 3> front, uint32_t uAxis,
+                       uint32_t vAxis) const noexcept -> uint8_t {
+  const auto &padded = *blocks;
+  auto solid = [&](int du, int dv) {
+    auto p = front;
+    p[uAxis] = static_cast<uint32_t>(static_cast<int>(p[uAxis]) + du);
+    p[vAxis] = static_cast<uint32_t>(static_cast<int>(p[vAxis]) + dv);
+    return padded[paddedIndex(p[0], p[1], p[2])] != AIR;
+  };
+
+  const bool uMin = solid(-1, 0);
+  const bool uMax = solid(1, 0);
+  const bool vMin = solid(0, -1);
+  const bool vMax = solid(0, 1);
+
+  uint8_t ao = 0;
+  ao |= (uMin || vMin || solid(-1, -1)) ? 1 : 0;
+  ao |= (uMax || vMin || solid(1, -1)) ? 2 : 0;
+  ao |= (uMax || vMax || solid(1, 1)) ? 4 : 0;
+  ao |= (uMin || vMax || solid(-1, 1)) ? 8 : 0;
+  return ao;
+}
+
+void Mesher::meshFace(Face face, uint32_t layers,
+                      const ChunkNeighbours &neighbours,
+                      std::vector<Quad> &out,
+                      std::array<uint16_t, CHUNK_SIZE> &slices) noexcept {
+  const auto axis = faceAxis(face);
+  const auto uAxis = (axis + 1) % 3;
+  const auto vAxis = (axis + 2) % 3;
+  const bool positive = isPositive(face);
+  const auto &padded = *blocks;
+  const auto *beyond = neighbours.lights[static_cast<uint32_t>(face)];
+  // Light of the voxel in front of a face, at `front` in padded voxels. Only
+  // the outermost slice's is in the neighbour.
+  const auto lightAt = [&](std::array<uint32_t, 3> front) -> uint8_t {
+    const ChunkLight *light = neighbours.light;
+    if (front[axis] == 0 || front[axis] == PADDED_SIZE - 1) {
+      light = beyond;
+      front[axis] = front[axis] == 0 ? CHUNK_SIZE : 1;
+    }
+    return light == nullptr ? SKY_LIT
+                            : light->get(Chunk::index(
+                                  front[0] - 1, front[1] - 1, front[2] - 1));
+  };
+
+  planes.clear();
+  for (auto &depth : planesAtDepth) {
+    depth.clear();
+  }
+
+  for (uint32_t u = 0; u < CHUNK_SIZE; ++u) {
+    for (uint32_t v = 0; v < CHUNK_SIZE; ++v) {
+      const auto column = axis == 2 ? columns[axis][v][u] : columns[axis][u][v];
+      // A face is visible where a solid voxel has air after it (positive)
+      // or before it (negative). Dropping the padding bits leaves one bit
+      // per voxel of this chunk.
+      const auto visible =
+          positive ? column & ~(column >> 1) : column & ~(column << 1);
+      auto bits = static_cast<uint32_t>(visible >> 1) & layers;
+
+      while (bits != 0) {
+        const auto depth = static_cast<uint32_t>(std::countr_zero(bits));
+        bits &= bits - 1;
+
+        std::array<uint32_t, 3> p{};
+        p[axis] = depth + 1;
+        p[uAxis] = u + 1;
+        p[vAxis] = v + 1;
+        const auto block = padded[paddedIndex(p[0], p[1], p[2])];
+
+        p[axis] = positive ? depth + 2 : depth;
+        const auto ao = occlusion(p, uAxis, vAxis);
+
+        planeFor(depth, block, ao, lightAt(p)).rows[u] |= 1u << v;
+      }
+    }
+  }
+
+  for (auto remaining = layers; remaining != 0; remaining &= remaining - 1) {
+    const auto depth = static_cast<uint32_t>(std::countr_zero(remaining));
+    const auto before = out.size();
+    for (const auto index : planesAtDepth[depth]) {
+      mergePlane(planes[index], face, out);
+    }
+    slices[depth] = static_cast<uint16_t>(out.size() - before);
+  }
+}
+
+void Mesher::mergePlane(Plane &plane, Face face,
+                        std::vector<Quad> &out) noexcept {
+  const auto axis = faceAxis(face);
+  const auto uAxis = (axis + 1) % 3;
+  const auto vAxis = (axis + 2) % 3;
+  auto &rows = plane.rows;
+  // Corner bits are (0,0), (w,0), (w,h), (0,h).
+  const auto ao = plane.ao;
+  const bool mergeV = ((ao >> 0) & 1) == ((ao >> 3) & 1) &&
+                      ((ao >> 1) & 1) == ((ao >> 2) & 1);
+  const bool mergeU = ((ao >> 0) & 1) == ((ao >> 1) & 1) &&
+                      ((ao >> 3) & 1) == ((ao >> 2) & 1);
+
+  for (uint32_t u = 0; u < CHUNK_SIZE; ++u) {
+    while (rows[u] != 0) {
+      const auto v = static_cast<uint32_t>(std::countr_zero(rows[u]));
+      const auto height =
+          mergeV ? static_cast<uint32_t>(std::countr_one(rows[u] >> v)) : 1;
+      const uint32_t mask = (height == 32 ? ~0u : ((1u << height) - 1)) << v;
+
+      rows[u] &= ~mask;
+      uint32_t width = 1;
+      while (mergeU && u + width < CHUNK_SIZE &&
+             (rows[u + width] & mask) == mask) {
+        rows[u + width] &= ~mask;
+        ++width;
+      }
+
+      std::array<uint8_t, 3> position{};
+      position[axis] = plane.depth;
+      position[uAxis] = static_cast<uint8_t>(u);
+      position[vAxis] = static_cast<uint8_t>(v);
+
+      out.push_back(Quad::make(position, face, width, height, plane.block, ao,
+                               plane.light));
+    }
+  }
+}
+
+} // namespace engine::voxel
@@ -0,0 +1,485 @@
+#include "engine/voxel/region.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <lz4.h>
+#include <xxhash.h>
+
+namespace engine::voxel {
+
+// The file is written in the machine's byte order.
+static_assert(std::endian::native == std::endian::little,
+              "region files are little endian");
+
+namespace {
+
+constexpr char MAGIC[8] = {'V', 'V', 'E', 'R', 'E', 'G', 'N', '\0'};
+constexpr uint32_t VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t regionSize;
+  uint32_t columnChunks;
+  uint32_t chunkSize;
+  uint32_t reserved[2];
+};
+static_assert(sizeof(Header) == 32);
+
+/// The table follows the header. Entries are as big as the header, so none
+/// straddles a disk sector and each is written whole or not at all.
+constexpr uint64_t TABLE_OFFSET = sizeof(Header);
+constexpr uint64_t ENTRY_SIZE = 32;
+constexpr uint64_t DATA_OFFSET = TABLE_OFFSET + REGION_COLUMNS * ENTRY_SIZE;
+
+/// Way past any real column, so a damaged size cannot ask for gigabytes.
+constexpr uint32_t MAX_RAW_SIZE = 64u << 20;
+
+constexpr auto columnIndex(glm::ivec2 local) noexcept -> uint32_t {
+  return static_cast<uint32_t>(local.y) * REGION_SIZE +
+         static_cast<uint32_t>(local.x);
+}
+
+auto asBytes(const auto &value) noexcept -> std::span<const std::byte> {
+  return std::as_bytes(std::span(&value, 1));
+}
+
+/// Uncompressed column being loaded or saved on this thread.
+auto scratch() noexcept -> std::vector<std::byte> & {
+  thread_local std::vector<std::byte> bytes;
+  return bytes;
+}
+
+} // namespace
+
+auto RegionFile::open(const std::filesystem::path &path) noexcept
+    -> std::expected<RegionFile, std::string> {
+  auto file = MappedFile::open(path);
+  if (!file) {
+    return std::unexpected(path.string() + ": " + file.error());
+  }
+
+  // A file shorter than its table never had anything committed, it was
+  // created by a run that did not get as far as syncing the table.
+  if (file->size() < DATA_OFFSET) {
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.regionSize = REGION_SIZE;
+    header.columnChunks = COLUMN_CHUNKS;
+    header.chunkSize = CHUNK_SIZE;
+    std::vector<std::byte> start(DATA_OFFSET);
+    std::memcpy(start.data(), &header, sizeof(header));
+
+    auto written = file->write(0, start);
+    if (written) {
+      written = file->sync();
+    }
+    if (written) {
+      written = file->remap();
+    }
+    if (!written) {
+      return std::unexpected(path.string() + ": " + written.error());
+    }
+  }
+
+  Header header;
+  std::memcpy(&header, file->data().data(), sizeof(header));
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != VERSION) {
+    return std::unexpected(path.string() + ": not a region file");
+  }
+  if (header.regionSize != REGION_SIZE ||
+      header.columnChunks != COLUMN_CHUNKS || header.chunkSize != CHUNK_SIZE) {
+    return std::unexpected(path.string() +
+                           ": region saved with different dimensions");
+  }
+
+  // Anything between or past the committed columns is a replaced copy, a
+  // save a crash cut short or space the file grew ahead of saves, all free.
+  RegionFile region(std::move(*file), DATA_OFFSET);
+  std::vector<Extent> used;
+  for (uint32_t i = 0; i < REGION_COLUMNS; ++i) {
+    const auto entry = region.entry(i);
+    if (entry.size != 0) {
+      used.push_back(Extent{.offset = entry.offset, .size = entry.size});
+    }
+  }
+  std::ranges::sort(used, {}, &Extent::offset);
+  for (const auto &extent : used) {
+    if (extent.offset > region.end) {
+      region.gaps.push_back(
+          Extent{.offset = region.end, .size = extent.offset - region.end});
+    }
+    region.end = std::max(region.end, extent.offset + extent.size);
+  }
+  return region;
+}
+
+void RegionFile::encode(std::span<const Chunk, COLUMN_CHUNKS> chunks,
+                        std::span<const std::byte> metadata,
+                        Encoded &out) noexcept {
+  auto &raw = scratch();
+  raw.clear();
+  const auto metadataSize = static_cast<uint32_t>(metadata.size());
+  const auto size = asBytes(metadataSize);
+  raw.insert(raw.end(), size.begin(), size.end());
+  raw.insert(raw.end(), metadata.begin(), metadata.end());
+  for (const auto &chunk : chunks) {
+    chunk.serialize(raw);
+  }
+
+  const auto rawSize = static_cast<int>(raw.size());
+  out.bytes.resize(static_cast<size_t>(LZ4_compressBound(rawSize)));
+  const auto compressed = LZ4_compress_default(
+      reinterpret_cast<const char *>(raw.data()),
+      reinterpret_cast<char *>(out.bytes.data()), rawSize,
+      static_cast<int>(out.bytes.size()));
+  out.bytes.resize(static_cast<size_t>(compressed));
+  out.rawSize = static_cast<uint32_t>(rawSize);
+}
+
+auto RegionFile::contains(glm::ivec2 local) const noexcept -> bool {
+  return entry(columnIndex(local)).size != 0;
+}
+
+auto RegionFile::load(glm::ivec2 local, std::span<Chunk, COLUMN_CHUNKS> chunks,
+                      std::vector<std::byte> &metadata) const noexcept
+    -> std::expected<bool, std::string> {
+  const auto column = entry(columnIndex(local));
+  if (column.size == 0) {
+    return false;
+  }
+
+  const auto data = file.data();
+  if (column.offset < DATA_OFFSET || column.offset > data.size() ||
+      column.size > data.size() - column.offset ||
+      column.rawSize > MAX_RAW_SIZE) {
+    return std::unexpected("Column entry out of bounds");
+  }
+  const auto payload = data.subspan(column.offset, column.size);
+  if (XXH32(payload.data(), payload.size(), 0) != column.checksum) {
+    return std::unexpected("Column checksum mismatch");
+  }
+
+  auto &raw = scratch();
+  raw.resize(column.rawSize);
+  const auto decompressed = LZ4_decompress_safe(
+      reinterpret_cast<const char *>(payload.data()),
+      reinterpret_cast<char *>(raw.data()), static_cast<int>(payload.size()),
+      static_cast<int>(raw.size()));
+  if (decompressed != static_cast<int>(column.rawSize)) {
+    return std::unexpected("Column failed to decompress");
+  }
+
+  std::span<const std::byte> in(raw);
+  uint32_t metadataSize;
+  if (in.size() < sizeof(metadataSize)) {
+    return std::unexpected("Column truncated");
+  }
+  std::memcpy(&metadataSize, in.data(), sizeof(metadataSize));
+  in = in.subspan(sizeof(metadataSize));
+  if (in.size() < metadataSize) {
+    return std::unexpected("Column truncated");
+  }
+  metadata.assign(in.begin(), in.begin() + metadataSize);
+  in = in.subspan(metadataSize);
+
+  for (auto &chunk : chunks) {
+    auto loaded = Chunk::deserialize(in);
+    if (!loaded) {
+      return std::unexpected("Column holds an invalid chunk");
+    }
+    chunk = std::move(*loaded);
+  }
+  if (!in.empty()) {
+    return std::unexpected("Column has trailing bytes");
+  }
+  return true;
+}
+
+auto RegionFile::save(glm::ivec2 local, const Encoded &column) noexcept
+    -> std::expected<void, std::string> {
+  const auto size = static_cast<uint64_t>(column.bytes.size());
+  const auto offset = allocate(size);
+  if (offset + size > file.size()) {
+    if (auto reserved =
+            file.reserve(std::max(offset + size, file.size() * 2));
+        !reserved) {
+      release(Extent{.offset = offset, .size = size});
+      return reserved;
+    }
+  }
+  if (auto written = file.write(offset, column.bytes); !written) {
+    release(Extent{.offset = offset, .size = size});
+    return written;
+  }
+
+  const Entry entry{
+      .offset = offset,
+      .size = static_cast<uint32_t>(size),
+      .rawSize = column.rawSize,
+      .checksum = XXH32(column.bytes.data(), column.bytes.size(), 0),
+      .reserved = {}};
+  auto &saved = pending[columnIndex(local)];
+  // Saved over before it was committed, so nothing on disk points at it.
+  if (saved.size != 0 &&
+      std::ranges::find(committing, saved.offset) == committing.end()) {
+    release(Extent{.offset = saved.offset, .size = saved.size});
+  }
+  saved = entry;
+  return {};
+}
+
+auto RegionFile::commit() noexcept -> std::expected<void, std::string> {
+  if (pending.empty()) {
+    return {};
+  }
+  auto batch = prepareCommit();
+  // The columns have to be on disk before any entry points at them.
+  auto result = flush();
+  if (result) {
+    result = finishCommit(batch);
+  }
+  if (result) {
+    result = flush();
+  }
+  endCommit(batch, result.has_value());
+  return result;
+}
+
+auto RegionFile::prepareCommit() noexcept -> Batch {
+  Batch batch{.entries = {pending.begin(), pending.end()}, .replaced = {}};
+  committing.clear();
+  for (const auto &[_, entry] : batch.entries) {
+    committing.push_back(entry.offset);
+  }
+  return batch;
+}
+
+auto RegionFile::finishCommit(Batch &batch) noexcept
+    -> std::expected<void, std::string> {
+  for (const auto &[index, entry] : batch.entries) {
+    const auto offset = TABLE_OFFSET + index * ENTRY_SIZE;
+    Entry old;
+    std::memcpy(&old, file.data().data() + offset, sizeof(old));
+    if (auto written = file.write(offset, asBytes(entry)); !written) {
+      return written;
+    }
+    if (old.size != 0) {
+      batch.replaced.push_back(Extent{.offset = old.offset, .size = old.size});
+    }
+    // Still pending if saved again since.
+    const auto it = pending.find(index);
+    if (it != pending.end() && it->second.offset == entry.offset) {
+      pending.erase(it);
+    }
+  }
+  return {};
+}
+
+void RegionFile::endCommit(const Batch &batch, bool durable) noexcept {
+  committing.clear();
+  if (!durable) {
+    return;
+  }
+  // Entries saved over while being committed are in the table now, and
+  // replacing them there is up to the next commit.
+  for (const auto &extent : batch.replaced) {
+    release(extent);
+  }
+}
+
+auto RegionFile::entry(uint32_t index) const noexcept -> Entry {
+  if (const auto it = pending.find(index); it != pending.end()) {
+    return it->second;
+  }
+  Entry entry;
+  std::memcpy(&entry, file.data().data() + TABLE_OFFSET + index * ENTRY_SIZE,
+              sizeof(entry));
+  return entry;
+}
+
+auto RegionFile::allocate(uint64_t size) noexcept -> uint64_t {
+  const auto gap = std::ranges::find_if(
+      gaps, [&](const Extent &extent) { return extent.size >= size; });
+  if (gap == gaps.end()) {
+    return std::exchange(end, end + size);
+  }
+  const auto offset = gap->offset;
+  gap->offset += size;
+  gap->size -= size;
+  if (gap->size == 0) {
+    gaps.erase(gap);
+  }
+  return offset;
+}
+
+void RegionFile::release(Extent extent) noexcept {
+  auto next = std::ranges::upper_bound(gaps, extent.offset, {},
+                                       &Extent::offset);
+  if (next != gaps.end() && extent.offset + extent.size == next->offset) {
+    extent.size += next->size;
+    next = gaps.erase(next);
+  }
+  if (next != gaps.begin()) {
+    if (auto &previous = *std::prev(next);
+        previous.offset + previous.size == extent.offset) {
+      previous.size += extent.size;
+      extent = previous;
+      next = gaps.erase(std::prev(next));
+    }
+  }
+  // Free space at the end is given back to it rather than kept as a gap.
+  if (extent.offset + extent.size == end) {
+    end = extent.offset;
+    return;
+  }
+  gaps.insert(next, extent);
+}
+
+auto RegionStore::open(const std::filesystem::path &directory) noexcept
+    -> std::expected<RegionStore, std::string> {
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    return std::unexpected(directory.string() + ": " + error.message());
+  }
+  return RegionStore(directory);
+}
+
+auto RegionStore::load(glm::ivec2 column,
+                       std::span<Chunk, COLUMN_CHUNKS> chunks,
+                       std::vector<std::byte> &metadata) noexcept
+    -> std::expected<bool, std::string> {
+  auto region = find(regionOf(column));
+  if (!region) {
+    return std::unexpected(region.error());
+  }
+  std::shared_lock lock((*region)->mutex);
+  if (!(*region)->file) {
+    return false;
+  }
+  return (*region)->file->load(localOf(column), chunks, metadata);
+}
+
+auto RegionStore::save(glm::ivec2 column,
+                       std::span<const Chunk, COLUMN_CHUNKS> chunks,
+                       std::span<const std::byte> metadata) noexcept
+    -> std::expected<void, std::string> {
+  // Compressed before taking the lock, so loads only wait on the write.
+  thread_local RegionFile::Encoded encoded;
+  RegionFile::encode(chunks, metadata, encoded);
+
+  const auto position = regionOf(column);
+  auto region = find(position);
+  if (!region) {
+    return std::unexpected(region.error());
+  }
+  std::unique_lock lock((*region)->mutex);
+  auto &file = (*region)->file;
+  if (!file) {
+    auto opened = RegionFile::open(path(position));
+    if (!opened) {
+      return std::unexpected(opened.error());
+    }
+    file.emplace(std::move(*opened));
+  }
+  return file->save(localOf(column), encoded);
+}
+
+auto RegionStore::commit() noexcept -> std::expected<void, std::string> {
+  std::vector<Region *> all;
+  {
+    std::lock_guard lock(regions->mutex);
+    all.reserve(regions->byKey.size());
+    for (const auto &[_, region] : regions->byKey) {
+      all.push_back(region.get());
+    }
+  }
+
+  // Keeps going past a failed region so the others are still committed.
+  std::expected<void, std::string> result;
+  for (auto *region : all) {
+    if (auto committed = commit(*region); !committed && result) {
+      result = committed;
+    }
+  }
+  return result;
+}
+
+auto RegionStore::commit(glm::ivec2 position) noexcept
+    -> std::expected<void, std::string> {
+  auto region = find(position);
+  if (!region) {
+    return std::unexpected(region.error());
+  }
+  return commit(**region);
+}
+
+auto RegionStore::commit(Region &region) noexcept
+    -> std::expected<void, std::string> {
+  // Loads and saves carry on while the disk flushes, the lock is only held
+  // to read and update the table.
+  std::lock_guard committing(region.committing);
+  RegionFile::Batch batch;
+  {
+    std::unique_lock lock(region.mutex);
+    if (!region.file || region.file->pendingCount() == 0) {
+      return {};
+    }
+    batch = region.file->prepareCommit();
+  }
+  // Never reset once set, so safe to use unlocked.
+  auto &file = *region.file;
+  auto result = file.flush();
+  if (result) {
+    std::unique_lock lock(region.mutex);
+    result = file.finishCommit(batch);
+  }
+  if (result) {
+    result = file.flush();
+  }
+  std::unique_lock lock(region.mutex);
+  file.endCommit(batch, result.has_value());
+  return result;
+}
+
+auto RegionStore::path(glm::ivec2 region) const noexcept
+    -> std::filesystem::path {
+  return directory / ("r." + std::to_string(region.x) + "." +
+                      std::to_string(region.y) + ".region");
+}
+
+auto RegionStore::find(glm::ivec2 position) noexcept
+    -> std::expected<Region *, std::string> {
+  const auto key =
+      (static_cast<uint64_t>(static_cast<uint32_t>(position.x)) << 32) |
+      static_cast<uint32_t>(position.y);
+  std::lock_guard lock(regions->mutex);
+  auto &region = regions->byKey[key];
+  if (region) {
+    return region.get();
+  }
+
+  auto created = std::make_unique<Region>();
+  const auto file = path(position);
+  if (std::error_code error; std::filesystem::exists(file, error)) {
+    auto opened = RegionFile::open(file);
+    if (!opened) {
+      regions->byKey.erase(key);
+      return std::unexpected(opened.error());
+    }
+    created->file.emplace(std::move(*opened));
+  }
+  region = std::move(created);
+  return region.get();
+}
+
+} // namespace engine::voxel
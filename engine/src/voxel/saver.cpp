@@ -0,0 +1,168 @@
+#include "engine/voxel/saver.hpp"
+
+#include "engine/trace.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace engine::voxel {
+
+namespace {
+
+/// How often the thread looks for work. Submitting does not wake it, a
+/// wakeup would be a system call on the submitting thread, and on a busy
+/// machine a switch to the saving thread in the middle of its frame.
+constexpr auto POLL_INTERVAL = std::chrono::milliseconds(50);
+
+} // namespace
+
+BackgroundSaver::BackgroundSaver(RegionStore &store,
+                                 const Settings &settings) noexcept
+    : store(&store), settings(settings), thread([this]() { run(); }) {}
+
+BackgroundSaver::~BackgroundSaver() {
+  {
+    std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  thread.join();
+}
+
+auto BackgroundSaver::submit(std::vector<Column> columns) noexcept
+    -> uint64_t {
+  const auto count = static_cast<uint32_t>(columns.size());
+  uint64_t ticket;
+  {
+    std::lock_guard lock(mutex);
+    ticket = ++lastTicket;
+    queue.push_back(Batch{.ticket = ticket, .columns = std::move(columns)});
+    // Under the lock so the thread never takes off more than was added.
+    queuedColumns.fetch_add(count, std::memory_order_relaxed);
+  }
+  return ticket;
+}
+
+void BackgroundSaver::flush() noexcept {
+  uint64_t ticket;
+  {
+    std::lock_guard lock(mutex);
+    ticket = lastTicket;
+    ++flushing;
+  }
+  wake.notify_all();
+
+  for (auto current = saved(); current < ticket; current = saved()) {
+    savedTicket.wait(current, std::memory_order_acquire);
+  }
+
+  std::lock_guard lock(mutex);
+  --flushing;
+}
+
+void BackgroundSaver::run() noexcept {
+  trace::setThreadName("Saver");
+  std::vector<Batch> batches;
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      wake.wait_for(lock, POLL_INTERVAL, [&]() {
+        return stopping || (flushing != 0 && !queue.empty());
+      });
+      if (queue.empty()) {
+        if (stopping) {
+          return;
+        }
+        continue;
+      }
+      batches.swap(queue);
+    }
+    save(batches);
+    batches.clear();
+  }
+}
+
+void BackgroundSaver::save(std::vector<Batch> &batches) noexcept {
+  EG_ZONE("Save columns");
+  // Batches are in ticket order, so of two snapshots of a column the later
+  // one is newer. Sorting by region keeps each region's saves together.
+  struct Save {
+    glm::ivec2 region;
+    uint32_t local;
+    uint32_t order;
+    Column *column;
+  };
+  std::vector<Save> saves;
+  for (auto &batch : batches) {
+    for (auto &column : batch.columns) {
+      const auto local = RegionStore::localOf(column.position);
+      saves.push_back(Save{.region = RegionStore::regionOf(column.position),
+                           .local = static_cast<uint32_t>(local.x) +
+                                    static_cast<uint32_t>(local.y) *
+                                        REGION_SIZE,
+                           .order = static_cast<uint32_t>(saves.size()),
+                           .column = &column});
+    }
+  }
+  std::ranges::sort(saves, [](const Save &a, const Save &b) {
+    if (a.region.x != b.region.x) {
+      return a.region.x < b.region.x;
+    }
+    if (a.region.y != b.region.y) {
+      return a.region.y < b.region.y;
+    }
+    if (a.local != b.local) {
+      return a.local < b.local;
+    }
+    return a.order < b.order;
+  });
+
+  const auto interval =
+      settings.maxColumnsPerSecond == 0
+          ? std::chrono::steady_clock::duration::zero()
+          : std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::seconds(1)) /
+                settings.maxColumnsPerSecond;
+  auto next = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < saves.size(); ++i) {
+    const auto &current = saves[i];
+    const bool last = i + 1 == saves.size();
+    const bool superseded = !last && saves[i + 1].region == current.region &&
+                            saves[i + 1].local == current.local;
+    if (!superseded) {
+      if (interval != std::chrono::steady_clock::duration::zero()) {
+        throttle(next);
+        next = std::max(next + interval, std::chrono::steady_clock::now());
+      }
+      const auto &column = *current.column;
+      if (auto result =
+              store->save(column.position, column.chunks, column.metadata);
+          !result) {
+        Logger::error("Failed to save column ({}, {}): {}", column.position.x,
+                      column.position.y, result.error());
+      }
+    }
+
+    if (last || saves[i + 1].region != current.region) {
+      if (auto committed = store->commit(current.region); !committed) {
+        Logger::error("Failed to commit region ({}, {}): {}",
+                      current.region.x, current.region.y, committed.error());
+      }
+    }
+  }
+
+  queuedColumns.fetch_sub(static_cast<uint32_t>(saves.size()),
+                          std::memory_order_relaxed);
+  savedTicket.store(batches.back().ticket, std::memory_order_release);
+  savedTicket.notify_all();
+}
+
+void BackgroundSaver::throttle(
+    std::chrono::steady_clock::time_point until) noexcept {
+  std::unique_lock lock(mutex);
+  wake.wait_until(lock, until, [&]() { return flushing != 0 || stopping; });
+}
+
+} // namespace engine::voxel
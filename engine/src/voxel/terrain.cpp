@@ -0,0 +1,561 @@
+#include "engine/voxel/terrain.hpp"
+
+#include "engine/trace.hpp"
+#include "engine/voxel/region.hpp"
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace engine::voxel {
+
+namespace {
+
+constexpr int32_t SEA_LEVEL = 64;
+constexpr float BASE_HEIGHT = 80.0f;
+/// Heights swing about this far either way of `BASE_HEIGHT`.
+constexpr float HEIGHT_RANGE = 56.0f;
+/// Keeps the tallest tree inside the column.
+constexpr int32_t MAX_HEIGHT = static_cast<int32_t>(COLUMN_HEIGHT) - 16;
+/// Ground at most this far above sea level is sand instead of grass.
+constexpr int32_t BEACH_HEIGHT = SEA_LEVEL + 2;
+/// Dirt (or sand) below the top block, above the stone.
+constexpr int32_t SOIL_DEPTH = 3;
+
+/// Cave noise above this is carved out. Fractal noise rarely leaves about
+/// [-0.8, 0.8], so this hollows out a few percent of the ground.
+constexpr float CAVE_THRESHOLD = 0.42f;
+
+/// Chance out of 1024 for a grass block to grow a tree.
+constexpr uint32_t TREE_CHANCE = 6;
+constexpr uint32_t MIN_TREE_HEIGHT = 4;
+constexpr uint32_t TREE_HEIGHT_RANGE = 3;
+/// Furthest a tree's leaves reach from its trunk, so the furthest it can
+/// reach into a neighbouring column.
+constexpr int32_t TREE_REACH = 2;
+
+constexpr uint32_t COLUMN_VOLUME = COLUMN_CHUNKS * CHUNK_VOLUME;
+
+/// A tree anchor as saved, its base and height as four int32s.
+constexpr size_t SAVED_TREE_SIZE = 4 * sizeof(int32_t);
+
+/// Index into a column's blocks, each chunk a contiguous slab in
+/// `Chunk::index` order.
+constexpr auto columnIndex(uint32_t x, uint32_t y, uint32_t z) noexcept
+    -> uint32_t {
+  return (y >> CHUNK_SIZE_SHIFT) * CHUNK_VOLUME +
+         Chunk::index(x, y & (CHUNK_SIZE - 1), z);
+}
+
+/// Mixes a seed and a world position into 32 random bits.
+auto hash(int32_t seed, int32_t x, int32_t z) noexcept -> uint32_t {
+  uint32_t h = static_cast<uint32_t>(seed) * 0x9E3779B9u;
+  h ^= static_cast<uint32_t>(x) * 0x85EBCA6Bu;
+  h = (h ^ (h >> 16)) * 0x7FEB352Du;
+  h ^= static_cast<uint32_t>(z) * 0xC2B2AE35u;
+  h = (h ^ (h >> 15)) * 0x846CA68Bu;
+  return h ^ (h >> 16);
+}
+
+/// Unpacked blocks of the column being generated on this thread.
+auto scratchBlocks() noexcept -> std::span<BlockId, COLUMN_VOLUME> {
+  thread_local std::vector<BlockId> voxels(COLUMN_VOLUME);
+  return std::span<BlockId, COLUMN_VOLUME>(voxels.data(), COLUMN_VOLUME);
+}
+
+auto scratchDensity() noexcept -> std::span<float, CHUNK_VOLUME> {
+  thread_local std::vector<float> density(CHUNK_VOLUME);
+  return std::span<float, CHUNK_VOLUME>(density.data(), CHUNK_VOLUME);
+}
+
+auto heightNoise(int32_t seed) noexcept -> noise::Fractal {
+  return noise::Fractal{.basis = noise::Basis::Simplex,
+                        .seed = seed,
+                        .frequency = 1.0f / 256.0f,
+                        .octaves = 5,
+                        .lacunarity = 2.0f,
+                        .gain = 0.5f};
+}
+
+auto heightWarp(int32_t seed) noexcept -> noise::Warp {
+  return noise::Warp{.amplitude = 48.0f,
+                     .fractal = {.basis = noise::Basis::Simplex,
+                                 .seed = seed + 1,
+                                 .frequency = 1.0f / 512.0f,
+                                 .octaves = 2,
+                                 .lacunarity = 2.0f,
+                                 .gain = 0.5f}};
+}
+
+auto caveNoise(int32_t seed) noexcept -> noise::Fractal {
+  return noise::Fractal{.basis = noise::Basis::Simplex,
+                        .seed = seed + 2,
+                        .frequency = 1.0f / 48.0f,
+                        .octaves = 2,
+                        .lacunarity = 2.0f,
+                        .gain = 0.5f};
+}
+
+} // namespace
+
+/// The generation passes. Each only reads the settings and the columns it is
+/// handed, so any number run at once.
+struct TerrainGenerator::Passes {
+  int32_t seed;
+  noise::Noise height;
+  noise::Noise caves;
+
+  explicit Passes(const Settings &settings) noexcept
+      : seed(settings.seed),
+        height(heightNoise(settings.seed), heightWarp(settings.seed),
+               settings.isa),
+        caves(caveNoise(settings.seed), {}, settings.isa) {}
+
+  /// Runs every pass up to the surface, which only needs the column itself.
+  void generate(ColumnState &column) const noexcept {
+    const auto voxels = scratchBlocks();
+    heightmap(column);
+    carve(column, voxels);
+    surface(column, voxels);
+    for (uint32_t i = 0; i < COLUMN_CHUNKS; ++i) {
+      column.chunks[i].pack(
+          voxels.subspan(i * CHUNK_VOLUME).first<CHUNK_VOLUME>());
+    }
+  }
+
+  /// Ground height of every x, z in the column.
+  void heightmap(ColumnState &column) const noexcept {
+    std::array<float, CHUNK_AREA> values;
+    const auto origin = glm::vec2(column.position * glm::ivec2(CHUNK_SIZE));
+    height.grid(origin, glm::uvec2(CHUNK_SIZE), 1.0f, values);
+
+    for (uint32_t i = 0; i < CHUNK_AREA; ++i) {
+      const auto y = static_cast<int32_t>(
+          std::floor(BASE_HEIGHT + values[i] * HEIGHT_RANGE));
+      column.heights[i] = static_cast<uint16_t>(std::clamp(y, 1, MAX_HEIGHT));
+    }
+  }
+
+  /// Fills the column with stone up to its height, less the caves. The
+  /// bottom layer is never carved.
+  void carve(const ColumnState &column,
+             std::span<BlockId, COLUMN_VOLUME> voxels) const noexcept {
+    const auto maxHeight = *std::ranges::max_element(column.heights);
+    const auto density = scratchDensity();
+
+    for (uint32_t chunk = 0; chunk < COLUMN_CHUNKS; ++chunk) {
+      const auto slab =
+          voxels.subspan(chunk * CHUNK_VOLUME).first<CHUNK_VOLUME>();
+      const uint32_t baseY = chunk * CHUNK_SIZE;
+      if (baseY > maxHeight) {
+        std::ranges::fill(slab, AIR);
+        continue;
+      }
+
+      const glm::vec3 origin(static_cast<float>(column.position.x) * CHUNK_SIZE,
+                             static_cast<float>(baseY),
+                             static_cast<float>(column.position.y) *
+                                 CHUNK_SIZE);
+      caves.grid(origin, glm::uvec3(CHUNK_SIZE), 1.0f, density);
+
+      for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+        const uint32_t worldY = baseY + y;
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+          for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+            const auto i = Chunk::index(x, y, z);
+            const bool solid =
+                worldY <= column.heights[z * CHUNK_SIZE + x] &&
+                (worldY == 0 || density[i] <= CAVE_THRESHOLD);
+            slab[i] = solid ? blocks::STONE : AIR;
+          }
+        }
+      }
+    }
+  }
+
+  /// Covers the topmost stone under each x, z with soil and picks where
+  /// trees grow.
+  void surface(ColumnState &column,
+               std::span<BlockId, COLUMN_VOLUME> voxels) const noexcept {
+    column.trees.clear();
+    const auto origin = column.position * glm::ivec2(CHUNK_SIZE);
+
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+      for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+        const int32_t height = column.heights[z * CHUNK_SIZE + x];
+        int32_t y = height;
+        while (y > 0 && voxels[columnIndex(x, y, z)] == AIR) {
+          --y;
+        }
+        if (y == 0) {
+          continue;
+        }
+
+        const bool beach = y <= BEACH_HEIGHT;
+        voxels[columnIndex(x, y, z)] = beach ? blocks::SAND : blocks::GRASS;
+        for (int32_t depth = 1; depth <= SOIL_DEPTH && y - depth > 0;
+             ++depth) {
+          auto &block = voxels[columnIndex(x, y - depth, z)];
+          if (block == AIR) {
+            break;
+          }
+          block = beach ? blocks::SAND : blocks::DIRT;
+        }
+
+        // Only on open ground, not on cave floors.
+        const auto worldX = origin.x + static_cast<int32_t>(x);
+        const auto worldZ = origin.y + static_cast<int32_t>(z);
+        const auto roll = hash(seed, worldX, worldZ);
+        if (!beach && y == height && (roll & 1023) < TREE_CHANCE) {
+          column.trees.push_back(TreeAnchor{
+              .base = {worldX, y + 1, worldZ},
+              .height = MIN_TREE_HEIGHT + (roll >> 10) % TREE_HEIGHT_RANGE});
+        }
+      }
+    }
+  }
+
+  /// Stamps the trees of the column and its neighbours into the column.
+  /// Leaves only fill air and trunks only air or leaves, so overlapping
+  /// trees come out the same whichever is stamped first.
+  void structures(ColumnState &column,
+                  std::span<const ColumnState *const, 8> neighbours)
+      const noexcept {
+    stampTrees(column, column);
+    for (const auto *neighbour : neighbours) {
+      stampTrees(column, *neighbour);
+    }
+  }
+
+  static void stampTrees(ColumnState &column,
+                         const ColumnState &source) noexcept {
+    const auto min = column.position * glm::ivec2(CHUNK_SIZE);
+    const auto max = min + glm::ivec2(CHUNK_SIZE);
+
+    const auto place = [&](int32_t x, int32_t y, int32_t z, BlockId block) {
+      if (x < min.x || x >= max.x || z < min.y || z >= max.y || y < 0 ||
+          y >= static_cast<int32_t>(COLUMN_HEIGHT)) {
+        return;
+      }
+      auto &chunk = column.chunks[static_cast<uint32_t>(y) / CHUNK_SIZE];
+      const auto localX = static_cast<uint32_t>(x - min.x);
+      const auto localY = static_cast<uint32_t>(y) % CHUNK_SIZE;
+      const auto localZ = static_cast<uint32_t>(z - min.y);
+      const auto current = chunk.get(localX, localY, localZ);
+      if (current == AIR ||
+          (block == blocks::WOOD && current == blocks::LEAVES)) {
+        chunk.set(localX, localY, localZ, block);
+      }
+    };
+
+    for (const auto &tree : source.trees) {
+      const auto [x, y, z] = tree.base;
+      if (x + TREE_REACH < min.x || x - TREE_REACH >= max.x ||
+          z + TREE_REACH < min.y || z - TREE_REACH >= max.y) {
+        continue;
+      }
+
+      const auto top = y + static_cast<int32_t>(tree.height) - 1;
+      for (int32_t dy = -1; dy <= 2; ++dy) {
+        // Wide below the top of the trunk, narrowing above it.
+        const int32_t reach = dy <= 0 ? TREE_REACH : 1;
+        for (int32_t dz = -reach; dz <= reach; ++dz) {
+          for (int32_t dx = -reach; dx <= reach; ++dx) {
+            const bool corner = std::abs(dx) == reach && std::abs(dz) == reach;
+            if (corner && (reach == TREE_REACH || dy == 2)) {
+              continue;
+            }
+            place(x + dx, top + dy, z + dz, blocks::LEAVES);
+          }
+        }
+      }
+      for (int32_t trunk = y; trunk <= top; ++trunk) {
+        place(x, trunk, z, blocks::WOOD);
+      }
+    }
+  }
+};
+
+template <typename Fn>
+void TerrainGenerator::forEachNeighbour(const ColumnState &column,
+                                        Fn &&fn) const noexcept {
+  for (int32_t dz = -1; dz <= 1; ++dz) {
+    for (int32_t dx = -1; dx <= 1; ++dx) {
+      if (dx != 0 || dz != 0) {
+        fn(find(column.position + glm::ivec2(dx, dz)));
+      }
+    }
+  }
+}
+
+TerrainGenerator::TerrainGenerator(JobSystem &jobs,
+                                   const Settings &settings) noexcept
+    : jobs(&jobs), passes(std::make_unique<const Passes>(settings)),
+      maxJobs(settings.maxJobs != 0
+                  ? settings.maxJobs
+                  : std::max(1u, jobs.workerCount() * 2)),
+      store(settings.store), committing(std::make_unique<JobCounter>()) {}
+
+TerrainGenerator::TerrainGenerator(TerrainGenerator &&) noexcept = default;
+
+TerrainGenerator::~TerrainGenerator() {
+  // Moved from.
+  if (!committing) {
+    return;
+  }
+  wait();
+  jobs->waitAndHelp(*committing);
+  if (store != nullptr) {
+    if (auto committed = store->commit(); !committed) {
+      Logger::error("Failed to commit saved columns: {}", committed.error());
+    }
+  }
+}
+
+void TerrainGenerator::update(const glm::vec3 &eye, uint32_t radius) noexcept {
+  for (auto &[_, column] : columns) {
+    if (column->running && column->done.isDone()) {
+      retire(*column);
+    }
+  }
+  // Saves pile up while a commit runs and all go in the next, so a busy
+  // generator flushes once per commit rather than once per column.
+  if (unsaved != 0 && committing->isDone()) {
+    startCommit();
+  }
+
+  const auto structuresRadius = static_cast<float>(radius);
+  // Reaches every neighbour of a column within `structuresRadius`.
+  const auto surfaceRadius = structuresRadius + 1.5f;
+  // Leaves some slack so columns on the edge are not dropped and generated
+  // again while the camera wobbles back and forth.
+  const auto dropRadius = surfaceRadius + 2.0f;
+
+  std::erase_if(columns, [&](const auto &entry) {
+    const auto &column = *entry.second;
+    return !column.running && column.pins == 0 &&
+           distance(eye, column.position) > dropRadius;
+  });
+
+  const auto centre = columnAt(eye);
+  const auto reach = static_cast<int32_t>(std::ceil(surfaceRadius));
+  for (int32_t dz = -reach; dz <= reach; ++dz) {
+    for (int32_t dx = -reach; dx <= reach; ++dx) {
+      const auto position = centre + glm::ivec2(dx, dz);
+      if (distance(eye, position) > surfaceRadius) {
+        continue;
+      }
+      auto &column = columns[key(position)];
+      if (!column) {
+        column = std::make_unique<ColumnState>();
+        column->position = position;
+      }
+    }
+  }
+
+  if (running >= maxJobs) {
+    return;
+  }
+
+  struct Candidate {
+    float distance;
+    ColumnState *column;
+  };
+  std::vector<Candidate> candidates;
+  for (auto &[_, column] : columns) {
+    if (column->running) {
+      continue;
+    }
+    const auto d = distance(eye, column->position);
+    bool ready = false;
+    if (column->stage == Stage::Empty) {
+      // The ring past `structuresRadius` only waits on a neighbour that was
+      // generated rather than loaded, so reopening a saved world skips it.
+      ready = d <= structuresRadius;
+      if (!ready && d <= surfaceRadius) {
+        forEachNeighbour(*column, [&](const ColumnState *neighbour) {
+          ready = ready ||
+                  (neighbour != nullptr &&
+                   neighbour->stage == Stage::Surface &&
+                   distance(eye, neighbour->position) <= structuresRadius);
+        });
+      }
+    } else if (column->stage == Stage::Surface && d <= structuresRadius) {
+      ready = true;
+      forEachNeighbour(*column, [&](const ColumnState *neighbour) {
+        ready = ready && neighbour != nullptr &&
+                neighbour->stage != Stage::Empty;
+      });
+    }
+    if (ready) {
+      candidates.push_back({d, column.get()});
+    }
+  }
+
+  std::ranges::sort(candidates, {}, &Candidate::distance);
+  for (const auto &candidate : candidates) {
+    if (running >= maxJobs) {
+      break;
+    }
+    if (candidate.column->stage == Stage::Empty) {
+      startLocal(*candidate.column);
+    } else {
+      startStructures(*candidate.column);
+    }
+  }
+}
+
+auto TerrainGenerator::takeFinished() noexcept -> std::vector<Column> {
+  return std::exchange(finished, {});
+}
+
+void TerrainGenerator::wait() noexcept {
+  for (auto &[_, column] : columns) {
+    if (column->running) {
+      jobs->waitAndHelp(column->done);
+    }
+  }
+}
+
+auto TerrainGenerator::find(glm::ivec2 column) const noexcept
+    -> ColumnState * {
+  const auto it = columns.find(key(column));
+  return it != columns.end() ? it->second.get() : nullptr;
+}
+
+void TerrainGenerator::request(glm::ivec2 column) noexcept {
+  auto *state = find(column);
+  if (state == nullptr || state->running || state->pins != 0 ||
+      state->stage != Stage::Structures) {
+    return;
+  }
+  // Its heights and trees stay as they were for the neighbours, the passes
+  // write the same ones again.
+  state->stage = Stage::Empty;
+  state->target = Stage::Empty;
+  state->loaded = false;
+}
+
+void TerrainGenerator::retire(ColumnState &column) noexcept {
+  column.running = false;
+  // A loaded column skipped straight past its structures.
+  column.stage = column.loaded ? Stage::Structures : column.target;
+  --running;
+
+  if (column.stage == Stage::Structures) {
+    if (column.target == Stage::Structures) {
+      forEachNeighbour(column,
+                       [](ColumnState *neighbour) { --neighbour->pins; });
+      if (store != nullptr) {
+        ++unsaved;
+      }
+    }
+    finished.push_back(Column{.position = column.position,
+                              .chunks = std::move(column.chunks),
+                              .metadata = std::move(column.metadata)});
+  }
+}
+
+void TerrainGenerator::startLocal(ColumnState &column) noexcept {
+  column.target = Stage::Surface;
+  column.running = true;
+  ++running;
+  jobs->submit(
+      [passes = passes.get(), store = store, state = &column]() {
+        EG_ZONE("Generate column");
+        if (store == nullptr || !load(*store, *state)) {
+          passes->generate(*state);
+        }
+      },
+      &column.done);
+}
+
+void TerrainGenerator::startStructures(ColumnState &column) noexcept {
+  // Pinned so they stay loaded while the job reads them.
+  std::array<const ColumnState *, 8> neighbours;
+  uint32_t count = 0;
+  forEachNeighbour(column, [&](ColumnState *neighbour) {
+    ++neighbour->pins;
+    neighbours[count++] = neighbour;
+  });
+
+  column.target = Stage::Structures;
+  column.running = true;
+  ++running;
+  jobs->submit(
+      [passes = passes.get(), store = store, state = &column, neighbours]() {
+        EG_ZONE("Place structures");
+        passes->structures(*state, neighbours);
+        encodeTrees(*state);
+        if (store == nullptr) {
+          return;
+        }
+        if (auto saved =
+                store->save(state->position, state->chunks, state->metadata);
+            !saved) {
+          Logger::error("Failed to save column ({}, {}): {}",
+                        state->position.x, state->position.y, saved.error());
+        }
+      },
+      &column.done);
+}
+
+void TerrainGenerator::startCommit() noexcept {
+  unsaved = 0;
+  jobs->submit(
+      [store = store]() {
+        EG_ZONE("Commit regions");
+        if (auto committed = store->commit(); !committed) {
+          Logger::error("Failed to commit saved columns: {}",
+                        committed.error());
+        }
+      },
+      committing.get());
+}
+
+auto TerrainGenerator::load(RegionStore &store, ColumnState &column) noexcept
+    -> bool {
+  auto &metadata = column.metadata;
+  const auto loaded = store.load(column.position, column.chunks, metadata);
+  if (!loaded) {
+    // Generated again, and replaced by the next save.
+    Logger::warn("Failed to load column ({}, {}): {}", column.position.x,
+                 column.position.y, loaded.error());
+    return false;
+  }
+  if (!*loaded) {
+    return false;
+  }
+
+  if (metadata.size() % SAVED_TREE_SIZE != 0) {
+    Logger::warn("Column ({}, {}) has malformed tree anchors",
+                 column.position.x, column.position.y);
+    return false;
+  }
+  column.trees.resize(metadata.size() / SAVED_TREE_SIZE);
+  for (size_t i = 0; i < column.trees.size(); ++i) {
+    int32_t values[4];
+    std::memcpy(values, metadata.data() + i * SAVED_TREE_SIZE,
+                SAVED_TREE_SIZE);
+    column.trees[i] = TreeAnchor{.base = {values[0], values[1], values[2]},
+                                 .height = static_cast<uint32_t>(values[3])};
+  }
+  column.loaded = true;
+  return true;
+}
+
+void TerrainGenerator::encodeTrees(ColumnState &column) noexcept {
+  auto &metadata = column.metadata;
+  metadata.resize(column.trees.size() * SAVED_TREE_SIZE);
+  for (size_t i = 0; i < column.trees.size(); ++i) {
+    const auto &tree = column.trees[i];
+    const int32_t values[4] = {tree.base.x, tree.base.y, tree.base.z,
+                               static_cast<int32_t>(tree.height)};
+    std::memcpy(metadata.data() + i * SAVED_TREE_SIZE, values,
+                SAVED_TREE_SIZE);
+  }
+}
+
+} // namespace engine::voxel
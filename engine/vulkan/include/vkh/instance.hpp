@@ -6,9 +6,12 @@
 #include <vulkan/vulkan_raii.hpp>
 
 namespace vkh {
+/// With `presentable`, also enables the extensions GLFW needs to create
+/// window surfaces, which requires GLFW to be initialised.
 auto createInstance(vk::raii::Context &context, const char *appName,
                     const bool enableValidationLayers,
                     const std::span<const char *const> extraExtensions = {},
-                    const std::span<const char *const> extraLayers = {})
+                    const std::span<const char *const> extraLayers = {},
+                    const bool presentable = true)
     -> std::expected<vk::raii::Instance, std::string>;
 } // namespace vkh
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/rangeAllocator.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+namespace vkh {
+
+/// One large device local buffer that many small meshes are carved out of.
+///
+/// Every range is addressed through the buffer's device address, so shaders
+/// can pull from any of them without rebinding. The buffer itself is not
+/// destroyed here, hand `getBuffer` to whatever owns the allocator's other
+/// buffers.
+class MegaBuffer {
+public:
+  struct Range {
+    vk::DeviceSize offset;
+    vk::DeviceSize size;
+    vk::DeviceAddress address;
+  };
+
+  /// `usage` is added to the storage, transfer destination and device
+  /// address usages every mega buffer needs. With more than one distinct
+  /// family in `queueFamilies` the buffer is shared concurrently between
+  /// them, so each can write its own ranges without ownership transfers,
+  /// which would cover the whole buffer.
+  static auto create(const vk::raii::Device &device, vma::Allocator &allocator,
+                     vk::DeviceSize size, vk::BufferUsageFlags usage = {},
+                     std::span<const uint32_t> queueFamilies = {}) noexcept
+      -> std::expected<MegaBuffer, std::string>;
+
+  /// Empty when no free range is large enough, which may be the case even
+  /// with enough free bytes overall, see `Stats::fragmentation`.
+  [[nodiscard]] auto allocate(vk::DeviceSize size,
+                              vk::DeviceSize alignment = 16) noexcept
+      -> std::optional<Range>;
+
+  /// The GPU must be done with `range` before it is freed.
+  void free(const Range &range) noexcept;
+
+  [[nodiscard]] auto stats() const noexcept -> RangeAllocator::Stats {
+    return ranges.stats();
+  }
+
+  [[nodiscard]] auto getBuffer() const noexcept -> const AllocatedBuffer & {
+    return buffer;
+  }
+
+  [[nodiscard]] auto getAddress() const noexcept -> vk::DeviceAddress {
+    return address;
+  }
+
+private:
+  AllocatedBuffer buffer;
+  vk::DeviceAddress address;
+  RangeAllocator ranges;
+
+  MegaBuffer(AllocatedBuffer buffer, vk::DeviceAddress address,
+             vk::DeviceSize size) noexcept
+      : buffer(buffer), address(address), ranges(size) {}
+};
+
+} // namespace vkh
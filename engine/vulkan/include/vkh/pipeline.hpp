@@ -43,6 +43,8 @@ struct GraphicsPipelineConfig {
   vk::PipelineViewportStateCreateInfo viewport;
   vk::PipelineRasterizationStateCreateInfo rasterizer;
   vk::PipelineMultisampleStateCreateInfo multisampling;
+  /// Ignored unless `rendering` has a depth attachment format.
+  vk::PipelineDepthStencilStateCreateInfo depthStencil;
   std::vector<vk::PipelineColorBlendAttachmentState> blendAttachments;
   vk::PipelineColorBlendStateCreateInfo blending;
   DynamicStateInfo dynamicState;
@@ -73,6 +75,7 @@ struct GraphicsPipelineConfig {
         .pViewportState = &viewport,
         .pRasterizationState = &rasterizer,
         .pMultisampleState = &multisampling,
+        .pDepthStencilState = &depthStencil,
         .pColorBlendState = &blending,
         .pDynamicState = dynamicState,
         .layout = layout,
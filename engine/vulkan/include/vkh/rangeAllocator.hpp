@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+namespace vkh {
+
+/// Best fit free-list allocator over the range `[0, capacity)`.
+///
+/// It only does the bookkeeping, so it can sit on top of any buffer and be
+/// exercised without a GPU. Free ranges are indexed by offset for coalescing
+/// and by size for the best fit search, both in O(log n).
+class RangeAllocator {
+public:
+  struct Allocation {
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  struct Stats {
+    uint64_t capacity;
+    uint64_t used;
+    uint64_t free;
+    uint64_t largestFree;
+    uint32_t allocations;
+    uint32_t freeRanges;
+
+    /// 0 when all free space is one range, towards 1 as it splinters.
+    [[nodiscard]] auto fragmentation() const noexcept -> double {
+      return free == 0 ? 0.0
+                       : 1.0 - static_cast<double>(largestFree) /
+                                   static_cast<double>(free);
+    }
+  };
+
+  explicit RangeAllocator(uint64_t capacity) noexcept;
+
+  /// Reserves `size` bytes at an offset that is a multiple of `alignment`,
+  /// which must be a power of two. Padding in front of the offset stays
+  /// free. Empty when no free range fits.
+  [[nodiscard]] auto allocate(uint64_t size, uint64_t alignment = 1) noexcept
+      -> std::optional<Allocation>;
+
+  /// Returns an allocation, merging it with any free neighbours.
+  void free(const Allocation &allocation) noexcept;
+
+  [[nodiscard]] auto stats() const noexcept -> Stats;
+
+  [[nodiscard]] auto capacity() const noexcept -> uint64_t { return total; }
+
+private:
+  uint64_t total;
+  uint64_t used = 0;
+  uint32_t allocations = 0;
+
+  /// Offset to size.
+  std::map<uint64_t, uint64_t> byOffset;
+  /// (size, offset), so the smallest fitting range is a `lower_bound`.
+  std::set<std::pair<uint64_t, uint64_t>> bySize;
+
+  void insertFree(uint64_t offset, uint64_t size) noexcept;
+  void eraseFree(std::map<uint64_t, uint64_t>::iterator it) noexcept;
+};
+
+} // namespace vkh
@@ -64,5 +64,13 @@ public:
 
     return stages(shaderStages);
   }
+
+  [[nodiscard]] auto compute(const char *const fn = "main") const noexcept
+      -> vk::PipelineShaderStageCreateInfo {
+    return vk::PipelineShaderStageCreateInfo{
+        .stage = vk::ShaderStageFlagBits::eCompute,
+        .module = get(),
+        .pName = fn};
+  }
 };
 } // namespace vkh
@@ -9,7 +9,8 @@ namespace vkh {
 auto createInstance(vk::raii::Context &context, const char *appName,
                     const bool enableValidationLayers,
                     const std::span<const char *const> extraExtensions,
-                    const std::span<const char *const> extraLayers)
+                    const std::span<const char *const> extraLayers,
+                    const bool presentable)
     -> std::expected<vk::raii::Instance, std::string> {
   Logger::trace("Creating Instance");
   auto appInfo = vk::ApplicationInfo{
@@ -20,12 +21,14 @@ auto createInstance(vk::raii::Context &context, const char *appName,
       .apiVersion = vk::ApiVersion14,
   };
 
-  auto glfwExtCount = 0u;
-  auto glfwRequiredExtensions =
-      glfwGetRequiredInstanceExtensions(&glfwExtCount);
-
-  auto extensions = std::vector<const char *>(
-      glfwRequiredExtensions, glfwRequiredExtensions + glfwExtCount);
+  auto extensions = std::vector<const char *>{};
+  if (presentable) {
+    auto glfwExtCount = 0u;
+    auto glfwRequiredExtensions =
+        glfwGetRequiredInstanceExtensions(&glfwExtCount);
+    extensions.assign(glfwRequiredExtensions,
+                      glfwRequiredExtensions + glfwExtCount);
+  }
 
   extensions.insert(extensions.end(), extraExtensions.begin(),
                     extraExtensions.end());
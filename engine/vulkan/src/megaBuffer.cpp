@@ -0,0 +1,63 @@
+#include "vkh/megaBuffer.hpp"
+
+#include "vk-logger.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace vkh {
+
+auto MegaBuffer::create(const vk::raii::Device &device,
+                        vma::Allocator &allocator, vk::DeviceSize size,
+                        vk::BufferUsageFlags usage,
+                        std::span<const uint32_t> queueFamilies) noexcept
+    -> std::expected<MegaBuffer, std::string> {
+  std::vector<uint32_t> families(queueFamilies.begin(), queueFamilies.end());
+  std::ranges::sort(families);
+  families.erase(std::ranges::unique(families).begin(), families.end());
+  const auto concurrent = families.size() > 1;
+
+  auto buffer = AllocatedBuffer::create(
+      allocator,
+      vk::BufferCreateInfo{
+          .size = size,
+          .usage = usage | vk::BufferUsageFlagBits::eStorageBuffer |
+                   vk::BufferUsageFlagBits::eTransferDst |
+                   vk::BufferUsageFlagBits::eShaderDeviceAddress,
+          .sharingMode = concurrent ? vk::SharingMode::eConcurrent
+                                    : vk::SharingMode::eExclusive,
+          .queueFamilyIndexCount =
+              concurrent ? static_cast<uint32_t>(families.size()) : 0,
+          .pQueueFamilyIndices = concurrent ? families.data() : nullptr},
+      vma::AllocationCreateInfo{.usage = vma::MemoryUsage::eAutoPreferDevice});
+  if (!buffer) {
+    Logger::error("Failed to create mega buffer of {} bytes", size);
+    return std::unexpected(buffer.error());
+  }
+
+  const auto address = device.getBufferAddress(
+      vk::BufferDeviceAddressInfo{.buffer = buffer->buffer});
+
+  Logger::trace("Created mega buffer of {} bytes", size);
+
+  return MegaBuffer(*buffer, address, size);
+}
+
+auto MegaBuffer::allocate(vk::DeviceSize size,
+                          vk::DeviceSize alignment) noexcept
+    -> std::optional<Range> {
+  auto allocation = ranges.allocate(size, alignment);
+  if (!allocation) {
+    return std::nullopt;
+  }
+
+  return Range{.offset = allocation->offset,
+               .size = allocation->size,
+               .address = address + allocation->offset};
+}
+
+void MegaBuffer::free(const Range &range) noexcept {
+  ranges.free({.offset = range.offset, .size = range.size});
+}
+
+} // namespace vkh
@@ -0,0 +1,91 @@
+#include "vkh/rangeAllocator.hpp"
+
+#include <iterator>
+
+namespace vkh {
+
+RangeAllocator::RangeAllocator(uint64_t capacity) noexcept : total(capacity) {
+  if (capacity > 0) {
+    insertFree(0, capacity);
+  }
+}
+
+auto RangeAllocator::allocate(uint64_t size, uint64_t alignment) noexcept
+    -> std::optional<Allocation> {
+  if (size == 0) {
+    return std::nullopt;
+  }
+
+  // The smallest range of at least `size` bytes usually fits, alignment
+  // padding can push the fit to a larger one.
+  for (auto it = bySize.lower_bound({size, 0}); it != bySize.end(); ++it) {
+    const auto [rangeSize, rangeOffset] = *it;
+    const auto aligned = (rangeOffset + alignment - 1) & ~(alignment - 1);
+    const auto padding = aligned - rangeOffset;
+    if (padding + size > rangeSize) {
+      continue;
+    }
+
+    eraseFree(byOffset.find(rangeOffset));
+    if (padding > 0) {
+      insertFree(rangeOffset, padding);
+    }
+    if (padding + size < rangeSize) {
+      insertFree(aligned + size, rangeSize - padding - size);
+    }
+
+    used += size;
+    ++allocations;
+    return Allocation{.offset = aligned, .size = size};
+  }
+
+  return std::nullopt;
+}
+
+void RangeAllocator::free(const Allocation &allocation) noexcept {
+  auto offset = allocation.offset;
+  auto size = allocation.size;
+
+  auto next = byOffset.lower_bound(offset);
+  if (next != byOffset.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      offset = prev->first;
+      size += prev->second;
+      eraseFree(prev);
+    }
+  }
+
+  if (next != byOffset.end() && offset + size == next->first) {
+    size += next->second;
+    eraseFree(next);
+  }
+
+  insertFree(offset, size);
+  used -= allocation.size;
+  --allocations;
+}
+
+auto RangeAllocator::stats() const noexcept -> Stats {
+  return Stats{
+      .capacity = total,
+      .used = used,
+      .free = total - used,
+      .largestFree = bySize.empty() ? 0 : bySize.rbegin()->first,
+      .allocations = allocations,
+      .freeRanges = static_cast<uint32_t>(byOffset.size()),
+  };
+}
+
+void RangeAllocator::insertFree(uint64_t offset, uint64_t size) noexcept {
+  byOffset.emplace(offset, size);
+  bySize.emplace(size, offset);
+}
+
+void RangeAllocator::eraseFree(
+    std::map<uint64_t, uint64_t>::iterator it) noexcept {
+  bySize.erase({it->second, it->first});
+  byOffset.erase(it);
+}
+
+} // namespace vkh
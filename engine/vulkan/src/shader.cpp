@@ -1,6 +1,7 @@
 #include "vkh/shader.hpp"
 
 #include "vk-logger.hpp"
+#include <filesystem>
 #include <fstream>
 #include <vector>
 #include <vkh/macros.hpp>
@@ -25,6 +26,14 @@ auto getExecutablePath() -> std::string {
     return "";
   }
 
+#elif defined(__linux__)
+  std::error_code error;
+  const auto path = std::filesystem::read_symlink("/proc/self/exe", error);
+  if (error) {
+    return "";
+  }
+  return path.parent_path().string() + "/";
+
 #else
   static_assert(false, "Not implemented");
 #endif
@@ -8,6 +8,7 @@
 
 #include <engine/core.hpp>
 #include <engine/debug.hpp>
+#include <engine/trace.hpp>
 #include <engine/util/macros.hpp>
 #include <vkh/physicalDeviceSelector.hpp>
 #include <vkh/pipeline.hpp>
@@ -15,23 +16,76 @@
 
 #include <imgui/imgui.h>
 
+namespace {
+/// Frames a CPU trace captures, a few seconds.
+constexpr uint32_t TRACE_FRAMES = 300;
+constexpr const char *TRACE_PATH = "cpu_trace.json";
+/// In blocks, far enough to edit the ground from as high as the world goes.
+constexpr float EDIT_REACH = 256.0f;
+} // namespace
+
 void App::onWindowResize(engine::Dimensions dim) noexcept {
   Logger::info("Window resized to {}x{}", dim.width, dim.height);
   camera.camera.onResize(dim.width, dim.height);
 }
 
 App::TickResult App::update(float deltaTime) noexcept {
-  engine::FrameData frameData{
-      .deltaTimeMs = deltaTime,
-      .input = engine::Input::instance(),
-  };
+  const auto frameData =
+      flythrough.has_value() ? flythrough->advance(deltaTime)
+                             : engine::FrameData{
+                                   .deltaTime = deltaTime,
+                                   .input = engine::Input::instance(),
+                               };
 
   camera.camera.update(frameData);
+  edit(frameData.input);
+
+  if (traceFramesLeft != 0 && --traceFramesLeft == 0) {
+    engine::trace::stop();
+    if (auto written = engine::trace::write(TRACE_PATH); !written) {
+      Logger::error("Failed to write CPU trace: {}", written.error());
+    } else {
+      Logger::info("Wrote a CPU trace of {} frames to {}", TRACE_FRAMES,
+                   TRACE_PATH);
+    }
+  }
+
+  return TickResult::Success;
+}
+
+void App::edit(const engine::Input &input) noexcept {
+  const bool placing = input.isDown(engine::Key::E);
+  if (!placing && !input.isDown(engine::Key::Q)) {
+    return;
+  }
+  const auto picked = world.pick(camera.camera.getPosition(),
+                                 camera.camera.forward(), EDIT_REACH);
+  if (!picked) {
+    return;
+  }
+  if (!placing) {
+    world.setBlock(picked->block, engine::voxel::AIR);
+  } else if (picked->normal != glm::ivec3(0)) {
+    world.setBlock(picked->block + picked->normal,
+                   engine::voxel::blocks::TORCH);
+  }
+}
+
+App::TickResult App::tick(float tickSeconds) noexcept {
+  const engine::FrameData tickData{
+      .deltaTime = tickSeconds,
+      .input = flythrough.has_value() ? flythrough->getInput()
+                                      : engine::Input::instance(),
+  };
+
+  camera.camera.beginTick();
+  camera.camera.tick(tickData);
+  world.update(camera.camera.getPosition());
 
   return TickResult::Success;
 }
 
-App::TickResult App::render() noexcept {
+App::TickResult App::render(float interpolation) noexcept {
   auto res = newFrame();
   if (!res) {
     return res.error();
@@ -40,11 +94,51 @@ App::TickResult App::render() noexcept {
 
   auto &cmdBuffer = commandBuffers[fInfo.frameIndex];
 
+  // newFrame waited on this frame's fence, so its staging partition is free
+  // and what the GPU culled into its draw list can be read back.
+  staging.beginFrame(fInfo.frameIndex);
+  if (capture.has_value()) {
+    writeCapture(fInfo.frameIndex);
+  }
+
+  cullCounts = drawList.counts(fInfo.frameIndex);
+  checkCull(fInfo.frameIndex);
+
+  world.upload(staging, uploader, chunkBuffer,
+               [this](const vkh::MegaBuffer::Range &range) {
+                 destroyLater([this, range]() { chunkBuffer.free(range); },
+                              range.size);
+               });
+  // Ahead of this frame's submission, which waits on the batch.
+  if (auto submitted = uploader.submit(device); !submitted) {
+    Logger::error("Failed to submit chunk uploads: {}", submitted.error());
+    return TickResult::Bail;
+  }
+  const auto uploadWait = uploader.takeWait();
+
+  camera.camera.interpolate(interpolation);
   camera.camera.writeMatrices(camera.buffers, fInfo.frameIndex);
+  const auto viewProjection = camera.camera.matrices().viewProjection;
+  // Staged along with the meshes, so the flush below uploads them.
+  writeDraws(fInfo.frameIndex, viewProjection);
 
   cmdBuffer.begin(vk::CommandBufferBeginInfo{
       .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
 
+  // Reads back what this frame's slot timed the last time round.
+  profiler.beginFrame(cmdBuffer, fInfo.frameIndex);
+  const auto frameScope = profiler.begin(cmdBuffer, "Frame");
+
+  auto scope = profiler.begin(cmdBuffer, "Uploads");
+  staging.flush(cmdBuffer, fInfo.frameIndex);
+  profiler.end(cmdBuffer, scope);
+
+  scope = profiler.begin(cmdBuffer, "Cull");
+  cull(cmdBuffer, fInfo.frameIndex);
+  profiler.end(cmdBuffer, scope);
+
+  scope = profiler.begin(cmdBuffer, "Draw");
+
   engine::transitionImageLayout(
       cmdBuffer, renderImage.image, vk::ImageLayout::eUndefined,
       vk::ImageLayout::eColorAttachmentOptimal, {},
@@ -52,32 +146,69 @@ App::TickResult App::render() noexcept {
       vk::PipelineStageFlagBits2::eTopOfPipe,
       vk::PipelineStageFlagBits2::eColorAttachmentOutput);
 
-  vk::RenderingAttachmentInfo attachmentInfo{
-      .imageView = renderImage.view,
-      .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
-      .loadOp = vk::AttachmentLoadOp::eClear,
-      .storeOp = vk::AttachmentStoreOp::eStore,
-      .clearValue = vk::ClearValue{.color = {std::array<float, 4>{
-                                       0.0f,
-                                       0.0f,
-                                       0.0f,
-                                       1.0f,
-                                   }}}};
-
-  vk::RenderingInfo renderingInfo{
-      .renderArea = vk::Rect2D{.offset = {.x = 0, .y = 0},
-                               .extent = {.width = renderImage.extent.width,
-                                          .height = renderImage.extent.height}},
-      .layerCount = 1,
-      .colorAttachmentCount = 1,
-      .pColorAttachments = &attachmentInfo};
+  // The previous frame may still be testing against or reducing the depth.
+  engine::transitionImageLayout(
+      cmdBuffer, depthImage.image, vk::ImageLayout::eUndefined,
+      vk::ImageLayout::eDepthAttachmentOptimal,
+      vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+      vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+          vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+      vk::PipelineStageFlagBits2::eLateFragmentTests |
+          vk::PipelineStageFlagBits2::eComputeShader,
+      vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+          vk::PipelineStageFlagBits2::eLateFragmentTests,
+      vk::ImageAspectFlagBits::eDepth);
 
   Logger::trace("Beginning rendering");
-  cmdBuffer.beginRendering(renderingInfo);
-
-  draw(cmdBuffer, fInfo.frameIndex);
-
+  beginRendering(cmdBuffer, vk::AttachmentLoadOp::eClear);
+  draw(cmdBuffer, fInfo.frameIndex, ChunkDrawList::Phase::Early);
   cmdBuffer.endRendering();
+  profiler.end(cmdBuffer, scope);
+
+  if (gpuCulling && occlusionCulling) {
+    scope = profiler.begin(cmdBuffer, "Late cull");
+    engine::transitionImageLayout(
+        cmdBuffer, depthImage.image, vk::ImageLayout::eDepthAttachmentOptimal,
+        vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+        vk::AccessFlagBits2::eShaderSampledRead,
+        vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+            vk::PipelineStageFlagBits2::eLateFragmentTests,
+        vk::PipelineStageFlagBits2::eComputeShader,
+        vk::ImageAspectFlagBits::eDepth);
+
+    cullLate(cmdBuffer, fInfo.frameIndex, viewProjection);
+    profiler.end(cmdBuffer, scope);
+
+    engine::transitionImageLayout(
+        cmdBuffer, depthImage.image, vk::ImageLayout::eShaderReadOnlyOptimal,
+        vk::ImageLayout::eDepthAttachmentOptimal,
+        vk::AccessFlagBits2::eShaderSampledRead,
+        vk::AccessFlagBits2::eDepthStencilAttachmentRead |
+            vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+        vk::PipelineStageFlagBits2::eComputeShader,
+        vk::PipelineStageFlagBits2::eEarlyFragmentTests |
+            vk::PipelineStageFlagBits2::eLateFragmentTests,
+        vk::ImageAspectFlagBits::eDepth);
+
+    // Orders the late draws after the early ones.
+    engine::transitionImageLayout(
+        cmdBuffer, renderImage.image, vk::ImageLayout::eColorAttachmentOptimal,
+        vk::ImageLayout::eColorAttachmentOptimal,
+        vk::AccessFlagBits2::eColorAttachmentWrite,
+        vk::AccessFlagBits2::eColorAttachmentWrite,
+        vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+        vk::PipelineStageFlagBits2::eColorAttachmentOutput);
+
+    scope = profiler.begin(cmdBuffer, "Late draw");
+    beginRendering(cmdBuffer, vk::AttachmentLoadOp::eLoad);
+    draw(cmdBuffer, fInfo.frameIndex, ChunkDrawList::Phase::Late);
+    cmdBuffer.endRendering();
+    profiler.end(cmdBuffer, scope);
+  }
+
+  // Read once the frame retires, by `counts` and `checkCull`.
+  drawList.readBack(cmdBuffer, fInfo.frameIndex);
 
   engine::transitionImageLayout(
       cmdBuffer, renderImage.image, vk::ImageLayout::eColorAttachmentOptimal,
@@ -87,7 +218,50 @@ App::TickResult App::render() noexcept {
       vk::PipelineStageFlagBits2::eColorAttachmentOutput,
       vk::PipelineStageFlagBits2::eTransfer);
 
-  engine::transitionImageLayout(cmdBuffer, swapchain.images()[fInfo.imageIndex],
+  if (capture.has_value()) {
+    scope = profiler.begin(cmdBuffer, "Capture");
+    capture->record(cmdBuffer, renderImage.image, fInfo.frameIndex,
+                    frameNumber);
+    profiler.end(cmdBuffer, scope);
+  }
+
+  if (!isHeadless()) {
+    blitToSwapchain(cmdBuffer, fInfo.imageIndex);
+  }
+
+  profiler.end(cmdBuffer, frameScope);
+  cmdBuffer.end();
+
+  auto cmdBuf = static_cast<vk::CommandBuffer>(cmdBuffer);
+
+  std::span<const vk::SemaphoreSubmitInfo> waits;
+  if (uploadWait.has_value()) {
+    waits = {&uploadWait.value(), 1};
+  }
+
+  // Submitted whatever presenting returns.
+  const auto result = presentFrame(fInfo, {&cmdBuf, 1}, waits);
+  profiler.markSubmitted(fInfo.frameIndex);
+  if (frameLimit != 0 && frameNumber >= frameLimit) {
+    if (flythrough.has_value()) {
+      if (auto written = flythrough->writeReport(profiler.stats()); !written) {
+        Logger::error("Failed to write flythrough report: {}",
+                      written.error());
+      } else {
+        Logger::info("Wrote the flythrough report after {} frames",
+                     frameNumber);
+      }
+    }
+    requestClose();
+  }
+  return result;
+}
+
+void App::blitToSwapchain(vk::raii::CommandBuffer &cmdBuffer,
+                          uint32_t imageIndex) {
+  auto scope = profiler.begin(cmdBuffer, "Blit");
+
+  engine::transitionImageLayout(cmdBuffer, swapchain->images()[imageIndex],
                                 vk::ImageLayout::eUndefined,
                                 vk::ImageLayout::eTransferDstOptimal, {},
                                 vk::AccessFlagBits2::eTransferWrite,
@@ -120,8 +294,8 @@ App::TickResult App::render() noexcept {
       .dstOffsets = {{
           vk::Offset3D{.x = 0, .y = 0, .z = 0},
           vk::Offset3D{
-              .x = static_cast<int32_t>(swapchain.config().extent.width),
-              .y = static_cast<int32_t>(swapchain.config().extent.height),
+              .x = static_cast<int32_t>(swapchain->config().extent.width),
+              .y = static_cast<int32_t>(swapchain->config().extent.height),
               .z = 1,
           },
       }}};
@@ -129,7 +303,7 @@ App::TickResult App::render() noexcept {
   vk::BlitImageInfo2 blitInfo{
       .srcImage = renderImage.image,
       .srcImageLayout = vk::ImageLayout::eTransferSrcOptimal,
-      .dstImage = swapchain.images()[fInfo.imageIndex],
+      .dstImage = swapchain->images()[imageIndex],
       .dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
       .regionCount = 1,
       .pRegions = &blit,
@@ -137,15 +311,19 @@ App::TickResult App::render() noexcept {
   };
 
   cmdBuffer.blitImage2(blitInfo);
+  profiler.end(cmdBuffer, scope);
 
   {
     ImGui::ShowDemoWindow();
   }
 
   ui();
+  profilerUi();
+
+  scope = profiler.begin(cmdBuffer, "ImGui");
 
   engine::transitionImageLayout(
-      cmdBuffer, swapchain.images()[fInfo.imageIndex],
+      cmdBuffer, swapchain->images()[imageIndex],
       vk::ImageLayout::eTransferDstOptimal,
       vk::ImageLayout::eColorAttachmentOptimal,
       vk::AccessFlagBits2::eTransferWrite,
@@ -153,23 +331,178 @@ App::TickResult App::render() noexcept {
       vk::PipelineStageFlagBits2::eTransfer,
       vk::PipelineStageFlagBits2::eColorAttachmentOutput);
 
-  drawImGui(cmdBuffer, fInfo.imageIndex);
+  drawImGui(cmdBuffer, imageIndex);
+  profiler.end(cmdBuffer, scope);
 
   engine::transitionImageLayout(
-      cmdBuffer, swapchain.images()[fInfo.imageIndex],
+      cmdBuffer, swapchain->images()[imageIndex],
       vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR,
       vk::AccessFlagBits2::eColorAttachmentWrite, {},
       vk::PipelineStageFlagBits2::eColorAttachmentOutput,
       vk::PipelineStageFlagBits2::eBottomOfPipe);
+}
 
-  cmdBuffer.end();
+void App::writeCapture(uint32_t frameIndex) noexcept {
+  if (auto written = capture->write(frameIndex); !written) {
+    Logger::error("Failed to capture frame: {}", written.error());
+  }
+}
 
-  auto cmdBuf = static_cast<vk::CommandBuffer>(cmdBuffer);
+void App::checkCull(uint32_t frameIndex) noexcept {
+  auto &pending = cullChecks.pending[frameIndex];
+  if (!pending.has_value()) {
+    return;
+  }
+  cullChecks.last = drawList.checkCull(
+      frameIndex, engine::Frustum(pending->viewProjection), pending->eye,
+      pending->occlusion);
+  if (cullChecks.last.mismatches == 0) {
+    ++cullChecks.passed;
+  } else {
+    ++cullChecks.failed;
+    Logger::warn("GPU cull drew {} chunks, CPU reference {}, {} differ",
+                 cullChecks.last.gpuDraws, cullChecks.last.cpuDraws,
+                 cullChecks.last.mismatches);
+  }
+  pending = std::nullopt;
+}
+
+auto App::finishCullChecks() noexcept -> bool {
+  device.waitIdle();
+  // Frames still in flight, oldest first.
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    checkCull((currentFrame + i) % MAX_FRAMES_IN_FLIGHT);
+  }
+  Logger::info("Checked the GPU cull of {} frames, {} failed",
+               cullChecks.passed + cullChecks.failed, cullChecks.failed);
+  return cullChecks.passed != 0 && cullChecks.failed == 0;
+}
+
+void App::writeDraws(uint32_t frameIndex, const glm::mat4 &viewProjection) {
+  std::optional<glm::vec3> eye;
+  if (faceCulling) {
+    eye = camera.camera.eye();
+  }
+
+  if (!gpuCulling) {
+    drawCount = drawList
+                    .writeVisible(staging, frameIndex, world.meshes(),
+                                  engine::Frustum(viewProjection), eye)
+                    .value_or(0);
+    return;
+  }
+
+  std::optional<ChunkDrawList::Occlusion> occlusion;
+  if (occlusionCulling) {
+    const auto &extent = depthPyramid.getImage().extent;
+    occlusion = ChunkDrawList::Occlusion{
+        .previousViewProjection = pyramidViewProjection,
+        .pyramidSize = {.width = extent.width, .height = extent.height},
+        .pyramidLevels = depthPyramid.levelCount(),
+        .previousPyramid = depthPyramid.isBuilt(),
+    };
+  }
 
-  return presentFrame(fInfo, {&cmdBuf, 1});
+  const auto written = drawList.writeCandidates(
+      staging, frameIndex, world.meshes(), faceCulling, occlusion);
+  drawCount = written.value_or(0);
+  if (cullChecks.enabled && written.has_value()) {
+    cullChecks.pending[frameIndex] =
+        CullChecks::Pending{.viewProjection = viewProjection,
+                            .eye = eye,
+                            .occlusion = occlusionCulling};
+  }
 }
 
-void App::draw(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex) {
+void App::cull(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex) {
+  if (!gpuCulling) {
+    return;
+  }
+
+  depthPyramid.prepare(cmdBuffer);
+  dispatchCull(cmdBuffer, frameIndex, pipelines::Cull::Phase::Early);
+}
+
+void App::cullLate(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+                   const glm::mat4 &viewProjection) {
+  depthPyramid.build(cmdBuffer, depthReducePipeline);
+  pyramidViewProjection = viewProjection;
+
+  dispatchCull(cmdBuffer, frameIndex, pipelines::Cull::Phase::Late);
+}
+
+void App::dispatchCull(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+                       pipelines::Cull::Phase phase) {
+  cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, cullPipeline);
+  cmdBuffer.bindDescriptorSets(
+      vk::PipelineBindPoint::eCompute, cullPipeline.getLayout(), 0,
+      {camera.buffers.descriptorSets[frameIndex],
+       depthPyramid.getSampleSet()},
+      nullptr);
+
+  pipelines::Cull::CullPushConstants pc{
+      .frameAddress = drawList.frameAddress(frameIndex),
+      .phase = phase,
+  };
+  cmdBuffer.pushConstants<pipelines::Cull::CullPushConstants>(
+      *cullPipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, pc);
+
+  // The late phase only retests some candidates, but how many is only known
+  // on the GPU.
+  cmdBuffer.dispatch((drawCount + pipelines::Cull::WORKGROUP_SIZE - 1) /
+                         pipelines::Cull::WORKGROUP_SIZE,
+                     1, 1);
+
+  // The late phase reads the retests the early phase appended.
+  vk::MemoryBarrier2 barrier{
+      .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eDrawIndirect |
+                      vk::PipelineStageFlagBits2::eVertexShader |
+                      vk::PipelineStageFlagBits2::eComputeShader,
+      .dstAccessMask = vk::AccessFlagBits2::eIndirectCommandRead |
+                       vk::AccessFlagBits2::eShaderStorageRead};
+  cmdBuffer.pipelineBarrier2(
+      vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &barrier});
+}
+
+void App::beginRendering(vk::raii::CommandBuffer &cmdBuffer,
+                         vk::AttachmentLoadOp loadOp) {
+  vk::RenderingAttachmentInfo attachmentInfo{
+      .imageView = renderImage.view,
+      .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+      .loadOp = loadOp,
+      .storeOp = vk::AttachmentStoreOp::eStore,
+      .clearValue = vk::ClearValue{.color = {std::array<float, 4>{
+                                       0.0f,
+                                       0.0f,
+                                       0.0f,
+                                       1.0f,
+                                   }}}};
+
+  // Reverse Z, cleared to the far plane.
+  vk::RenderingAttachmentInfo depthInfo{
+      .imageView = depthImage.view,
+      .imageLayout = vk::ImageLayout::eDepthAttachmentOptimal,
+      .loadOp = loadOp,
+      .storeOp = vk::AttachmentStoreOp::eStore,
+      .clearValue = vk::ClearValue{
+          .depthStencil = {.depth = 0.0f, .stencil = 0}}};
+
+  vk::RenderingInfo renderingInfo{
+      .renderArea = vk::Rect2D{.offset = {.x = 0, .y = 0},
+                               .extent = {.width = renderImage.extent.width,
+                                          .height = renderImage.extent.height}},
+      .layerCount = 1,
+      .colorAttachmentCount = 1,
+      .pColorAttachments = &attachmentInfo,
+      .pDepthAttachment = &depthInfo};
+
+  cmdBuffer.beginRendering(renderingInfo);
+}
+
+void App::draw(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+               ChunkDrawList::Phase phase) {
   cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
 
   setupCmdBuffer(cmdBuffer);
@@ -179,14 +512,13 @@ void App::draw(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex) {
       {camera.buffers.descriptorSets[frameIndex]}, nullptr);
 
   pipelines::Mesh::MeshPushConstants pc{
-      .modelMatrix = glm::mat4(1.0f),
-      .vBufferAddress = vertexBufferAddress,
+      .drawsAddress = drawList.drawsAddress(frameIndex, phase),
   };
 
   cmdBuffer.pushConstants<pipelines::Mesh::MeshPushConstants>(
       *pipeline.getLayout(), vk::ShaderStageFlagBits::eVertex, 0, pc);
 
-  cmdBuffer.draw(4, 1, 0, 0);
+  drawList.draw(cmdBuffer, frameIndex, phase);
 }
 
 void App::ui() {
@@ -199,5 +531,102 @@ void App::ui() {
   ImGui::Text("Camera rotation: (Yaw: %.2f, Pitch: %.2f)",
               camera.camera.getRotation().yaw,
               camera.camera.getRotation().pitch);
+  ImGui::Text("Ticks: %llu at %d Hz, %llu dropped",
+              static_cast<unsigned long long>(timestep.getTicks()), TICK_RATE,
+              static_cast<unsigned long long>(timestep.getDroppedTicks()));
+
+  if (traceFramesLeft != 0) {
+    ImGui::Text("Capturing CPU trace, %u frames left", traceFramesLeft);
+  } else if (ImGui::Button("Capture CPU trace")) {
+    engine::trace::start();
+    traceFramesLeft = TRACE_FRAMES;
+  }
+
+  const auto worldStats = world.stats();
+  ImGui::Text("World: %u columns, %u generating, %u lighting, %u meshing, "
+              "%u uploading, %u saving, %u patched",
+              worldStats.columns, worldStats.generating, worldStats.lighting,
+              worldStats.meshing, worldStats.uploading, worldStats.saving,
+              worldStats.patched);
+  ImGui::Text("Tiles drawn by level: %u, %u, %u, %u", worldStats.tiles[0],
+              worldStats.tiles[1], worldStats.tiles[2], worldStats.tiles[3]);
+
+  const auto &uploads = staging.lastFrameStats();
+  ImGui::Text("Uploaded: %.1f KiB in %u uploads, %u copies (%u deferred), "
+              "%.1f KiB copied on the GPU",
+              static_cast<double>(uploads.bytes) / 1024.0, uploads.uploads,
+              uploads.copyCommands, uploads.rejected,
+              static_cast<double>(uploads.copiedBytes) / 1024.0);
+
+  ImGui::Checkbox("Face culling", &faceCulling);
+  const auto submittedShare =
+      cullCounts.candidateQuads == 0
+          ? 0.0
+          : static_cast<double>(cullCounts.submittedQuads) /
+                static_cast<double>(cullCounts.candidateQuads);
+  ImGui::Text("Quads: %u submitted of %u (%.0f%%)", cullCounts.submittedQuads,
+              cullCounts.candidateQuads, submittedShare * 100.0);
+
+  ImGui::Checkbox("GPU culling", &gpuCulling);
+  if (gpuCulling) {
+    ImGui::Checkbox("Occlusion culling", &occlusionCulling);
+    ImGui::Text("Chunks: %u candidates of %zu meshes", drawCount,
+                world.meshes().size());
+    ImGui::Text("Draws: %u early, %u late, %u chunks retested",
+                cullCounts.draws, cullCounts.lateDraws, cullCounts.retests);
+    ImGui::Checkbox("Check GPU culling", &cullChecks.enabled);
+    if (cullChecks.enabled) {
+      ImGui::Text("Cull checks: %u passed, %u failed (last %u GPU, %u CPU, "
+                  "%u occluded)",
+                  cullChecks.passed, cullChecks.failed,
+                  cullChecks.last.gpuDraws, cullChecks.last.cpuDraws,
+                  cullChecks.last.occluded);
+    }
+  } else {
+    ImGui::Text("Chunks: %u drawn of %zu meshes", drawCount,
+                world.meshes().size());
+  }
+
+  const auto chunkMemory = chunkBuffer.stats();
+  ImGui::Text("Chunk buffer: %.1f / %.1f MiB in %u ranges, %.0f%% fragmented",
+              static_cast<double>(chunkMemory.used) / (1024.0 * 1024.0),
+              static_cast<double>(chunkMemory.capacity) / (1024.0 * 1024.0),
+              chunkMemory.allocations, chunkMemory.fragmentation() * 100.0);
+
+  const auto &deletions = getDeletionQueue();
+  ImGui::Text("Pending deletion: %zu objects, %.1f KiB", deletions.depth(),
+              static_cast<double>(deletions.pendingBytes()) / 1024.0);
+  ImGui::End();
+}
+
+void App::profilerUi() {
+  ImGui::Begin("GPU");
+  if (!profiler.isEnabled()) {
+    ImGui::Text("No timestamps on the graphics queue");
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("Over the last %u frames, a frame behind",
+              engine::GpuProfiler::HISTORY);
+  if (ImGui::BeginTable("Passes", 5,
+                        ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+    ImGui::TableSetupColumn("Pass");
+    ImGui::TableSetupColumn("Last ms");
+    ImGui::TableSetupColumn("Min ms");
+    ImGui::TableSetupColumn("Avg ms");
+    ImGui::TableSetupColumn("Max ms");
+    ImGui::TableHeadersRow();
+    for (const auto &pass : profiler.stats()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::Text("%*s%s", static_cast<int>(pass.depth * 2), "", pass.name);
+      for (const auto value : {pass.last, pass.min, pass.avg, pass.max}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f", static_cast<double>(value));
+      }
+    }
+    ImGui::EndTable();
+  }
   ImGui::End();
 }
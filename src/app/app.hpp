@@ -1,29 +1,92 @@
 #pragma once
 
+#include "app/depthPyramid.hpp"
+#include "app/draws.hpp"
+#include "app/flythrough.hpp"
+#include "app/world.hpp"
 #include "camera.hpp"
 #include "pipelines/pipelines.hpp"
 #include <engine/app.hpp>
+#include <engine/frameCapture.hpp>
+#include <engine/gpuProfiler.hpp>
+#include <engine/staging.hpp>
+#include <engine/uploader.hpp>
+#include <vkh/megaBuffer.hpp>
+
+#include <filesystem>
+#include <optional>
 
 class App : public engine::App {
 public:
-  static auto create() noexcept -> std::expected<App, std::string>;
+  struct Options {
+    /// Renders offscreen with no window, swapchain or UI, on any device with
+    /// a graphics queue, software ones included.
+    bool headless = false;
+    /// Frames rendered before closing, zero to run until the window closes.
+    uint64_t frames = 0;
+    /// Writes every frame rendered here as a PPM image when set.
+    std::optional<std::filesystem::path> captureDirectory;
+    /// Replays the scripted `Flythrough` instead of following input and
+    /// writes its report here when set. The world is then never saved or
+    /// loaded, and `frames` is the length of the path.
+    std::optional<std::filesystem::path> flythroughReport;
+    /// Compares the GPU cull of every frame with `engine::Frustum`, see
+    /// `finishCullChecks`.
+    bool checkCull = false;
+  };
+
+  static auto create(const Options &options) noexcept
+      -> std::expected<App, std::string>;
 
   App() = delete;
   App(const App &) = delete;
   App(App &&) = default;
 
+  /// Looks around and takes the edit keys: E places a torch against the
+  /// block looked at, Q breaks it.
   TickResult update(float deltaTime) noexcept override;
-  TickResult render() noexcept override;
-  void draw(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex);
+  /// Flies the camera and streams the world around it.
+  TickResult tick(float tickSeconds) noexcept override;
+  TickResult render(float interpolation) noexcept override;
+  /// Stages the frame's cull candidates, or culls on the CPU and stages the
+  /// draws. Ahead of the staging flush.
+  void writeDraws(uint32_t frameIndex, const glm::mat4 &viewProjection);
+  /// Records the early cull phase when culling on the GPU.
+  void cull(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex);
+  /// Builds the depth pyramid from the early draws and records the late cull
+  /// phase against it. The depth image must be in the shader read only
+  /// layout.
+  void cullLate(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+                const glm::mat4 &viewProjection);
+  void dispatchCull(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+                    pipelines::Cull::Phase phase);
+  void beginRendering(vk::raii::CommandBuffer &cmdBuffer,
+                      vk::AttachmentLoadOp loadOp);
+  void draw(vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+            ChunkDrawList::Phase phase);
   void ui();
+  /// GPU time of each profiled pass.
+  void profilerUi();
 
   void onWindowResize(engine::Dimensions dim) noexcept override;
 
+  /// Waits for the frames in flight and checks their cull too. True if at
+  /// least one frame's GPU cull was checked and none differed from
+  /// `engine::Frustum`. Call once the app stopped running.
+  [[nodiscard]] auto finishCullChecks() noexcept -> bool;
+
   ~App() override {
     if (moveGuard.moved())
       return;
 
     device.waitIdle();
+    // Frames still in flight, oldest first.
+    for (uint32_t i = 0; capture.has_value() && i < MAX_FRAMES_IN_FLIGHT;
+         ++i) {
+      writeCapture((currentFrame + i) % MAX_FRAMES_IN_FLIGHT);
+    }
+    // Pending releases may point into members destroyed before the base.
+    deletionQueue.flush(allocator, device);
   }
 
 protected:
@@ -35,36 +98,119 @@ protected:
 
   App(engine::rendering::Core &&core, vk::raii::PhysicalDevice &&physicalDevice,
       vk::raii::Device &&device, vma::Allocator allocator, Queues &&queues,
-      vkh::Swapchain &&swapchain, vkh::AllocatedImage &&renderImage,
-      vk::raii::CommandPool &&commandPool,
+      std::optional<vkh::Swapchain> &&swapchain,
+      vkh::AllocatedImage &&renderImage, vk::raii::CommandPool &&commandPool,
       std::array<engine::SyncObjects, MAX_FRAMES_IN_FLIGHT> &&syncObjects,
       engine::ImGuiVkObjects &&imGuiObjects,
       std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers,
       CameraObjects camera, pipelines::Mesh greedyPipeline,
-      vkh::AllocatedBuffer vertexBuffer) noexcept
+      pipelines::Cull cullPipeline, pipelines::DepthReduce depthReducePipeline,
+      vkh::AllocatedImage depthImage, DepthPyramid depthPyramid,
+      vkh::MegaBuffer chunkBuffer, const World::Settings &worldSettings,
+      ChunkDrawList drawList, engine::StagingRing staging,
+      engine::AsyncUploader uploader, engine::GpuProfiler profiler,
+      uint64_t frameLimit, std::optional<engine::FrameCapture> capture,
+      std::optional<Flythrough> flythrough, bool checkCull) noexcept
       : engine::App(std::move(core), std::move(physicalDevice),
                     std::move(device), allocator, std::move(queues),
                     std::move(swapchain), std::move(renderImage),
                     std::move(commandPool), std::move(syncObjects),
                     std::move(imGuiObjects)),
         commandBuffers(std::move(commandBuffers)), camera(std::move(camera)),
-        pipeline(std::move(greedyPipeline)), vertexBuffer(vertexBuffer) {
-    vk::BufferDeviceAddressInfo bufferAddressInfo{.buffer =
-                                                      vertexBuffer.buffer};
-
-    vertexBufferAddress = this->device.getBufferAddress(bufferAddressInfo);
-
-    registerBuffer(this->vertexBuffer);
+        pipeline(std::move(greedyPipeline)),
+        cullPipeline(std::move(cullPipeline)),
+        depthReducePipeline(std::move(depthReducePipeline)),
+        depthImage(depthImage), depthPyramid(std::move(depthPyramid)),
+        chunkBuffer(std::move(chunkBuffer)), world(*jobs, worldSettings),
+        drawList(std::move(drawList)),
+        staging(std::move(staging)), uploader(std::move(uploader)),
+        profiler(std::move(profiler)), frameLimit(frameLimit),
+        capture(std::move(capture)), flythrough(std::move(flythrough)) {
+    registerImage(this->depthImage);
+    registerImage(this->depthPyramid.getImage());
+    registerBuffer(this->chunkBuffer.getBuffer());
+    for (const auto &buf : this->drawList.getBuffers()) {
+      registerBuffer(buf);
+    }
+    for (const auto &buf : this->drawList.getReadbacks()) {
+      registerBuffer(buf);
+    }
+    registerBuffer(this->staging.getBuffer());
+    registerBuffer(this->uploader.getStaging().getBuffer());
     for (auto &buf : this->camera.buffers.uniformBuffers) {
       registerBuffer(buf);
     }
+    if (this->capture.has_value()) {
+      registerBuffer(this->capture->getBuffer());
+    }
+    if (this->flythrough.has_value()) {
+      timestep.lockFrameTime(Flythrough::FRAME_TIME);
+    }
+    cullChecks.enabled = checkCull;
   }
 
+  /// Copies the swapchain image `imageIndex` over from the render image,
+  /// which must be in the transfer source layout, and draws ImGui on top.
+  void blitToSwapchain(vk::raii::CommandBuffer &cmdBuffer, uint32_t imageIndex);
+  /// Writes out what `frameIndex` last captured, once its fence was waited
+  /// on.
+  void writeCapture(uint32_t frameIndex) noexcept;
+  /// Compares what `frameIndex` last culled on the GPU with the CPU, if a
+  /// check is due, once its fence was waited on.
+  void checkCull(uint32_t frameIndex) noexcept;
+  /// Places or breaks the block looked at if an edit key went down.
+  void edit(const engine::Input &input) noexcept;
+
   std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers;
 
   CameraObjects camera;
 
   pipelines::Mesh pipeline;
-  vkh::AllocatedBuffer vertexBuffer;
-  vk::DeviceAddress vertexBufferAddress = 0;
+  pipelines::Cull cullPipeline;
+  pipelines::DepthReduce depthReducePipeline;
+  vkh::AllocatedImage depthImage;
+  DepthPyramid depthPyramid;
+  /// What the pyramid was last built with.
+  glm::mat4 pyramidViewProjection{1.0f};
+  vkh::MegaBuffer chunkBuffer;
+  World world;
+  ChunkDrawList drawList;
+  /// Candidates when culling on the GPU, draws when culling on the CPU.
+  uint32_t drawCount = 0;
+
+  struct CullChecks {
+    struct Pending {
+      glm::mat4 viewProjection;
+      std::optional<glm::vec3> eye;
+      bool occlusion;
+    };
+
+    /// Compare the GPU cull with `engine::Frustum` once each frame retires.
+    bool enabled = false;
+    /// How each frame was culled, while a check is due.
+    std::array<std::optional<Pending>, MAX_FRAMES_IN_FLIGHT> pending{};
+    uint32_t passed = 0;
+    uint32_t failed = 0;
+    ChunkDrawList::CullCheck last{};
+  };
+
+  /// Skip chunk faces pointing away from the camera.
+  bool faceCulling = true;
+  bool gpuCulling = true;
+  /// Only with GPU culling.
+  bool occlusionCulling = true;
+  /// Of the last retired frame.
+  ChunkDrawList::Counts cullCounts{};
+  CullChecks cullChecks;
+
+  /// Frames a CPU trace still records for, zero when not capturing.
+  uint32_t traceFramesLeft = 0;
+
+  engine::StagingRing staging;
+  engine::AsyncUploader uploader;
+  engine::GpuProfiler profiler;
+  /// Zero to run until the window closes.
+  uint64_t frameLimit;
+  std::optional<engine::FrameCapture> capture;
+  std::optional<Flythrough> flythrough;
 };
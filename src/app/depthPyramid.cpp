@@ -0,0 +1,265 @@
+#include "app/depthPyramid.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include <engine/util/macros.hpp>
+
+namespace {
+
+auto levelExtent(vk::Extent2D base, uint32_t level) noexcept -> vk::Extent2D {
+  return vk::Extent2D{.width = std::max(base.width >> level, 1u),
+                      .height = std::max(base.height >> level, 1u)};
+}
+
+} // namespace
+
+auto DepthPyramid::reduceLayout(const vk::raii::Device &device) noexcept
+    -> std::expected<vk::raii::DescriptorSetLayout, std::string> {
+  std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+      vk::DescriptorSetLayoutBinding{
+          .binding = 0,
+          .descriptorType = vk::DescriptorType::eSampledImage,
+          .descriptorCount = 1,
+          .stageFlags = vk::ShaderStageFlagBits::eCompute},
+      vk::DescriptorSetLayoutBinding{
+          .binding = 1,
+          .descriptorType = vk::DescriptorType::eStorageImage,
+          .descriptorCount = 1,
+          .stageFlags = vk::ShaderStageFlagBits::eCompute}};
+
+  VK_MAKE(layout,
+          device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+              .bindingCount = static_cast<uint32_t>(bindings.size()),
+              .pBindings = bindings.data()}),
+          "Failed to create depth reduce descriptor layout");
+
+  return std::move(layout);
+}
+
+auto DepthPyramid::sampleLayout(const vk::raii::Device &device) noexcept
+    -> std::expected<vk::raii::DescriptorSetLayout, std::string> {
+  vk::DescriptorSetLayoutBinding binding{
+      .binding = 0,
+      .descriptorType = vk::DescriptorType::eSampledImage,
+      .descriptorCount = 1,
+      .stageFlags = vk::ShaderStageFlagBits::eCompute};
+
+  VK_MAKE(layout,
+          device.createDescriptorSetLayout(vk::DescriptorSetLayoutCreateInfo{
+              .bindingCount = 1, .pBindings = &binding}),
+          "Failed to create depth pyramid descriptor layout");
+
+  return std::move(layout);
+}
+
+auto DepthPyramid::create(
+    const vk::raii::Device &device, vma::Allocator &allocator,
+    const vkh::AllocatedImage &depth,
+    const vk::raii::DescriptorSetLayout &reduceLayout,
+    const vk::raii::DescriptorSetLayout &sampleLayout) noexcept
+    -> std::expected<DepthPyramid, std::string> {
+  const vk::Extent2D extent{.width = depth.extent.width,
+                            .height = depth.extent.height};
+  const auto levels = static_cast<uint32_t>(
+      std::bit_width(std::max(extent.width, extent.height)));
+
+  vk::ImageCreateInfo imageCreateInfo{
+      .imageType = vk::ImageType::e2D,
+      .format = FORMAT,
+      .extent = vk::Extent3D{.width = extent.width,
+                             .height = extent.height,
+                             .depth = 1},
+      .mipLevels = levels,
+      .arrayLayers = 1,
+      .samples = vk::SampleCountFlagBits::e1,
+      .tiling = vk::ImageTiling::eOptimal,
+      .usage = vk::ImageUsageFlagBits::eStorage |
+               vk::ImageUsageFlagBits::eSampled,
+      .sharingMode = vk::SharingMode::eExclusive,
+      .initialLayout = vk::ImageLayout::eUndefined};
+
+  VMA_MAKE(imagePair,
+           allocator.createImage(imageCreateInfo,
+                                 vma::AllocationCreateInfo{
+                                     .usage = vma::MemoryUsage::eGpuOnly}),
+           "Failed to create depth pyramid image");
+
+  auto viewInfo = [&](uint32_t baseLevel, uint32_t levelCount) {
+    return vk::ImageViewCreateInfo{
+        .image = imagePair.first,
+        .viewType = vk::ImageViewType::e2D,
+        .format = FORMAT,
+        .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                             .baseMipLevel = baseLevel,
+                             .levelCount = levelCount,
+                             .baseArrayLayer = 0,
+                             .layerCount = 1}};
+  };
+
+  VK_MAKE(fullView, device.createImageView(viewInfo(0, levels)),
+          "Failed to create depth pyramid view");
+
+  std::vector<vk::raii::ImageView> levelViews;
+  levelViews.reserve(levels);
+  for (uint32_t level = 0; level < levels; ++level) {
+    VK_MAKE(levelView, device.createImageView(viewInfo(level, 1)),
+            "Failed to create depth pyramid level view");
+    levelViews.push_back(std::move(levelView));
+  }
+
+  std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+      vk::DescriptorPoolSize{.type = vk::DescriptorType::eSampledImage,
+                             .descriptorCount = levels + 1},
+      vk::DescriptorPoolSize{.type = vk::DescriptorType::eStorageImage,
+                             .descriptorCount = levels}};
+  VK_MAKE(pool,
+          device.createDescriptorPool(vk::DescriptorPoolCreateInfo{
+              .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+              .maxSets = levels + 1,
+              .poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+              .pPoolSizes = poolSizes.data()}),
+          "Failed to create depth pyramid descriptor pool");
+
+  std::vector<vk::DescriptorSetLayout> reduceLayouts(levels, *reduceLayout);
+  VK_MAKE(reduceSets,
+          device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+              .descriptorPool = *pool,
+              .descriptorSetCount = levels,
+              .pSetLayouts = reduceLayouts.data()}),
+          "Failed to allocate depth reduce descriptor sets");
+
+  VK_MAKE(sampleSets,
+          device.allocateDescriptorSets(vk::DescriptorSetAllocateInfo{
+              .descriptorPool = *pool,
+              .descriptorSetCount = 1,
+              .pSetLayouts = &*sampleLayout}),
+          "Failed to allocate depth pyramid descriptor set");
+
+  for (uint32_t level = 0; level < levels; ++level) {
+    vk::DescriptorImageInfo source =
+        level == 0
+            ? vk::DescriptorImageInfo{.imageView = depth.view,
+                                      .imageLayout = vk::ImageLayout::
+                                          eShaderReadOnlyOptimal}
+            : vk::DescriptorImageInfo{.imageView = *levelViews[level - 1],
+                                      .imageLayout = vk::ImageLayout::eGeneral};
+    vk::DescriptorImageInfo target{.imageView = *levelViews[level],
+                                   .imageLayout = vk::ImageLayout::eGeneral};
+
+    std::array<vk::WriteDescriptorSet, 2> writes = {
+        vk::WriteDescriptorSet{
+            .dstSet = *reduceSets[level],
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eSampledImage,
+            .pImageInfo = &source},
+        vk::WriteDescriptorSet{
+            .dstSet = *reduceSets[level],
+            .dstBinding = 1,
+            .descriptorCount = 1,
+            .descriptorType = vk::DescriptorType::eStorageImage,
+            .pImageInfo = &target}};
+    device.updateDescriptorSets(writes, {});
+  }
+
+  vk::DescriptorImageInfo pyramidInfo{.imageView = *fullView,
+                                      .imageLayout = vk::ImageLayout::eGeneral};
+  vk::WriteDescriptorSet pyramidWrite{
+      .dstSet = *sampleSets[0],
+      .dstBinding = 0,
+      .descriptorCount = 1,
+      .descriptorType = vk::DescriptorType::eSampledImage,
+      .pImageInfo = &pyramidInfo};
+  device.updateDescriptorSets(pyramidWrite, {});
+
+  Logger::trace("Created depth pyramid of {}x{} with {} levels", extent.width,
+                extent.height, levels);
+
+  return DepthPyramid(
+      vkh::AllocatedImage{.image = imagePair.first,
+                          .view = fullView.release(),
+                          .alloc = imagePair.second,
+                          .extent = imageCreateInfo.extent,
+                          .format = FORMAT},
+      extent, std::move(levelViews), std::move(pool), std::move(reduceSets),
+      std::move(sampleSets[0]));
+}
+
+void DepthPyramid::prepare(const vk::raii::CommandBuffer &cmdBuffer) noexcept {
+  if (prepared) {
+    return;
+  }
+
+  vk::ImageMemoryBarrier2 toGeneral{
+      .srcStageMask = vk::PipelineStageFlagBits2::eNone,
+      .srcAccessMask = {},
+      .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead |
+                       vk::AccessFlagBits2::eShaderStorageWrite,
+      .oldLayout = vk::ImageLayout::eUndefined,
+      .newLayout = vk::ImageLayout::eGeneral,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image.image,
+      .subresourceRange = {.aspectMask = vk::ImageAspectFlagBits::eColor,
+                           .baseMipLevel = 0,
+                           .levelCount = levelCount(),
+                           .baseArrayLayer = 0,
+                           .layerCount = 1}};
+  cmdBuffer.pipelineBarrier2(vk::DependencyInfo{
+      .imageMemoryBarrierCount = 1, .pImageMemoryBarriers = &toGeneral});
+
+  prepared = true;
+}
+
+void DepthPyramid::build(const vk::raii::CommandBuffer &cmdBuffer,
+                         const pipelines::DepthReduce &pipeline) noexcept {
+  prepare(cmdBuffer);
+
+  // The cull shaders may still be reading the previous pyramid.
+  vk::MemoryBarrier2 readsDone{
+      .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .srcAccessMask = vk::AccessFlagBits2::eShaderSampledRead,
+      .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+      .dstAccessMask = vk::AccessFlagBits2::eShaderStorageWrite};
+  cmdBuffer.pipelineBarrier2(vk::DependencyInfo{
+      .memoryBarrierCount = 1, .pMemoryBarriers = &readsDone});
+
+  cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+
+  for (uint32_t level = 0; level < levelCount(); ++level) {
+    const auto source =
+        level == 0 ? depthExtent : levelExtent(depthExtent, level - 1);
+    const auto target = levelExtent(depthExtent, level);
+
+    cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute,
+                                 pipeline.getLayout(), 0, {reduceSets[level]},
+                                 nullptr);
+
+    pipelines::DepthReduce::ReducePushConstants pc{
+        .sourceSize = source,
+        .targetSize = target,
+        .fromDepth = level == 0 ? 1u : 0u,
+    };
+    cmdBuffer.pushConstants<pipelines::DepthReduce::ReducePushConstants>(
+        *pipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, pc);
+
+    constexpr auto GROUP = pipelines::DepthReduce::WORKGROUP_SIZE;
+    cmdBuffer.dispatch((target.width + GROUP - 1) / GROUP,
+                       (target.height + GROUP - 1) / GROUP, 1);
+
+    vk::MemoryBarrier2 barrier{
+        .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead};
+    cmdBuffer.pipelineBarrier2(vk::DependencyInfo{.memoryBarrierCount = 1,
+                                                  .pMemoryBarriers = &barrier});
+  }
+
+  built = true;
+}
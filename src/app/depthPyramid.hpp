@@ -0,0 +1,91 @@
+#pragma once
+
+#include "pipelines/pipelines.hpp"
+
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+
+#include <vk_mem_alloc.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+/// Min/max mip chain of a depth image for occlusion culling.
+///
+/// Level 0 matches the depth image and each level after halves it, rounding
+/// down. A texel covers the 2x2 texels below it, plus the last row or column
+/// when the level below has an odd size, so `texel >> level`, clamped to the
+/// level, always covers `texel`. Red holds the smallest depth, the farthest
+/// with reverse Z, green the largest.
+///
+/// The pyramid stays in the general layout.
+class DepthPyramid {
+public:
+  static constexpr vk::Format FORMAT = vk::Format::eR32G32Sfloat;
+
+  /// Layout of each reduction step, the source level as a sampled image at
+  /// binding 0 and the target level as a storage image at binding 1.
+  static auto reduceLayout(const vk::raii::Device &device) noexcept
+      -> std::expected<vk::raii::DescriptorSetLayout, std::string>;
+
+  /// Layout the cull shader reads the pyramid through, every level as one
+  /// sampled image at binding 0.
+  static auto sampleLayout(const vk::raii::Device &device) noexcept
+      -> std::expected<vk::raii::DescriptorSetLayout, std::string>;
+
+  static auto create(const vk::raii::Device &device, vma::Allocator &allocator,
+                     const vkh::AllocatedImage &depth,
+                     const vk::raii::DescriptorSetLayout &reduceLayout,
+                     const vk::raii::DescriptorSetLayout &sampleLayout) noexcept
+      -> std::expected<DepthPyramid, std::string>;
+
+  /// Moves the pyramid into the general layout the first time it runs. The
+  /// cull shader binds the pyramid whether or not it reads it, so this has to
+  /// be recorded before the first cull.
+  void prepare(const vk::raii::CommandBuffer &cmdBuffer) noexcept;
+
+  /// Reduces the depth image, which must be in the shader read only layout,
+  /// into every level. Ends with a barrier making the pyramid visible to
+  /// later compute shaders.
+  void build(const vk::raii::CommandBuffer &cmdBuffer,
+             const pipelines::DepthReduce &pipeline) noexcept;
+
+  /// Whether `build` has run, before that the contents are undefined.
+  [[nodiscard]] auto isBuilt() const noexcept -> bool { return built; }
+
+  [[nodiscard]] auto getSampleSet() const noexcept
+      -> const vk::raii::DescriptorSet & {
+    return sampleSet;
+  }
+
+  [[nodiscard]] auto getImage() const noexcept -> const vkh::AllocatedImage & {
+    return image;
+  }
+
+  [[nodiscard]] auto levelCount() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(levelViews.size());
+  }
+
+private:
+  vkh::AllocatedImage image;
+  vk::Extent2D depthExtent;
+  std::vector<vk::raii::ImageView> levelViews;
+
+  vk::raii::DescriptorPool pool;
+  /// One per level, level 0 reads the depth image.
+  std::vector<vk::raii::DescriptorSet> reduceSets;
+  vk::raii::DescriptorSet sampleSet;
+
+  bool prepared = false;
+  bool built = false;
+
+  DepthPyramid(vkh::AllocatedImage image, vk::Extent2D depthExtent,
+               std::vector<vk::raii::ImageView> &&levelViews,
+               vk::raii::DescriptorPool &&pool,
+               std::vector<vk::raii::DescriptorSet> &&reduceSets,
+               vk::raii::DescriptorSet &&sampleSet) noexcept
+      : image(image), depthExtent(depthExtent),
+        levelViews(std::move(levelViews)), pool(std::move(pool)),
+        reduceSets(std::move(reduceSets)), sampleSet(std::move(sampleSet)) {}
+};
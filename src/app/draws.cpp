@@ -0,0 +1,445 @@
+#include "app/draws.hpp"
+
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <engine/util/macros.hpp>
+#include <engine/voxel/chunk.hpp>
+
+namespace {
+
+using engine::voxel::FACE_COUNT;
+
+constexpr uint32_t ALL_FACES = (1u << FACE_COUNT) - 1;
+
+auto chunkCandidate(const ChunkMesh &mesh) noexcept -> ChunkCandidate {
+  return ChunkCandidate{.origin = glm::vec3(mesh.position) *
+                                  static_cast<float>(engine::voxel::CHUNK_SIZE),
+                        .quadCount = mesh.quadCount,
+                        .quads = mesh.range.address,
+                        .faceCounts = mesh.faceCounts,
+                        .scale = static_cast<float>(1u << mesh.level),
+                        .padding = 0};
+}
+
+/// A mesh at a coarser level of detail covers `scale` chunks a side.
+auto chunkMax(const glm::vec3 &origin, float scale) noexcept -> glm::vec3 {
+  return origin + static_cast<float>(engine::voxel::CHUNK_SIZE) * scale;
+}
+
+/// Bit per `Face` that can point at `eye` from somewhere in the chunk. Every
+/// positive face lies past the chunk's minimum on its axis and every
+/// negative one before its maximum. Same test as `facesTowards` in
+/// cull.slang.
+auto facesTowards(const glm::vec3 &origin, float scale,
+                  const glm::vec3 &eye) noexcept -> uint32_t {
+  const auto max = chunkMax(origin, scale);
+  uint32_t faces = 0;
+  for (glm::length_t axis = 0; axis < 3; ++axis) {
+    if (eye[axis] > origin[axis]) {
+      faces |= 1u << (axis * 2);
+    }
+    if (eye[axis] < max[axis]) {
+      faces |= 2u << (axis * 2);
+    }
+  }
+  return faces;
+}
+
+/// Calls `fn` with a draw for each run of consecutive faces in `faces` that
+/// has quads. Same runs as `appendDraws` in cull.slang.
+template <typename Fn>
+void forEachRun(const ChunkCandidate &candidate, uint32_t faces,
+                Fn &&fn) noexcept {
+  uint32_t offset = 0;
+  uint32_t start = 0;
+  uint32_t count = 0;
+  auto flush = [&]() {
+    if (count != 0) {
+      fn(ChunkDraw{.origin = candidate.origin,
+                   .quadCount = count,
+                   .quads = candidate.quads +
+                            start * sizeof(engine::voxel::Quad),
+                   .scale = candidate.scale,
+                   .padding = 0});
+    }
+    count = 0;
+  };
+
+  for (uint32_t face = 0; face < FACE_COUNT; ++face) {
+    const auto faceCount = candidate.faceCounts[face];
+    if (((faces >> face) & 1) != 0) {
+      count += faceCount;
+    } else {
+      flush();
+      start = offset + faceCount;
+    }
+    offset += faceCount;
+  }
+  flush();
+}
+
+/// Orders draws by origin and then scale, which together are unique per
+/// mesh: meshes of two levels of detail share an origin while one replaces
+/// the other. `w` is the scale.
+auto originLess(const glm::vec4 &a, const glm::vec4 &b) noexcept -> bool {
+  if (a.x != b.x) {
+    return a.x < b.x;
+  }
+  if (a.y != b.y) {
+    return a.y < b.y;
+  }
+  if (a.z != b.z) {
+    return a.z < b.z;
+  }
+  return a.w < b.w;
+}
+
+/// Slack in world units for chunks that touch a frustum plane, where the
+/// shader and the CPU may round differently.
+constexpr float CULL_CHECK_MARGIN = 0.01f;
+
+} // namespace
+
+auto ChunkDrawList::create(vma::Allocator &allocator,
+                           const vk::raii::Device &device, uint32_t maxChunks,
+                           bool readDraws) noexcept
+    -> std::expected<ChunkDrawList, std::string> {
+  // A command and a draw record per face and phase, a candidate and a
+  // retest index.
+  const vk::DeviceSize perChunk =
+      (sizeof(vk::DrawIndirectCommand) + sizeof(ChunkDraw)) * FACE_COUNT * 2 +
+      sizeof(ChunkCandidate) + sizeof(uint32_t);
+  const auto size = sizeof(CullFrame) + perChunk * maxChunks;
+  const vk::DeviceSize readbackSize =
+      sizeof(CullFrame) +
+      (readDraws ? sizeof(ChunkDraw) * FACE_COUNT * 2 * maxChunks : 0);
+
+  std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> buffers;
+  std::array<vk::DeviceAddress, MAX_FRAMES_IN_FLIGHT> addresses{};
+  std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> readbacks;
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    EG_MAKE(buffer,
+            vkh::AllocatedBuffer::create(
+                allocator,
+                vk::BufferCreateInfo{
+                    .size = size,
+                    .usage = vk::BufferUsageFlagBits::eIndirectBuffer |
+                             vk::BufferUsageFlagBits::eStorageBuffer |
+                             vk::BufferUsageFlagBits::eShaderDeviceAddress |
+                             vk::BufferUsageFlagBits::eTransferSrc |
+                             vk::BufferUsageFlagBits::eTransferDst,
+                    .sharingMode = vk::SharingMode::eExclusive},
+                vma::AllocationCreateInfo{
+                    .usage = vma::MemoryUsage::eAutoPreferDevice}),
+            "Failed to create chunk draw buffer");
+
+    EG_MAKE(readback,
+            vkh::AllocatedBuffer::create(
+                allocator,
+                vk::BufferCreateInfo{
+                    .size = readbackSize,
+                    .usage = vk::BufferUsageFlagBits::eTransferDst,
+                    .sharingMode = vk::SharingMode::eExclusive},
+                vma::AllocationCreateInfo{
+                    .flags = vma::AllocationCreateFlagBits::eMapped |
+                             vma::AllocationCreateFlagBits::eHostAccessRandom,
+                    .usage = vma::MemoryUsage::eAuto,
+                    .requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible |
+                                     vk::MemoryPropertyFlagBits::eHostCoherent,
+                }),
+            "Failed to create chunk draw readback buffer");
+
+    // Counts are read back before the first cull writes them.
+    std::memset(readback.allocInfo.pMappedData, 0, sizeof(CullFrame));
+
+    buffers[i] = buffer;
+    addresses[i] = device.getBufferAddress(
+        vk::BufferDeviceAddressInfo{.buffer = buffer.buffer});
+    readbacks[i] = readback;
+  }
+
+  Logger::trace("Created chunk draw buffers for {} chunks", maxChunks);
+
+  return ChunkDrawList(buffers, addresses, readbacks, maxChunks, readDraws);
+}
+
+auto ChunkDrawList::writeCandidates(
+    engine::StagingRing &staging, uint32_t frameIndex,
+    std::span<const ChunkMesh> meshes, bool faceCulling,
+    const std::optional<Occlusion> &occlusion) noexcept
+    -> std::optional<uint32_t> {
+  auto &written = candidates[frameIndex];
+  written.clear();
+
+  uint32_t quads = 0;
+  for (const auto &mesh : meshes) {
+    if (written.size() == maxChunks) {
+      break;
+    }
+    if (mesh.quadCount != 0) {
+      written.push_back(chunkCandidate(mesh));
+      quads += mesh.quadCount;
+    }
+  }
+  const auto count = static_cast<uint32_t>(written.size());
+
+  const auto base = addresses[frameIndex];
+  CullFrame frame{
+      .previousViewProjection = glm::mat4(1.0f),
+      .candidates = base + candidatesOffset(),
+      .draws = base + drawsOffset(Phase::Early),
+      .commands = base + commandsOffset(Phase::Early),
+      .lateDraws = base + drawsOffset(Phase::Late),
+      .lateCommands = base + commandsOffset(Phase::Late),
+      .retest = base + retestOffset(),
+      .candidateCount = count,
+      .flags = faceCulling ? CullFrame::FACE_CULLING : 0,
+      .pyramidWidth = 0,
+      .pyramidHeight = 0,
+      .pyramidLevels = 0,
+      .drawCount = 0,
+      .lateDrawCount = 0,
+      .retestCount = 0,
+      .candidateQuads = quads,
+      .submittedQuads = 0,
+  };
+  if (occlusion) {
+    frame.previousViewProjection = occlusion->previousViewProjection;
+    frame.flags |= CullFrame::OCCLUSION;
+    if (occlusion->previousPyramid) {
+      frame.flags |= CullFrame::PREVIOUS_PYRAMID;
+    }
+    frame.pyramidWidth = occlusion->pyramidSize.width;
+    frame.pyramidHeight = occlusion->pyramidSize.height;
+    frame.pyramidLevels = occlusion->pyramidLevels;
+  }
+
+  const auto buffer = buffers[frameIndex].buffer;
+  if (!staging.upload(buffer, candidatesOffset(),
+                      std::span<const ChunkCandidate>(written)) ||
+      !staging.upload(buffer, 0, std::span<const CullFrame>(&frame, 1))) {
+    dropFrame(frameIndex);
+    return std::nullopt;
+  }
+  staged[frameIndex] = true;
+  return count;
+}
+
+auto ChunkDrawList::writeVisible(
+    engine::StagingRing &staging, uint32_t frameIndex,
+    std::span<const ChunkMesh> meshes, const engine::Frustum &frustum,
+    const std::optional<glm::vec3> &eye) noexcept -> std::optional<uint32_t> {
+  visibleCommands.clear();
+  visibleDraws.clear();
+  candidates[frameIndex].clear();
+
+  CullFrame frame{};
+  uint32_t candidateCount = 0;
+  uint32_t chunks = 0;
+  for (const auto &mesh : meshes) {
+    if (candidateCount == maxChunks) {
+      break;
+    }
+    if (mesh.quadCount == 0) {
+      continue;
+    }
+    ++candidateCount;
+    frame.candidateQuads += mesh.quadCount;
+
+    const auto candidate = chunkCandidate(mesh);
+    if (!frustum.intersects(candidate.origin,
+                            chunkMax(candidate.origin, candidate.scale))) {
+      continue;
+    }
+
+    const auto before = visibleDraws.size();
+    const auto faces = eye ? facesTowards(candidate.origin, candidate.scale,
+                                          *eye)
+                           : ALL_FACES;
+    forEachRun(candidate, faces, [&](const ChunkDraw &draw) {
+      visibleCommands.push_back(
+          vk::DrawIndirectCommand{.vertexCount = draw.quadCount * 6,
+                                  .instanceCount = 1,
+                                  .firstVertex = 0,
+                                  .firstInstance = 0});
+      visibleDraws.push_back(draw);
+      frame.submittedQuads += draw.quadCount;
+    });
+    if (visibleDraws.size() != before) {
+      ++chunks;
+    }
+  }
+  frame.drawCount = static_cast<uint32_t>(visibleDraws.size());
+
+  const auto buffer = buffers[frameIndex].buffer;
+  if (!staging.upload(buffer, commandsOffset(Phase::Early),
+                      std::span<const vk::DrawIndirectCommand>(
+                          visibleCommands)) ||
+      !staging.upload(buffer, drawsOffset(Phase::Early),
+                      std::span<const ChunkDraw>(visibleDraws)) ||
+      !staging.upload(buffer, 0, std::span<const CullFrame>(&frame, 1))) {
+    dropFrame(frameIndex);
+    return std::nullopt;
+  }
+  staged[frameIndex] = true;
+  return chunks;
+}
+
+void ChunkDrawList::dropFrame(uint32_t frameIndex) noexcept {
+  Logger::warn("No staging room for the chunk draws of frame {}",
+               frameIndex);
+  // Whatever was staged lands in a buffer nothing reads this frame.
+  staged[frameIndex] = false;
+  candidates[frameIndex].clear();
+  // `readBack` records nothing, so these are the counts read next.
+  std::memset(readbacks[frameIndex].allocInfo.pMappedData, 0,
+              sizeof(CullFrame));
+}
+
+void ChunkDrawList::readBack(const vk::raii::CommandBuffer &cmdBuffer,
+                             uint32_t frameIndex) const noexcept {
+  if (!staged[frameIndex]) {
+    return;
+  }
+
+  // The counts and draws are appended by the cull shader, or were staged.
+  const vk::MemoryBarrier2 culled{
+      .srcStageMask = vk::PipelineStageFlagBits2::eComputeShader |
+                      vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite |
+                       vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .dstAccessMask = vk::AccessFlagBits2::eTransferRead};
+  cmdBuffer.pipelineBarrier2(
+      vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &culled});
+
+  constexpr vk::DeviceSize COUNTS = offsetof(CullFrame, drawCount);
+  const std::array<vk::BufferCopy, 3> regions{
+      vk::BufferCopy{.srcOffset = COUNTS,
+                     .dstOffset = COUNTS,
+                     .size = sizeof(CullFrame) - COUNTS},
+      vk::BufferCopy{.srcOffset = drawsOffset(Phase::Early),
+                     .dstOffset = readbackDrawsOffset(Phase::Early),
+                     .size = sizeof(ChunkDraw) * maxDraws},
+      vk::BufferCopy{.srcOffset = drawsOffset(Phase::Late),
+                     .dstOffset = readbackDrawsOffset(Phase::Late),
+                     .size = sizeof(ChunkDraw) * maxDraws},
+  };
+  cmdBuffer.copyBuffer(buffers[frameIndex].buffer, readbacks[frameIndex].buffer,
+                       vk::ArrayProxy<const vk::BufferCopy>(
+                           readDraws ? 3 : 1, regions.data()));
+
+  // The fence alone does not make the copy visible to the host.
+  const vk::MemoryBarrier2 copied{
+      .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+      .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+      .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+      .dstAccessMask = vk::AccessFlagBits2::eHostRead};
+  cmdBuffer.pipelineBarrier2(
+      vk::DependencyInfo{.memoryBarrierCount = 1, .pMemoryBarriers = &copied});
+}
+
+auto ChunkDrawList::header(uint32_t frameIndex) const noexcept -> CullFrame {
+  CullFrame frame;
+  std::memcpy(&frame, readback(frameIndex), sizeof(frame));
+  return frame;
+}
+
+auto ChunkDrawList::counts(uint32_t frameIndex) const noexcept -> Counts {
+  const auto frame = header(frameIndex);
+  return Counts{.draws = std::min(frame.drawCount, maxDraws),
+                .lateDraws = std::min(frame.lateDrawCount, maxDraws),
+                .retests = std::min(frame.retestCount, maxChunks),
+                .candidateQuads = frame.candidateQuads,
+                .submittedQuads = frame.submittedQuads};
+}
+
+auto ChunkDrawList::checkCull(uint32_t frameIndex,
+                              const engine::Frustum &frustum,
+                              const std::optional<glm::vec3> &eye,
+                              bool occlusion) const noexcept -> CullCheck {
+  const auto gpuCounts = counts(frameIndex);
+
+  std::vector<glm::vec4> gpu;
+  gpu.reserve(gpuCounts.draws + gpuCounts.lateDraws);
+  for (auto [phase, count] : {std::pair{Phase::Early, gpuCounts.draws},
+                              std::pair{Phase::Late, gpuCounts.lateDraws}}) {
+    const auto *draws = reinterpret_cast<const ChunkDraw *>(
+        readback(frameIndex) + readbackDrawsOffset(phase));
+    for (uint32_t i = 0; i < count; ++i) {
+      gpu.emplace_back(draws[i].origin, draws[i].scale);
+    }
+  }
+
+  std::vector<glm::vec4> cpu;
+  for (const auto &candidate : candidates[frameIndex]) {
+    if (!frustum.intersects(candidate.origin,
+                            chunkMax(candidate.origin, candidate.scale))) {
+      continue;
+    }
+    bool drawn = false;
+    forEachRun(candidate,
+               eye ? facesTowards(candidate.origin, candidate.scale, *eye)
+                   : ALL_FACES,
+               [&](const ChunkDraw &) { drawn = true; });
+    if (drawn) {
+      cpu.emplace_back(candidate.origin, candidate.scale);
+    }
+  }
+
+  // A mesh draws once per run of faces.
+  std::ranges::sort(gpu, originLess);
+  const auto duplicates = std::ranges::unique(gpu, [](auto a, auto b) {
+    return !originLess(a, b) && !originLess(b, a);
+  });
+  gpu.erase(duplicates.begin(), duplicates.end());
+  std::ranges::sort(cpu, originLess);
+
+  auto clearlyWrong = [&](const glm::vec4 &draw) {
+    const glm::vec3 origin(draw);
+    const auto max = chunkMax(origin, draw.w);
+    return frustum.intersects(origin, max, CULL_CHECK_MARGIN) ==
+           frustum.intersects(origin, max, -CULL_CHECK_MARGIN);
+  };
+
+  std::vector<glm::vec4> gpuOnly;
+  std::ranges::set_difference(gpu, cpu, std::back_inserter(gpuOnly),
+                              originLess);
+  std::vector<glm::vec4> cpuOnly;
+  std::ranges::set_difference(cpu, gpu, std::back_inserter(cpuOnly),
+                              originLess);
+
+  auto mismatches = std::ranges::count_if(gpuOnly, clearlyWrong);
+  uint32_t occluded = 0;
+  if (occlusion) {
+    occluded = static_cast<uint32_t>(cpuOnly.size());
+  } else {
+    mismatches += std::ranges::count_if(cpuOnly, clearlyWrong);
+  }
+
+  return CullCheck{.gpuDraws = static_cast<uint32_t>(gpu.size()),
+                   .cpuDraws = static_cast<uint32_t>(cpu.size()),
+                   .mismatches = static_cast<uint32_t>(mismatches),
+                   .occluded = occluded};
+}
+
+void ChunkDrawList::draw(const vk::raii::CommandBuffer &cmdBuffer,
+                         uint32_t frameIndex, Phase phase) const noexcept {
+  if (!staged[frameIndex]) {
+    return;
+  }
+  const auto countOffset = phase == Phase::Late
+                               ? offsetof(CullFrame, lateDrawCount)
+                               : offsetof(CullFrame, drawCount);
+  cmdBuffer.drawIndirectCount(buffers[frameIndex].buffer,
+                              commandsOffset(phase),
+                              buffers[frameIndex].buffer, countOffset,
+                              maxDraws, sizeof(vk::DrawIndirectCommand));
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include "engine/defines.hpp"
+#include "pipelines/pipelines.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <engine/frustum.hpp>
+#include <engine/staging.hpp>
+#include <engine/voxel/mesher.hpp>
+#include <glm/glm.hpp>
+#include <vk_mem_alloc.hpp>
+#include <vkh/megaBuffer.hpp>
+#include <vkh/structs.hpp>
+#include <vulkan/vulkan_raii.hpp>
+
+/// A chunk's mesh in the chunk mega buffer, its quads grouped by face as the
+/// mesher emits them. A mesh at a coarser level of detail covers `1 <<
+/// level` chunks a side, its quads in cells of as many blocks.
+struct ChunkMesh {
+  /// In chunks, the minimum corner.
+  glm::ivec3 position;
+  vkh::MegaBuffer::Range range;
+  uint32_t quadCount;
+  engine::voxel::FaceCounts faceCounts;
+  uint32_t level = 0;
+};
+
+/// Per chunk record the mesh shader reads through `SV_DrawIndex`, matches
+/// `ChunkDraw` in chunk.slang.
+struct ChunkDraw {
+  glm::vec3 origin;
+  uint32_t quadCount;
+  vk::DeviceAddress quads;
+  /// Blocks per quad cell.
+  float scale;
+  uint32_t padding;
+};
+static_assert(sizeof(ChunkDraw) == 32);
+
+/// Per chunk cull input, matches `ChunkCandidate` in chunk.slang. Culling
+/// turns each into a `ChunkDraw` per run of faces that can face the camera.
+struct ChunkCandidate {
+  glm::vec3 origin;
+  uint32_t quadCount;
+  vk::DeviceAddress quads;
+  engine::voxel::FaceCounts faceCounts;
+  float scale;
+  uint32_t padding;
+};
+static_assert(sizeof(ChunkCandidate) == 56);
+
+/// Header of each frame's draw buffer, matches `CullFrame` in cull.slang.
+/// The CPU uploads it whole before the cull, the shader only appends to the
+/// counts.
+struct CullFrame {
+  /// Occlusion is tested against the previous frame's pyramid with the view
+  /// projection it was drawn with.
+  glm::mat4 previousViewProjection;
+  vk::DeviceAddress candidates;
+  vk::DeviceAddress draws;
+  vk::DeviceAddress commands;
+  vk::DeviceAddress lateDraws;
+  vk::DeviceAddress lateCommands;
+  /// Indices of candidates the early phase found occluded.
+  vk::DeviceAddress retest;
+  uint32_t candidateCount;
+  /// `OCCLUSION`, `PREVIOUS_PYRAMID` and `FACE_CULLING` bits.
+  uint32_t flags;
+  uint32_t pyramidWidth;
+  uint32_t pyramidHeight;
+  uint32_t pyramidLevels;
+  uint32_t drawCount;
+  uint32_t lateDrawCount;
+  uint32_t retestCount;
+  /// Quads of every candidate, written by the CPU.
+  uint32_t candidateQuads;
+  /// Quads of every draw in both phases.
+  uint32_t submittedQuads;
+
+  /// Test occlusion, the late phase only runs with this set.
+  static constexpr uint32_t OCCLUSION = 1;
+  /// The early phase may test against the previous frame's pyramid.
+  static constexpr uint32_t PREVIOUS_PYRAMID = 2;
+  /// Skip the faces of a chunk that point away from the camera.
+  static constexpr uint32_t FACE_CULLING = 4;
+};
+static_assert(offsetof(CullFrame, candidates) == 64);
+static_assert(offsetof(CullFrame, candidateCount) == 112);
+static_assert(offsetof(CullFrame, drawCount) == 132);
+static_assert(offsetof(CullFrame, submittedQuads) == 148);
+static_assert(sizeof(CullFrame) == 152);
+
+/// Draw commands and chunk records for every chunk, drawn with a single
+/// `drawIndirectCount` per cull phase.
+///
+/// Each frame in flight has its own device local buffer laid out as a
+/// `CullFrame`, the early phase's `maxDraws` commands and draw records, the
+/// same for the late phase, `maxChunks` candidates and `maxChunks` retest
+/// indices. A chunk draws each run of consecutive faces that can face the
+/// camera separately, so there are up to `FACE_COUNT` draws per chunk.
+/// Either the cull compute shader fills the draws from the candidates, or
+/// `writeVisible` fills the early draws on the CPU. What the CPU writes goes
+/// through the staging ring, so recording costs the same however many
+/// chunks there are.
+///
+/// Only the counts come back to the host, through a small mapped buffer per
+/// frame, along with the draw records when created to check the cull.
+class ChunkDrawList {
+public:
+  using Phase = pipelines::Cull::Phase;
+
+  /// Occlusion state for the cull shader, see `CullFrame`.
+  struct Occlusion {
+    glm::mat4 previousViewProjection;
+    vk::Extent2D pyramidSize;
+    uint32_t pyramidLevels;
+    /// The previous frame built a pyramid the early phase can test against.
+    bool previousPyramid;
+  };
+
+  /// What the cull wrote for a retired frame.
+  struct Counts {
+    uint32_t draws;
+    uint32_t lateDraws;
+    /// Chunks the early phase found occluded and the late phase retested.
+    uint32_t retests;
+    uint32_t candidateQuads;
+    uint32_t submittedQuads;
+  };
+
+  /// Outcome of comparing one frame's GPU cull with the CPU reference.
+  struct CullCheck {
+    /// Chunks drawn in either phase.
+    uint32_t gpuDraws;
+    uint32_t cpuDraws;
+    /// Chunks only one side drew, ignoring ones within a rounding error of
+    /// a frustum plane. With occlusion, only chunks the GPU drew outside the
+    /// frustum, the CPU reference does no occlusion.
+    uint32_t mismatches;
+    /// Chunks in the frustum the GPU found occluded.
+    uint32_t occluded;
+  };
+
+  /// With `readDraws`, every frame's draw records are read back too, for
+  /// `checkCull`.
+  static auto create(vma::Allocator &allocator, const vk::raii::Device &device,
+                     uint32_t maxChunks, bool readDraws) noexcept
+      -> std::expected<ChunkDrawList, std::string>;
+
+  /// Stages every non-empty mesh as a cull candidate for `frameIndex` and
+  /// the frame's header with cleared counts. Returns the number of
+  /// candidates written, or nothing if `staging` had no room, in which case
+  /// nothing is drawn for the frame.
+  auto writeCandidates(engine::StagingRing &staging, uint32_t frameIndex,
+                       std::span<const ChunkMesh> meshes, bool faceCulling,
+                       const std::optional<Occlusion> &occlusion) noexcept
+      -> std::optional<uint32_t>;
+
+  /// Culls on the CPU and stages the survivors as the early draws, leaving
+  /// the late draws empty. With `eye`, skips faces pointing away from it.
+  /// Returns the number of chunks drawn, or nothing as `writeCandidates`
+  /// does.
+  auto writeVisible(engine::StagingRing &staging, uint32_t frameIndex,
+                    std::span<const ChunkMesh> meshes,
+                    const engine::Frustum &frustum,
+                    const std::optional<glm::vec3> &eye) noexcept
+      -> std::optional<uint32_t>;
+
+  /// Records copying the frame's counts, and its draw records if created
+  /// to, to where the host reads them. After the last cull phase.
+  void readBack(const vk::raii::CommandBuffer &cmdBuffer,
+                uint32_t frameIndex) const noexcept;
+
+  /// The counts `readBack` copied for `frameIndex`. Only valid once that
+  /// frame has retired and before the next write for it.
+  [[nodiscard]] auto counts(uint32_t frameIndex) const noexcept -> Counts;
+
+  /// Compares the chunks the GPU drew for `frameIndex` with the CPU
+  /// reference, run over the candidates written for that frame so meshes
+  /// uploaded since make no difference. `eye` is where faces were culled
+  /// from, if they were. Only valid if created to read the draws back, once
+  /// that frame has retired and before the next write for it.
+  [[nodiscard]] auto checkCull(uint32_t frameIndex,
+                               const engine::Frustum &frustum,
+                               const std::optional<glm::vec3> &eye,
+                               bool occlusion) const noexcept -> CullCheck;
+
+  void draw(const vk::raii::CommandBuffer &cmdBuffer, uint32_t frameIndex,
+            Phase phase) const noexcept;
+
+  /// The frame's `CullFrame`.
+  [[nodiscard]] auto frameAddress(uint32_t frameIndex) const noexcept
+      -> vk::DeviceAddress {
+    return addresses[frameIndex];
+  }
+  [[nodiscard]] auto drawsAddress(uint32_t frameIndex,
+                                  Phase phase) const noexcept
+      -> vk::DeviceAddress {
+    return addresses[frameIndex] + drawsOffset(phase);
+  }
+
+  [[nodiscard]] auto getBuffers() const noexcept
+      -> const std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> & {
+    return buffers;
+  }
+  [[nodiscard]] auto getReadbacks() const noexcept
+      -> const std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> & {
+    return readbacks;
+  }
+
+private:
+  std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> buffers;
+  std::array<vk::DeviceAddress, MAX_FRAMES_IN_FLIGHT> addresses;
+  /// Host visible, laid out as a `CullFrame` of which only the counts are
+  /// written, then the early and late draw records if `readDraws`.
+  std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> readbacks;
+  uint32_t maxChunks;
+  uint32_t maxDraws;
+  bool readDraws;
+  /// Whether the frame's last write made it into the staging ring, its
+  /// buffer is stale otherwise.
+  std::array<bool, MAX_FRAMES_IN_FLIGHT> staged{};
+  /// The candidates staged for each frame, kept for `checkCull`.
+  std::array<std::vector<ChunkCandidate>, MAX_FRAMES_IN_FLIGHT> candidates;
+  /// Scratch for `writeVisible`.
+  std::vector<vk::DrawIndirectCommand> visibleCommands;
+  std::vector<ChunkDraw> visibleDraws;
+
+  [[nodiscard]] auto commandsOffset(Phase phase) const noexcept
+      -> vk::DeviceSize {
+    const vk::DeviceSize phaseSize =
+        (sizeof(vk::DrawIndirectCommand) + sizeof(ChunkDraw)) * maxDraws;
+    return sizeof(CullFrame) + (phase == Phase::Late ? phaseSize : 0);
+  }
+  [[nodiscard]] auto drawsOffset(Phase phase) const noexcept
+      -> vk::DeviceSize {
+    return commandsOffset(phase) + sizeof(vk::DrawIndirectCommand) * maxDraws;
+  }
+  [[nodiscard]] auto candidatesOffset() const noexcept -> vk::DeviceSize {
+    return drawsOffset(Phase::Late) + sizeof(ChunkDraw) * maxDraws;
+  }
+  [[nodiscard]] auto retestOffset() const noexcept -> vk::DeviceSize {
+    return candidatesOffset() + sizeof(ChunkCandidate) * maxChunks;
+  }
+
+  /// Where `readBack` copies the phase's draw records to.
+  [[nodiscard]] auto readbackDrawsOffset(Phase phase) const noexcept
+      -> vk::DeviceSize {
+    return sizeof(CullFrame) +
+           (phase == Phase::Late ? sizeof(ChunkDraw) * maxDraws : 0);
+  }
+
+  [[nodiscard]] auto readback(uint32_t frameIndex) const noexcept
+      -> const std::byte * {
+    return static_cast<const std::byte *>(
+        readbacks[frameIndex].allocInfo.pMappedData);
+  }
+
+  [[nodiscard]] auto header(uint32_t frameIndex) const noexcept -> CullFrame;
+
+  /// Leaves the frame undrawn with zero counts when `staging` has no room
+  /// for its writes.
+  void dropFrame(uint32_t frameIndex) noexcept;
+
+  ChunkDrawList(
+      std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> buffers,
+      std::array<vk::DeviceAddress, MAX_FRAMES_IN_FLIGHT> addresses,
+      std::array<vkh::AllocatedBuffer, MAX_FRAMES_IN_FLIGHT> readbacks,
+      uint32_t maxChunks, bool readDraws) noexcept
+      : buffers(buffers), addresses(addresses), readbacks(readbacks),
+        maxChunks(maxChunks), maxDraws(maxChunks * engine::voxel::FACE_COUNT),
+        readDraws(readDraws) {}
+};
@@ -0,0 +1,191 @@
+#include "app/flythrough.hpp"
+
+#include <engine/trace.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace {
+
+/// Frames spent holding `keys` and moving the mouse by `look` each frame.
+struct Segment {
+  uint32_t frames;
+  std::vector<engine::Key> keys;
+  glm::vec2 look;
+};
+
+/// Keys move the camera 25 blocks, or turn it 25 degrees, a second.
+auto script() noexcept -> const std::vector<Segment> & {
+  using engine::Key;
+  static const std::vector<Segment> segments = {
+      // Lets the columns around the start load.
+      {.frames = 120, .keys = {}, .look = {0.0f, 0.0f}},
+      {.frames = 480, .keys = {Key::W}, .look = {0.0f, 0.0f}},
+      {.frames = 240, .keys = {Key::W, Key::Right}, .look = {0.0f, 0.0f}},
+      {.frames = 180, .keys = {Key::W, Key::Space}, .look = {0.0f, 0.0f}},
+      // A full turn on the spot, with the mouse.
+      {.frames = 240, .keys = {}, .look = {1.5f, 0.0f}},
+      {.frames = 240,
+       .keys = {Key::W, Key::D, Key::Ctrl},
+       .look = {0.0f, 0.0f}},
+      {.frames = 180, .keys = {Key::W, Key::Down}, .look = {0.0f, 0.0f}},
+      // Straight down, then edits to the ground below, drifting sideways in
+      // between: two torches placed, the second broken again along with the
+      // ground under it, and a hole dug.
+      {.frames = 60, .keys = {Key::Down}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::E}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::D}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::E}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::Q}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::Q}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::D}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::Q}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {}, .look = {0.0f, 0.0f}},
+      {.frames = 20, .keys = {Key::Q}, .look = {0.0f, 0.0f}},
+  };
+  return segments;
+}
+
+/// Nearest rank, of `sorted`.
+auto percentile(const std::vector<float> &sorted, float p) noexcept -> float {
+  if (sorted.empty()) {
+    return 0.0f;
+  }
+  const auto rank = static_cast<size_t>(
+      std::ceil(p * static_cast<float>(sorted.size())));
+  return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+} // namespace
+
+Flythrough::ScriptedInput::ScriptedInput() noexcept {
+  window = nullptr;
+  mouseMut().move(glm::vec2(0.0f));
+  onFrameEnd();
+}
+
+void Flythrough::ScriptedInput::step(std::span<const engine::Key> keys,
+                                     glm::vec2 look) noexcept {
+  // Presses from last frame become held, and releases are forgotten.
+  onFrameEnd();
+
+  std::vector<engine::Key> released;
+  for (const auto &[held, state] : keyStates()) {
+    if (state != engine::KeyState::Up &&
+        std::ranges::find(keys, held) == keys.end()) {
+      released.push_back(held);
+    }
+  }
+  for (const auto k : released) {
+    key(k, engine::KeyAction::Release);
+  }
+  for (const auto k : keys) {
+    if (isReleased(k)) {
+      key(k, engine::KeyAction::Press);
+    }
+  }
+
+  mouseMut().move(mouse().pos() + look);
+}
+
+auto Flythrough::frameCount() noexcept -> uint64_t {
+  uint64_t frames = 0;
+  for (const auto &segment : script()) {
+    frames += segment.frames;
+  }
+  return frames;
+}
+
+Flythrough::Flythrough(std::filesystem::path reportPath) noexcept
+    : reportPath(std::move(reportPath)) {
+  frameTimes.reserve(frameCount());
+}
+
+auto Flythrough::advance(float frameTime) noexcept -> engine::FrameData {
+  if (frame == 0) {
+    engine::trace::start();
+  } else {
+    frameTimes.push_back(frameTime);
+  }
+
+  // Past the end of the path the camera stays put.
+  auto first = frame++;
+  const Segment *current = nullptr;
+  for (const auto &segment : script()) {
+    if (first < segment.frames) {
+      current = &segment;
+      break;
+    }
+    first -= segment.frames;
+  }
+  if (current != nullptr) {
+    input.step(current->keys, current->look);
+  } else {
+    input.step({}, {0.0f, 0.0f});
+  }
+
+  return engine::FrameData{.deltaTime = DELTA_TIME, .input = input};
+}
+
+auto Flythrough::writeReport(
+    std::span<const engine::GpuProfiler::ScopeStats> passes) const noexcept
+    -> std::expected<void, std::string> {
+  engine::trace::stop();
+  const auto zones = engine::trace::totals();
+
+  auto sorted = frameTimes;
+  std::ranges::sort(sorted);
+  const auto mean =
+      sorted.empty() ? 0.0f
+                     : std::reduce(sorted.begin(), sorted.end()) /
+                           static_cast<float>(sorted.size());
+  const auto ms = [](float seconds) { return seconds * 1e3f; };
+
+  auto *file = std::fopen(reportPath.string().c_str(), "wb");
+  if (file == nullptr) {
+    return std::unexpected("Failed to open " + reportPath.string());
+  }
+
+  // Names are literals from the engine and app, none of which need escaping.
+  std::fprintf(file, "{\n  \"frames\": %llu,\n  \"deltaTime\": %.6f,\n",
+               static_cast<unsigned long long>(frame), DELTA_TIME);
+  std::fprintf(file,
+               "  \"frameTimeMs\": {\"samples\": %zu, \"mean\": %.3f, "
+               "\"min\": %.3f, \"p50\": %.3f, \"p95\": %.3f, \"p99\": %.3f, "
+               "\"max\": %.3f},\n",
+               sorted.size(), ms(mean), ms(sorted.empty() ? 0 : sorted.front()),
+               ms(percentile(sorted, 0.50f)), ms(percentile(sorted, 0.95f)),
+               ms(percentile(sorted, 0.99f)),
+               ms(sorted.empty() ? 0 : sorted.back()));
+
+  std::fputs("  \"cpuZones\": [", file);
+  for (size_t i = 0; i < zones.size(); ++i) {
+    const auto &zone = zones[i];
+    std::fprintf(file,
+                 "%s\n    {\"name\": \"%s\", \"count\": %llu, "
+                 "\"totalMs\": %.3f}",
+                 i == 0 ? "" : ",", zone.name,
+                 static_cast<unsigned long long>(zone.count),
+                 static_cast<double>(zone.nanoseconds) * 1e-6);
+  }
+  std::fputs("\n  ],\n  \"gpuPassesMs\": [", file);
+  for (size_t i = 0; i < passes.size(); ++i) {
+    const auto &pass = passes[i];
+    std::fprintf(file,
+                 "%s\n    {\"name\": \"%s\", \"depth\": %u, \"avg\": %.3f, "
+                 "\"min\": %.3f, \"max\": %.3f}",
+                 i == 0 ? "" : ",", pass.name, pass.depth, pass.avg, pass.min,
+                 pass.max);
+  }
+  std::fputs("\n  ]\n}\n", file);
+
+  const auto failed = std::ferror(file) != 0;
+  if (std::fclose(file) != 0 || failed) {
+    return std::unexpected("Failed to write " + reportPath.string());
+  }
+  return {};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <engine/gpuProfiler.hpp>
+#include <engine/input.hpp>
+#include <engine/structs.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/// Replays a scripted camera path and reports how long frames took along it.
+///
+/// The camera is driven through `PerspectiveCamera` like it is live, by
+/// holding keys and moving the mouse on an input of its own, but every
+/// frame counts as `FRAME_TIME` whatever it really took, to the camera and
+/// to the fixed timestep alike. The path therefore comes out the same on
+/// every run and machine, and only the time it takes to render varies.
+///
+/// A CPU trace records for the whole path, so its report has the time spent
+/// in each zone next to the frame times and the GPU time of each pass.
+class Flythrough {
+public:
+  static constexpr std::chrono::nanoseconds FRAME_TIME{1'000'000'000 / 60};
+  /// `FRAME_TIME` in seconds.
+  static constexpr float DELTA_TIME =
+      std::chrono::duration<float>(FRAME_TIME).count();
+
+  /// Frames the whole path takes.
+  [[nodiscard]] static auto frameCount() noexcept -> uint64_t;
+
+  /// Writes its report to `reportPath`.
+  explicit Flythrough(std::filesystem::path reportPath) noexcept;
+
+  /// Steps along the path, given the real seconds the frame before took.
+  /// Call once a frame, the result refers to this flythrough.
+  [[nodiscard]] auto advance(float frameTime) noexcept -> engine::FrameData;
+
+  /// What the path holds down, for ticks between frames.
+  [[nodiscard]] auto getInput() const noexcept -> const engine::Input & {
+    return input;
+  }
+
+  /// Stops the CPU trace and writes the report, as JSON. GPU times are the
+  /// profiler's, over its last `GpuProfiler::HISTORY` frames.
+  auto writeReport(std::span<const engine::GpuProfiler::ScopeStats> passes)
+      const noexcept -> std::expected<void, std::string>;
+
+private:
+  /// Only ever pressed by the script.
+  class ScriptedInput : public engine::Input {
+  public:
+    ScriptedInput() noexcept;
+
+    /// Holds exactly `keys` and moves the mouse by `look` this frame.
+    void step(std::span<const engine::Key> keys, glm::vec2 look) noexcept;
+  };
+
+  std::filesystem::path reportPath;
+  ScriptedInput input;
+  uint64_t frame = 0;
+  /// In seconds, of every frame but the first, which also covers start up.
+  std::vector<float> frameTimes;
+};
@@ -7,8 +7,13 @@
 
 #include <engine/core.hpp>
 #include <engine/debug.hpp>
+#include <engine/frameCapture.hpp>
+#include <engine/gpuProfiler.hpp>
 #include <engine/setup.hpp>
+#include <engine/staging.hpp>
+#include <engine/uploader.hpp>
 #include <engine/util/macros.hpp>
+#include <vkh/megaBuffer.hpp>
 #include <vkh/physicalDeviceSelector.hpp>
 #include <vkh/pipeline.hpp>
 #include <vkh/shader.hpp>
@@ -25,28 +30,58 @@ const bool enableValidationLayers = true;
 const bool enableValidationLayers = false;
 #endif
 
-const std::array<const char *, 3> requiredDeviceExtensions = {
-    vk::KHRSwapchainExtensionName, vk::KHRSpirv14ExtensionName,
-    vk::KHRCreateRenderpass2ExtensionName};
+constexpr vk::DeviceSize STAGING_PARTITION_SIZE = 8ull * 1024 * 1024;
+constexpr vk::DeviceSize UPLOAD_STAGING_SIZE = 32ull * 1024 * 1024;
+/// Shared by every chunk mesh.
+constexpr vk::DeviceSize CHUNK_BUFFER_SIZE = 256ull * 1024 * 1024;
+constexpr uint32_t MAX_DRAWN_CHUNKS = 16384;
+constexpr vk::Format DEPTH_FORMAT = vk::Format::eD32Sfloat;
+constexpr int32_t WORLD_SEED = 1337;
+/// In columns of chunks, drawn at full detail.
+constexpr uint32_t VIEW_DISTANCE = 6;
+/// Each level of detail reaches twice as far as the one before, so three
+/// draw out to 48 columns for about the quads 12 columns took at full
+/// detail.
+constexpr uint32_t DETAIL_LEVELS = 3;
+/// Relative to the working directory. Columns saved here win over the seed,
+/// so clear it after changing the generator.
+constexpr const char *SAVE_DIRECTORY = "saves/world";
+
+/// Headless, the render image is this size.
+constexpr vk::Extent2D HEADLESS_EXTENT = {.width = WINDOW_WIDTH,
+                                          .height = WINDOW_HEIGHT};
+
+const std::array<const char *, 2> requiredDeviceExtensions = {
+    vk::KHRSpirv14ExtensionName, vk::KHRCreateRenderpass2ExtensionName};
 } // namespace
 
-std::expected<App, std::string> App::create() noexcept {
+std::expected<App, std::string> App::create(const Options &options) noexcept {
   EG_MAKE(core,
-          engine::rendering::Core::create(
-              engine::Window::Attribs{
-                  .width = WINDOW_WIDTH,
-                  .height = WINDOW_HEIGHT,
-                  .title = WINDOW_TITLE,
-              },
-              {}, enableValidationLayers),
+          options.headless
+              ? engine::rendering::Core::createHeadless({},
+                                                        enableValidationLayers)
+              : engine::rendering::Core::create(
+                    engine::Window::Attribs{
+                        .width = WINDOW_WIDTH,
+                        .height = WINDOW_HEIGHT,
+                        .title = WINDOW_TITLE,
+                    },
+                    {}, enableValidationLayers),
           "Failed to create core");
 
+  // Nothing is presented headless, so only a window needs swapchains.
+  std::vector<const char *> deviceExtensions(requiredDeviceExtensions.begin(),
+                                             requiredDeviceExtensions.end());
+  if (!options.headless) {
+    deviceExtensions.push_back(vk::KHRSwapchainExtensionName);
+  }
+
   EG_MAKE(physicalDevice,
           engine::setup::selectPhysicalDevice(
               core.getInstance(),
-              [](vkh::PhysicalDeviceSelector &selector)
+              [&](vkh::PhysicalDeviceSelector &selector)
                   -> std::optional<std::string> {
-                selector.requireExtensions(requiredDeviceExtensions);
+                selector.requireExtensions(deviceExtensions);
                 selector.requireVersion(1, 4, 0);
                 selector.requireQueueFamily(vk::QueueFlagBits::eGraphics);
 
@@ -68,28 +103,36 @@ std::expected<App, std::string> App::create() noexcept {
           engine::setup::findCoreQueues(physicalDevice, core.getSurface()),
           "Failed to find core queue families");
 
+  const auto transferFamily = engine::setup::findTransferQueue(
+      physicalDevice, coreQueuesIndices.graphics);
+
   std::vector<engine::setup::QueueCreateInfo> queueCreateInfos;
   queueCreateInfos.push_back(
       {.familyIndex = coreQueuesIndices.graphics, .priority = 1.0f});
   if (coreQueuesIndices.present != coreQueuesIndices.graphics)
     queueCreateInfos.push_back(
         {.familyIndex = coreQueuesIndices.present, .priority = 1.0f});
+  if (transferFamily.has_value() &&
+      transferFamily.value() != coreQueuesIndices.present)
+    queueCreateInfos.push_back(
+        {.familyIndex = transferFamily.value(), .priority = 0.5f});
 
   EG_MAKE(device,
           engine::setup::createLogicalDevice(
               physicalDevice, queueCreateInfos,
-              engine::setup::ENGINE_DEVICE_EXTENSIONS,
-              requiredDeviceExtensions),
+              engine::setup::ENGINE_DEVICE_EXTENSIONS, deviceExtensions),
           "Failed to create logical device");
 
   EG_MAKE(queues,
           engine::setup::retrieveQueues(
-              device, {coreQueuesIndices.graphics, coreQueuesIndices.present}),
+              device, {coreQueuesIndices.graphics, coreQueuesIndices.present,
+                       transferFamily.value_or(coreQueuesIndices.graphics)}),
           "Failed to retrieve queues");
 
   engine::App::Queues coreQueues{
       .graphics = queues[0],
       .present = queues[1],
+      .transfer = queues[2],
   };
 
   vma::AllocatorCreateInfo allocCreateInfo{
@@ -102,18 +145,38 @@ std::expected<App, std::string> App::create() noexcept {
   VMA_MAKE(allocator, vma::createAllocator(allocCreateInfo),
            "Failed to make allocator");
 
-  EG_MAKE(swapchain,
-          engine::setup::createSwapchain(physicalDevice, device,
-                                         core.getWindow(), core.getSurface(),
-                                         coreQueuesIndices, std::nullopt),
-          "Failed to create swapchain");
+  std::optional<vkh::Swapchain> swapchain;
+  auto extent = HEADLESS_EXTENT;
+  if (!options.headless) {
+    EG_MAKE(windowSwapchain,
+            engine::setup::createSwapchain(physicalDevice, device,
+                                           core.getWindow(), core.getSurface(),
+                                           coreQueuesIndices, std::nullopt),
+            "Failed to create swapchain");
+    extent = windowSwapchain.config().extent;
+    swapchain = std::move(windowSwapchain);
+  }
 
   EG_MAKE(renderImage,
-          engine::setup::createRenderImage(device, allocator,
-                                           swapchain.config(),
+          engine::setup::createRenderImage(device, allocator, extent,
                                            vk::Format::eR16G16B16A16Sfloat),
           "Failed to create render image");
 
+  std::optional<engine::FrameCapture> capture;
+  if (options.captureDirectory.has_value()) {
+    EG_MAKE(frameCapture,
+            engine::FrameCapture::create(allocator, renderImage.extent,
+                                         renderImage.format,
+                                         *options.captureDirectory),
+            "Failed to create frame capture");
+    capture = std::move(frameCapture);
+  }
+
+  EG_MAKE(depthImage,
+          engine::setup::createDepthImage(device, allocator,
+                                          renderImage.extent, DEPTH_FORMAT),
+          "Failed to create depth image");
+
   VK_MAKE(commandPool,
           device.createCommandPool(vk::CommandPoolCreateInfo{
               .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
@@ -128,13 +191,18 @@ std::expected<App, std::string> App::create() noexcept {
   std::array<engine::SyncObjects, MAX_FRAMES_IN_FLIGHT> syncObjects = {
       std::move(sync1), std::move(sync2)};
 
-  engine::Input::instance().setupWindow(core.getWindow());
-
-  EG_MAKE(imGuiObjects,
-          engine::setup::setupImGui(core.getWindow().get(), core.getInstance(),
-                                    device, physicalDevice, coreQueues.graphics,
-                                    swapchain.config().format.format),
-          "Failed to setup ImGui Vulkan objects");
+  engine::ImGuiVkObjects imGuiObjects{.descriptorPool = nullptr};
+  if (swapchain.has_value()) {
+    engine::Input::instance().setupWindow(core.getWindow());
+
+    EG_MAKE(windowImGui,
+            engine::setup::setupImGui(
+                core.getWindow().get(), core.getInstance(), device,
+                physicalDevice, coreQueues.graphics,
+                swapchain->config().format.format),
+            "Failed to setup ImGui Vulkan objects");
+    imGuiObjects = std::move(windowImGui);
+  }
 
   vk::CommandBufferAllocateInfo commandBufferAllocInfo{
       .commandPool = *commandPool,
@@ -148,103 +216,34 @@ std::expected<App, std::string> App::create() noexcept {
   std::array<vk::raii::CommandBuffer, MAX_FRAMES_IN_FLIGHT> commandBuffers{
       std::move(commandBuffersV[0]), std::move(commandBuffersV[1])};
 
-  using pipelines::Mesh;
-
-  std::array<pipelines::Mesh::Vertex, 4> vertices = {
-      Mesh::Vertex{.position = {-0.5f, -0.5f, 0.0f},
-                   .uvX = -0.5f,
-                   .normal = engine::FORWARD,
-                   .uvY = 0.5f,
-                   .color = {1.0f, 0.0f, 0.0f, 1.0f}},
-      Mesh::Vertex{.position = {0.5f, -0.5f, 0.0f},
-                   .uvX = 0.5f,
-                   .normal = engine::FORWARD,
-                   .uvY = -0.5f,
-                   .color = {0.0f, 1.0f, 0.0f, 1.0f}},
-      Mesh::Vertex{.position = {-0.5f, 0.5f, 0.0f},
-                   .uvX = -0.5f,
-                   .normal = engine::FORWARD,
-                   .uvY = 0.5f,
-                   .color = {0.0f, 0.0f, 1.0f, 1.0f}},
-      Mesh::Vertex{.position = {0.5f, 0.5f, 0.0f},
-                   .uvX = 0.5f,
-                   .normal = engine::FORWARD,
-                   .uvY = 0.5f,
-                   .color = {1.0f, 1.0f, 1.0f, 1.0f}}};
-
-  vk::BufferCreateInfo vertexBufferInfo{
-      .size = sizeof(Mesh::Vertex) * vertices.size(),
-      .usage = vk::BufferUsageFlagBits::eTransferDst |
-               vk::BufferUsageFlagBits::eStorageBuffer |
-               vk::BufferUsageFlagBits::eShaderDeviceAddress,
-      .sharingMode = vk::SharingMode::eExclusive};
-
-  vma::AllocationCreateInfo vertexAllocInfo{
-      .usage = vma::MemoryUsage::eGpuOnly,
-  };
-
-  vkh::AllocatedBuffer vBuffer;
-  VMA_MAKE(vertexBufferPair,
-           allocator.createBuffer(vertexBufferInfo, vertexAllocInfo,
-                                  &vBuffer.allocInfo),
-           "Failed to create vertex buffer");
-  vBuffer.buffer = vertexBufferPair.first;
-  vBuffer.alloc = vertexBufferPair.second;
-
-  vkh::AllocatedBuffer stagingBuffer;
-  VMA_MAKE(
-      stagingBufferPair,
-      allocator.createBuffer(
-          vk::BufferCreateInfo{.size = vertexBufferInfo.size,
-                               .usage = vk::BufferUsageFlagBits::eTransferSrc,
-                               .sharingMode = vk::SharingMode::eExclusive},
-          vma::AllocationCreateInfo{
-              .flags = vma::AllocationCreateFlagBits::eMapped,
-              .usage = vma::MemoryUsage::eCpuOnly,
-          },
-          &stagingBuffer.allocInfo),
-      "Failed to create staging buffer");
-  stagingBuffer.buffer = stagingBufferPair.first;
-  stagingBuffer.alloc = stagingBufferPair.second;
-
-  memcpy(stagingBuffer.allocInfo.pMappedData, vertices.data(),
-         vertexBufferInfo.size);
-
-  {
-    auto &cmdBuf = commandBuffers[0];
-
-    cmdBuf.begin(vk::CommandBufferBeginInfo{
-        .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit});
-
-    vk::BufferCopy copyRegion{
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size = vertexBufferInfo.size,
-    };
-
-    cmdBuf.copyBuffer(stagingBuffer.buffer, vBuffer.buffer, copyRegion);
-
-    cmdBuf.end();
-
-    vk::CommandBufferSubmitInfo submitInfo{.commandBuffer = cmdBuf};
-    vk::SubmitInfo2 submitInfos{
-        .commandBufferInfoCount = 1,
-        .pCommandBufferInfos = &submitInfo,
-    };
-
-    VK_MAKE(waitFence, device.createFence(vk::FenceCreateInfo{}),
-            "Failed to create fence");
-
-    coreQueues.graphics.queue->submit2(submitInfos, waitFence);
-
-    auto res = device.waitForFences({waitFence}, VK_TRUE, UINT64_MAX);
-    if (res != vk::Result::eSuccess) {
-      return std::unexpected(
-          "Failed to wait for fence after vertex buffer copy");
-    }
-
-    stagingBuffer.destroy(allocator);
-  }
+  EG_MAKE(uploader,
+          engine::AsyncUploader::create(device, allocator, coreQueues.transfer,
+                                        coreQueuesIndices.graphics,
+                                        UPLOAD_STAGING_SIZE),
+          "Failed to create uploader");
+
+  // Patched meshes copy their unchanged quads from the mesh they replace.
+  // Shared with the uploader's family, which writes ranges of it too.
+  const auto uploadFamilies = uploader.getFamilies();
+  EG_MAKE(chunkBuffer,
+          vkh::MegaBuffer::create(device, allocator, CHUNK_BUFFER_SIZE,
+                                  vk::BufferUsageFlagBits::eTransferSrc,
+                                  uploadFamilies),
+          "Failed to create chunk mesh buffer");
+
+  EG_MAKE(drawList,
+          ChunkDrawList::create(allocator, device, MAX_DRAWN_CHUNKS,
+                                options.checkCull),
+          "Failed to create chunk draw list");
+
+  EG_MAKE(staging,
+          engine::StagingRing::create(allocator, STAGING_PARTITION_SIZE),
+          "Failed to create staging ring");
+
+  EG_MAKE(profiler,
+          engine::GpuProfiler::create(device, physicalDevice,
+                                      coreQueues.graphics),
+          "Failed to create GPU profiler");
 
   vk::DescriptorPoolSize poolSize{.type = vk::DescriptorType::eUniformBuffer,
                                   .descriptorCount = MAX_FRAMES_IN_FLIGHT};
@@ -264,13 +263,38 @@ std::expected<App, std::string> App::create() noexcept {
               device, allocator, cameraDescriptorPool, cameraDescriptorLayout),
           "Failed to create uniform buffers");
 
+  EG_MAKE(reduceLayout, DepthPyramid::reduceLayout(device),
+          "Failed to create depth reduce descriptor layout");
+
+  EG_MAKE(pyramidLayout, DepthPyramid::sampleLayout(device),
+          "Failed to create depth pyramid descriptor layout");
+
+  EG_MAKE(depthPyramid,
+          DepthPyramid::create(device, allocator, depthImage, reduceLayout,
+                               pyramidLayout),
+          "Failed to create depth pyramid");
+
   EG_MAKE(basicVertexPipeline,
-          pipelines::Mesh::create(device, renderImage.format,
+          pipelines::Mesh::create(device, renderImage.format, DEPTH_FORMAT,
                                   pipelines::Mesh::DescriptorLayouts{
                                       .camera = cameraDescriptorLayout}),
           "Failed to create basic vertex pipeline");
 
-  constexpr glm::vec3 CAMERA_START_POS = {0.0f, 0.0f, 2.0f};
+  EG_MAKE(cullPipeline,
+          pipelines::Cull::create(
+              device,
+              pipelines::Cull::DescriptorLayouts{
+                  .camera = cameraDescriptorLayout, .pyramid = pyramidLayout}),
+          "Failed to create cull pipeline");
+
+  EG_MAKE(depthReducePipeline,
+          pipelines::DepthReduce::create(
+              device, pipelines::DepthReduce::DescriptorLayouts{
+                          .reduce = reduceLayout}),
+          "Failed to create depth reduce pipeline");
+
+  // Above most of the terrain.
+  constexpr glm::vec3 CAMERA_START_POS = {0.0f, 160.0f, 0.0f};
   constexpr float CAMERA_START_FOV = glm::radians(90.0f);
   constexpr float CAMERA_NEAR_PLANE = 0.1f;
 
@@ -278,11 +302,21 @@ std::expected<App, std::string> App::create() noexcept {
       CAMERA_START_POS, {},
       engine::cameras::Perspective::Params{
           .fov = CAMERA_START_FOV,
-          .aspectRatio = static_cast<float>(swapchain.config().extent.width) /
-                         static_cast<float>(swapchain.config().extent.height),
+          .aspectRatio = static_cast<float>(extent.width) /
+                         static_cast<float>(extent.height),
           .nearPlane = CAMERA_NEAR_PLANE,
       });
 
+  std::optional<Flythrough> flythrough;
+  auto frameLimit = options.frames;
+  // Saved columns would make the flythrough depend on earlier runs.
+  std::filesystem::path saveDirectory = SAVE_DIRECTORY;
+  if (options.flythroughReport.has_value()) {
+    flythrough.emplace(*options.flythroughReport);
+    frameLimit = Flythrough::frameCount();
+    saveDirectory.clear();
+  }
+
   CameraObjects camObjs{.pool = std::move(cameraDescriptorPool),
                         .buffers = std::move(cameraBuffers),
                         .camera = std::move(camera)};
@@ -292,5 +326,14 @@ std::expected<App, std::string> App::create() noexcept {
              std::move(renderImage), std::move(commandPool),
              std::move(syncObjects), std::move(imGuiObjects),
              std::move(commandBuffers), std::move(camObjs),
-             std::move(basicVertexPipeline), vBuffer);
+             std::move(basicVertexPipeline), std::move(cullPipeline),
+             std::move(depthReducePipeline), depthImage,
+             std::move(depthPyramid), std::move(chunkBuffer),
+             World::Settings{.terrain = {.seed = WORLD_SEED},
+                             .viewDistance = VIEW_DISTANCE,
+                             .lodLevels = DETAIL_LEVELS,
+                             .saveDirectory = std::move(saveDirectory)},
+             std::move(drawList), std::move(staging), std::move(uploader),
+             std::move(profiler), frameLimit, std::move(capture),
+             std::move(flythrough), options.checkCull);
 }
@@ -0,0 +1,878 @@
+#include "app/world.hpp"
+
+#include "logger.hpp"
+
+#include <engine/trace.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+namespace {
+
+using engine::voxel::COLUMN_CHUNKS;
+using engine::voxel::ColumnSummary;
+using engine::voxel::LodTile;
+using engine::voxel::TerrainGenerator;
+
+/// Columns are unloaded this many columns past the generator's radius, so
+/// ones on the edge are not thrown away and loaded again as the camera
+/// wobbles. Past where the generator drops them, 3.5 columns out, or it
+/// would never hand them back if the camera returned.
+constexpr float UNLOAD_MARGIN = 4.0f;
+
+auto isAir(const engine::voxel::Chunk &chunk) noexcept -> bool {
+  return chunk.isUniform() && chunk.getPalette().front() == engine::voxel::AIR;
+}
+
+} // namespace
+
+World::World(engine::JobSystem &jobs, const Settings &settings) noexcept
+    : jobs(&jobs), store(openStore(settings.saveDirectory)),
+      saver(store ? std::make_unique<engine::voxel::BackgroundSaver>(
+                        *store, settings.saver)
+                  : nullptr),
+      generator(jobs, withStore(settings.terrain, store.get())),
+      lod({.distance = settings.viewDistance, .levels = settings.lodLevels}),
+      generatorRadius(static_cast<uint32_t>(std::ceil(lod.coverage()))),
+      maxMeshJobs(std::max(1u, jobs.workerCount() * 2)) {}
+
+World::~World() {
+  for (const auto &job : meshing) {
+    jobs->waitAndHelp(job->done);
+  }
+  for (const auto &job : summarising) {
+    jobs->waitAndHelp(job->done);
+  }
+  for (const auto &job : lightJobs) {
+    jobs->waitAndHelp(job->done);
+  }
+  // The saver writes them out before it is destroyed.
+  if (saver) {
+    autosave(chunks.dirtyCount(), {});
+  }
+}
+
+auto World::openStore(const std::filesystem::path &directory) noexcept
+    -> std::unique_ptr<engine::voxel::RegionStore> {
+  if (directory.empty()) {
+    return nullptr;
+  }
+  auto store = engine::voxel::RegionStore::open(directory);
+  if (!store) {
+    Logger::warn("Not saving the world: {}", store.error());
+    return nullptr;
+  }
+  Logger::info("Saving the world to {}", directory.string());
+  return std::make_unique<engine::voxel::RegionStore>(std::move(*store));
+}
+
+void World::update(const glm::vec3 &eye) noexcept {
+  EG_ZONE("World update");
+  generator.update(eye, generatorRadius);
+
+  for (auto &column : generator.takeFinished()) {
+    // What is loaded may have been edited since, so it wins over a column
+    // generated or loaded again after the generator dropped it.
+    const auto [it, inserted] = columns.try_emplace(key(column.position));
+    auto &loaded = it->second;
+    if (!inserted && loaded.full) {
+      continue;
+    }
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      chunks.insert(glm::ivec3(column.position.x, y, column.position.y),
+                    std::move(column.chunks[y]));
+    }
+    loaded.full = true;
+    loaded.metadata = std::move(column.metadata);
+    startLighting(column.position, loaded);
+    // One that comes back is what was summarised when it left.
+    if (inserted) {
+      startSummary(column.position, loaded);
+    }
+  }
+
+  std::erase_if(summarising, [&](auto &job) {
+    if (!job->done.isDone()) {
+      return false;
+    }
+    const auto it = columns.find(key(job->column));
+    if (it == columns.end() || it->second.summaryJob != job->number) {
+      return true;
+    }
+    const bool refresh = it->second.summary != nullptr;
+    it->second.summary = std::move(job->summary);
+    if (refresh) {
+      for (uint32_t level = ColumnSummary::LEVEL;
+           level < engine::voxel::LOD_LEVELS; ++level) {
+        remesh(LodTile::of(job->column, level));
+      }
+    }
+    return true;
+  });
+
+  // Stitched in on the main thread, it reads the lit columns beside it.
+  // The meshes the light changed in are patched in `upload`.
+  uint32_t stitched = 0;
+  std::erase_if(lightJobs, [&](auto &job) {
+    if (!job->done.isDone()) {
+      return false;
+    }
+    const auto it = columns.find(key(job->column));
+    if (it != columns.end() && it->second.full &&
+        it->second.lightJob == job->number) {
+      if (stitched == engine::voxel::STITCHES_PER_UPDATE) {
+        return false;
+      }
+      ++stitched;
+      lighting.insertColumn(chunks, job->column, std::move(job->light));
+      it->second.lit = true;
+    }
+    return true;
+  });
+
+  lod.update(eye);
+  updateTiles();
+
+  const auto needed = fullColumns();
+  for (const auto columnKey : needed) {
+    if (const auto it = columns.find(columnKey);
+        it != columns.end() && !it->second.full) {
+      const auto position = engine::voxel::ChunkMap::unpack(columnKey);
+      generator.request(glm::ivec2(position.x, position.z));
+    }
+  }
+  unloadColumns(eye, needed);
+
+  // Finished jobs of tiles removed meanwhile are dropped.
+  std::erase_if(meshing, [&](auto &job) {
+    if (!job->done.isDone()) {
+      return false;
+    }
+    if (const auto it = tiles.find(job->tile.key()); it != tiles.end()) {
+      // Uploaded all the same, the new meshes replace them when done.
+      it->second.state =
+          it->second.remesh ? TileState::Waiting : TileState::Uploading;
+      it->second.remesh = false;
+      uploads.push_back(std::move(job));
+    }
+    return true;
+  });
+
+  if (meshing.size() >= maxMeshJobs) {
+    return;
+  }
+
+  std::vector<std::pair<float, Tile *>> ready;
+  for (auto &[_, tile] : tiles) {
+    if (tile.wanted && tile.state == TileState::Waiting && isReady(tile.tile)) {
+      ready.emplace_back(engine::voxel::LodTree::distance(eye, tile.tile),
+                         &tile);
+    }
+  }
+
+  std::ranges::sort(ready, {}, &std::pair<float, Tile *>::first);
+  for (const auto &[_, tile] : ready) {
+    if (meshing.size() >= maxMeshJobs) {
+      break;
+    }
+    startMeshing(*tile);
+  }
+}
+
+void World::updateTiles() noexcept {
+  for (auto &[_, tile] : tiles) {
+    tile.wanted = false;
+  }
+  for (const auto &picked : lod.tiles()) {
+    tiles.try_emplace(picked.key(), Tile{.tile = picked})
+        .first->second.wanted = true;
+  }
+
+  std::erase_if(tiles, [&](const auto &entry) {
+    const auto &tile = entry.second;
+    if (tile.wanted || (tile.drawn && !isCovered(tile.tile))) {
+      return false;
+    }
+    removed.push_back(tile.tile);
+    return true;
+  });
+}
+
+auto World::isCovered(const LodTile &tile) const noexcept -> bool {
+  for (auto up = tile; up.level + 1 < engine::voxel::LOD_LEVELS;) {
+    up = up.parent();
+    if (const auto it = tiles.find(up.key());
+        it != tiles.end() && it->second.wanted) {
+      return it->second.drawn;
+    }
+  }
+
+  std::vector<LodTile> below;
+  const auto pushChildren = [&](const LodTile &parent) {
+    if (parent.level != 0) {
+      for (uint32_t i = 0; i < 4; ++i) {
+        below.push_back(parent.child(i));
+      }
+    }
+  };
+  pushChildren(tile);
+  while (!below.empty()) {
+    const auto current = below.back();
+    below.pop_back();
+    if (const auto it = tiles.find(current.key());
+        it != tiles.end() && it->second.wanted) {
+      if (!it->second.drawn) {
+        return false;
+      }
+      continue;
+    }
+    pushChildren(current);
+  }
+  return true;
+}
+
+auto World::fullColumns() const noexcept -> std::unordered_set<uint64_t> {
+  std::unordered_set<uint64_t> needed;
+  for (const auto &[_, entry] : tiles) {
+    const auto &tile = entry.tile;
+    if (!entry.wanted || tile.level >= ColumnSummary::LEVEL) {
+      continue;
+    }
+    const auto first = tile.firstColumn();
+    for (int32_t z = 0; z < tile.size(); ++z) {
+      for (int32_t x = 0; x < tile.size(); ++x) {
+        needed.insert(key(first + glm::ivec2(x, z)));
+      }
+    }
+    if (tile.level == 0) {
+      for (const auto side : SIDES) {
+        needed.insert(key(first + side));
+      }
+    }
+  }
+  return needed;
+}
+
+void World::unloadColumns(
+    const glm::vec3 &eye, const std::unordered_set<uint64_t> &needed) noexcept {
+  // Edited columns are saved first and let go of once that is on disk.
+  const auto unloadDistance =
+      static_cast<float>(generatorRadius) + UNLOAD_MARGIN;
+  std::vector<glm::ivec2> leaving;
+  // A loop rather than `erase_if`, whose predicate only sees the columns as
+  // const.
+  for (auto it = columns.begin(); it != columns.end();) {
+    auto &loaded = it->second;
+    const auto position = engine::voxel::ChunkMap::unpack(it->first);
+    const glm::ivec2 column(position.x, position.z);
+    const bool inRange =
+        TerrainGenerator::distance(eye, column) <= unloadDistance;
+    bool keepChunks = loaded.full && inRange && needed.contains(it->first);
+    if (loaded.full && !keepChunks) {
+      if (saver) {
+        if (isDirty(column)) {
+          leaving.push_back(column);
+          keepChunks = true;
+        } else {
+          keepChunks = loaded.saveTicket > saver->saved();
+        }
+      } else {
+        // Nowhere to save the edits, so they stay while in range.
+        keepChunks = inRange && isDirty(column);
+      }
+
+      if (!keepChunks) {
+        if (inRange && loaded.edited) {
+          startSummary(column, loaded);
+        }
+        for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+          chunks.erase(glm::ivec3(column.x, y, column.y));
+        }
+        loaded.full = false;
+        lighting.eraseColumn(column);
+        loaded.lit = false;
+      }
+    }
+    it = inRange || keepChunks ? std::next(it) : columns.erase(it);
+  }
+  if (saver) {
+    autosave(engine::voxel::AUTOSAVE_COLUMNS, leaving);
+  }
+}
+
+auto World::setBlock(glm::ivec3 position,
+                     engine::voxel::BlockId block) noexcept -> bool {
+  if (!chunks.setBlock(position, block)) {
+    return false;
+  }
+  const auto chunk = engine::voxel::ChunkMap::chunkOf(position);
+  const glm::ivec2 column(chunk.x, chunk.z);
+  auto &loaded = columns[key(column)];
+  loaded.edited = true;
+  // Coarser tiles are meshed from the column's summary, taken again when
+  // its chunks are let go.
+  remesh(LodTile::of(column, 1));
+  engine::voxel::markBlock(position, edits);
+
+  // A column still being lit has to start over from its chunks as they are
+  // now.
+  if (loaded.lit) {
+    lighting.blockChanged(chunks, position);
+  } else {
+    startLighting(column, loaded);
+  }
+  return true;
+}
+
+auto World::pick(glm::vec3 origin, glm::vec3 direction,
+                 float reach) const noexcept -> std::optional<Pick> {
+  // Steps from block to block through whichever face the ray leaves by
+  // first, `next` being how far along the ray the next face on each axis is.
+  constexpr auto NEVER = std::numeric_limits<float>::infinity();
+  glm::ivec3 block(glm::floor(origin));
+  glm::ivec3 step(0);
+  glm::vec3 delta(NEVER);
+  glm::vec3 next(NEVER);
+  for (glm::length_t axis = 0; axis < 3; ++axis) {
+    if (direction[axis] == 0.0f) {
+      continue;
+    }
+    step[axis] = direction[axis] > 0.0f ? 1 : -1;
+    delta[axis] = std::abs(1.0f / direction[axis]);
+    const auto face = static_cast<float>(block[axis] + (step[axis] > 0));
+    next[axis] = std::abs(face - origin[axis]) * delta[axis];
+  }
+
+  glm::ivec3 normal(0);
+  for (float distance = 0.0f; distance <= reach;) {
+    if (chunks.getBlock(block) != engine::voxel::AIR) {
+      return Pick{.block = block, .normal = normal};
+    }
+    glm::length_t axis = 0;
+    if (next.y < next[axis]) {
+      axis = 1;
+    }
+    if (next.z < next[axis]) {
+      axis = 2;
+    }
+    distance = next[axis];
+    next[axis] += delta[axis];
+    block[axis] += step[axis];
+    normal = glm::ivec3(0);
+    normal[axis] = -step[axis];
+  }
+  return std::nullopt;
+}
+
+void World::remesh(const LodTile &tile) noexcept {
+  const auto it = tiles.find(tile.key());
+  if (it == tiles.end()) {
+    return;
+  }
+  auto &entry = it->second;
+  if (entry.state == TileState::Meshing) {
+    entry.remesh = true;
+  } else {
+    entry.state = TileState::Waiting;
+  }
+}
+
+void World::autosave(uint32_t maxColumns,
+                     std::span<const glm::ivec2> extra) noexcept {
+  std::vector<glm::ivec2> positions(extra.begin(), extra.end());
+  chunks.takeDirtyColumns(maxColumns, positions);
+  if (positions.empty()) {
+    return;
+  }
+  std::ranges::sort(positions, [](glm::ivec2 a, glm::ivec2 b) {
+    return a.x != b.x ? a.x < b.x : a.y < b.y;
+  });
+  positions.erase(std::unique(positions.begin(), positions.end()),
+                  positions.end());
+
+  // The whole column is saved, so every chunk in it is clean after this.
+  std::vector<engine::voxel::BackgroundSaver::Column> snapshots;
+  snapshots.reserve(positions.size());
+  for (const auto position : positions) {
+    auto &snapshot = snapshots.emplace_back();
+    snapshot.position = position;
+    snapshot.metadata = columns[key(position)].metadata;
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      const auto handle = chunks.find(glm::ivec3(position.x, y, position.y));
+      snapshot.chunks[y] = *chunks.get(handle);
+      chunks.clearDirty(handle);
+    }
+  }
+
+  const auto ticket = saver->submit(std::move(snapshots));
+  for (const auto position : positions) {
+    columns[key(position)].saveTicket = ticket;
+  }
+}
+
+auto World::isDirty(glm::ivec2 column) const noexcept -> bool {
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    if (chunks.isDirty(chunks.find(glm::ivec3(column.x, y, column.y)))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto World::isReady(const LodTile &tile) const noexcept -> bool {
+  const auto has = [&](glm::ivec2 column, bool full) {
+    const auto it = columns.find(key(column));
+    return it != columns.end() &&
+           (full ? it->second.full : it->second.summary != nullptr);
+  };
+
+  const auto first = tile.firstColumn();
+  if (tile.level == 0) {
+    // Lit as well, for the light its faces are baked with.
+    const auto lit = [&](glm::ivec2 column) {
+      const auto it = columns.find(key(column));
+      return it != columns.end() && it->second.full && it->second.lit;
+    };
+    return lit(first) && std::ranges::all_of(SIDES, [&](glm::ivec2 side) {
+             return lit(first + side);
+           });
+  }
+  const bool full = tile.level < ColumnSummary::LEVEL;
+  for (int32_t z = 0; z < tile.size(); ++z) {
+    for (int32_t x = 0; x < tile.size(); ++x) {
+      if (!has(first + glm::ivec2(x, z), full)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void World::startSummary(glm::ivec2 column, LoadedColumn &loaded) noexcept {
+  auto job = std::make_unique<SummaryJob>();
+  job->column = column;
+  job->number = ++summaryJobs;
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    job->chunks[y] =
+        *chunks.get(chunks.find(glm::ivec3(column.x, y, column.y)));
+  }
+  loaded.summaryJob = job->number;
+  loaded.edited = false;
+
+  jobs->submit(
+      [state = job.get()]() {
+        EG_ZONE("Summarise column");
+        state->summary = std::make_shared<ColumnSummary>(state->chunks);
+      },
+      &job->done);
+  summarising.push_back(std::move(job));
+}
+
+void World::startLighting(glm::ivec2 column, LoadedColumn &loaded) noexcept {
+  auto job = std::make_unique<LightJob>();
+  job->column = column;
+  job->number = ++lightJobCount;
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    job->chunks[y] =
+        *chunks.get(chunks.find(glm::ivec3(column.x, y, column.y)));
+  }
+  loaded.lightJob = job->number;
+
+  jobs->submit(
+      [state = job.get()]() {
+        EG_ZONE("Light column");
+        state->light = engine::voxel::Lighting::lightColumn(state->chunks);
+      },
+      &job->done);
+  lightJobs.push_back(std::move(job));
+}
+
+void World::startMeshing(Tile &tile) noexcept {
+  auto job = std::make_unique<MeshJob>();
+  job->tile = tile.tile;
+  const auto copy = [&](glm::ivec2 from) {
+    auto &to = job->columns.emplace_back();
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      to[y] = *chunks.get(chunks.find(glm::ivec3(from.x, y, from.y)));
+    }
+  };
+  const auto copyLight = [&](glm::ivec2 from) {
+    auto &to = job->lights.emplace_back();
+    for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+      to[y] = *lighting.get(glm::ivec3(from.x, y, from.y));
+    }
+  };
+
+  const auto first = tile.tile.firstColumn();
+  if (tile.tile.level == 0) {
+    copy(first);
+    copyLight(first);
+    for (const auto side : SIDES) {
+      copy(first + side);
+      copyLight(first + side);
+    }
+  } else {
+    for (int32_t z = 0; z < tile.tile.size(); ++z) {
+      for (int32_t x = 0; x < tile.tile.size(); ++x) {
+        const auto column = first + glm::ivec2(x, z);
+        if (tile.tile.level < ColumnSummary::LEVEL) {
+          copy(column);
+        } else {
+          job->summaries.push_back(columns.find(key(column))->second.summary);
+        }
+      }
+    }
+  }
+
+  tile.state = TileState::Meshing;
+  jobs->submit([state = job.get()]() { mesh(*state); }, &job->done);
+  meshing.push_back(std::move(job));
+}
+
+void World::mesh(MeshJob &job) noexcept {
+  EG_ZONE("Mesh tile");
+  if (job.tile.level == 0) {
+    meshColumn(job);
+  } else {
+    meshCoarse(job);
+  }
+}
+
+void World::meshColumn(MeshJob &job) noexcept {
+  using engine::voxel::Face;
+
+  thread_local engine::voxel::Mesher mesher;
+  const auto &column = job.columns[0];
+  const auto &light = job.lights[0];
+  for (uint32_t y = 0; y < COLUMN_CHUNKS; ++y) {
+    const auto &chunk = column[y];
+    if (isAir(chunk)) {
+      job.faceCounts[y] = {};
+      job.slices[y] = {};
+      continue;
+    }
+
+    engine::voxel::ChunkNeighbours neighbours;
+    const auto at = [](Face face) { return static_cast<size_t>(face); };
+    neighbours.chunks[at(Face::NegX)] = &job.columns[1][y];
+    neighbours.chunks[at(Face::PosX)] = &job.columns[2][y];
+    neighbours.chunks[at(Face::NegZ)] = &job.columns[3][y];
+    neighbours.chunks[at(Face::PosZ)] = &job.columns[4][y];
+    neighbours.chunks[at(Face::NegY)] = y > 0 ? &column[y - 1] : nullptr;
+    neighbours.chunks[at(Face::PosY)] =
+        y + 1 < COLUMN_CHUNKS ? &column[y + 1] : nullptr;
+    neighbours.light = &light[y];
+    neighbours.lights[at(Face::NegX)] = &job.lights[1][y];
+    neighbours.lights[at(Face::PosX)] = &job.lights[2][y];
+    neighbours.lights[at(Face::NegZ)] = &job.lights[3][y];
+    neighbours.lights[at(Face::PosZ)] = &job.lights[4][y];
+    neighbours.lights[at(Face::NegY)] = y > 0 ? &light[y - 1] : nullptr;
+    neighbours.lights[at(Face::PosY)] =
+        y + 1 < COLUMN_CHUNKS ? &light[y + 1] : nullptr;
+    job.faceCounts[y] =
+        mesher.mesh(chunk, neighbours, job.quads[y], &job.slices[y]);
+  }
+}
+
+void World::meshCoarse(MeshJob &job) noexcept {
+  using engine::voxel::Face;
+
+  thread_local engine::voxel::Mesher mesher;
+
+  // Each mesh is a node of the tile, a chunk of cells `1 << level` blocks a
+  // side, meshed with its sides as air so the tile has skirts.
+  const auto &tile = job.tile;
+  const auto count = tile.meshCount();
+  std::vector<const ColumnSummary *> summaries;
+  for (const auto &summary : job.summaries) {
+    summaries.push_back(summary.get());
+  }
+  std::array<engine::voxel::Chunk, COLUMN_CHUNKS> nodes;
+  for (uint32_t i = 0; i < count; ++i) {
+    nodes[i] = tile.level < ColumnSummary::LEVEL
+                   ? engine::voxel::coarseNode(
+                         std::span<const Column, 4>(job.columns.data(), 4), i)
+                   : engine::voxel::coarseNode(summaries, tile.level, i);
+  }
+
+  for (uint32_t i = 0; i < count; ++i) {
+    if (isAir(nodes[i])) {
+      job.faceCounts[i] = {};
+      continue;
+    }
+    engine::voxel::ChunkNeighbours neighbours;
+    neighbours.chunks[static_cast<size_t>(Face::NegY)] =
+        i > 0 ? &nodes[i - 1] : nullptr;
+    neighbours.chunks[static_cast<size_t>(Face::PosY)] =
+        i + 1 < count ? &nodes[i + 1] : nullptr;
+    job.faceCounts[i] = mesher.mesh(nodes[i], neighbours, job.quads[i]);
+  }
+}
+
+void World::upload(engine::StagingRing &staging,
+                   engine::AsyncUploader &uploader,
+                   vkh::MegaBuffer &chunkBuffer,
+                   const std::function<void(const vkh::MegaBuffer::Range &)>
+                       &release) noexcept {
+  EG_ZONE("World upload");
+  for (const auto &tile : removed) {
+    for (uint32_t i = 0; i < tile.meshCount(); ++i) {
+      removeMesh(tile.meshPosition(i), tile.level, release);
+    }
+  }
+  removed.clear();
+
+  // Before the finished meshes, so no mesh a patch copies from is written
+  // this frame. Patches copy from the old mesh, so they stay in order with
+  // the draws on the graphics queue.
+  patched = 0;
+  patch(staging, chunkBuffer, release);
+
+  while (!uploads.empty()) {
+    auto &job = *uploads.front();
+    const auto tile = tiles.find(job.tile.key());
+    if (tile == tiles.end()) {
+      uploads.pop_front();
+      continue;
+    }
+
+    for (; job.uploaded < job.tile.meshCount(); ++job.uploaded) {
+      const auto i = job.uploaded;
+      const auto position = job.tile.meshPosition(i);
+      const auto &quads = job.quads[i];
+      if (quads.empty()) {
+        removeMesh(position, job.tile.level, release);
+        continue;
+      }
+
+      const auto range =
+          chunkBuffer.allocate(quads.size() * sizeof(engine::voxel::Quad),
+                               alignof(engine::voxel::Quad));
+      if (!range) {
+        Logger::warn("Chunk buffer full, dropping mesh of chunk ({}, {}, {})",
+                     position.x, position.y, position.z);
+        continue;
+      }
+      // Never seen by the GPU, so it can be freed straight away.
+      if (!uploader.upload(chunkBuffer.getBuffer().buffer, range->offset,
+                           std::span(quads))) {
+        chunkBuffer.free(*range);
+        return;
+      }
+
+      setMesh(ChunkMesh{.position = position,
+                        .range = *range,
+                        .quadCount = static_cast<uint32_t>(quads.size()),
+                        .faceCounts = job.faceCounts[i],
+                        .level = job.tile.level},
+              release);
+      if (job.tile.level == 0) {
+        slices[engine::voxel::ChunkMap::pack(position)] = job.slices[i];
+      }
+    }
+    tile->second.drawn = true;
+    if (tile->second.state == TileState::Uploading) {
+      tile->second.state = TileState::Meshed;
+    }
+    uploads.pop_front();
+  }
+}
+
+void World::patch(engine::StagingRing &staging, vkh::MegaBuffer &chunkBuffer,
+                  const std::function<void(const vkh::MegaBuffer::Range &)>
+                      &release) noexcept {
+  EG_ZONE("World patch");
+  lightChanges.clear();
+  lighting.takeChanged(lightChanges);
+  for (const auto position : lightChanges) {
+    engine::voxel::markBlock(position, edits);
+  }
+
+  for (auto it = edits.begin(); it != edits.end();) {
+    const auto position = engine::voxel::ChunkMap::unpack(it->first);
+    const auto tile =
+        tiles.find(LodTile::of(glm::ivec2(position.x, position.z), 0).key());
+    const auto handle = chunks.find(position);
+    // A tile still to be meshed sees the edit anyway. One being meshed or
+    // uploaded may have copied its chunks before it, and is patched once
+    // its meshes are up.
+    if (tile == tiles.end() || tile->second.state == TileState::Waiting ||
+        !chunks.contains(handle)) {
+      it = edits.erase(it);
+      continue;
+    }
+    if (tile->second.state != TileState::Meshed) {
+      ++it;
+      continue;
+    }
+    if (!patchMesh(position, it->second, staging, chunkBuffer, release)) {
+      return;
+    }
+    ++patched;
+    it = edits.erase(it);
+  }
+}
+
+auto World::patchMesh(glm::ivec3 position,
+                      const engine::voxel::DirtySlices &dirty,
+                      engine::StagingRing &staging,
+                      vkh::MegaBuffer &chunkBuffer,
+                      const std::function<void(const vkh::MegaBuffer::Range &)>
+                          &release) noexcept -> bool {
+  using engine::voxel::Quad;
+
+  const auto meshKey = engine::voxel::ChunkMap::pack(position);
+  const auto handle = chunks.find(position);
+  // With no mesh to keep slices from, every slice is meshed again.
+  const auto previous = meshIndices[0].find(meshKey);
+  const bool hasPrevious = previous != meshIndices[0].end();
+  const auto remeshed =
+      hasPrevious ? dirty : engine::voxel::DirtySlices::all();
+  const auto found = slices.find(meshKey);
+  const auto before = hasPrevious && found != slices.end()
+                          ? found->second
+                          : engine::voxel::SliceCounts{};
+  auto after = before;
+  auto neighbours = chunks.faceNeighbours(handle);
+  neighbours.light = lighting.get(position);
+  for (uint32_t face = 0; face < engine::voxel::FACE_COUNT; ++face) {
+    const auto direction = static_cast<engine::voxel::Face>(face);
+    glm::ivec3 offset(0);
+    offset[static_cast<glm::length_t>(engine::voxel::faceAxis(direction))] =
+        engine::voxel::isPositive(direction) ? 1 : -1;
+    neighbours.lights[face] = lighting.get(position + offset);
+  }
+  patchQuads.clear();
+  patchRuns.clear();
+  mesher.remesh(*chunks.get(handle), neighbours, remeshed, patchQuads, after);
+  engine::voxel::sliceRuns(before, after, remeshed, patchRuns);
+
+  const auto quadCount =
+      patchRuns.empty() ? 0 : patchRuns.back().target + patchRuns.back().count;
+  if (quadCount == 0) {
+    removeMesh(position, 0, release);
+    return true;
+  }
+
+  // Where no slice's count changed, every quad kept stays where it was, so
+  // only the slices meshed again are written, over the mesh in place. All
+  // or none of them, so a full ring never leaves it half patched.
+  const auto buffer = chunkBuffer.getBuffer().buffer;
+  if (hasPrevious && after == before) {
+    vk::DeviceSize needed = 0;
+    for (const auto &run : patchRuns) {
+      if (run.remeshed) {
+        needed += run.count * sizeof(Quad) +
+                  engine::StagingRing::UPLOAD_ALIGNMENT;
+      }
+    }
+    if (needed > staging.room()) {
+      return false;
+    }
+    const auto offset = chunkMeshes[previous->second].range.offset;
+    for (const auto &run : patchRuns) {
+      if (run.remeshed &&
+          !staging.upload(buffer, offset + run.target * sizeof(Quad),
+                          std::span<const Quad>(patchQuads)
+                              .subspan(run.source, run.count))) {
+        return false;
+      }
+    }
+    // Frames still in flight may be drawing the mesh.
+    staging.waitForReads();
+    return true;
+  }
+
+  const auto range = chunkBuffer.allocate(quadCount * sizeof(Quad),
+                                          alignof(Quad));
+  if (!range) {
+    Logger::warn("Chunk buffer full, dropping edit of chunk ({}, {}, {})",
+                 position.x, position.y, position.z);
+    return true;
+  }
+
+  // Slices left as they were are copied from the mesh being replaced.
+  for (const auto &run : patchRuns) {
+    const auto target = range->offset + run.target * sizeof(Quad);
+    if (!run.remeshed) {
+      staging.copy(buffer,
+                   chunkMeshes[previous->second].range.offset +
+                       run.source * sizeof(Quad),
+                   target, run.count * sizeof(Quad));
+    } else if (!staging.upload(buffer, target,
+                               std::span<const Quad>(patchQuads).subspan(
+                                   run.source, run.count))) {
+      // Copies into it may be queued already, so it has to outlive them.
+      release(*range);
+      return false;
+    }
+  }
+
+  setMesh(ChunkMesh{.position = position,
+                    .range = *range,
+                    .quadCount = quadCount,
+                    .faceCounts = engine::voxel::faceCounts(after),
+                    .level = 0},
+          release);
+  slices[meshKey] = after;
+  return true;
+}
+
+auto World::stats() const noexcept -> Stats {
+  Stats stats{.columns = static_cast<uint32_t>(columns.size()),
+              .generating = generator.jobsInFlight(),
+              .meshing = static_cast<uint32_t>(meshing.size()),
+              .lighting = static_cast<uint32_t>(lightJobs.size()),
+              .uploading = static_cast<uint32_t>(uploads.size()),
+              .saving = saver ? saver->backlog() : 0,
+              .patched = patched,
+              .tiles = {}};
+  for (const auto &[_, tile] : tiles) {
+    if (tile.drawn) {
+      ++stats.tiles[tile.tile.level];
+    }
+  }
+  return stats;
+}
+
+void World::setMesh(const ChunkMesh &mesh,
+                    const std::function<void(const vkh::MegaBuffer::Range &)>
+                        &release) noexcept {
+  const auto [it, inserted] = meshIndices[mesh.level].try_emplace(
+      engine::voxel::ChunkMap::pack(mesh.position),
+      static_cast<uint32_t>(chunkMeshes.size()));
+  if (inserted) {
+    chunkMeshes.push_back(mesh);
+    return;
+  }
+  release(chunkMeshes[it->second].range);
+  chunkMeshes[it->second] = mesh;
+}
+
+void World::removeMesh(glm::ivec3 position, uint32_t level,
+                       const std::function<void(const vkh::MegaBuffer::Range &)>
+                           &release) noexcept {
+  auto &indices = meshIndices[level];
+  const auto it = indices.find(engine::voxel::ChunkMap::pack(position));
+  if (it == indices.end()) {
+    return;
+  }
+  const auto index = it->second;
+  indices.erase(it);
+  if (level == 0) {
+    slices.erase(engine::voxel::ChunkMap::pack(position));
+  }
+  release(chunkMeshes[index].range);
+
+  // Keeps the list packed by moving the last mesh into the gap.
+  if (index + 1 != chunkMeshes.size()) {
+    const auto &last = chunkMeshes.back();
+    meshIndices[last.level][engine::voxel::ChunkMap::pack(last.position)] =
+        index;
+    chunkMeshes[index] = last;
+  }
+  chunkMeshes.pop_back();
+}
@@ -0,0 +1,352 @@
+#pragma once
+
+#include "app/draws.hpp"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <engine/jobs.hpp>
+#include <engine/staging.hpp>
+#include <engine/uploader.hpp>
+#include <engine/voxel/chunkMap.hpp>
+#include <engine/voxel/light.hpp>
+#include <engine/voxel/lod.hpp>
+#include <engine/voxel/mesher.hpp>
+#include <engine/voxel/region.hpp>
+#include <engine/voxel/saver.hpp>
+#include <engine/voxel/terrain.hpp>
+#include <glm/glm.hpp>
+#include <vkh/megaBuffer.hpp>
+
+/// Keeps the terrain around the camera generated, meshed and uploaded into
+/// the chunk buffer.
+///
+/// Terrain is drawn in `LodTile`s picked by a `LodTree`: full detail near
+/// the camera and coarser further out. Generation and meshing both run on
+/// the job system, and meshing jobs work on copies of the chunks they read so
+/// they never share chunk data with the main thread. A full detail tile, a
+/// single column, is meshed once the four columns beside it are loaded, so
+/// faces on its border are culled against real neighbours. A coarser tile
+/// is meshed from its columns downsampled, as if nothing were beside it, so
+/// it has walls, skirts, on its sides that hide the cracks where it meets
+/// tiles of another level.
+///
+/// Columns keep their chunks while a tile of level 1 or finer covers them or
+/// a full detail tile beside them, and otherwise only a `ColumnSummary` for
+/// the coarser levels, asking the generator for the chunks again when the
+/// camera comes back. A tile that leaves the selection is drawn until the
+/// tiles replacing it are, so no holes open while they mesh.
+///
+/// Generated columns are saved into region files under the save directory,
+/// and loaded from there instead of generated the next time round.
+///
+/// An edit patches the full detail meshes it shows in on the main thread,
+/// in the next `upload`: only the slices of each face it touches are meshed
+/// again and staged. Where their quad counts are unchanged they are written
+/// over the mesh in place, otherwise into a new mesh the rest is copied
+/// into on the GPU from the one it replaces. Coarser tiles are meshed again
+/// on the job system.
+///
+/// Columns are lit by a `Lighting` once loaded, each on its own on the job
+/// system and then stitched to the lit columns beside it on the main thread.
+/// A full detail tile waits for its column and the ones beside it to be lit
+/// and bakes their light into its meshes. Edits relight around them on the
+/// main thread, and the meshes the light changed in are patched along with
+/// the edit's. Coarser tiles are lit as if under the open sky.
+///
+/// Edited chunks are flagged dirty and autosaved a few columns a frame: the
+/// columns are copied, which shares their index storage until the next edit,
+/// and handed to a `BackgroundSaver`. A column with unsaved edits stays
+/// loaded until its save is on disk, so it never comes back from the store
+/// older than it left.
+class World {
+public:
+  struct Settings {
+    /// `store` is filled in by the world.
+    engine::voxel::TerrainGenerator::Settings terrain;
+    /// In columns, drawn at full detail.
+    uint32_t viewDistance;
+    /// Levels of detail past full detail, each reaching twice as far as the
+    /// one before, below `LOD_LEVELS`.
+    uint32_t lodLevels = 0;
+    /// Nothing is saved if empty.
+    std::filesystem::path saveDirectory;
+    engine::voxel::BackgroundSaver::Settings saver;
+  };
+
+  struct Stats {
+    uint32_t columns;
+    uint32_t generating;
+    uint32_t meshing;
+    /// Columns being lit on their own.
+    uint32_t lighting;
+    /// Columns meshed and waiting for room in the staging ring.
+    uint32_t uploading;
+    /// Columns snapshotted and not yet on disk.
+    uint32_t saving;
+    /// Full detail meshes patched after edits by the last `upload`.
+    uint32_t patched;
+    /// Tiles drawn per level of detail.
+    std::array<uint32_t, engine::voxel::LOD_LEVELS> tiles;
+  };
+
+  /// A block looked at, see `pick`.
+  struct Pick {
+    glm::ivec3 block;
+    /// Towards the block in front of the face the ray entered through, zero
+    /// if it started inside the block.
+    glm::ivec3 normal;
+  };
+
+  World(engine::JobSystem &jobs, const Settings &settings) noexcept;
+  World(const World &) = delete;
+  World(World &&) noexcept = default;
+  /// Waits for the jobs in flight and saves every edited column.
+  ~World();
+
+  /// Takes in finished columns, picks the tiles to draw around `eye` and
+  /// starts meshing the ones ready, nearest first. Autosaves some of the
+  /// edited columns. Columns well out of range are unloaded.
+  void update(const glm::vec3 &eye) noexcept;
+
+  /// The block at `position` in world blocks, `AIR` where nothing is loaded.
+  [[nodiscard]] auto getBlock(glm::ivec3 position) const noexcept
+      -> engine::voxel::BlockId {
+    return chunks.getBlock(position);
+  }
+
+  /// Sets the block at `position` in world blocks and relights around it,
+  /// patches the full detail meshes it and its light show in with the next
+  /// `upload` and meshes the coarser tiles again. False where the chunk is
+  /// not loaded.
+  auto setBlock(glm::ivec3 position, engine::voxel::BlockId block) noexcept
+      -> bool;
+
+  /// The first block other than air along the ray from `origin` in
+  /// `direction`, up to `reach` blocks away. Chunks not loaded count as air.
+  [[nodiscard]] auto pick(glm::vec3 origin, glm::vec3 direction,
+                          float reach) const noexcept -> std::optional<Pick>;
+
+  /// Patches the meshes edits show in through `staging`, so call it between
+  /// `beginFrame` and `flush`, and uploads finished meshes into
+  /// `chunkBuffer` through `uploader`, as many as its batch has room for, to
+  /// be submitted after. `chunkBuffer` needs the transfer source usage and
+  /// must be shared with the uploader's families. Replaced and removed
+  /// meshes go to `release`, which must keep their range alive until the GPU
+  /// is done with it.
+  void upload(engine::StagingRing &staging, engine::AsyncUploader &uploader,
+              vkh::MegaBuffer &chunkBuffer,
+              const std::function<void(const vkh::MegaBuffer::Range &)>
+                  &release) noexcept;
+
+  /// Only changes in `upload`.
+  [[nodiscard]] auto meshes() const noexcept -> std::span<const ChunkMesh> {
+    return chunkMeshes;
+  }
+
+  [[nodiscard]] auto stats() const noexcept -> Stats;
+
+private:
+  using Column = std::array<engine::voxel::Chunk,
+                            engine::voxel::COLUMN_CHUNKS>;
+
+  /// Columns beside a column, in -x, +x, -z, +z order.
+  static constexpr std::array<glm::ivec2, 4> SIDES = {
+      glm::ivec2(-1, 0), glm::ivec2(1, 0), glm::ivec2(0, -1),
+      glm::ivec2(0, 1)};
+
+  /// Meshes a tile, `tile.meshCount()` meshes from the bottom up.
+  struct MeshJob {
+    engine::voxel::LodTile tile;
+    /// Copies of the chunks read. Level 0: the tile's column, then the
+    /// columns at `SIDES`. Level 1: the tile's columns, x first.
+    std::vector<Column> columns;
+    /// Levels 2 and up: the tile's columns, x first.
+    std::vector<std::shared_ptr<const engine::voxel::ColumnSummary>>
+        summaries;
+    std::array<std::vector<engine::voxel::Quad>, engine::voxel::COLUMN_CHUNKS>
+        quads;
+    std::array<engine::voxel::FaceCounts, engine::voxel::COLUMN_CHUNKS>
+        faceCounts;
+    /// Level 0 only, the light of `columns`.
+    std::vector<engine::voxel::ColumnLight> lights;
+    /// Level 0 only, see `World::slices`.
+    std::array<engine::voxel::SliceCounts, engine::voxel::COLUMN_CHUNKS>
+        slices;
+    /// Meshes uploaded so far, a tile can take more than one frame.
+    uint32_t uploaded = 0;
+    engine::JobCounter done;
+  };
+
+  struct SummaryJob {
+    glm::ivec2 column;
+    /// Only the column's latest job is kept, see `LoadedColumn::summaryJob`.
+    uint64_t number;
+    Column chunks;
+    std::shared_ptr<engine::voxel::ColumnSummary> summary;
+    engine::JobCounter done;
+  };
+
+  struct LightJob {
+    glm::ivec2 column;
+    /// Only the column's latest job is kept, see `LoadedColumn::lightJob`.
+    uint64_t number;
+    Column chunks;
+    engine::voxel::ColumnLight light;
+    engine::JobCounter done;
+  };
+
+  /// A tile is `Meshed` once its meshes are all uploaded.
+  enum class TileState : uint8_t { Waiting, Meshing, Uploading, Meshed };
+
+  struct Tile {
+    engine::voxel::LodTile tile;
+    TileState state = TileState::Waiting;
+    /// Picked by the last `LodTree::update`. A tile that is not stays until
+    /// the tiles covering it instead are drawn.
+    bool wanted = true;
+    /// Every mesh uploaded at least once.
+    bool drawn = false;
+    /// Edited while meshing, so meshed again once the job is done.
+    bool remesh = false;
+  };
+
+  struct LoadedColumn {
+    /// Whether its chunks are in `chunks`.
+    bool full = true;
+    /// Edited since its summary was taken.
+    bool edited = false;
+    /// Of the last snapshot handed to the saver, 0 if none.
+    uint64_t saveTicket = 0;
+    /// From the generator, saved along with the chunks.
+    std::vector<std::byte> metadata;
+    /// Null until the first summary job is done.
+    std::shared_ptr<const engine::voxel::ColumnSummary> summary;
+    /// Number of the last summary job started for it.
+    uint64_t summaryJob = 0;
+    /// Whether its light is in `lighting`, only while its chunks are loaded.
+    bool lit = false;
+    /// Number of the last light job started for it.
+    uint64_t lightJob = 0;
+  };
+
+  engine::JobSystem *jobs;
+  /// Null when not saving. Declared before the saver and the generator,
+  /// which both save to it until destroyed.
+  std::unique_ptr<engine::voxel::RegionStore> store;
+  /// Null when not saving.
+  std::unique_ptr<engine::voxel::BackgroundSaver> saver;
+  engine::voxel::TerrainGenerator generator;
+  engine::voxel::LodTree lod;
+  /// In columns, every column a tile may cover is generated.
+  uint32_t generatorRadius;
+  uint32_t maxMeshJobs;
+
+  engine::voxel::ChunkMap chunks;
+  /// Loaded columns by `key`.
+  std::unordered_map<uint64_t, LoadedColumn> columns;
+  /// Tiles drawn or to be drawn by `LodTile::key`.
+  std::unordered_map<uint64_t, Tile> tiles;
+  std::vector<std::unique_ptr<MeshJob>> meshing;
+  std::vector<std::unique_ptr<SummaryJob>> summarising;
+  uint64_t summaryJobs = 0;
+  std::vector<std::unique_ptr<LightJob>> lightJobs;
+  uint64_t lightJobCount = 0;
+  engine::voxel::Lighting lighting;
+  std::deque<std::unique_ptr<MeshJob>> uploads;
+  /// Tiles whose meshes are released in `upload`.
+  std::vector<engine::voxel::LodTile> removed;
+
+  /// Edits waiting to be patched into full detail meshes by `ChunkMap::pack`
+  /// of the chunk, see `engine::voxel::markBlock`.
+  std::unordered_map<uint64_t, engine::voxel::DirtySlices> edits;
+  /// Meshes edits on the main thread.
+  engine::voxel::Mesher mesher;
+  /// Reused by `patch`.
+  std::vector<engine::voxel::Quad> patchQuads;
+  std::vector<engine::voxel::SliceRun> patchRuns;
+  std::vector<glm::ivec3> lightChanges;
+  uint32_t patched = 0;
+
+  std::vector<ChunkMesh> chunkMeshes;
+  /// Index into `chunkMeshes` per level by `ChunkMap::pack` of the mesh
+  /// position.
+  std::array<std::unordered_map<uint64_t, uint32_t>,
+             engine::voxel::LOD_LEVELS>
+      meshIndices;
+  /// Slices of the level 0 meshes by `ChunkMap::pack` of their position, all
+  /// empty where there is none.
+  std::unordered_map<uint64_t, engine::voxel::SliceCounts> slices;
+
+  [[nodiscard]] static auto key(glm::ivec2 column) noexcept -> uint64_t {
+    return engine::voxel::ChunkMap::pack(glm::ivec3(column.x, 0, column.y));
+  }
+
+  [[nodiscard]] static auto
+  openStore(const std::filesystem::path &directory) noexcept
+      -> std::unique_ptr<engine::voxel::RegionStore>;
+  [[nodiscard]] static auto
+  withStore(engine::voxel::TerrainGenerator::Settings settings,
+            engine::voxel::RegionStore *store) noexcept
+      -> engine::voxel::TerrainGenerator::Settings {
+    settings.store = store;
+    return settings;
+  }
+
+  /// Copies up to `maxColumns` columns with dirty chunks into one batch for
+  /// the saver, along with the columns in `extra`.
+  void autosave(uint32_t maxColumns,
+                std::span<const glm::ivec2> extra) noexcept;
+  /// Whether any chunk of `column` is edited and not yet snapshotted.
+  [[nodiscard]] auto isDirty(glm::ivec2 column) const noexcept -> bool;
+  /// Whether the columns `tile` reads are loaded.
+  [[nodiscard]] auto isReady(const engine::voxel::LodTile &tile) const noexcept
+      -> bool;
+  /// Whether every tile picked that overlaps `tile` is drawn, so it can go.
+  [[nodiscard]] auto
+  isCovered(const engine::voxel::LodTile &tile) const noexcept -> bool;
+  /// Keys of the columns whose chunks the tiles picked read.
+  [[nodiscard]] auto fullColumns() const noexcept
+      -> std::unordered_set<uint64_t>;
+  /// Adds the tiles picked and removes the ones no longer needed.
+  void updateTiles() noexcept;
+  /// Lets go of the columns out of range, and of the chunks of columns not
+  /// in `needed`.
+  void unloadColumns(const glm::vec3 &eye,
+                     const std::unordered_set<uint64_t> &needed) noexcept;
+  void remesh(const engine::voxel::LodTile &tile) noexcept;
+  /// Patches the meshes of the chunks in `edits` whose tiles are meshed,
+  /// after adding the blocks whose light changed. Stops once `staging` is
+  /// full.
+  void patch(engine::StagingRing &staging, vkh::MegaBuffer &chunkBuffer,
+             const std::function<void(const vkh::MegaBuffer::Range &)>
+                 &release) noexcept;
+  /// False when `staging` is full, the mesh is left as it was.
+  auto patchMesh(glm::ivec3 position,
+                 const engine::voxel::DirtySlices &dirty,
+                 engine::StagingRing &staging, vkh::MegaBuffer &chunkBuffer,
+                 const std::function<void(const vkh::MegaBuffer::Range &)>
+                     &release) noexcept -> bool;
+  void startSummary(glm::ivec2 column, LoadedColumn &loaded) noexcept;
+  /// Lights the column again from its chunks now, dropping any job before.
+  void startLighting(glm::ivec2 column, LoadedColumn &loaded) noexcept;
+  void startMeshing(Tile &tile) noexcept;
+  static void mesh(MeshJob &job) noexcept;
+  static void meshColumn(MeshJob &job) noexcept;
+  static void meshCoarse(MeshJob &job) noexcept;
+  void setMesh(const ChunkMesh &mesh,
+               const std::function<void(const vkh::MegaBuffer::Range &)>
+                   &release) noexcept;
+  void removeMesh(glm::ivec3 position, uint32_t level,
+                  const std::function<void(const vkh::MegaBuffer::Range &)>
+                      &release) noexcept;
+};
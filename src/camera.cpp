@@ -4,8 +4,7 @@
 #include <engine/directions.hpp>
 
 void PerspectiveCamera::update(const engine::FrameData &data) noexcept {
-  auto deltaMs = data.deltaTimeMs;
-  auto scale = deltaMs * 25.0f;
+  auto scale = data.deltaTime * 25.0f;
   const auto &input = data.input;
 
   constexpr float rotationSpeed = 1.f;
@@ -13,28 +12,9 @@ void PerspectiveCamera::update(const engine::FrameData &data) noexcept {
   auto delta = input.mouse().delta();
   engine::Camera::Axes rot{
       .yaw = delta.x * rotationSpeed,
-      .pitch = delta.y * rotationSpeed,
+      .pitch = -delta.y * rotationSpeed,
   };
 
-  if (input.isPressed(engine::Key::W)) {
-    move(engine::FORWARD * scale);
-  }
-  if (input.isPressed(engine::Key::S)) {
-    move(engine::BACKWARD * scale);
-  }
-  if (input.isPressed(engine::Key::A)) {
-    move(-engine::LEFT * scale);
-  }
-  if (input.isPressed(engine::Key::D)) {
-    move(-engine::RIGHT * scale);
-  }
-  if (input.isPressed(engine::Key::Space)) {
-    moveAbsolute(-engine::UP * scale);
-  }
-  if (input.isPressed(engine::Key::Ctrl)) {
-    moveAbsolute(-engine::DOWN * scale);
-  }
-
   if (input.isPressed(engine::Key::Left)) {
     rot.yaw -= scale;
   }
@@ -42,10 +22,10 @@ void PerspectiveCamera::update(const engine::FrameData &data) noexcept {
     rot.yaw += scale;
   }
   if (input.isPressed(engine::Key::Up)) {
-    rot.pitch -= scale;
+    rot.pitch += scale;
   }
   if (input.isPressed(engine::Key::Down)) {
-    rot.pitch += scale;
+    rot.pitch -= scale;
   }
 
   if (input.isDown(engine::Key::C)) {
@@ -55,6 +35,30 @@ void PerspectiveCamera::update(const engine::FrameData &data) noexcept {
   rotate(rot);
 }
 
+void PerspectiveCamera::tick(const engine::FrameData &data) noexcept {
+  auto scale = data.deltaTime * 25.0f;
+  const auto &input = data.input;
+
+  if (input.isPressed(engine::Key::W)) {
+    move(engine::FORWARD * scale);
+  }
+  if (input.isPressed(engine::Key::S)) {
+    move(engine::BACKWARD * scale);
+  }
+  if (input.isPressed(engine::Key::A)) {
+    move(-engine::LEFT * scale);
+  }
+  if (input.isPressed(engine::Key::D)) {
+    move(-engine::RIGHT * scale);
+  }
+  if (input.isPressed(engine::Key::Space)) {
+    moveAbsolute(engine::UP * scale);
+  }
+  if (input.isPressed(engine::Key::Ctrl)) {
+    moveAbsolute(engine::DOWN * scale);
+  }
+}
+
 [[nodiscard]] auto PerspectiveCamera::createDescriptorSets(
     const vk::raii::Device &device,
     const vk::raii::DescriptorPool &descriptorPool,
@@ -144,8 +148,9 @@ auto PerspectiveCamera::descriptorLayout(
       .binding = 0,
       .descriptorType = vk::DescriptorType::eUniformBuffer,
       .descriptorCount = 1,
-      .stageFlags =
-          vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment,
+      .stageFlags = vk::ShaderStageFlagBits::eVertex |
+                    vk::ShaderStageFlagBits::eFragment |
+                    vk::ShaderStageFlagBits::eCompute,
   };
 
   vk::DescriptorSetLayoutCreateInfo layoutInfo{.bindingCount = 1,
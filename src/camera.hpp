@@ -20,7 +20,10 @@ public:
                     const engine::cameras::Perspective::Params &params) noexcept
       : engine::cameras::Perspective(position, rotation, params) {}
 
+  /// Looks around with the mouse and arrow keys.
   void update(const engine::FrameData &) noexcept override;
+  /// Flies with WASD, space and control.
+  void tick(const engine::FrameData &) noexcept override;
 
   [[nodiscard]] static auto
   descriptorLayout(const vk::raii::Device &device) noexcept
@@ -0,0 +1,79 @@
+#include "app/app.hpp"
+
+#include "logger.hpp"
+#include <engine/window_manager.hpp>
+
+#include <optional>
+#include <string_view>
+
+namespace {
+
+constexpr const char *DEFAULT_REPORT = "flythrough.json";
+
+/// Headless unless `--window` is passed. `--report FILE` picks where the
+/// report goes, `--capture DIR` writes every frame into DIR and
+/// `--check-cull` fails the run if any frame's GPU cull is wrong.
+auto parseOptions(int argc, char **argv) noexcept
+    -> std::optional<App::Options> {
+  App::Options options{.headless = true,
+                       .frames = 0,
+                       .captureDirectory = std::nullopt,
+                       .flythroughReport = DEFAULT_REPORT,
+                       .checkCull = false};
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--window") {
+      options.headless = false;
+    } else if (arg == "--report" && hasValue) {
+      options.flythroughReport = argv[++i];
+    } else if (arg == "--capture" && hasValue) {
+      options.captureDirectory = argv[++i];
+    } else if (arg == "--check-cull") {
+      options.checkCull = true;
+    } else {
+      Logger::critical("Unknown argument: {}", arg);
+      Logger::info("Usage: {} [--window] [--report FILE] [--capture DIR] "
+                   "[--check-cull]",
+                   argv[0]);
+      return std::nullopt;
+    }
+  }
+  return options;
+}
+
+} // namespace
+
+/// Flies the camera along the same path every run and reports frame times,
+/// CPU zones and GPU passes, to compare builds against each other.
+auto main(int argc, char **argv) noexcept -> int {
+  Logger::init();
+
+  const auto options = parseOptions(argc, argv);
+  if (!options.has_value()) {
+    return EXIT_FAILURE;
+  }
+
+  std::optional<WindowManager> windowManager;
+  if (!options->headless) {
+    windowManager.emplace();
+  }
+
+  auto app = App::create(*options);
+
+  if (!app.has_value()) {
+    Logger::critical("Failed to create Program.");
+    return EXIT_FAILURE;
+  }
+
+  engine::run(*app);
+
+  // The path puts the camera in the same places every run.
+  if (options->checkCull && !app->finishCullChecks()) {
+    Logger::critical("GPU culling does not match the CPU reference.");
+    return EXIT_FAILURE;
+  }
+
+  Logger::info("Application terminated successfully.");
+  return EXIT_SUCCESS;
+}
@@ -3,11 +3,59 @@
 #include "logger.hpp"
 #include <engine/window_manager.hpp>
 
-auto main() noexcept -> int {
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+namespace {
+
+/// `--headless` renders offscreen, `--frames N` closes after N frames and
+/// `--capture DIR` writes every frame into DIR.
+auto parseOptions(int argc, char **argv) noexcept
+    -> std::optional<App::Options> {
+  App::Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if (arg == "--headless") {
+      options.headless = true;
+    } else if (arg == "--frames" && hasValue) {
+      const std::string_view value = argv[++i];
+      const auto [end, error] = std::from_chars(
+          value.data(), value.data() + value.size(), options.frames);
+      if (error != std::errc() || end != value.data() + value.size()) {
+        Logger::critical("Invalid frame count: {}", value);
+        return std::nullopt;
+      }
+    } else if (arg == "--capture" && hasValue) {
+      options.captureDirectory = argv[++i];
+    } else {
+      Logger::critical("Unknown argument: {}", arg);
+      Logger::info("Usage: {} [--headless] [--frames N] [--capture DIR]",
+                   argv[0]);
+      return std::nullopt;
+    }
+  }
+  return options;
+}
+
+} // namespace
+
+auto main(int argc, char **argv) noexcept -> int {
   Logger::init();
-  auto windowManager = WindowManager();
 
-  auto app = App::create();
+  const auto options = parseOptions(argc, argv);
+  if (!options.has_value()) {
+    return EXIT_FAILURE;
+  }
+
+  // GLFW cannot initialise without a display, and headless never uses it.
+  std::optional<WindowManager> windowManager;
+  if (!options->headless) {
+    windowManager.emplace();
+  }
+
+  auto app = App::create(*options);
 
   if (!app.has_value()) {
     Logger::critical("Failed to create Program.");
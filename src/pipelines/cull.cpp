@@ -0,0 +1,46 @@
+#include "pipelines.hpp"
+
+#include <array>
+
+#include "logger.hpp"
+#include <engine/util/macros.hpp>
+#include <vkh/shader.hpp>
+
+namespace pipelines {
+auto Cull::create(const vk::raii::Device &device,
+                  const DescriptorLayouts &layouts) noexcept
+    -> std::expected<Cull, std::string> {
+  Logger::trace("Creating Cull Pipeline");
+
+  EG_MAKE(shaderModule, vkh::Shader::create(device, "cull.spv"),
+          "Failed to create cull shader module");
+
+  vk::PushConstantRange pushConstantRange{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(CullPushConstants)};
+
+  std::array<vk::DescriptorSetLayout, 2> setLayouts = {*layouts.camera,
+                                                       *layouts.pyramid};
+
+  vk::PipelineLayoutCreateInfo layoutInfo{
+      .setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
+      .pSetLayouts = setLayouts.data(),
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &pushConstantRange,
+  };
+
+  VK_MAKE(layout, device.createPipelineLayout(layoutInfo),
+          "Failed to create cull pipeline layout");
+
+  VK_MAKE(pipeline,
+          device.createComputePipeline(
+              nullptr, vk::ComputePipelineCreateInfo{
+                           .stage = shaderModule.compute(), .layout = layout}),
+          "Failed to create cull pipeline");
+  Logger::trace("Cull Pipeline created");
+
+  return Cull({std::move(layout), std::move(pipeline)});
+}
+
+} // namespace pipelines
@@ -0,0 +1,41 @@
+#include "pipelines.hpp"
+
+#include "logger.hpp"
+#include <engine/util/macros.hpp>
+#include <vkh/shader.hpp>
+
+namespace pipelines {
+auto DepthReduce::create(const vk::raii::Device &device,
+                         const DescriptorLayouts &layouts) noexcept
+    -> std::expected<DepthReduce, std::string> {
+  Logger::trace("Creating Depth Reduce Pipeline");
+
+  EG_MAKE(shaderModule, vkh::Shader::create(device, "depthReduce.spv"),
+          "Failed to create depth reduce shader module");
+
+  vk::PushConstantRange pushConstantRange{
+      .stageFlags = vk::ShaderStageFlagBits::eCompute,
+      .offset = 0,
+      .size = sizeof(ReducePushConstants)};
+
+  vk::PipelineLayoutCreateInfo layoutInfo{
+      .setLayoutCount = 1,
+      .pSetLayouts = &*layouts.reduce,
+      .pushConstantRangeCount = 1,
+      .pPushConstantRanges = &pushConstantRange,
+  };
+
+  VK_MAKE(layout, device.createPipelineLayout(layoutInfo),
+          "Failed to create depth reduce pipeline layout");
+
+  VK_MAKE(pipeline,
+          device.createComputePipeline(
+              nullptr, vk::ComputePipelineCreateInfo{
+                           .stage = shaderModule.compute(), .layout = layout}),
+          "Failed to create depth reduce pipeline");
+  Logger::trace("Depth Reduce Pipeline created");
+
+  return DepthReduce({std::move(layout), std::move(pipeline)});
+}
+
+} // namespace pipelines
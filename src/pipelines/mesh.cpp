@@ -8,6 +8,7 @@
 
 namespace pipelines {
 auto Mesh::create(const vk::raii::Device &device, const vk::Format outFormat,
+                  const vk::Format depthFormat,
                   const DescriptorLayouts &layouts) noexcept
     -> std::expected<Mesh, std::string> {
   Logger::trace("Creating Graphics Pipeline");
@@ -41,10 +42,11 @@ auto Mesh::create(const vk::raii::Device &device, const vk::Format outFormat,
 
   vkh::GraphicsPipelineConfig pipelineConfig = {
       .rendering = {.colorAttachmentCount = 1,
-                    .pColorAttachmentFormats = &outFormat},
+                    .pColorAttachmentFormats = &outFormat,
+                    .depthAttachmentFormat = depthFormat},
       .shaders = shaderStages,
       .vertexInput = {},
-      .inputAssembly = {.topology = vk::PrimitiveTopology::eTriangleStrip},
+      .inputAssembly = {.topology = vk::PrimitiveTopology::eTriangleList},
       .viewport = {.viewportCount = 1, .scissorCount = 1},
       .rasterizer = {.depthClampEnable = vk::False,
                      .rasterizerDiscardEnable = vk::False,
@@ -57,6 +59,10 @@ auto Mesh::create(const vk::raii::Device &device, const vk::Format outFormat,
       .multisampling = {.rasterizationSamples = vk::SampleCountFlagBits::e1,
                         .sampleShadingEnable = vk::False,
                         .minSampleShading = 1.0f},
+      // Reverse Z, nearer is larger.
+      .depthStencil = {.depthTestEnable = vk::True,
+                       .depthWriteEnable = vk::True,
+                       .depthCompareOp = vk::CompareOp::eGreaterOrEqual},
       .blendAttachments = {{.blendEnable = vk::False,
                             .colorWriteMask = vk::ColorComponentFlagBits::eR |
                                               vk::ColorComponentFlagBits::eG |
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <vulkan/vulkan_raii.hpp>
 
 class Pipeline {
 protected:
@@ -34,17 +35,11 @@ namespace pipelines {
 
 class Mesh : public Pipeline {
 public:
-  struct Vertex {
-    glm::vec3 position;
-    float uvX;
-    glm::vec3 normal;
-    float uvY;
-    glm::vec4 color;
-  };
-
+  /// `drawsAddress` points at the frame's `ChunkDraw` records, indexed by
+  /// draw. Each record points at packed `engine::voxel::Quad`s, the vertex
+  /// shader expands six vertices from each.
   struct MeshPushConstants {
-    glm::mat4 modelMatrix;
-    vk::DeviceAddress vBufferAddress;
+    vk::DeviceAddress drawsAddress;
   };
 
   struct DescriptorLayouts {
@@ -52,8 +47,58 @@ public:
   };
 
   static auto create(const vk::raii::Device &device, const vk::Format outFormat,
+                     const vk::Format depthFormat,
                      const DescriptorLayouts &layouts) noexcept
       -> std::expected<Mesh, std::string>;
 };
 
+/// Culls chunk draw records into indirect draw lists, see cull.slang.
+///
+/// The early phase tests the frustum and, when the previous frame left a
+/// depth pyramid, occlusion against it. Chunks it rejects for occlusion are
+/// retested by the late phase against the pyramid of this frame's early
+/// draws.
+class Cull : public Pipeline {
+public:
+  static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+  enum class Phase : uint32_t { Early = 0, Late = 1 };
+
+  struct CullPushConstants {
+    /// The frame's `CullFrame`.
+    vk::DeviceAddress frameAddress;
+    Phase phase;
+  };
+
+  struct DescriptorLayouts {
+    const vk::raii::DescriptorSetLayout &camera;
+    const vk::raii::DescriptorSetLayout &pyramid;
+  };
+
+  static auto create(const vk::raii::Device &device,
+                     const DescriptorLayouts &layouts) noexcept
+      -> std::expected<Cull, std::string>;
+};
+
+/// Reduces one depth pyramid level into the next, see depthReduce.slang.
+class DepthReduce : public Pipeline {
+public:
+  static constexpr uint32_t WORKGROUP_SIZE = 8;
+
+  struct ReducePushConstants {
+    vk::Extent2D sourceSize;
+    vk::Extent2D targetSize;
+    /// The source is the depth image rather than a pyramid level.
+    uint32_t fromDepth;
+  };
+
+  struct DescriptorLayouts {
+    const vk::raii::DescriptorSetLayout &reduce;
+  };
+
+  static auto create(const vk::raii::Device &device,
+                     const DescriptorLayouts &layouts) noexcept
+      -> std::expected<DepthReduce, std::string>;
+};
+
 } // namespace pipelines